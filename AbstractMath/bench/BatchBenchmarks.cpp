@@ -0,0 +1,1377 @@
+#include "Benchmark.h"
+
+#include <filesystem>
+#include <cstdlib>
+
+#include "AbstractMath.h"
+
+namespace AbstractMath { namespace Bench {
+
+	template<typename T, size_t C>
+	VectorArray<T, C> makeArray(size_t count, std::mt19937& engine)
+	{
+		VectorArray<T, C> result(count);
+
+		for (size_t i = 0; i < C; i++)
+		{
+			randomize(result.lane(i), count, engine);
+		}
+
+		return result;
+	}
+
+	template<typename T, size_t C>
+	void registerVectorArrayOps(BenchmarkRegistry& registry, size_t count)
+	{
+		using A = VectorArray<T, C>;
+		const std::string prefix = std::string("VectorArray<") + TypeName<T>::get() + "," + std::to_string(C) + ">[" + std::to_string(count) + "]/";
+
+		struct State
+		{
+			A a, b, out;
+			std::vector<T> scalars;
+		};
+
+		std::mt19937 engine(1234);
+		auto state = std::make_shared<State>();
+		state->a = makeArray<T, C>(count, engine);
+		state->b = makeArray<T, C>(count, engine);
+		state->out = A(count);
+		state->scalars.resize(count);
+
+		const double vectorBytes = double(sizeof(T) * C);
+
+		registry.add(prefix + "add", count, 3 * vectorBytes, [state]() { add(state->a, state->b, state->out); clobberMemory(); });
+		registry.add(prefix + "multiply_scalar", count, 2 * vectorBytes, [state]() { multiply(state->a, T(3), state->out); clobberMemory(); });
+		registry.add(prefix + "dot", count, 2 * vectorBytes + sizeof(T), [state]() { dot(state->a, state->b, state->scalars.data()); clobberMemory(); });
+		registry.add(prefix + "length", count, vectorBytes + sizeof(T), [state]() { length(state->a, state->scalars.data()); clobberMemory(); });
+		registry.add(prefix + "normalized", count, 2 * vectorBytes, [state]() { normalized(state->a, state->out); clobberMemory(); });
+		registry.add(prefix + "lerp", count, 3 * vectorBytes, [state]() { lerp(state->a, state->b, T(0.25), state->out); clobberMemory(); });
+
+		// the same work through the single-vector API, for comparison
+		struct ScalarState
+		{
+			std::vector<Vector<T, C>> a, b, out;
+		};
+
+		auto scalarState = std::make_shared<ScalarState>();
+		scalarState->a.resize(count);
+		scalarState->b.resize(count);
+		scalarState->out.resize(count);
+		state->a.store(scalarState->a.data());
+		state->b.store(scalarState->b.data());
+
+		registry.add(prefix + "add_aos", count, 3 * vectorBytes, [scalarState]()
+		{
+			for (size_t i = 0; i < scalarState->a.size(); i++)
+			{
+				scalarState->out[i] = scalarState->a[i] + scalarState->b[i];
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "normalized_aos", count, 2 * vectorBytes, [scalarState]()
+		{
+			for (size_t i = 0; i < scalarState->a.size(); i++)
+			{
+				scalarState->out[i] = scalarState->a[i].normalized();
+			}
+
+			clobberMemory();
+		});
+	}
+
+	template<typename T>
+	void registerTransformOps(BenchmarkRegistry& registry, size_t count)
+	{
+		const std::string prefix = std::string("transform<") + TypeName<T>::get() + ">[" + std::to_string(count) + "]/";
+
+		struct State
+		{
+			Matrix<T, 4, 4> matrix;
+			std::vector<Vector3<T>> points, out;
+			std::vector<Vector4<T>> points4, out4;
+			VectorArray<T, 3> soa, soaOut;
+		};
+
+		std::mt19937 engine(1234);
+		auto state = std::make_shared<State>();
+		state->matrix = perspective(T(1.5), T(1), T(0.1), T(100));
+		state->soa = makeArray<T, 3>(count, engine);
+		state->soaOut = VectorArray<T, 3>(count);
+		state->points.resize(count);
+		state->out.resize(count);
+		state->soa.store(state->points.data());
+
+		for (size_t i = 0; i < count; i++)
+		{
+			state->points4.push_back(Vector4<T>(state->points[i][0], state->points[i][1], state->points[i][2], T(1)));
+		}
+
+		state->out4.resize(count);
+		const double pointBytes = double(sizeof(Vector3<T>));
+
+		registry.add(prefix + "operator_loop", count, 2 * sizeof(Vector4<T>), [state]()
+		{
+			for (size_t i = 0; i < state->points4.size(); i++)
+			{
+				state->out4[i] = state->matrix * state->points4[i];
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "transformVectors", count, 2 * sizeof(Vector4<T>), [state]() { transformVectors(state->matrix, state->points4.data(), state->out4.data(), state->points4.size()); clobberMemory(); });
+		registry.add(prefix + "transformPoints", count, 2 * pointBytes, [state]() { transformPoints(state->matrix, state->points.data(), state->out.data(), state->points.size()); clobberMemory(); });
+		registry.add(prefix + "transformPoints_divide", count, 2 * pointBytes, [state]() { transformPoints(state->matrix, state->points.data(), state->out.data(), state->points.size(), true); clobberMemory(); });
+		registry.add(prefix + "transformDirections", count, 2 * pointBytes, [state]() { transformDirections(state->matrix, state->points.data(), state->out.data(), state->points.size()); clobberMemory(); });
+		registry.add(prefix + "transformPoints_soa", count, 2 * pointBytes, [state]() { transformPoints(state->matrix, state->soa, state->soaOut); clobberMemory(); });
+	}
+
+	// the same passes on pools of 1, 2, 4, ... up to every hardware thread, for scaling curves
+	template<typename T>
+	void registerParallelOps(BenchmarkRegistry& registry, size_t count)
+	{
+		const std::string prefix = std::string("parallel<") + TypeName<T>::get() + ">[" + std::to_string(count) + "]/";
+
+		struct State
+		{
+			Matrix<T, 4, 4> matrix;
+			std::vector<Vector3<T>> points, out;
+			std::vector<Quaternion<T>> from, to, blended;
+			std::vector<Matrix<T, 4, 4>> world, bind, palette;
+		};
+
+		std::mt19937 engine(1234);
+		std::uniform_real_distribution<T> angle(T(-3), T(3));
+		auto state = std::make_shared<State>();
+		state->matrix = perspective(T(1.5), T(1), T(0.1), T(100));
+		state->points.resize(count);
+		state->out.resize(count);
+		makeArray<T, 3>(count, engine).store(state->points.data());
+
+		for (size_t i = 0; i < count; i++)
+		{
+			state->from.push_back(Quaternion<T>(Vector3<T>(T(0), T(1), T(0)), angle(engine)));
+			state->to.push_back(Quaternion<T>(Vector3<T>(T(1), T(0), T(0)), angle(engine)));
+			state->world.push_back(state->matrix * translation(Vector3<T>(angle(engine), angle(engine), angle(engine))));
+			state->bind.push_back(translation(Vector3<T>(angle(engine), angle(engine), angle(engine))));
+		}
+
+		state->blended.resize(count);
+		state->palette.resize(count);
+
+		std::vector<size_t> threadCounts;
+
+		for (size_t threads = 1; threads < hardwareThreads(); threads *= 2)
+		{
+			threadCounts.push_back(threads);
+		}
+
+		threadCounts.push_back(hardwareThreads());
+
+		for (size_t threads : threadCounts)
+		{
+			auto pool = std::make_shared<ThreadPool>(threads - 1);
+			const std::string suffix = "_threads" + std::to_string(threads);
+
+			registry.add(prefix + "transformPoints" + suffix, count, 2 * sizeof(Vector3<T>), [state, pool]()
+			{
+				setJobSystem(pool.get());
+				parallelBatch(state->points.data(), state->out.data(), state->points.size(), [state](const Vector3<T>* src, Vector3<T>* dst, size_t n)
+				{
+					transformPoints(state->matrix, src, dst, n);
+				});
+				setJobSystem(nullptr);
+				clobberMemory();
+			});
+
+			registry.add(prefix + "slerp" + suffix, count, 3 * sizeof(Quaternion<T>), [state, pool]()
+			{
+				setJobSystem(pool.get());
+				parallelTransform(state->from.data(), state->to.data(), state->blended.data(), state->from.size(), [](const Quaternion<T>& a, const Quaternion<T>& b)
+				{
+					return a.slerp(b, T(0.3));
+				});
+				setJobSystem(nullptr);
+				clobberMemory();
+			});
+
+			registry.add(prefix + "palette" + suffix, count, 3 * sizeof(Matrix<T, 4, 4>), [state, pool]()
+			{
+				setJobSystem(pool.get());
+				parallelTransform(state->world.data(), state->bind.data(), state->palette.data(), state->world.size(), [](const Matrix<T, 4, 4>& a, const Matrix<T, 4, 4>& b)
+				{
+					return a * b;
+				});
+				setJobSystem(nullptr);
+				clobberMemory();
+			});
+		}
+	}
+
+	template<typename T>
+	void naiveMultiply(const DynamicMatrix<T>& a, const DynamicMatrix<T>& b, DynamicMatrix<T>& c)
+	{
+		c.setZero();
+
+		for (size_t j = 0; j < b.cols(); j++)
+		{
+			for (size_t k = 0; k < a.cols(); k++)
+			{
+				for (size_t i = 0; i < a.rows(); i++)
+				{
+					c(i, j) += a(i, k) * b(k, j);
+				}
+			}
+		}
+	}
+
+	// one op is the whole product, flops are reported as 2 n^3
+	template<typename T>
+	void registerGemm(BenchmarkRegistry& registry, size_t n, bool withNaive)
+	{
+		const std::string prefix = std::string("DynamicMatrix<") + TypeName<T>::get() + ">[" + std::to_string(n) + "]/";
+
+		struct State
+		{
+			DynamicMatrix<T> a, b, c;
+		};
+
+		std::mt19937 engine(1234);
+		auto state = std::make_shared<State>();
+		state->a = DynamicMatrix<T>(n, n);
+		state->b = DynamicMatrix<T>(n, n);
+		state->c = DynamicMatrix<T>(n, n);
+		randomize(state->a.data(), n * n, engine);
+		randomize(state->b.data(), n * n, engine);
+
+		const double bytes = double(3 * n * n * sizeof(T));
+		const double flops = 2.0 * double(n) * double(n) * double(n);
+
+		registry.add(prefix + "gemm", 1, bytes, [state]() { gemm(state->a, state->b, state->c); clobberMemory(); }, flops);
+
+		if (withNaive)
+		{
+			registry.add(prefix + "naive", 1, bytes, [state]() { naiveMultiply(state->a, state->b, state->c); clobberMemory(); }, flops);
+		}
+	}
+
+	// count independent N x N systems, e.g. the per-contact effective mass blocks of a physics step (positive
+	// definite so every solver applies), one op is one system
+	template<typename T, size_t N>
+	void registerSolverOps(BenchmarkRegistry& registry, size_t count)
+	{
+		const std::string prefix = std::string("Solve<") + TypeName<T>::get() + "," + std::to_string(N) + ">[" + std::to_string(count) + "]/";
+
+		struct State
+		{
+			std::vector<Matrix<T, N, N>> a;
+			std::vector<Vector<T, N>> b, x;
+		};
+
+		std::mt19937 engine(1234);
+		std::uniform_real_distribution<T> value(T(-1), T(1));
+		auto state = std::make_shared<State>();
+		state->a.resize(count);
+		state->b.resize(count);
+		state->x.resize(count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			//J * J^T plus a diagonal, the shape of an effective mass matrix
+			Matrix<T, N, N> jacobian;
+
+			for (T& element : jacobian.data)
+			{
+				element = value(engine);
+			}
+
+			for (size_t row = 0; row < N; row++)
+			{
+				for (size_t col = 0; col < N; col++)
+				{
+					T sum = row == col ? T(0.5) : T(0);
+
+					for (size_t k = 0; k < N; k++)
+					{
+						sum += jacobian.data[k * N + row] * jacobian.data[k * N + col];
+					}
+
+					state->a[i].data[col * N + row] = sum;
+				}
+			}
+
+			for (T& element : state->b[i].data)
+			{
+				element = value(engine);
+			}
+		}
+
+		const double bytes = double(sizeof(Matrix<T, N, N>) + 2 * sizeof(Vector<T, N>));
+
+		registry.add(prefix + "inverse_multiply", count, bytes, [state]()
+		{
+			for (size_t i = 0; i < state->a.size(); i++)
+			{
+				state->x[i] = state->a[i].inverted() * state->b[i];
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "lu", count, bytes, [state]()
+		{
+			for (size_t i = 0; i < state->a.size(); i++)
+			{
+				state->x[i] = LUDecomposition<T, N>(state->a[i]).solve(state->b[i]);
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "cholesky", count, bytes, [state]()
+		{
+			for (size_t i = 0; i < state->a.size(); i++)
+			{
+				state->x[i] = CholeskyDecomposition<T, N>(state->a[i]).solve(state->b[i]);
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "qr", count, bytes, [state]()
+		{
+			for (size_t i = 0; i < state->a.size(); i++)
+			{
+				state->x[i] = QRDecomposition<T, N, N>(state->a[i]).solve(state->b[i]);
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "batch_lu", count, bytes, [state]() { solveLU(state->a.data(), state->b.data(), state->x.data(), state->a.size()); clobberMemory(); });
+		registry.add(prefix + "batch_cholesky", count, bytes, [state]() { solveCholesky(state->a.data(), state->b.data(), state->x.data(), state->a.size()); clobberMemory(); });
+	}
+
+	// shape matching inputs: per-cluster deformation gradients, a rotation times a small stretch and shear, and
+	// the covariances of the same matrices for the symmetric solver
+	template<typename T>
+	void registerDecompositionOps(BenchmarkRegistry& registry, size_t count)
+	{
+		const std::string prefix = std::string("Decompose3<") + TypeName<T>::get() + ">[" + std::to_string(count) + "]/";
+
+		struct State
+		{
+			std::vector<Matrix<T, 3, 3>> a, symmetric, rotations;
+			std::vector<Quaternion<T>> orientations;
+			std::vector<SymmetricEigen3<T>> eigen;
+			std::vector<SVD3<T>> svd;
+			std::vector<PolarDecomposition3<T>> polar;
+		};
+
+		std::mt19937 engine(1234);
+		std::uniform_real_distribution<T> value(T(-1), T(1));
+		auto state = std::make_shared<State>();
+		state->a.resize(count);
+		state->symmetric.resize(count);
+		state->rotations.resize(count);
+		state->orientations.resize(count);
+		state->eigen.resize(count);
+		state->svd.resize(count);
+		state->polar.resize(count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			Quaternion<T> rotation = Quaternion<T>(value(engine), value(engine), value(engine), value(engine)).normalized();
+			Matrix<T, 3, 3> stretch = identity<T, 3>();
+
+			for (T& element : stretch.data)
+			{
+				element += T(0.2) * value(engine);
+			}
+
+			Matrix<T, 3, 3> basis;
+
+			for (size_t col = 0; col < 3; col++)
+			{
+				Vector3<T> axis = rotation.rotate(Vector3<T>(T(col == 0), T(col == 1), T(col == 2)));
+
+				for (size_t row = 0; row < 3; row++)
+				{
+					basis.data[col * 3 + row] = axis.data[row];
+				}
+			}
+
+			state->a[i] = basis * stretch;
+
+			for (size_t col = 0; col < 3; col++)
+			{
+				for (size_t row = 0; row < 3; row++)
+				{
+					const T* a = state->a[i].data;
+					state->symmetric[i].data[col * 3 + row] = a[row] * a[col] + a[3 + row] * a[3 + col] + a[6 + row] * a[6 + col];
+				}
+			}
+		}
+
+		const double bytes = double(sizeof(Matrix<T, 3, 3>) * 2);
+
+		registry.add(prefix + "eigen", count, bytes, [state]()
+		{
+			for (size_t i = 0; i < state->symmetric.size(); i++)
+			{
+				state->eigen[i] = symmetricEigen(state->symmetric[i]);
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "svd", count, bytes, [state]()
+		{
+			for (size_t i = 0; i < state->a.size(); i++)
+			{
+				state->svd[i] = svd(state->a[i]);
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "polar", count, bytes, [state]()
+		{
+			for (size_t i = 0; i < state->a.size(); i++)
+			{
+				state->polar[i] = polarDecomposition(state->a[i]);
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "batch_eigen", count, bytes, [state]() { symmetricEigen(state->symmetric.data(), state->eigen.data(), state->symmetric.size()); clobberMemory(); });
+		registry.add(prefix + "batch_svd", count, bytes, [state]() { svd(state->a.data(), state->svd.data(), state->a.size()); clobberMemory(); });
+		registry.add(prefix + "batch_polar", count, bytes, [state]() { polarDecomposition(state->a.data(), state->polar.data(), state->a.size()); clobberMemory(); });
+		registry.add(prefix + "batch_polar_rotation", count, bytes, [state]() { polarDecomposition(state->a.data(), state->rotations.data(), state->a.size()); clobberMemory(); });
+		registry.add(prefix + "batch_polar_quaternion", count, bytes, [state]() { polarDecomposition(state->a.data(), state->orientations.data(), state->a.size()); clobberMemory(); });
+	}
+
+	// a side x side cloth grid coupled to its 8 neighbours (9 nonzeros per row), shifted to be positive definite
+	// one op is one row, spmv_reference is the plain CSR loop the SIMD kernels are measured against
+	template<typename T>
+	void registerSparseOps(BenchmarkRegistry& registry, size_t side)
+	{
+		const size_t rows = side * side;
+		const std::string prefix = std::string("SparseMatrix<") + TypeName<T>::get() + ">[" + std::to_string(rows) + "]/";
+
+		struct State
+		{
+			SparseMatrix<T> scalar;
+			BlockSparseMatrix<T> block;
+			std::vector<T> x, y, solution;
+			std::vector<Vector3<T>> x3, y3, solution3;
+		};
+
+		std::mt19937 engine(1234);
+		std::uniform_real_distribution<T> stiffness(T(0.5), T(1));
+		std::vector<Triplet<T>> triplets;
+		std::vector<BlockTriplet<T>> blockTriplets;
+
+		for (size_t i = 0; i < side; i++)
+		{
+			for (size_t j = 0; j < side; j++)
+			{
+				SparseIndex row = SparseIndex(i * side + j);
+
+				for (size_t di = i > 0 ? i - 1 : 0; di <= i + 1 && di < side; di++)
+				{
+					for (size_t dj = j > 0 ? j - 1 : 0; dj <= j + 1 && dj < side; dj++)
+					{
+						SparseIndex col = SparseIndex(di * side + dj);
+
+						if (col < row)
+						{
+							//symmetric, each spring adds k to both diagonals and -k to both couplings
+							T k = stiffness(engine);
+							Matrix<T, 3, 3> spring = identity<T, 3>();
+
+							for (T& value : spring.data)
+							{
+								value *= k;
+							}
+
+							Matrix<T, 3, 3> coupling;
+
+							for (size_t c = 0; c < 9; c++)
+							{
+								coupling.data[c] = -spring.data[c];
+							}
+
+							triplets.push_back({ row, row, k });
+							triplets.push_back({ col, col, k });
+							triplets.push_back({ row, col, -k });
+							triplets.push_back({ col, row, -k });
+							blockTriplets.push_back({ row, row, spring });
+							blockTriplets.push_back({ col, col, spring });
+							blockTriplets.push_back({ row, col, coupling });
+							blockTriplets.push_back({ col, row, coupling });
+						}
+					}
+				}
+
+				triplets.push_back({ row, row, T(0.1) }); //the mass term
+				blockTriplets.push_back({ row, row, identity<T, 3>() });
+			}
+		}
+
+		auto state = std::make_shared<State>();
+		state->scalar.setFromTriplets(rows, rows, triplets.data(), triplets.size());
+		state->block.setFromTriplets(rows, rows, blockTriplets.data(), blockTriplets.size());
+		state->x.resize(rows);
+		state->y.resize(rows);
+		state->solution.resize(rows);
+		state->x3.resize(rows);
+		state->y3.resize(rows);
+		state->solution3.resize(rows);
+		randomize(state->x.data(), rows, engine);
+		makeArray<T, 3>(rows, engine).store(state->x3.data());
+
+		const double nonZeros = double(state->scalar.nonZeros()) / double(rows);
+		const double scalarBytes = nonZeros * (sizeof(T) + sizeof(SparseIndex)) + 2 * sizeof(T);
+		const double blockBytes = nonZeros * (sizeof(Matrix<T, 3, 3>) + sizeof(SparseIndex)) + 2 * sizeof(Vector3<T>);
+
+		registry.add(prefix + "spmv_reference", rows, scalarBytes, [state]()
+		{
+			const SparseIndex* offsets = state->scalar.rowOffsets();
+			const SparseIndex* columns = state->scalar.columnIndices();
+			const T* values = state->scalar.values();
+
+			for (size_t r = 0; r < state->scalar.rows(); r++)
+			{
+				T sum = T(0);
+
+				for (SparseIndex k = offsets[r]; k < offsets[r + 1]; k++)
+				{
+					sum += values[k] * state->x[columns[k]];
+				}
+
+				state->y[r] = sum;
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "spmv", rows, scalarBytes, [state]() { state->scalar.multiply(state->x.data(), state->y.data()); clobberMemory(); });
+		registry.add(prefix + "spmv_vector3", rows, scalarBytes + 4 * sizeof(T), [state]() { state->scalar.multiply(state->x3.data(), state->y3.data()); clobberMemory(); });
+		registry.add(prefix + "bsr3_spmv", rows, blockBytes, [state]() { state->block.multiply(state->x3.data(), state->y3.data()); clobberMemory(); });
+
+		//ten iterations from a cold start, the work of a warm-started solve in a frame
+		state->scalar.multiply(state->x.data(), state->y.data());
+		state->block.multiply(state->x3.data(), state->y3.data());
+
+		registry.add(prefix + "cg_10iterations", rows, 10 * scalarBytes, [state]()
+		{
+			std::fill(state->solution.begin(), state->solution.end(), T(0));
+			conjugateGradient(state->scalar, state->y.data(), state->solution.data(), T(0), 10);
+			clobberMemory();
+		});
+
+		registry.add(prefix + "bsr3_cg_10iterations", rows, 10 * blockBytes, [state]()
+		{
+			std::fill(state->solution3.begin(), state->solution3.end(), Vector3<T>());
+			conjugateGradient(state->block, state->y3.data(), state->solution3.data(), T(0), 10);
+			clobberMemory();
+		});
+	}
+
+	// objects scattered around a camera at the origin, roughly a tenth of them end up visible
+	template<typename T>
+	void registerFrustumOps(BenchmarkRegistry& registry, size_t count)
+	{
+		const std::string prefix = std::string("Frustum<") + TypeName<T>::get() + ">[" + std::to_string(count) + "]/";
+
+		struct State
+		{
+			Frustum<T> frustum;
+			VectorArray<T, 4> spheres;
+			VectorArray<T, 3> centers, extents;
+			std::vector<uint32_t> visible;
+			std::vector<uint8_t> coherency;
+		};
+
+		std::mt19937 engine(1234);
+		std::uniform_real_distribution<T> position(T(-100), T(100));
+		auto state = std::make_shared<State>();
+		state->frustum = Frustum<T>(perspective(T(16) / T(9), T(1.2), T(0.1), T(100)));
+		state->spheres = makeArray<T, 4>(count, engine);
+		state->centers = VectorArray<T, 3>(count);
+		state->extents = makeArray<T, 3>(count, engine);
+		state->visible.resize(count);
+		state->coherency.resize(count, 0);
+
+		for (size_t l = 0; l < 3; l++)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				state->spheres.lane(l)[i] = position(engine);
+				state->centers.lane(l)[i] = state->spheres.lane(l)[i];
+			}
+		}
+
+		const double sphereBytes = double(4 * sizeof(T));
+		const double boxBytes = double(6 * sizeof(T));
+
+		registry.add(prefix + "cull_spheres", count, sphereBytes, [state]() { doNotOptimize(state->frustum.cullSpheres(state->spheres, state->visible.data())); clobberMemory(); });
+		registry.add(prefix + "cull_spheres_coherent", count, sphereBytes + 1, [state]() { doNotOptimize(state->frustum.cullSpheres(state->spheres, state->visible.data(), state->coherency.data())); clobberMemory(); });
+		registry.add(prefix + "cull_spheres_parallel", count, sphereBytes, [state]() { doNotOptimize(state->frustum.cullSpheresParallel(state->spheres, state->visible.data())); clobberMemory(); });
+		registry.add(prefix + "cull_boxes", count, boxBytes, [state]() { doNotOptimize(state->frustum.cullBoxes(state->centers, state->extents, state->visible.data())); clobberMemory(); });
+		registry.add(prefix + "cull_boxes_parallel", count, boxBytes, [state]() { doNotOptimize(state->frustum.cullBoxesParallel(state->centers, state->extents, state->visible.data())); clobberMemory(); });
+
+		registry.add(prefix + "sphere_loop", count, sphereBytes, [state]()
+		{
+			size_t found = 0;
+
+			for (size_t i = 0; i < state->spheres.size(); i++)
+			{
+				Vector<T, 3> center = { state->spheres.lane(0)[i], state->spheres.lane(1)[i], state->spheres.lane(2)[i] };
+
+				if (state->frustum.intersectsSphere(center, state->spheres.lane(3)[i]))
+				{
+					state->visible[found++] = uint32_t(i);
+				}
+			}
+
+			doNotOptimize(found);
+			clobberMemory();
+		});
+	}
+
+	// picking and line-of-sight shapes: rays from random points toward the middle of a cloud of small triangles
+	// one op is one ray-triangle test, or one ray-box test for the box ops, *_loop is the scalar Möller-Trumbore and
+	// slab code over plain arrays the packet kernels are measured against
+	template<typename T>
+	void registerIntersectionOps(BenchmarkRegistry& registry, size_t triangleCount, size_t rayCount)
+	{
+		const std::string prefix = std::string("Intersection<") + TypeName<T>::get() + ">[" + std::to_string(triangleCount) + "x" + std::to_string(rayCount) + "]/";
+		const std::string boxPrefix = std::string("Intersection<") + TypeName<T>::get() + ">[" + std::to_string(rayCount * 64) + "]/";
+
+		struct State
+		{
+			std::vector<Triangle<T>> triangles;
+			TriangleArray<T> triangleArray;
+			std::vector<Ray<T>> rays, boxRays;
+			RayArray<T> rayArray, boxRayArray;
+			std::vector<RayHit<T>> hits;
+			std::vector<uint32_t> boxHits;
+			AABB<T> box;
+		};
+
+		std::mt19937 engine(1234);
+		std::uniform_real_distribution<T> value(T(-1), T(1));
+		auto state = std::make_shared<State>();
+
+		for (size_t i = 0; i < triangleCount; i++)
+		{
+			Vector3<T> center(T(10) * value(engine), T(10) * value(engine), T(10) * value(engine));
+			Vector3<T> corners[3];
+
+			for (Vector3<T>& corner : corners)
+			{
+				corner = Vector3<T>(center.x + value(engine), center.y + value(engine), center.z + value(engine));
+			}
+
+			state->triangles.push_back(Triangle<T>(corners[0], corners[1], corners[2]));
+		}
+
+		auto makeRay = [&]()
+		{
+			Vector3<T> origin(T(20) * value(engine), T(20) * value(engine), T(20) * value(engine));
+			Vector3<T> target(T(5) * value(engine), T(5) * value(engine), T(5) * value(engine));
+			return Ray<T>(origin, Vector3<T>(target - origin));
+		};
+
+		for (size_t i = 0; i < rayCount; i++)
+		{
+			state->rays.push_back(makeRay());
+		}
+
+		for (size_t i = 0; i < rayCount * 64; i++)
+		{
+			state->boxRays.push_back(makeRay());
+		}
+
+		state->triangleArray = TriangleArray<T>(state->triangles.data(), triangleCount);
+		state->rayArray = RayArray<T>(state->rays.data(), rayCount);
+		state->boxRayArray = RayArray<T>(state->boxRays.data(), state->boxRays.size());
+		state->hits.resize(rayCount);
+		state->boxHits.resize(state->boxRays.size());
+		state->box = AABB<T>(Vector3<T>(T(-3), T(-2), T(-4)), Vector3<T>(T(4), T(3), T(2)));
+
+		const size_t tests = triangleCount * rayCount;
+		const double bytes = double(9 * sizeof(T)) / double(rayCount); //the triangles stay in cache after the first ray
+
+		registry.add(prefix + "closest_loop", tests, bytes, [state]()
+		{
+			for (size_t r = 0; r < state->rays.size(); r++)
+			{
+				RayHit<T> hit;
+
+				for (size_t i = 0; i < state->triangles.size(); i++)
+				{
+					T t = T(0), u = T(0), v = T(0);
+
+					if (intersectTriangle(state->rays[r], state->triangles[i], t, u, v) && t < hit.t)
+					{
+						hit.t = t;
+						hit.u = u;
+						hit.v = v;
+						hit.index = uint32_t(i);
+					}
+				}
+
+				state->hits[r] = hit;
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "closest", tests, bytes, [state]()
+		{
+			for (size_t r = 0; r < state->rays.size(); r++)
+			{
+				state->hits[r] = RayHit<T>();
+				intersectClosest(state->rays[r], state->triangleArray, state->hits[r]);
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "closest_batch", tests, bytes, [state]() { intersectClosest(state->rayArray, state->triangleArray, state->hits.data()); clobberMemory(); });
+
+		registry.add(prefix + "any", tests, bytes, [state]()
+		{
+			size_t blocked = 0;
+
+			for (const Ray<T>& ray : state->rays)
+			{
+				blocked += intersectAny(ray, state->triangleArray) ? 1 : 0;
+			}
+
+			doNotOptimize(blocked);
+		});
+
+		const double rayBytes = double(12 * sizeof(T) + sizeof(uint32_t));
+
+		registry.add(boxPrefix + "box_loop", state->boxRays.size(), rayBytes, [state]()
+		{
+			size_t found = 0;
+
+			for (size_t i = 0; i < state->boxRays.size(); i++)
+			{
+				T tNear = T(0), tFar = T(0);
+				state->boxHits[found] = uint32_t(i);
+				found += intersectBox(state->boxRays[i], state->box, tNear, tFar) ? 1 : 0;
+			}
+
+			doNotOptimize(found);
+			clobberMemory();
+		});
+
+		registry.add(boxPrefix + "box_packet", state->boxRays.size(), rayBytes, [state]() { doNotOptimize(intersectBox(state->box, state->boxRayArray, state->boxHits.data())); clobberMemory(); });
+	}
+
+	// a terrain-like mesh of two triangles per cell of a gridSize x gridSize heightfield (708 gives about 1M triangles)
+	// one op is one triangle for build and refit, one ray for the ray queries and one query point or box otherwise,
+	// refit moves every vertex a little as a deforming mesh would
+	template<typename T>
+	void registerBvhOps(BenchmarkRegistry& registry, size_t gridSize, size_t queryCount)
+	{
+		const size_t triangleCount = 2 * gridSize * gridSize;
+		const std::string prefix = std::string("BVH<") + TypeName<T>::get() + ">[" + std::to_string(triangleCount) + "]/";
+
+		struct State
+		{
+			std::vector<Triangle<T>> triangles, moved;
+			BVH<T> bvh;
+			std::vector<Ray<T>> rays;
+			RayArray<T> rayArray;
+			std::vector<RayHit<T>> hits;
+			std::vector<Vector3<T>> points;
+			std::vector<AABB<T>> boxes;
+			std::vector<uint32_t> found;
+		};
+
+		std::mt19937 engine(1234);
+		std::uniform_real_distribution<T> value(T(-1), T(1));
+		auto state = std::make_shared<State>();
+		const T extent = T(gridSize);
+
+		auto height = [](T x, T z, T phase) { return T(4) * std::sin(x * T(0.05) + phase) * std::cos(z * T(0.07)) + std::sin(x * T(0.5) + z * T(0.3)); };
+		auto mesh = [&](std::vector<Triangle<T>>& out, T phase)
+		{
+			out.clear();
+			out.reserve(triangleCount);
+
+			for (size_t z = 0; z < gridSize; z++)
+			{
+				for (size_t x = 0; x < gridSize; x++)
+				{
+					T x0 = T(x), x1 = T(x + 1), z0 = T(z), z1 = T(z + 1);
+					Vector3<T> a(x0, height(x0, z0, phase), z0), b(x1, height(x1, z0, phase), z0);
+					Vector3<T> c(x0, height(x0, z1, phase), z1), d(x1, height(x1, z1, phase), z1);
+					out.push_back(Triangle<T>(a, b, c));
+					out.push_back(Triangle<T>(b, d, c));
+				}
+			}
+		};
+
+		mesh(state->triangles, T(0));
+		mesh(state->moved, T(0.3));
+		state->bvh.build(state->triangles.data(), triangleCount);
+
+		for (size_t i = 0; i < queryCount; i++)
+		{
+			Vector3<T> origin(extent * (T(0.5) + T(0.5) * value(engine)), T(20), extent * (T(0.5) + T(0.5) * value(engine)));
+			Vector3<T> direction(value(engine), T(-1), value(engine));
+			state->rays.push_back(Ray<T>(origin, direction));
+			state->points.push_back(Vector3<T>(origin.x + T(5) * value(engine), T(10) * value(engine), origin.z + T(5) * value(engine)));
+			state->boxes.push_back(AABB<T>(Vector3<T>(origin.x, T(-2), origin.z), Vector3<T>(origin.x + T(2), T(2), origin.z + T(2))));
+		}
+
+		state->rayArray = RayArray<T>(state->rays.data(), queryCount);
+		state->hits.resize(queryCount);
+
+		registry.add(prefix + "build", triangleCount, double(9 * sizeof(T)), [state]() { state->bvh.build(state->triangles.data(), state->triangles.size()); clobberMemory(); });
+
+		registry.add(prefix + "refit", triangleCount, double(9 * sizeof(T)), [state]()
+		{
+			state->bvh.refit(state->moved.data());
+			state->moved.swap(state->triangles);
+			clobberMemory();
+		});
+
+		registry.add(prefix + "closest", queryCount, 0.0, [state]()
+		{
+			for (size_t r = 0; r < state->rays.size(); r++)
+			{
+				state->hits[r] = RayHit<T>();
+				state->bvh.intersect(state->rays[r], state->hits[r]);
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "closest_batch", queryCount, 0.0, [state]() { state->bvh.intersect(state->rayArray, state->hits.data()); clobberMemory(); });
+
+		registry.add(prefix + "occluded", queryCount, 0.0, [state]()
+		{
+			size_t blocked = 0;
+
+			for (const Ray<T>& ray : state->rays)
+			{
+				blocked += state->bvh.occluded(ray) ? 1 : 0;
+			}
+
+			doNotOptimize(blocked);
+		});
+
+		registry.add(prefix + "closest_point", queryCount, 0.0, [state]()
+		{
+			for (const Vector3<T>& point : state->points)
+			{
+				SurfacePoint<T> surface;
+				state->bvh.closestPoint(point, surface);
+				doNotOptimize(surface.distanceSquared);
+			}
+		});
+
+		registry.add(prefix + "overlapping", queryCount, 0.0, [state]()
+		{
+			state->found.clear();
+
+			for (const AABB<T>& box : state->boxes)
+			{
+				state->bvh.overlapping(box, state->found);
+			}
+
+			doNotOptimize(state->found.size());
+		});
+	}
+
+	// one op is one bone, count is bones * characters
+	template<typename T>
+	void registerRotationBlendOps(BenchmarkRegistry& registry, size_t count)
+	{
+		const std::string prefix = std::string("rotations<") + TypeName<T>::get() + ">[" + std::to_string(count) + "]/";
+
+		struct State
+		{
+			VectorArray<T, 4> a, b, c, out;
+			std::vector<T> amounts;
+			std::vector<Quaternion<T>> aos, aosOther, aosOut;
+			std::vector<Matrix<T, 4, 4>> palette;
+		};
+
+		std::mt19937 engine(1234);
+		std::uniform_real_distribution<T> amount(T(0), T(1));
+		auto state = std::make_shared<State>();
+		state->a = makeArray<T, 4>(count, engine);
+		state->b = makeArray<T, 4>(count, engine);
+		state->c = makeArray<T, 4>(count, engine);
+		normalize(state->a);
+		normalize(state->b);
+		normalize(state->c);
+		state->out = VectorArray<T, 4>(count);
+		state->aos.resize(count);
+		state->aosOther.resize(count);
+		state->aosOut.resize(count);
+		state->palette.resize(count);
+		state->a.store(state->aos.data());
+		state->b.store(state->aosOther.data());
+
+		for (size_t i = 0; i < count; i++)
+		{
+			state->amounts.push_back(amount(engine));
+		}
+
+		const double rotationBytes = double(4 * sizeof(T));
+
+		registry.add(prefix + "nlerp", count, 3 * rotationBytes, [state]() { nlerp(state->a, state->b, T(0.25), state->out); clobberMemory(); });
+		registry.add(prefix + "nlerp_amounts", count, 3 * rotationBytes + sizeof(T), [state]() { nlerp(state->a, state->b, state->amounts.data(), state->out); clobberMemory(); });
+		registry.add(prefix + "fastSlerp", count, 3 * rotationBytes, [state]() { fastSlerp(state->a, state->b, T(0.25), state->out); clobberMemory(); });
+
+		registry.add(prefix + "blendRotations_3", count, 4 * rotationBytes, [state]()
+		{
+			const VectorArray<T, 4>* poses[3] = { &state->a, &state->b, &state->c };
+			const T weights[3] = { T(0.5), T(0.3), T(0.2) };
+			blendRotations(poses, weights, 3, state->out);
+			clobberMemory();
+		});
+
+		registry.add(prefix + "toRotationMatrices", count, rotationBytes + sizeof(Matrix<T, 4, 4>), [state]() { toRotationMatrices(state->a, state->palette.data()); clobberMemory(); });
+
+		// the same work through the single-quaternion API, for comparison
+		registry.add(prefix + "slerp_aos", count, 3 * rotationBytes, [state]()
+		{
+			for (size_t i = 0; i < state->aos.size(); i++)
+			{
+				state->aosOut[i] = state->aos[i].slerp(state->aosOther[i], T(0.25));
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "toRotationMatrix_aos", count, rotationBytes + sizeof(Matrix<T, 4, 4>), [state]()
+		{
+			for (size_t i = 0; i < state->aos.size(); i++)
+			{
+				state->palette[i] = state->aos[i].toRotationMatrix();
+			}
+
+			clobberMemory();
+		});
+	}
+
+	template<typename T>
+	void registerTRSOps(BenchmarkRegistry& registry, size_t count)
+	{
+		const std::string prefix = std::string("TRS<") + TypeName<T>::get() + ">[" + std::to_string(count) + "]/";
+
+		struct State
+		{
+			VectorArray<T, 3> translations, scales;
+			VectorArray<T, 4> rotations;
+			std::vector<Matrix<T, 4, 4>> matrices;
+			std::vector<Matrix<T, 3, 4>> affine;
+		};
+
+		std::mt19937 engine(1234);
+		auto state = std::make_shared<State>();
+		state->translations = makeArray<T, 3>(count, engine);
+		state->rotations = makeArray<T, 4>(count, engine);
+		state->scales = makeArray<T, 3>(count, engine);
+		normalize(state->rotations);
+		state->matrices.resize(count);
+		state->affine.resize(count);
+		composeTRS(state->translations, state->rotations, state->scales, state->matrices.data());
+
+		const double partsBytes = double(10 * sizeof(T));
+
+		registry.add(prefix + "composeTRS", count, partsBytes + sizeof(Matrix<T, 4, 4>), [state]() { composeTRS(state->translations, state->rotations, state->scales, state->matrices.data()); clobberMemory(); });
+		registry.add(prefix + "composeTRS_affine", count, partsBytes + sizeof(Matrix<T, 3, 4>), [state]() { composeTRS(state->translations, state->rotations, state->scales, state->affine.data()); clobberMemory(); });
+
+		// what composeTRS replaces: three matrices and two products per element
+		registry.add(prefix + "compose_products", count, partsBytes + sizeof(Matrix<T, 4, 4>), [state]()
+		{
+			for (size_t i = 0; i < state->matrices.size(); i++)
+			{
+				Vector<T, 3> scaling = state->scales.get(i);
+				Vector<T, 4> scaling4 = { scaling[0], scaling[1], scaling[2], T(1) };
+				state->matrices[i] = translation(state->translations.get(i)) * Quaternion<T>(state->rotations.get(i)).toRotationMatrix() * scale(scaling4);
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "decomposeTRS", count, partsBytes + sizeof(Matrix<T, 4, 4>), [state]() { decomposeTRS(state->matrices.data(), state->matrices.size(), state->translations, state->rotations, state->scales); clobberMemory(); });
+	}
+
+	// Vector3 positions packed into storage type S and widened back, one op is one vector
+	template<typename S>
+	void registerStorageOps(BenchmarkRegistry& registry, const std::string& name, size_t count)
+	{
+		const std::string prefix = "Vector<" + name + ",3>[" + std::to_string(count) + "]/";
+
+		struct State
+		{
+			std::vector<Vector3<float>> floats;
+			std::vector<Vector<S, 3>> packed;
+		};
+
+		std::mt19937 engine(1234);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		auto state = std::make_shared<State>();
+		state->floats.resize(count);
+		state->packed.resize(count);
+
+		for (Vector3<float>& v : state->floats)
+		{
+			v = Vector3<float>(distribution(engine), distribution(engine), distribution(engine));
+		}
+
+		const double bytes = double(3 * (sizeof(float) + sizeof(S)));
+
+		registry.add(prefix + "encode", count, bytes, [state]() { convert(state->floats.data(), state->packed.data(), state->floats.size()); clobberMemory(); });
+		registry.add(prefix + "decode", count, bytes, [state]() { convert(state->packed.data(), state->floats.data(), state->packed.size()); clobberMemory(); });
+
+		// per-element conversion through the converting constructor, what the bulk kernels replace
+		registry.add(prefix + "encode_loop", count, bytes, [state]()
+		{
+			for (size_t i = 0; i < state->floats.size(); i++)
+			{
+				state->packed[i] = Vector<S, 3>(state->floats[i]);
+			}
+
+			clobberMemory();
+		});
+	}
+
+	// keyframe rotations in smallest-three form, one op is one quaternion
+	template<size_t Bits_C>
+	void registerCompressedQuaternionOps(BenchmarkRegistry& registry, size_t count)
+	{
+		const std::string prefix = "Quaternion" + std::to_string(Bits_C) + "[" + std::to_string(count) + "]/";
+
+		struct State
+		{
+			std::vector<Quaternion<float>> rotations;
+			std::vector<CompressedQuaternion<Bits_C>> compressed;
+			VectorArray<float, 4> lanes;
+		};
+
+		std::mt19937 engine(1234);
+		auto state = std::make_shared<State>();
+		state->lanes = makeArray<float, 4>(count, engine);
+		normalize(state->lanes);
+		state->rotations.resize(count);
+		state->compressed.resize(count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			state->rotations[i] = state->lanes.get(i);
+		}
+
+		compress(state->rotations.data(), state->compressed.data(), count);
+
+		const double bytes = double(sizeof(Quaternion<float>) + sizeof(CompressedQuaternion<Bits_C>));
+
+		registry.add(prefix + "compress", count, bytes, [state]() { compress(state->rotations.data(), state->compressed.data(), state->rotations.size()); clobberMemory(); });
+		registry.add(prefix + "decompress", count, bytes, [state]() { decompress(state->compressed.data(), state->rotations.data(), state->compressed.size()); clobberMemory(); });
+		registry.add(prefix + "decompress_soa", count, bytes, [state]() { decompress(state->compressed.data(), state->compressed.size(), state->lanes); clobberMemory(); });
+
+		registry.add(prefix + "decompress_loop", count, bytes, [state]()
+		{
+			for (size_t i = 0; i < state->compressed.size(); i++)
+			{
+				state->rotations[i] = state->compressed[i].decompress();
+			}
+
+			clobberMemory();
+		});
+	}
+
+	// per-frame scratch from the heap and from a FrameArena, and a stream transform over aligned and misaligned elements
+	void registerMemoryOps(BenchmarkRegistry& registry, size_t count)
+	{
+		const std::string prefix = "Memory[" + std::to_string(count) + "]/";
+
+		struct State
+		{
+			std::vector<Matrix<float, 4, 4>> a, b;
+			aligned_vector<AlignedVector4f> aligned, alignedOut;
+			aligned_vector<float> misaligned, misalignedOut; //Vector4f elements at a 4 byte offset, like after a leading float in a struct
+			FrameArena arena;
+		};
+
+		std::mt19937 engine(1234);
+		std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+		auto state = std::make_shared<State>();
+		state->a.resize(count);
+		state->b.resize(count);
+		state->aligned.resize(count);
+		state->alignedOut.resize(count);
+		state->misaligned.resize(count * 4 + 4);
+		state->misalignedOut.resize(count * 4 + 4);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			for (size_t k = 0; k < 16; k++)
+			{
+				state->a[i].data[k] = value(engine);
+				state->b[i].data[k] = value(engine);
+			}
+
+			state->aligned[i] = Vector4<float>(value(engine), value(engine), value(engine), 1.0f);
+			std::memcpy(state->misaligned.data() + 1 + i * 4, state->aligned[i].data, sizeof(Vector4<float>));
+		}
+
+		const Matrix<float, 4, 4> matrix = state->a[0];
+		const double matrixBytes = double(3 * sizeof(Matrix<float, 4, 4>));
+
+		registry.add(prefix + "scratch_heap", count, matrixBytes, [state]()
+		{
+			std::vector<Matrix<float, 4, 4>> scratch(state->a.size());
+
+			for (size_t i = 0; i < scratch.size(); i++)
+			{
+				scratch[i] = state->a[i] * state->b[i];
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "scratch_arena", count, matrixBytes, [state]()
+		{
+			state->arena.reset();
+			Matrix<float, 4, 4>* scratch = state->arena.allocate<Matrix<float, 4, 4>>(state->a.size());
+
+			for (size_t i = 0; i < state->a.size(); i++)
+			{
+				scratch[i] = state->a[i] * state->b[i];
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "transformVectors_aligned", count, 2 * sizeof(Vector4<float>), [state, matrix]()
+		{
+			transformVectors(matrix, state->aligned.data(), state->alignedOut.data(), state->aligned.size());
+			clobberMemory();
+		});
+
+		registry.add(prefix + "transformVectors_misaligned", count, 2 * sizeof(Vector4<float>), [state, matrix, count]()
+		{
+			const Vector4<float>* src = reinterpret_cast<const Vector4<float>*>(state->misaligned.data() + 1);
+			transformVectors(matrix, src, reinterpret_cast<Vector4<float>*>(state->misalignedOut.data() + 1), count);
+			clobberMemory();
+		});
+	}
+
+	// an instance transform table loaded from text, through ArchiveReader and through a mapping, one op is one matrix
+	void registerArchiveOps(BenchmarkRegistry& registry, size_t count)
+	{
+		const std::string prefix = "Archive[" + std::to_string(count) + "]/";
+
+		struct State
+		{
+			std::string path;
+			std::string text;
+			std::vector<Matrix<float, 4, 4>> matrices, loaded;
+		};
+
+		std::mt19937 engine(1234);
+		std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+		auto state = std::make_shared<State>();
+		state->path = (std::filesystem::temp_directory_path() / "abstractmath_bench.amarchive").string();
+		state->matrices.resize(count);
+
+		for (Matrix<float, 4, 4>& matrix : state->matrices)
+		{
+			for (float& element : matrix.data)
+			{
+				element = value(engine);
+				state->text += std::to_string(element) + ' ';
+			}
+
+			state->text += '\n';
+		}
+
+		ArchiveWriter(state->path.c_str()).writeArray("instances", state->matrices.data(), count);
+		const double bytes = double(sizeof(Matrix<float, 4, 4>));
+
+		registry.add(prefix + "load_text", count, bytes, [state]()
+		{
+			state->loaded.clear();
+			const char* cursor = state->text.c_str();
+			char* end = nullptr;
+
+			while (*cursor != 0)
+			{
+				Matrix<float, 4, 4> matrix;
+
+				for (float& element : matrix.data)
+				{
+					element = std::strtof(cursor, &end);
+					cursor = end;
+				}
+
+				state->loaded.push_back(matrix);
+
+				while (*cursor == ' ' || *cursor == '\n')
+				{
+					cursor++;
+				}
+			}
+
+			clobberMemory();
+		});
+
+		registry.add(prefix + "load_stream", count, bytes, [state]()
+		{
+			ArchiveReader reader(state->path.c_str());
+			state->loaded.resize(size_t(reader.descriptor(0).count));
+			reader.read(0, 0, state->loaded.size(), state->loaded.data());
+			clobberMemory();
+		});
+
+		// open, validate and touch every matrix in place, no copy
+		registry.add(prefix + "load_mapped", count, bytes, [state]()
+		{
+			MappedArchive archive(state->path.c_str());
+			float sum = 0.0f;
+
+			for (const Matrix<float, 4, 4>& matrix : archive.array<Matrix<float, 4, 4>>("instances"))
+			{
+				sum += matrix.data[12];
+			}
+
+			state->loaded[0].data[0] = sum;
+			clobberMemory();
+		});
+
+		registry.add(prefix + "verify", count, bytes, [state]()
+		{
+			MappedArchive archive(state->path.c_str());
+			state->loaded[0].data[0] = archive.verify(0) ? 1.0f : 0.0f;
+			clobberMemory();
+		});
+
+		registry.add(prefix + "write", count, bytes, [state]()
+		{
+			ArchiveWriter(state->path.c_str()).writeArray("instances", state->matrices.data(), state->matrices.size());
+			clobberMemory();
+		});
+	}
+
+	// a wide, shallow scene of random recursive trees (about a dozen levels) under 100 roots, one op is one node
+	template<typename T>
+	void registerHierarchyOps(BenchmarkRegistry& registry, size_t count)
+	{
+		const std::string prefix = std::string("TransformHierarchy<") + TypeName<T>::get() + ">[" + std::to_string(count) + "]/";
+
+		std::mt19937 engine(1234);
+		std::uniform_real_distribution<T> offset(T(-1), T(1));
+		auto hierarchy = std::make_shared<TransformHierarchy<T>>();
+
+		for (size_t i = 0; i < count; i++)
+		{
+			uint32_t parent = i < 100 ? TransformHierarchy<T>::NO_PARENT : uint32_t(engine() % i);
+			hierarchy->addNode(parent, Vector3<T>(offset(engine), offset(engine), offset(engine)), Quaternion<T>(Vector3<T>(T(0), T(1), T(0)), offset(engine)));
+		}
+
+		hierarchy->update();
+		const double matrixBytes = double(sizeof(Matrix<T, 4, 4>));
+
+		auto touchAll = [hierarchy]()
+		{
+			for (uint32_t node = 0; node < hierarchy->size(); node++)
+			{
+				hierarchy->setScale(node, Vector3<T>(T(1), T(1), T(1)));
+			}
+		};
+
+		registry.add(prefix + "update_all", count, matrixBytes, [hierarchy, touchAll]() { touchAll(); hierarchy->update(); clobberMemory(); });
+		registry.add(prefix + "updateParallel_all", count, matrixBytes, [hierarchy, touchAll]() { touchAll(); hierarchy->updateParallel(); clobberMemory(); });
+		registry.add(prefix + "update_clean", count, 0, [hierarchy]() { hierarchy->update(); clobberMemory(); });
+
+		registry.add(prefix + "update_one_percent", count, matrixBytes, [hierarchy]()
+		{
+			//mostly leaves and small subtrees, like animated props in a static scene
+			for (uint32_t node = uint32_t(hierarchy->size() / 2); node < hierarchy->size(); node += 50)
+			{
+				hierarchy->setTranslation(node, hierarchy->translation(node));
+			}
+
+			hierarchy->update();
+			clobberMemory();
+		});
+	}
+
+	void registerBatchBenchmarks(BenchmarkRegistry& registry)
+	{
+		for (size_t count : { size_t(1024), size_t(65536), size_t(1) << 20 })
+		{
+			registerVectorArrayOps<float, 3>(registry, count);
+			registerVectorArrayOps<float, 4>(registry, count);
+			registerVectorArrayOps<double, 3>(registry, count);
+			registerTransformOps<float>(registry, count);
+			registerTransformOps<double>(registry, count);
+		}
+
+		registerParallelOps<float>(registry, 1 << 20);
+		registerParallelOps<double>(registry, 1 << 20);
+
+		registerFrustumOps<float>(registry, 200000);
+		registerFrustumOps<double>(registry, 200000);
+
+		registerIntersectionOps<float>(registry, 4096, 256);
+		registerIntersectionOps<double>(registry, 4096, 256);
+		registerBvhOps<float>(registry, 708, 16384);
+		registerBvhOps<double>(registry, 708, 16384);
+
+		registerRotationBlendOps<float>(registry, 150 * 2000);
+		registerRotationBlendOps<double>(registry, 150 * 2000);
+
+		registerTRSOps<float>(registry, 65536);
+		registerTRSOps<double>(registry, 65536);
+
+		registerStorageOps<half>(registry, "half", 1 << 20);
+		registerStorageOps<snorm16>(registry, "snorm16", 1 << 20);
+		registerStorageOps<unorm8>(registry, "unorm8", 1 << 20);
+
+		registerCompressedQuaternionOps<32>(registry, 1 << 20);
+		registerCompressedQuaternionOps<48>(registry, 1 << 20);
+
+		registerMemoryOps(registry, 65536);
+		registerArchiveOps(registry, 1 << 18);
+
+		registerHierarchyOps<float>(registry, 100000);
+		registerHierarchyOps<double>(registry, 100000);
+
+		for (size_t n : { size_t(64), size_t(256), size_t(512), size_t(1024) })
+		{
+			registerGemm<float>(registry, n, n <= 512);
+			registerGemm<double>(registry, n, n <= 512);
+		}
+
+		registerSparseOps<float>(registry, 512);
+		registerSparseOps<double>(registry, 512);
+
+		registerSolverOps<float, 3>(registry, 50000);
+		registerSolverOps<float, 6>(registry, 50000);
+		registerSolverOps<double, 6>(registry, 50000);
+		registerSolverOps<float, 12>(registry, 50000);
+
+		registerDecompositionOps<float>(registry, 50000);
+		registerDecompositionOps<double>(registry, 50000);
+	}
+} }
\ No newline at end of file
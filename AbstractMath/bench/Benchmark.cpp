@@ -0,0 +1,124 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace AbstractMath { namespace Bench {
+
+	static double secondsFor(const Benchmark& benchmark, size_t iterations)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		for (size_t i = 0; i < iterations; i++)
+		{
+			benchmark.run();
+		}
+
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double>(end - start).count();
+	}
+
+	BenchmarkResult measure(const Benchmark& benchmark, double minSeconds, size_t repetitions)
+	{
+		benchmark.run(); //warm caches and first-touch allocations
+
+		// double the iteration count until one repetition is long enough to time reliably
+		size_t iterations = 1;
+		double elapsed = secondsFor(benchmark, iterations);
+
+		while (elapsed < minSeconds && iterations < (size_t(1) << 40))
+		{
+			size_t scale = elapsed <= 0.0 ? 10 : std::min<size_t>(10, std::max<size_t>(2, size_t(minSeconds / elapsed * 1.2)));
+			iterations *= scale;
+			elapsed = secondsFor(benchmark, iterations);
+		}
+
+		std::vector<double> samples;
+		samples.push_back(elapsed);
+
+		for (size_t i = 1; i < repetitions; i++)
+		{
+			samples.push_back(secondsFor(benchmark, iterations));
+		}
+
+		std::sort(samples.begin(), samples.end());
+		double median = samples[samples.size() / 2];
+		double ops = double(iterations) * double(benchmark.opsPerRun);
+
+		BenchmarkResult result;
+		result.name = benchmark.name;
+		result.nsPerOp = median / ops * 1e9;
+		result.opsPerSecond = ops / median;
+		result.bytesPerSecond = result.opsPerSecond * benchmark.bytesPerOp;
+		result.gflops = result.opsPerSecond * benchmark.flopsPerOp / 1e9;
+		result.iterations = iterations;
+		return result;
+	}
+
+	std::string toJson(const std::vector<BenchmarkResult>& results)
+	{
+		std::ostringstream out;
+		out.precision(6);
+		out << "{\n  \"version\": 1,\n  \"benchmarks\": [\n";
+
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const BenchmarkResult& r = results[i];
+			out << "    { \"name\": \"" << r.name << "\", \"ns_per_op\": " << r.nsPerOp
+				<< ", \"ops_per_sec\": " << r.opsPerSecond << ", \"bytes_per_sec\": " << r.bytesPerSecond;
+
+			if (r.gflops > 0.0)
+			{
+				out << ", \"gflops\": " << r.gflops;
+			}
+
+			out << ", \"iterations\": " << r.iterations << " }" << (i + 1 < results.size() ? ",\n" : "\n");
+		}
+
+		out << "  ]\n}\n";
+		return out.str();
+	}
+
+	// only understands the flat layout toJson writes, which is all a baseline ever is
+	std::vector<std::pair<std::string, double>> readBaseline(const std::string& path)
+	{
+		std::vector<std::pair<std::string, double>> entries;
+		std::ifstream file(path);
+
+		if (!file)
+		{
+			return entries;
+		}
+
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+		std::string text = buffer.str();
+
+		const std::string nameKey = "\"name\": \"";
+		const std::string timeKey = "\"ns_per_op\": ";
+		size_t position = 0;
+
+		while ((position = text.find(nameKey, position)) != std::string::npos)
+		{
+			size_t nameStart = position + nameKey.size();
+			size_t nameEnd = text.find('"', nameStart);
+			size_t timeStart = text.find(timeKey, nameEnd);
+
+			if (nameEnd == std::string::npos || timeStart == std::string::npos)
+			{
+				break;
+			}
+
+			timeStart += timeKey.size();
+			entries.emplace_back(text.substr(nameStart, nameEnd - nameStart), std::strtod(text.c_str() + timeStart, nullptr));
+			position = timeStart;
+		}
+
+		return entries;
+	}
+} }
\ No newline at end of file
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <random>
+#include <type_traits>
+
+namespace AbstractMath { namespace Bench {
+
+	// one measurable unit of work: every call of run performs opsPerRun operations
+	struct Benchmark
+	{
+		std::string name;
+		size_t opsPerRun;
+		double bytesPerOp;
+		double flopsPerOp; //zero when flops are not meaningful for the operation
+		std::function<void()> run;
+	};
+
+	struct BenchmarkResult
+	{
+		std::string name;
+		double nsPerOp;
+		double opsPerSecond;
+		double bytesPerSecond;
+		double gflops;
+		size_t iterations;
+	};
+
+	class BenchmarkRegistry
+	{
+	public:
+		void add(const std::string& name, size_t opsPerRun, double bytesPerOp, std::function<void()> run, double flopsPerOp = 0.0)
+		{
+			benchmarks.push_back({ name, opsPerRun, bytesPerOp, flopsPerOp, std::move(run) });
+		}
+
+		const std::vector<Benchmark>& all() const { return benchmarks; }
+
+	private:
+		std::vector<Benchmark> benchmarks;
+	};
+
+	BenchmarkResult measure(const Benchmark& benchmark, double minSeconds, size_t repetitions);
+
+	std::string toJson(const std::vector<BenchmarkResult>& results);
+
+	// name -> ns/op pairs from a file written by toJson, empty when the file can not be read
+	std::vector<std::pair<std::string, double>> readBaseline(const std::string& path);
+
+	// keeps the optimizer from discarding results without adding any instructions of its own
+	template<typename T>
+	inline void doNotOptimize(const T& value)
+	{
+#if defined(_MSC_VER)
+		static volatile const void* sink;
+		sink = &value;
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+
+	inline void clobberMemory()
+	{
+#if defined(_MSC_VER)
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+#else
+		asm volatile("" : : : "memory");
+#endif
+	}
+
+	template<typename T> struct TypeName;
+	template<> struct TypeName<float> { static const char* get() { return "float"; } };
+	template<> struct TypeName<double> { static const char* get() { return "double"; } };
+	template<> struct TypeName<int> { static const char* get() { return "int"; } };
+
+	// elements processed by every element-wise run, small enough to stay in L1 for all the types we cover
+	static const size_t BATCH = 256;
+
+	template<typename T>
+	inline T randomScalar(std::mt19937& engine)
+	{
+		if constexpr (std::is_floating_point<T>::value)
+		{
+			return std::uniform_real_distribution<T>(T(0.5), T(2))(engine);
+		}
+		else
+		{
+			return std::uniform_int_distribution<T>(1, 100)(engine);
+		}
+	}
+
+	template<typename T>
+	inline void randomize(T* data, size_t count, std::mt19937& engine)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			data[i] = randomScalar<T>(engine);
+		}
+	}
+
+	// registers out[i] = op(a[i]) over BATCH random inputs, make(engine) produces one input
+	template<typename A, typename Make, typename Op>
+	void addUnary(BenchmarkRegistry& registry, const std::string& name, Make make, Op op)
+	{
+		using R = typename std::decay<decltype(op(std::declval<A&>()))>::type;
+
+		struct State
+		{
+			std::vector<A> a;
+			std::unique_ptr<R[]> out;
+		};
+
+		auto state = std::make_shared<State>();
+		std::mt19937 engine(1234);
+
+		for (size_t i = 0; i < BATCH; i++)
+		{
+			state->a.push_back(make(engine));
+		}
+
+		state->out.reset(new R[BATCH]);
+
+		registry.add(name, BATCH, double(sizeof(A) + sizeof(R)), [state, op]()
+		{
+			for (size_t i = 0; i < BATCH; i++)
+			{
+				state->out[i] = op(state->a[i]);
+			}
+
+			doNotOptimize(state->out[BATCH - 1]);
+			clobberMemory();
+		});
+	}
+
+	template<typename A, typename B, typename MakeA, typename MakeB, typename Op>
+	void addBinary(BenchmarkRegistry& registry, const std::string& name, MakeA makeA, MakeB makeB, Op op)
+	{
+		using R = typename std::decay<decltype(op(std::declval<A&>(), std::declval<B&>()))>::type;
+
+		struct State
+		{
+			std::vector<A> a;
+			std::vector<B> b;
+			std::unique_ptr<R[]> out;
+		};
+
+		auto state = std::make_shared<State>();
+		std::mt19937 engine(1234);
+
+		for (size_t i = 0; i < BATCH; i++)
+		{
+			state->a.push_back(makeA(engine));
+			state->b.push_back(makeB(engine));
+		}
+
+		state->out.reset(new R[BATCH]);
+
+		registry.add(name, BATCH, double(sizeof(A) + sizeof(B) + sizeof(R)), [state, op]()
+		{
+			for (size_t i = 0; i < BATCH; i++)
+			{
+				state->out[i] = op(state->a[i], state->b[i]);
+			}
+
+			doNotOptimize(state->out[BATCH - 1]);
+			clobberMemory();
+		});
+	}
+
+	// in-place variant, op(a[i], b[i]) mutates a[i]
+	// a is restored from its initial values before every run (and that copy is timed too) so repeated
+	// runs never drift into overflow or denormals
+	template<typename A, typename B, typename MakeA, typename MakeB, typename Op>
+	void addInPlace(BenchmarkRegistry& registry, const std::string& name, MakeA makeA, MakeB makeB, Op op)
+	{
+		struct State
+		{
+			std::vector<A> initial;
+			std::vector<A> a;
+			std::vector<B> b;
+		};
+
+		auto state = std::make_shared<State>();
+		std::mt19937 engine(1234);
+
+		for (size_t i = 0; i < BATCH; i++)
+		{
+			state->initial.push_back(makeA(engine));
+			state->b.push_back(makeB(engine));
+		}
+
+		state->a = state->initial;
+
+		registry.add(name, BATCH, double(3 * sizeof(A) + sizeof(B)), [state, op]()
+		{
+			for (size_t i = 0; i < BATCH; i++)
+			{
+				state->a[i] = state->initial[i];
+				op(state->a[i], state->b[i]);
+			}
+
+			doNotOptimize(state->a[BATCH - 1]);
+			clobberMemory();
+		});
+	}
+
+	void registerVectorBenchmarks(BenchmarkRegistry& registry);
+	void registerMatrixBenchmarks(BenchmarkRegistry& registry);
+	void registerQuaternionBenchmarks(BenchmarkRegistry& registry);
+	void registerBatchBenchmarks(BenchmarkRegistry& registry);
+} }
\ No newline at end of file
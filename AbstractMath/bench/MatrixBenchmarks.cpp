@@ -0,0 +1,151 @@
+#include "Benchmark.h"
+
+#include "AbstractMath.h"
+
+namespace AbstractMath { namespace Bench {
+
+	template<typename T, size_t R, size_t C>
+	Matrix<T, R, C> makeMatrix(std::mt19937& engine)
+	{
+		Matrix<T, R, C> result;
+		randomize(result.data, R * C, engine);
+		return result;
+	}
+
+	// diagonally dominant so every inverse is well conditioned
+	template<typename T, size_t N>
+	Matrix<T, N, N> makeInvertible(std::mt19937& engine)
+	{
+		Matrix<T, N, N> result = makeMatrix<T, N, N>(engine);
+
+		for (size_t i = 0; i < N; i++)
+		{
+			result.data[i * N + i] += T(4 * N);
+		}
+
+		return result;
+	}
+
+	template<typename T>
+	Matrix<T, 4, 4> makeRigid(std::mt19937& engine)
+	{
+		Vector<T, 3> axis = Vector<T, 3>{ randomScalar<T>(engine), randomScalar<T>(engine), randomScalar<T>(engine) }.normalized();
+		Quaternion<T> rotation(axis, randomScalar<T>(engine));
+		Matrix<T, 4, 4> move;
+		translation(move, Vector<T, 3>{ randomScalar<T>(engine), randomScalar<T>(engine), randomScalar<T>(engine) });
+		return move * rotation.toRotationMatrix();
+	}
+
+	template<typename T>
+	Matrix<T, 4, 4> makeAffine(std::mt19937& engine)
+	{
+		Matrix<T, 4, 4> size;
+		scale(size, Vector<T, 4>{ randomScalar<T>(engine), randomScalar<T>(engine), randomScalar<T>(engine), T(1) });
+		return makeRigid<T>(engine) * size;
+	}
+
+	template<typename T, size_t R, size_t C>
+	void registerMatrixShape(BenchmarkRegistry& registry)
+	{
+		using M = Matrix<T, R, C>;
+		const std::string prefix = std::string("Matrix<") + TypeName<T>::get() + "," + std::to_string(R) + "," + std::to_string(C) + ">/";
+		auto make = makeMatrix<T, R, C>;
+		auto makeColumns = makeMatrix<T, C, R>;
+		auto makeSquare = makeMatrix<T, C, C>;
+		auto makeVec = [](std::mt19937& engine) { Vector<T, C> v; randomize(v.data, C, engine); return v; };
+
+		addUnary<M>(registry, prefix + "copy", make, [](const M& a) { return M(a); });
+		addUnary<M>(registry, prefix + "convert_double", make, [](const M& a) { return Matrix<double, R, C>(a); });
+		addUnary<M>(registry, prefix + "column", make, [](M& a) { return a[C - 1]; });
+		addUnary<M>(registry, prefix + "transposed", make, [](const M& a) { return a.transposed(); });
+		addBinary<M, Matrix<T, C, R>>(registry, prefix + "multiply_matrix", make, makeColumns, [](const M& a, const Matrix<T, C, R>& b) { return a * b; });
+		addBinary<M, Matrix<T, C, C>>(registry, prefix + "multiply_square", make, makeSquare, [](const M& a, const Matrix<T, C, C>& b) { return a * b; });
+		addBinary<M, Vector<T, C>>(registry, prefix + "multiply_vector", make, makeVec, [](const M& a, const Vector<T, C>& b) { return a * b; });
+	}
+
+	template<typename T, size_t N>
+	void registerSquareOps(BenchmarkRegistry& registry)
+	{
+		using M = Matrix<T, N, N>;
+		const std::string prefix = std::string("Matrix<") + TypeName<T>::get() + "," + std::to_string(N) + "," + std::to_string(N) + ">/";
+		auto make = makeMatrix<T, N, N>;
+		auto makeDummy = [](std::mt19937&) { return 0; };
+		auto makeScale = [](std::mt19937& engine) { Vector<T, N> v; randomize(v.data, N, engine); return v; };
+
+		registerMatrixShape<T, N, N>(registry);
+
+		addUnary<M>(registry, prefix + "determinant", make, [](const M& a) { return a.determinant(); });
+		addInPlace<M, int>(registry, prefix + "identity", make, makeDummy, [](M& a, int) { identity(a); });
+		addInPlace<M, Vector<T, N>>(registry, prefix + "scale", make, makeScale, [](M& a, const Vector<T, N>& b) { scale(a, b); });
+
+		// a translation needs at least a two element offset
+		if constexpr (N > 2)
+		{
+			auto makeOffset = [](std::mt19937& engine) { Vector<T, N - 1> v; randomize(v.data, N - 1, engine); return v; };
+			addInPlace<M, Vector<T, N - 1>>(registry, prefix + "translation", make, makeOffset, [](M& a, const Vector<T, N - 1>& b) { translation(a, b); });
+		}
+
+		if constexpr (std::is_floating_point<T>::value)
+		{
+			addUnary<M>(registry, prefix + "inverted", makeInvertible<T, N>, [](const M& a) { return a.inverted(); });
+		}
+	}
+
+	template<typename T>
+	void registerProjectionOps(BenchmarkRegistry& registry)
+	{
+		using P = Vector<T, 4>;
+		const std::string prefix = std::string("Matrix<") + TypeName<T>::get() + ",4,4>/";
+		auto makeParams = [](std::mt19937& engine) { P p; randomize(p.data, 4, engine); return p; };
+
+		addUnary<Matrix<T, 4, 4>>(registry, prefix + "affine_inverse", makeAffine<T>, [](const Matrix<T, 4, 4>& a) { return a.affineInverse(); });
+		addUnary<Matrix<T, 4, 4>>(registry, prefix + "orthonormal_inverse", makeRigid<T>, [](const Matrix<T, 4, 4>& a) { return a.orthonormalInverse(); });
+
+		addUnary<P>(registry, prefix + "perspective", makeParams, [](const P& p) { return perspective(p[0], p[1], p[2] * T(0.1), p[3] * T(100)); });
+		addUnary<P>(registry, prefix + "perspectiveOGL", makeParams, [](const P& p) { return perspectiveOGL(p[0], p[1], p[2] * T(0.1), p[3] * T(100)); });
+		addUnary<P>(registry, prefix + "orthographic", makeParams, [](const P& p) { return orthographic(-p[0], p[0], -p[1], p[1], p[2] * T(0.1), p[3] * T(100)); });
+		addUnary<P>(registry, prefix + "orthographicOGL", makeParams, [](const P& p) { return orthographicOGL(-p[0], p[0], -p[1], p[1], p[2] * T(0.1), p[3] * T(100)); });
+	}
+
+	// counterparts of the Matrix<T,4,4> multiply, multiply_vector, affine_inverse and orthonormal_inverse entries
+	template<typename T>
+	void registerAffineOps(BenchmarkRegistry& registry)
+	{
+		using A = AffineMatrix<T>;
+		using V = Vector<T, 3>;
+		const std::string prefix = std::string("AffineMatrix<") + TypeName<T>::get() + ">/";
+		auto make = [](std::mt19937& engine) { return A(makeAffine<T>(engine)); };
+		auto makeRigidAffine = [](std::mt19937& engine) { return A(makeRigid<T>(engine)); };
+		auto makeVec = [](std::mt19937& engine) { V v; randomize(v.data, 3, engine); return v; };
+
+		addBinary<A, A>(registry, prefix + "multiply", make, make, [](const A& a, const A& b) { return a * b; });
+		addBinary<A, V>(registry, prefix + "transformPoint", make, makeVec, [](const A& a, const V& b) { return a.transformPoint(b); });
+		addBinary<A, V>(registry, prefix + "transformDirection", make, makeVec, [](const A& a, const V& b) { return a.transformDirection(b); });
+		addUnary<A>(registry, prefix + "inverted", make, [](const A& a) { return a.inverted(); });
+		addUnary<A>(registry, prefix + "orthonormal_inverse", makeRigidAffine, [](const A& a) { return a.orthonormalInverse(); });
+		addUnary<A>(registry, prefix + "toMatrix4", make, [](const A& a) { return a.toMatrix4(); });
+	}
+
+	template<typename T>
+	void registerMatrixType(BenchmarkRegistry& registry)
+	{
+		registerSquareOps<T, 2>(registry);
+		registerSquareOps<T, 3>(registry);
+		registerSquareOps<T, 4>(registry);
+		registerMatrixShape<T, 3, 4>(registry);
+
+		if constexpr (std::is_floating_point<T>::value)
+		{
+			registerSquareOps<T, 8>(registry);
+			registerProjectionOps<T>(registry);
+			registerAffineOps<T>(registry);
+		}
+	}
+
+	void registerMatrixBenchmarks(BenchmarkRegistry& registry)
+	{
+		registerMatrixType<float>(registry);
+		registerMatrixType<double>(registry);
+		registerMatrixType<int>(registry);
+	}
+} }
\ No newline at end of file
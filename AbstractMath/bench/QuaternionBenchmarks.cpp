@@ -0,0 +1,68 @@
+#include "Benchmark.h"
+
+#include "AbstractMath.h"
+
+namespace AbstractMath { namespace Bench {
+
+	template<typename T>
+	Vector<T, 3> makeAxis(std::mt19937& engine)
+	{
+		Vector<T, 3> axis;
+		randomize(axis.data, 3, engine);
+		return axis.normalized();
+	}
+
+	template<typename T>
+	Quaternion<T> makeRotation(std::mt19937& engine)
+	{
+		Vector<T, 3> axis = makeAxis<T>(engine);
+		return Quaternion<T>(axis, randomScalar<T>(engine));
+	}
+
+	template<typename T>
+	void registerQuaternionType(BenchmarkRegistry& registry)
+	{
+		using Q = Quaternion<T>;
+		using V = Vector<T, 3>;
+		const std::string prefix = std::string("Quaternion<") + TypeName<T>::get() + ">/";
+		auto make = makeRotation<T>;
+		auto makeVec = makeAxis<T>;
+		auto scalar = randomScalar<T>;
+
+		addBinary<V, T>(registry, prefix + "axis_angle", makeVec, scalar, [](const V& axis, T angle) { return Q(axis, angle); });
+		addBinary<V, T>(registry, prefix + "axis_angle_fast", makeVec, scalar, [](const V& axis, T angle) { return Q::template fromAxisAngle<Fast>(axis, angle); });
+		addBinary<V, T>(registry, prefix + "axis_angle_approx", makeVec, scalar, [](const V& axis, T angle) { return Q::template fromAxisAngle<Approx>(axis, angle); });
+		addUnary<Q>(registry, prefix + "conjugate", make, [](const Q& a) { return a.conjugate(); });
+		addBinary<Q, Q>(registry, prefix + "multiply", make, make, [](const Q& a, const Q& b) { return a * b; });
+		addBinary<Q, V>(registry, prefix + "multiply_vector", make, makeVec, [](const Q& a, const V& b) { return a * b; });
+		addBinary<Q, Q>(registry, prefix + "divide", make, make, [](const Q& a, const Q& b) { return a / b; });
+		addInPlace<Q, Q>(registry, prefix + "multiply_assign", make, make, [](Q& a, const Q& b) { a *= b; });
+		addInPlace<Q, Q>(registry, prefix + "divide_assign", make, make, [](Q& a, const Q& b) { a /= b; });
+		addBinary<Q, V>(registry, prefix + "rotate", make, makeVec, [](const Q& a, const V& b) { return a.rotate(b); });
+		addUnary<Q>(registry, prefix + "eulerAngles", make, [](const Q& a) { return a.eulerAngles(); });
+		addUnary<Q>(registry, prefix + "eulerAngles_fast", make, [](const Q& a) { return a.template eulerAngles<Fast>(); });
+		addUnary<Q>(registry, prefix + "eulerAngles_approx", make, [](const Q& a) { return a.template eulerAngles<Approx>(); });
+		addUnary<Q>(registry, prefix + "getRoll", make, [](const Q& a) { return a.getRoll(); });
+		addUnary<Q>(registry, prefix + "getPitch", make, [](const Q& a) { return a.getPitch(); });
+		addUnary<Q>(registry, prefix + "getYaw", make, [](const Q& a) { return a.getYaw(); });
+		addUnary<Q>(registry, prefix + "getRight", make, [](const Q& a) { return a.getRight(); });
+		addUnary<Q>(registry, prefix + "getLeft", make, [](const Q& a) { return a.getLeft(); });
+		addUnary<Q>(registry, prefix + "getUp", make, [](const Q& a) { return a.getUp(); });
+		addUnary<Q>(registry, prefix + "getDown", make, [](const Q& a) { return a.getDown(); });
+		addUnary<Q>(registry, prefix + "getForward", make, [](const Q& a) { return a.getForward(); });
+		addUnary<Q>(registry, prefix + "getForward_fast", make, [](const Q& a) { return a.template getForward<Fast>(); });
+		addUnary<Q>(registry, prefix + "getBack", make, [](const Q& a) { return a.getBack(); });
+		addUnary<Q>(registry, prefix + "normalized", make, [](const Q& a) { return a.normalized(); });
+		addUnary<Q>(registry, prefix + "normalized_fast", make, [](const Q& a) { return a.template normalized<Fast>(); });
+		addBinary<Q, Q>(registry, prefix + "nlerp", make, make, [](const Q& a, const Q& b) { return a.nlerp(b, 0.25); });
+		addBinary<Q, Q>(registry, prefix + "slerp", make, make, [](const Q& a, const Q& b) { return a.slerp(b, 0.25); });
+		addBinary<Q, Q>(registry, prefix + "fastSlerp", make, make, [](const Q& a, const Q& b) { return a.fastSlerp(b, 0.25); });
+		addUnary<Q>(registry, prefix + "toRotationMatrix", make, [](Q& a) { return a.toRotationMatrix(); });
+	}
+
+	void registerQuaternionBenchmarks(BenchmarkRegistry& registry)
+	{
+		registerQuaternionType<float>(registry);
+		registerQuaternionType<double>(registry);
+	}
+} }
\ No newline at end of file
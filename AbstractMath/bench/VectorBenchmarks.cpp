@@ -0,0 +1,87 @@
+#include "Benchmark.h"
+
+#include "AbstractMath.h"
+
+namespace AbstractMath { namespace Bench {
+
+	template<typename T, size_t C>
+	Vector<T, C> makeVector(std::mt19937& engine)
+	{
+		Vector<T, C> result;
+		randomize(result.data, C, engine);
+		return result;
+	}
+
+	template<typename T, size_t C>
+	void registerVectorOps(BenchmarkRegistry& registry)
+	{
+		using V = Vector<T, C>;
+		const std::string prefix = std::string("Vector<") + TypeName<T>::get() + "," + std::to_string(C) + ">/";
+		auto make = makeVector<T, C>;
+		auto scalar = randomScalar<T>;
+
+		addUnary<V>(registry, prefix + "copy", make, [](const V& a) { return V(a); });
+		addUnary<V>(registry, prefix + "construct_pointer", make, [](const V& a) { return V(a.data, sizeof(T) * C); });
+		addUnary<V>(registry, prefix + "convert_double", make, [](const V& a) { return Vector<double, C>(a); });
+		addUnary<V>(registry, prefix + "index", make, [](const V& a) { return a[C - 1]; });
+		addUnary<V>(registry, prefix + "negate", make, [](const V& a) { return -a; });
+
+		addBinary<V, V>(registry, prefix + "add", make, make, [](const V& a, const V& b) { return a + b; });
+		addBinary<V, V>(registry, prefix + "subtract", make, make, [](const V& a, const V& b) { return a - b; });
+		addBinary<V, V>(registry, prefix + "multiply", make, make, [](const V& a, const V& b) { return a * b; });
+		addBinary<V, V>(registry, prefix + "divide", make, make, [](const V& a, const V& b) { return a / b; });
+
+		addBinary<V, T>(registry, prefix + "add_scalar", make, scalar, [](const V& a, T b) { return a + b; });
+		addBinary<V, T>(registry, prefix + "subtract_scalar", make, scalar, [](const V& a, T b) { return a - b; });
+		addBinary<V, T>(registry, prefix + "multiply_scalar", make, scalar, [](const V& a, T b) { return a * b; });
+		addBinary<V, T>(registry, prefix + "divide_scalar", make, scalar, [](const V& a, T b) { return a / b; });
+
+		addInPlace<V, V>(registry, prefix + "add_assign", make, make, [](V& a, const V& b) { a += b; });
+		addInPlace<V, V>(registry, prefix + "subtract_assign", make, make, [](V& a, const V& b) { a -= b; });
+		addInPlace<V, V>(registry, prefix + "multiply_assign", make, make, [](V& a, const V& b) { a *= b; });
+		addInPlace<V, V>(registry, prefix + "divide_assign", make, make, [](V& a, const V& b) { a /= b; });
+
+		addBinary<V, V>(registry, prefix + "less", make, make, [](const V& a, const V& b) { return a < b; });
+		addBinary<V, V>(registry, prefix + "greater", make, make, [](const V& a, const V& b) { return a > b; });
+		addBinary<V, V>(registry, prefix + "equal", make, make, [](const V& a, const V& b) { return a == b; });
+
+		addUnary<V>(registry, prefix + "length", make, [](const V& a) { return a.length(); });
+		addUnary<V>(registry, prefix + "normalized", make, [](const V& a) { return a.normalized(); });
+
+		if constexpr (std::is_floating_point<T>::value)
+		{
+			addUnary<V>(registry, prefix + "normalized_fast", make, [](const V& a) { return a.template normalized<Fast>(); });
+		}
+
+		addBinary<V, V>(registry, prefix + "dot", make, make, [](V& a, const V& b) { return a.dot(b); });
+		addBinary<V, V>(registry, prefix + "lerp", make, make, [](V& a, const V& b) { return a.lerp(b, 0.25); });
+	}
+
+	template<typename T>
+	void registerCrossOps(BenchmarkRegistry& registry)
+	{
+		const std::string name = TypeName<T>::get();
+		auto make2 = [](std::mt19937& engine) { return Vector2<T>(makeVector<T, 2>(engine)); };
+		auto make3 = [](std::mt19937& engine) { return Vector3<T>(makeVector<T, 3>(engine)); };
+
+		addBinary<Vector2<T>, Vector2<T>>(registry, "Vector2<" + name + ">/cross", make2, make2, [](Vector2<T>& a, const Vector2<T>& b) { return a.cross(b); });
+		addBinary<Vector3<T>, Vector3<T>>(registry, "Vector3<" + name + ">/cross", make3, make3, [](Vector3<T>& a, const Vector3<T>& b) { return a.cross(b); });
+	}
+
+	template<typename T>
+	void registerVectorType(BenchmarkRegistry& registry)
+	{
+		registerVectorOps<T, 2>(registry);
+		registerVectorOps<T, 3>(registry);
+		registerVectorOps<T, 4>(registry);
+		registerVectorOps<T, 8>(registry);
+		registerCrossOps<T>(registry);
+	}
+
+	void registerVectorBenchmarks(BenchmarkRegistry& registry)
+	{
+		registerVectorType<float>(registry);
+		registerVectorType<double>(registry);
+		registerVectorType<int>(registry);
+	}
+} }
\ No newline at end of file
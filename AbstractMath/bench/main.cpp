@@ -0,0 +1,147 @@
+#include "Benchmark.h"
+
+#include "Profiling.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace AbstractMath::Bench;
+
+static void printUsage()
+{
+	std::fprintf(stderr,
+		"usage: abstractmath_bench [options]\n"
+		"  --filter <text>      only run benchmarks whose name contains text\n"
+		"  --list               print benchmark names and exit\n"
+		"  --output <file>      write JSON results to file instead of stdout\n"
+		"  --baseline <file>    compare against a previous --output file, exit code 1 on regressions\n"
+		"  --threshold <ratio>  slowdown that counts as a regression (default 0.10)\n"
+		"  --min-time <ms>      minimum timed duration per repetition (default 20)\n"
+		"  --repetitions <n>    timed repetitions, the median is reported (default 5)\n"
+		"  --profile <file>     write the operation counters of the run as JSON (needs ABSTRACTMATH_PROFILE)\n");
+}
+
+int main(int argc, char** argv)
+{
+	std::string filter, outputPath, baselinePath, profilePath;
+	double threshold = 0.10;
+	double minSeconds = 0.02;
+	size_t repetitions = 5;
+	bool listOnly = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "--filter" && hasValue) { filter = argv[++i]; }
+		else if (arg == "--output" && hasValue) { outputPath = argv[++i]; }
+		else if (arg == "--baseline" && hasValue) { baselinePath = argv[++i]; }
+		else if (arg == "--threshold" && hasValue) { threshold = std::atof(argv[++i]); }
+		else if (arg == "--min-time" && hasValue) { minSeconds = std::atof(argv[++i]) / 1000.0; }
+		else if (arg == "--repetitions" && hasValue) { repetitions = std::max(1, std::atoi(argv[++i])); }
+		else if (arg == "--profile" && hasValue) { profilePath = argv[++i]; }
+		else if (arg == "--list") { listOnly = true; }
+		else
+		{
+			printUsage();
+			return arg == "--help" || arg == "-h" ? 0 : 2;
+		}
+	}
+
+	BenchmarkRegistry registry;
+	registerVectorBenchmarks(registry);
+	registerMatrixBenchmarks(registry);
+	registerQuaternionBenchmarks(registry);
+	registerBatchBenchmarks(registry);
+
+	std::vector<BenchmarkResult> results;
+
+	for (const Benchmark& benchmark : registry.all())
+	{
+		if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+		{
+			continue;
+		}
+
+		if (listOnly)
+		{
+			std::printf("%s\n", benchmark.name.c_str());
+			continue;
+		}
+
+		BenchmarkResult result = measure(benchmark, minSeconds, repetitions);
+		std::fprintf(stderr, "%-56s %12.3f ns/op\n", result.name.c_str(), result.nsPerOp);
+		results.push_back(result);
+	}
+
+	if (listOnly)
+	{
+		return 0;
+	}
+
+	std::string json = toJson(results);
+
+	if (outputPath.empty())
+	{
+		std::fputs(json.c_str(), stdout);
+	}
+	else
+	{
+		std::ofstream(outputPath) << json;
+	}
+
+	if (!profilePath.empty())
+	{
+#if defined(ABSTRACTMATH_PROFILE)
+		std::ofstream(profilePath) << AbstractMath::profile::snapshot().toJson();
+#else
+		std::fprintf(stderr, "--profile ignored, configure with -DABSTRACTMATH_PROFILE=ON\n");
+#endif
+	}
+
+	if (baselinePath.empty())
+	{
+		return 0;
+	}
+
+	std::vector<std::pair<std::string, double>> baseline = readBaseline(baselinePath);
+
+	if (baseline.empty())
+	{
+		std::fprintf(stderr, "could not read baseline %s\n", baselinePath.c_str());
+		return 2;
+	}
+
+	size_t regressions = 0;
+
+	for (const BenchmarkResult& result : results)
+	{
+		for (const auto& entry : baseline)
+		{
+			if (entry.first != result.name || entry.second <= 0.0)
+			{
+				continue;
+			}
+
+			double change = result.nsPerOp / entry.second - 1.0;
+
+			if (change > threshold)
+			{
+				std::fprintf(stderr, "REGRESSION %-45s %10.3f -> %10.3f ns/op (%+.1f%%)\n", result.name.c_str(), entry.second, result.nsPerOp, change * 100.0);
+				regressions++;
+			}
+			else if (change < -threshold)
+			{
+				std::fprintf(stderr, "improved   %-45s %10.3f -> %10.3f ns/op (%+.1f%%)\n", result.name.c_str(), entry.second, result.nsPerOp, change * 100.0);
+			}
+		}
+	}
+
+	std::fprintf(stderr, "%zu regression(s) beyond %.0f%%\n", regressions, threshold * 100.0);
+	return regressions == 0 ? 0 : 1;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Vector.h"
+#include "StorageTypes.h"
 
 #include "Vec4.h"
 #include "Vec3.h"
@@ -8,4 +9,23 @@
 
 #include "Quaternion.h"
 
-#include "Matrix.h"
\ No newline at end of file
+#include "Matrix.h"
+
+#include "VectorArray.h"
+#include "BatchTransform.h"
+#include "BatchQuaternion.h"
+#include "CompressedQuaternion.h"
+#include "TRS.h"
+#include "AffineMatrix.h"
+#include "Memory.h"
+#include "Archive.h"
+#include "Profiling.h"
+#include "Expression.h"
+#include "DynamicMatrix.h"
+#include "SparseMatrix.h"
+#include "Solvers.h"
+#include "Decomposition3.h"
+#include "Frustum.h"
+#include "Intersection.h"
+#include "BVH.h"
+#include "TransformHierarchy.h"
\ No newline at end of file
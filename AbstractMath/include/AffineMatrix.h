@@ -0,0 +1,246 @@
+#pragma once
+
+#include <type_traits>
+#include <assert.h>
+
+#include "Simd.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "VectorArray.h"
+#include "BatchTransform.h"
+
+namespace AbstractMath {
+
+	namespace detail {
+
+#if defined(ABSTRACTMATH_SSE)
+		// the four columns of a packed column-major 3x4 as ( x, y, z, junk ), without reading past its twelve floats
+		inline void loadAffineColumns3x4f(const float* src, __m128* columns)
+		{
+			columns[0] = _mm_loadu_ps(src + 0);
+			columns[1] = _mm_loadu_ps(src + 3);
+			columns[2] = _mm_loadu_ps(src + 6);
+			columns[3] = swizzle<1, 2, 3, 3>(_mm_loadu_ps(src + 8));
+		}
+
+		// overlapping stores in order so each column overwrites the junk lane of the one before
+		inline void storeAffineColumns3x4f(const __m128* columns, float* dest)
+		{
+			__m128 last = _mm_shuffle_ps(columns[2], columns[3], _MM_SHUFFLE(0, 0, 2, 2));
+
+			_mm_storeu_ps(dest + 0, columns[0]);
+			_mm_storeu_ps(dest + 3, columns[1]);
+			_mm_storeu_ps(dest + 6, columns[2]);
+			_mm_storeu_ps(dest + 8, _mm_shuffle_ps(last, columns[3], _MM_SHUFFLE(2, 1, 2, 0)));
+		}
+
+		// [ A | a ] * [ B | b ] = [ AB | Ab + a ], 27 multiplies instead of the 4x4 product's 64
+		inline void multiplyAffine3x4f(const float* left, const float* right, float* dest)
+		{
+			__m128 l[4], r[4], result[4];
+			loadAffineColumns3x4f(left, l);
+			loadAffineColumns3x4f(right, r);
+
+			for (size_t i = 0; i < 4; i++)
+			{
+				__m128 sum = multiplyAdd(l[0], swizzle<0, 0, 0, 0>(r[i]), i == 3 ? l[3] : _mm_setzero_ps());
+				sum = multiplyAdd(l[1], swizzle<1, 1, 1, 1>(r[i]), sum);
+				result[i] = multiplyAdd(l[2], swizzle<2, 2, 2, 2>(r[i]), sum);
+			}
+
+			storeAffineColumns3x4f(result, dest);
+		}
+#endif
+	}
+
+	// affine transform stored as the top three rows of a 4x4 (12 scalars, column-major like Matrix), the implied
+	// last row is ( 0, 0, 0, 1 ), a palette or instance buffer of them is 48 bytes per float entry
+	// default constructs to identity like Quaternion, composeTRS() writes into it through Matrix<T, 3, 4>
+	template<typename T>
+	class AffineMatrix : public Matrix<T, 3, 4>
+	{
+		static_assert(std::is_floating_point<T>::value, "AffineMatrix requires a floating point type!");
+
+	public:
+		using Matrix<T, 3, 4>::operator*; // 3x4 * Vector<T, 4>, the full homogeneous product
+
+		constexpr AffineMatrix() : Matrix<T, 3, 4>()
+		{
+			this->data[0] = T(1);
+			this->data[4] = T(1);
+			this->data[8] = T(1);
+		}
+
+		constexpr AffineMatrix(const Matrix<T, 3, 4>& other) : Matrix<T, 3, 4>(other) {}
+
+		// drops the last row, which is assumed to be ( 0, 0, 0, 1 )
+		constexpr explicit AffineMatrix(const Matrix<T, 4, 4>& other) : Matrix<T, 3, 4>()
+		{
+			for (size_t col = 0; col < 4; col++)
+			{
+				for (size_t row = 0; row < 3; row++)
+				{
+					this->data[col * 3 + row] = other.data[col * 4 + row];
+				}
+			}
+		}
+
+		constexpr Matrix<T, 4, 4> toMatrix4() const
+		{
+			Matrix<T, 4, 4> result;
+
+			for (size_t col = 0; col < 4; col++)
+			{
+				for (size_t row = 0; row < 3; row++)
+				{
+					result.data[col * 4 + row] = this->data[col * 3 + row];
+				}
+			}
+
+			result.data[15] = T(1);
+			return result;
+		}
+
+		// upper-left 3x3, the first nine scalars
+		constexpr Matrix<T, 3, 3> linear() const
+		{
+			Matrix<T, 3, 3> result;
+
+			for (size_t i = 0; i < 9; i++)
+			{
+				result.data[i] = this->data[i];
+			}
+
+			return result;
+		}
+
+		constexpr Vector<T, 3> translation() const
+		{
+			return Vector<T, 3>{ this->data[9], this->data[10], this->data[11] };
+		}
+
+		constexpr AffineMatrix<T> operator*(const AffineMatrix<T>& other) const
+		{
+			AffineMatrix<T> result;
+
+#if defined(ABSTRACTMATH_SSE)
+			if constexpr (std::is_same<T, float>::value)
+			{
+				if (!detail::isConstantEvaluated())
+				{
+					detail::multiplyAffine3x4f(this->data, other.data, result.data);
+					return result;
+				}
+			}
+#endif
+
+			const T* a = this->data;
+			const T* b = other.data;
+
+			for (size_t col = 0; col < 4; col++)
+			{
+				for (size_t row = 0; row < 3; row++)
+				{
+					T sum = a[row] * b[col * 3] + a[3 + row] * b[col * 3 + 1] + a[6 + row] * b[col * 3 + 2];
+					result.data[col * 3 + row] = col == 3 ? sum + a[9 + row] : sum;
+				}
+			}
+
+			return result;
+		}
+
+		constexpr void operator*=(const AffineMatrix<T>& other)
+		{
+			*this = operator*(other);
+		}
+
+		// w = 1, the translation applies
+		constexpr Vector<T, 3> transformPoint(const Vector<T, 3>& point) const
+		{
+			const T* m = this->data;
+			const T x = point.data[0], y = point.data[1], z = point.data[2];
+
+			return Vector<T, 3>{ m[0] * x + m[3] * y + m[6] * z + m[9], m[1] * x + m[4] * y + m[7] * z + m[10], m[2] * x + m[5] * y + m[8] * z + m[11] };
+		}
+
+		// w = 0, only the linear part applies
+		constexpr Vector<T, 3> transformDirection(const Vector<T, 3>& direction) const
+		{
+			const T* m = this->data;
+			const T x = direction.data[0], y = direction.data[1], z = direction.data[2];
+
+			return Vector<T, 3>{ m[0] * x + m[3] * y + m[6] * z, m[1] * x + m[4] * y + m[7] * z, m[2] * x + m[5] * y + m[8] * z };
+		}
+
+		// 3x3 cofactor inverse plus the back-rotated translation, no 4x4 work
+		constexpr AffineMatrix<T> inverted() const
+		{
+			return fromLinearInverse(linear().inverted());
+		}
+
+		// rotation and translation only: the transposed rotation
+		constexpr AffineMatrix<T> orthonormalInverse() const
+		{
+			return fromLinearInverse(linear().transposed());
+		}
+
+	private:
+		constexpr AffineMatrix<T> fromLinearInverse(const Matrix<T, 3, 3>& inverse) const
+		{
+			AffineMatrix<T> result;
+
+			for (size_t i = 0; i < 9; i++)
+			{
+				result.data[i] = inverse.data[i];
+			}
+
+			for (size_t row = 0; row < 3; row++)
+			{
+				result.data[9 + row] = -(inverse.data[row] * this->data[9] + inverse.data[3 + row] * this->data[10] + inverse.data[6 + row] * this->data[11]);
+			}
+
+			return result;
+		}
+	};
+
+	static_assert(sizeof(AffineMatrix<float>) == 12 * sizeof(float), "AffineMatrix must stay tightly packed for palettes and instance buffers!");
+
+	typedef AffineMatrix<float> AffineMatrixf;
+	typedef AffineMatrix<double> AffineMatrixd;
+
+	// stream transforms, the 4x4 kernels read only the first three rows so the matrix is widened once per call
+
+	template<typename T, typename V>
+	void transformPoints(const AffineMatrix<T>& matrix, const V* src, V* dst, size_t count)
+	{
+		transformPoints(matrix.toMatrix4(), src, dst, count);
+	}
+
+	template<typename T, typename V>
+	void transformDirections(const AffineMatrix<T>& matrix, const V* src, V* dst, size_t count)
+	{
+		transformDirections(matrix.toMatrix4(), src, dst, count);
+	}
+
+	template<typename T>
+	void transformPoints(const AffineMatrix<T>& matrix, const VectorArray<T, 3>& src, VectorArray<T, 3>& dst)
+	{
+		transformPoints(matrix.toMatrix4(), src, dst);
+	}
+
+	template<typename T>
+	void transformDirections(const AffineMatrix<T>& matrix, const VectorArray<T, 3>& src, VectorArray<T, 3>& dst)
+	{
+		transformDirections(matrix.toMatrix4(), src, dst);
+	}
+
+	// dst[i] = a[i] * b[i], e.g. a skinning palette from world matrices and inverse bind poses, dst may be a or b
+	template<typename T>
+	void multiply(const AffineMatrix<T>* a, const AffineMatrix<T>* b, AffineMatrix<T>* dst, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			dst[i] = a[i] * b[i];
+		}
+	}
+}
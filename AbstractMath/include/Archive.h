@@ -0,0 +1,1279 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <assert.h>
+
+#if defined(_WIN32)
+	#if !defined(NOMINMAX)
+		#define NOMINMAX
+	#endif
+	#if !defined(WIN32_LEAN_AND_MEAN)
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include "Simd.h"
+#include "Vector.h"
+#include "Vec2.h"
+#include "Vec3.h"
+#include "Vec4.h"
+#include "Quaternion.h"
+#include "Matrix.h"
+#include "AffineMatrix.h"
+#include "CompressedQuaternion.h"
+#include "VectorArray.h"
+#include "StorageTypes.h"
+#include "Memory.h"
+
+namespace AbstractMath {
+
+	// binary container for arrays of Vector, Quaternion, Matrix and CompressedQuaternion, little endian throughout:
+	// [ ArchiveHeader ][ array data, each array 64 byte aligned ][ ArrayDescriptor directory ]
+	// an AoS array is count elements exactly as they are in memory, so a mapped file is read through plain pointers;
+	// an SoA array is one lane per component, each lane padded with zeros to a multiple of 64 bytes (the VectorArray
+	// kernels may read up to the padding)
+	// the header and directory carry CRC32C checksums that open() verifies along with every descriptor's bounds and
+	// layout, after that typed access is a descriptor compare and a pointer; the data checksums are only checked by verify()
+	// quantized arrays are arrays of storage-typed elements (Vector<half, 3>, Vector<snorm16, 4>, Quaternion32, ...),
+	// ArchiveWriter::append() converts float elements into them on the way out
+
+	enum class ArchiveError
+	{
+		None,
+		OpenFailed,
+		ReadFailed,
+		WriteFailed,
+		NotAnArchive,
+		UnsupportedVersion,
+		UnsupportedPlatform, //big endian hosts, the data would need swapping
+		HeaderChecksum,
+		DirectoryChecksum,
+		BadLayout,
+		TypeMismatch,
+		InvalidState
+	};
+
+	enum class ElementKind : uint8_t
+	{
+		Vector,
+		Quaternion,
+		Matrix,
+		CompressedQuaternion
+	};
+
+	enum class ScalarType : uint8_t
+	{
+		None, //CompressedQuaternion
+		Float32,
+		Float64,
+		Half,
+		Snorm16,
+		Snorm8,
+		Unorm16,
+		Unorm8,
+		Int32,
+		Uint32
+	};
+
+	enum class ArrayLayout : uint8_t
+	{
+		AoS,
+		SoA
+	};
+
+	struct ArchiveHeader
+	{
+		static constexpr uint32_t VERSION = 1;
+
+		char magic[8]; //"AMARCHV" and a terminating zero
+		uint32_t version;
+		uint32_t arrayCount;
+		uint64_t directoryOffset;
+		uint64_t fileSize;
+		uint32_t directoryChecksum;
+		uint32_t headerChecksum; //over the 64 header bytes with this field zeroed
+		uint8_t reserved[24];
+	};
+
+	struct ArrayDescriptor
+	{
+		char name[32]; //zero terminated
+		ElementKind kind;
+		ScalarType scalar;
+		uint8_t rows; //components of a Vector or Quaternion, rows of a Matrix, 16 bit words of a CompressedQuaternion
+		uint8_t cols; //1 unless a Matrix
+		ArrayLayout layout;
+		uint8_t reserved[3];
+		uint32_t elementSize; //sizeof the element for AoS, of one scalar for SoA
+		uint32_t dataChecksum; //CRC32C of the lane bytes, of the lane checksums when there is more than one lane
+		uint64_t count;
+		uint64_t offset;
+		uint64_t size;
+		uint64_t lanePitch; //bytes from one SoA lane to the next
+	};
+
+	static_assert(sizeof(ArchiveHeader) == 64 && sizeof(ArrayDescriptor) == 80, "Archive structures must match the file layout!");
+
+	namespace detail {
+
+		static constexpr uint64_t ARCHIVE_ALIGNMENT = 64;
+		static constexpr char ARCHIVE_MAGIC[8] = { 'A', 'M', 'A', 'R', 'C', 'H', 'V', 0 };
+
+		constexpr bool isLittleEndian()
+		{
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+			return __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+#else
+			return true; //msvc only targets little endian
+#endif
+		}
+
+		constexpr uint64_t alignArchive(uint64_t value)
+		{
+			return (value + ARCHIVE_ALIGNMENT - 1) / ARCHIVE_ALIGNMENT * ARCHIVE_ALIGNMENT;
+		}
+
+		struct Crc32cTable
+		{
+			uint32_t entries[256];
+
+			constexpr Crc32cTable() : entries{}
+			{
+				for (uint32_t i = 0; i < 256; i++)
+				{
+					uint32_t crc = i;
+
+					for (int bit = 0; bit < 8; bit++)
+					{
+						crc = (crc >> 1) ^ (0x82f63b78u & (0u - (crc & 1u)));
+					}
+
+					entries[i] = crc;
+				}
+			}
+		};
+
+		// CRC32C (castagnoli, the polynomial of the SSE4.2 crc32 instruction), continues from a previous result
+		inline uint32_t crc32c(uint32_t crc, const void* data, size_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			crc = ~crc;
+
+#if defined(ABSTRACTMATH_SSE42) && (defined(__x86_64__) || defined(_M_X64))
+			uint64_t wide = crc;
+
+			for (; size >= 8; size -= 8, bytes += 8)
+			{
+				uint64_t word = 0;
+				std::memcpy(&word, bytes, 8);
+				wide = _mm_crc32_u64(wide, word);
+			}
+
+			crc = uint32_t(wide);
+
+			for (; size > 0; size--)
+			{
+				crc = _mm_crc32_u8(crc, *bytes++);
+			}
+#else
+			static constexpr Crc32cTable TABLE;
+
+			for (; size > 0; size--)
+			{
+				crc = (crc >> 8) ^ TABLE.entries[(crc ^ *bytes++) & 0xff];
+			}
+#endif
+
+			return ~crc;
+		}
+
+		inline uint32_t headerChecksum(ArchiveHeader header)
+		{
+			header.headerChecksum = 0;
+			return crc32c(0, &header, sizeof(ArchiveHeader));
+		}
+
+		inline uint32_t combineLaneChecksums(const uint32_t* lanes, size_t count)
+		{
+			return count == 1 ? lanes[0] : crc32c(0, lanes, sizeof(uint32_t) * count);
+		}
+
+		inline size_t scalarSize(ScalarType scalar)
+		{
+			switch (scalar)
+			{
+			case ScalarType::Float32: case ScalarType::Int32: case ScalarType::Uint32: return 4;
+			case ScalarType::Float64: return 8;
+			case ScalarType::Half: case ScalarType::Snorm16: case ScalarType::Unorm16: return 2;
+			case ScalarType::Snorm8: case ScalarType::Unorm8: return 1;
+			default: return 0;
+			}
+		}
+
+		template<typename T>
+		struct ScalarTraits
+		{
+			static constexpr ScalarType id = ScalarType::None;
+		};
+
+		template<> struct ScalarTraits<float> { static constexpr ScalarType id = ScalarType::Float32; };
+		template<> struct ScalarTraits<double> { static constexpr ScalarType id = ScalarType::Float64; };
+		template<> struct ScalarTraits<half> { static constexpr ScalarType id = ScalarType::Half; };
+		template<> struct ScalarTraits<snorm16> { static constexpr ScalarType id = ScalarType::Snorm16; };
+		template<> struct ScalarTraits<snorm8> { static constexpr ScalarType id = ScalarType::Snorm8; };
+		template<> struct ScalarTraits<unorm16> { static constexpr ScalarType id = ScalarType::Unorm16; };
+		template<> struct ScalarTraits<unorm8> { static constexpr ScalarType id = ScalarType::Unorm8; };
+		template<> struct ScalarTraits<int32_t> { static constexpr ScalarType id = ScalarType::Int32; };
+		template<> struct ScalarTraits<uint32_t> { static constexpr ScalarType id = ScalarType::Uint32; };
+
+		// the shape an element type is stored as, valid is false for anything the archive cannot hold
+		template<typename T>
+		struct ElementTraits
+		{
+			static constexpr bool valid = false;
+		};
+
+		template<typename T, ElementKind Kind_C, size_t Rows_C, size_t Cols_C>
+		struct ShapeTraits
+		{
+			using scalar_type = T;
+			static constexpr bool valid = Kind_C == ElementKind::CompressedQuaternion || ScalarTraits<T>::id != ScalarType::None;
+			static constexpr ElementKind kind = Kind_C;
+			static constexpr ScalarType scalar = ScalarTraits<T>::id;
+			static constexpr uint8_t rows = uint8_t(Rows_C);
+			static constexpr uint8_t cols = uint8_t(Cols_C);
+		};
+
+		template<typename T, size_t C> struct ElementTraits<Vector<T, C>> : ShapeTraits<T, ElementKind::Vector, C, 1> {};
+		template<typename T> struct ElementTraits<Vector2<T>> : ElementTraits<Vector<T, 2>> {};
+		template<typename T> struct ElementTraits<Vector3<T>> : ElementTraits<Vector<T, 3>> {};
+		template<typename T> struct ElementTraits<Vector4<T>> : ElementTraits<Vector<T, 4>> {};
+		template<typename T> struct ElementTraits<Quaternion<T>> : ShapeTraits<T, ElementKind::Quaternion, 4, 1> {};
+		template<typename T, size_t R, size_t C> struct ElementTraits<Matrix<T, R, C>> : ShapeTraits<T, ElementKind::Matrix, R, C> {};
+		template<typename T> struct ElementTraits<AffineMatrix<T>> : ElementTraits<Matrix<T, 3, 4>> {};
+		template<size_t Bits_C> struct ElementTraits<CompressedQuaternion<Bits_C>> : ShapeTraits<uint16_t, ElementKind::CompressedQuaternion, Bits_C / 16, 1> {};
+		template<typename V, size_t Alignment_C> struct ElementTraits<Aligned<V, Alignment_C>> : ElementTraits<V> {};
+
+		template<typename T>
+		bool describes(const ArrayDescriptor& descriptor, ArrayLayout layout)
+		{
+			using Traits = ElementTraits<T>;
+			static_assert(Traits::valid, "Archives hold Vector, Quaternion, Matrix and CompressedQuaternion arrays of float, double, int32_t, uint32_t or storage types!");
+
+			size_t elementSize = layout == ArrayLayout::AoS ? sizeof(T) : sizeof(typename Traits::scalar_type);
+
+			return descriptor.layout == layout && descriptor.kind == Traits::kind && descriptor.scalar == Traits::scalar
+				&& descriptor.rows == Traits::rows && descriptor.cols == Traits::cols && descriptor.elementSize == elementSize;
+		}
+
+		// count scalars of S into the archive scalar type of dst
+		template<typename S>
+		void encodeScalars(const S* src, ScalarType scalar, void* dst, size_t count)
+		{
+			switch (scalar)
+			{
+			case ScalarType::Float32: convert(src, static_cast<float*>(dst), count); break;
+			case ScalarType::Float64: convert(src, static_cast<double*>(dst), count); break;
+			case ScalarType::Half: convert(src, static_cast<half*>(dst), count); break;
+			case ScalarType::Snorm16: convert(src, static_cast<snorm16*>(dst), count); break;
+			case ScalarType::Snorm8: convert(src, static_cast<snorm8*>(dst), count); break;
+			case ScalarType::Unorm16: convert(src, static_cast<unorm16*>(dst), count); break;
+			case ScalarType::Unorm8: convert(src, static_cast<unorm8*>(dst), count); break;
+			case ScalarType::Int32: convert(src, static_cast<int32_t*>(dst), count); break;
+			case ScalarType::Uint32: convert(src, static_cast<uint32_t*>(dst), count); break;
+			default: assert(false); break;
+			}
+		}
+
+		// everything open() checks before handing out pointers, directory is fileSize - directoryOffset bytes
+		inline ArchiveError validateArchive(const ArchiveHeader& header, const ArrayDescriptor* directory, uint64_t fileSize)
+		{
+			for (size_t i = 0; i < header.arrayCount; i++)
+			{
+				const ArrayDescriptor& array = directory[i];
+				size_t scalarBytes = scalarSize(array.scalar);
+
+				if (std::memchr(array.name, 0, sizeof(array.name)) == nullptr || array.kind > ElementKind::CompressedQuaternion
+					|| array.scalar > ScalarType::Uint32 || array.layout > ArrayLayout::SoA || array.rows == 0 || array.cols == 0 || array.elementSize == 0
+					|| array.offset % ARCHIVE_ALIGNMENT != 0 || array.offset < sizeof(ArchiveHeader) || array.offset > header.directoryOffset
+					|| array.size > header.directoryOffset - array.offset)
+				{
+					return ArchiveError::BadLayout;
+				}
+
+				if (array.kind == ElementKind::CompressedQuaternion)
+				{
+					if ((array.rows != 2 && array.rows != 3) || array.cols != 1 || array.elementSize != 2u * array.rows || array.layout != ArrayLayout::AoS)
+					{
+						return ArchiveError::BadLayout;
+					}
+				}
+				else if (scalarBytes == 0 || (array.kind != ElementKind::Matrix && array.cols != 1) || (array.kind == ElementKind::Quaternion && array.rows != 4))
+				{
+					return ArchiveError::BadLayout;
+				}
+
+				if (array.layout == ArrayLayout::AoS)
+				{
+					if ((array.kind != ElementKind::CompressedQuaternion && array.elementSize < scalarBytes * array.rows * array.cols)
+						|| array.count > array.size / array.elementSize || array.count * array.elementSize != array.size)
+					{
+						return ArchiveError::BadLayout;
+					}
+				}
+				else if (array.kind != ElementKind::Vector || array.elementSize != scalarBytes || array.lanePitch % ARCHIVE_ALIGNMENT != 0
+					|| array.size / array.rows != array.lanePitch || array.size % array.rows != 0 || array.count > array.lanePitch / array.elementSize)
+				{
+					return ArchiveError::BadLayout;
+				}
+			}
+
+			return header.directoryOffset + uint64_t(header.arrayCount) * sizeof(ArrayDescriptor) == fileSize ? ArchiveError::None : ArchiveError::BadLayout;
+		}
+
+		// header and directory checks shared by the mapped and the streaming reader, the directory is read separately
+		inline ArchiveError validateHeader(const ArchiveHeader& header, uint64_t fileSize)
+		{
+			if (!isLittleEndian())
+			{
+				return ArchiveError::UnsupportedPlatform;
+			}
+
+			if (std::memcmp(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0)
+			{
+				return ArchiveError::NotAnArchive;
+			}
+
+			if (header.version != ArchiveHeader::VERSION)
+			{
+				return ArchiveError::UnsupportedVersion;
+			}
+
+			if (header.headerChecksum != headerChecksum(header))
+			{
+				return ArchiveError::HeaderChecksum;
+			}
+
+			if (header.fileSize != fileSize || header.directoryOffset % ARCHIVE_ALIGNMENT != 0 || header.directoryOffset < sizeof(ArchiveHeader)
+				|| header.directoryOffset > fileSize || header.arrayCount > (fileSize - header.directoryOffset) / sizeof(ArrayDescriptor))
+			{
+				return ArchiveError::BadLayout;
+			}
+
+			return ArchiveError::None;
+		}
+
+		inline bool seekFile(std::FILE* file, uint64_t position)
+		{
+#if defined(_WIN32)
+			return _fseeki64(file, int64_t(position), SEEK_SET) == 0;
+#else
+			return fseeko(file, off_t(position), SEEK_SET) == 0;
+#endif
+		}
+
+		// read-only view of a whole file, the pages are loaded on first touch
+		class MappedFile
+		{
+		public:
+			MappedFile() = default;
+
+			~MappedFile()
+			{
+				close();
+			}
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			bool open(const char* path)
+			{
+				close();
+
+#if defined(_WIN32)
+				HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+				if (file == INVALID_HANDLE_VALUE)
+				{
+					return false;
+				}
+
+				LARGE_INTEGER fileSize = {};
+				bool result = GetFileSizeEx(file, &fileSize) != 0 && fileSize.QuadPart > 0;
+
+				if (result)
+				{
+					HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+					bytes = mapping != nullptr ? static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+					size = uint64_t(fileSize.QuadPart);
+					result = bytes != nullptr;
+
+					if (mapping != nullptr)
+					{
+						CloseHandle(mapping); //the view keeps the mapping alive
+					}
+				}
+
+				CloseHandle(file);
+#else
+				int file = ::open(path, O_RDONLY);
+
+				if (file < 0)
+				{
+					return false;
+				}
+
+				struct stat status;
+				bool result = fstat(file, &status) == 0 && status.st_size > 0;
+
+				if (result)
+				{
+					void* view = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+					result = view != MAP_FAILED;
+					bytes = result ? static_cast<const uint8_t*>(view) : nullptr;
+					size = result ? uint64_t(status.st_size) : 0;
+				}
+
+				::close(file); //the mapping keeps the file alive
+#endif
+
+				if (!result)
+				{
+					bytes = nullptr;
+					size = 0;
+				}
+
+				return result;
+			}
+
+			void close()
+			{
+				if (bytes != nullptr)
+				{
+#if defined(_WIN32)
+					UnmapViewOfFile(bytes);
+#else
+					munmap(const_cast<uint8_t*>(bytes), size_t(size));
+#endif
+				}
+
+				bytes = nullptr;
+				size = 0;
+			}
+
+			// asks the OS to start reading a range in ahead of use
+			void prefetch(uint64_t offset, uint64_t length) const
+			{
+#if !defined(_WIN32)
+				uint64_t page = uint64_t(sysconf(_SC_PAGESIZE));
+				uint64_t start = offset / page * page;
+
+				if (bytes != nullptr && length > 0)
+				{
+					madvise(const_cast<uint8_t*>(bytes) + start, size_t(offset + length - start), MADV_WILLNEED);
+				}
+#else
+				(void)offset;
+				(void)length;
+#endif
+			}
+
+			const uint8_t* bytes = nullptr;
+			uint64_t size = 0;
+		};
+	}
+
+	// count elements straight out of a mapped archive
+	template<typename T>
+	struct ArrayView
+	{
+		const T* data = nullptr;
+		size_t count = 0;
+
+		const T* begin() const { return data; }
+		const T* end() const { return data + count; }
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		explicit operator bool() const { return data != nullptr; }
+
+		const T& operator[](size_t index) const
+		{
+			assert(index < count);
+			return data[index];
+		}
+	};
+
+	// the lanes of a mapped SoA array, laid out like a VectorArray's (zero padded to a 64 byte multiple)
+	template<typename T, size_t C>
+	struct LaneView
+	{
+		const T* lanes[C] = {};
+		size_t count = 0;
+
+		const T* lane(size_t component) const
+		{
+			assert(component < C);
+			return lanes[component];
+		}
+
+		Vector<T, C> get(size_t index) const
+		{
+			assert(index < count);
+			Vector<T, C> result;
+
+			for (size_t i = 0; i < C; i++)
+			{
+				result.data[i] = lanes[i][index];
+			}
+
+			return result;
+		}
+
+		size_t size() const { return count; }
+		explicit operator bool() const { return lanes[0] != nullptr; }
+	};
+
+	// streaming writer: one array at a time, elements appended in chunks of any size so files larger than memory
+	// can be written, the directory and header go out in finish() (or the destructor)
+	// every call after a failure returns false, error() says what failed
+	class ArchiveWriter
+	{
+	public:
+		ArchiveWriter() = default;
+
+		explicit ArchiveWriter(const char* path)
+		{
+			open(path);
+		}
+
+		~ArchiveWriter()
+		{
+			finish();
+		}
+
+		ArchiveWriter(const ArchiveWriter&) = delete;
+		ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+		bool open(const char* path)
+		{
+			finish();
+			arrays.clear();
+			status = ArchiveError::None;
+
+			if (!detail::isLittleEndian())
+			{
+				return fail(ArchiveError::UnsupportedPlatform);
+			}
+
+			file = std::fopen(path, "wb");
+
+			if (file == nullptr)
+			{
+				return fail(ArchiveError::OpenFailed);
+			}
+
+			ArchiveHeader header = {};
+			position = 0;
+			return writeBytes(&header, sizeof(ArchiveHeader));
+		}
+
+		// starts an AoS array stored as T, e.g. Matrix<float, 4, 4>, Vector<half, 3> or Quaternion48
+		template<typename T>
+		bool beginArray(const char* name)
+		{
+			using Traits = detail::ElementTraits<T>;
+			static_assert(Traits::valid, "Archives hold Vector, Quaternion, Matrix and CompressedQuaternion arrays of float, double, int32_t, uint32_t or storage types!");
+
+			return begin(name, Traits::kind, Traits::scalar, Traits::rows, Traits::cols, ArrayLayout::AoS, sizeof(T), 0);
+		}
+
+		// starts an SoA array of count Vector<T, C>, its lanes are appended in chunks through appendLanes()
+		template<typename T, size_t C>
+		bool beginLanes(const char* name, size_t count)
+		{
+			static_assert(detail::ScalarTraits<T>::id != ScalarType::None, "Lanes must be float, double, int32_t, uint32_t or a storage type!");
+
+			return begin(name, ElementKind::Vector, detail::ScalarTraits<T>::id, uint8_t(C), 1, ArrayLayout::SoA, sizeof(T), count);
+		}
+
+		// appends count elements to the current AoS array, S is either the stored type or the same shape in another scalar
+		// type (float matrices into a half array, ...) or Quaternion<T> into a CompressedQuaternion array
+		template<typename S>
+		bool append(const S* src, size_t count)
+		{
+			using Traits = detail::ElementTraits<S>;
+			static_assert(Traits::valid, "Archives hold Vector, Quaternion, Matrix and CompressedQuaternion arrays of float, double, int32_t, uint32_t or storage types!");
+
+			if (!ready(true) || current.layout != ArrayLayout::AoS)
+			{
+				return fail(ArchiveError::InvalidState);
+			}
+
+			if (detail::describes<S>(current, ArrayLayout::AoS))
+			{
+				return writeData(src, sizeof(S) * count, 0) && advance(count);
+			}
+
+			const size_t scalars = size_t(Traits::rows) * Traits::cols;
+			std::vector<uint8_t> buffer(CHUNK * size_t(current.elementSize));
+
+			for (size_t first = 0; first < count; first += CHUNK)
+			{
+				size_t chunk = count - first < CHUNK ? count - first : CHUNK;
+
+				if constexpr (Traits::kind == ElementKind::Quaternion)
+				{
+					if (current.kind == ElementKind::CompressedQuaternion)
+					{
+						if (current.rows == 2)
+						{
+							compress(src + first, reinterpret_cast<Quaternion32*>(buffer.data()), chunk);
+						}
+						else
+						{
+							compress(src + first, reinterpret_cast<Quaternion48*>(buffer.data()), chunk);
+						}
+
+						if (!writeData(buffer.data(), chunk * current.elementSize, 0))
+						{
+							return false;
+						}
+
+						continue;
+					}
+				}
+
+				if constexpr (Traits::kind != ElementKind::CompressedQuaternion)
+				{
+					if (current.kind != Traits::kind || current.rows != Traits::rows || current.cols != Traits::cols
+						|| sizeof(S) != sizeof(typename Traits::scalar_type) * scalars || current.elementSize != detail::scalarSize(current.scalar) * scalars)
+					{
+						return fail(ArchiveError::TypeMismatch);
+					}
+
+					detail::encodeScalars(reinterpret_cast<const typename Traits::scalar_type*>(src + first), current.scalar, buffer.data(), chunk * scalars);
+
+					if (!writeData(buffer.data(), chunk * current.elementSize, 0))
+					{
+						return false;
+					}
+				}
+				else
+				{
+					return fail(ArchiveError::TypeMismatch);
+				}
+			}
+
+			return advance(count);
+		}
+
+		// appends every element of chunk to the lanes of the current SoA array, converting the scalars if S differs
+		template<typename S, size_t C>
+		bool appendLanes(const VectorArray<S, C>& chunk)
+		{
+			if (!ready(true) || current.layout != ArrayLayout::SoA || chunk.size() > current.count - written)
+			{
+				return fail(ArchiveError::InvalidState);
+			}
+
+			if (current.rows != C)
+			{
+				return fail(ArchiveError::TypeMismatch);
+			}
+
+			std::vector<uint8_t> buffer;
+
+			for (size_t i = 0; i < C; i++)
+			{
+				if (!detail::seekFile(file, current.offset + i * current.lanePitch + written * current.elementSize))
+				{
+					return fail(ArchiveError::WriteFailed);
+				}
+
+				if (detail::ScalarTraits<S>::id == current.scalar)
+				{
+					if (!writeData(chunk.lane(i), sizeof(S) * chunk.size(), i))
+					{
+						return false;
+					}
+				}
+				else
+				{
+					buffer.resize(chunk.size() * current.elementSize);
+					detail::encodeScalars(chunk.lane(i), current.scalar, buffer.data(), chunk.size());
+
+					if (!writeData(buffer.data(), buffer.size(), i))
+					{
+						return false;
+					}
+				}
+			}
+
+			written += chunk.size();
+			return true;
+		}
+
+		// closes the current array, SoA lanes must have received exactly the count given to beginLanes()
+		bool endArray()
+		{
+			if (!ready(true))
+			{
+				return fail(ArchiveError::InvalidState);
+			}
+
+			inArray = false;
+
+			if (current.layout == ArrayLayout::AoS)
+			{
+				current.count = written;
+				current.size = written * current.elementSize;
+			}
+			else
+			{
+				if (written != current.count)
+				{
+					return fail(ArchiveError::InvalidState);
+				}
+
+				//zero the tail of every lane in file order, so the lane checksums cover the padding too
+				std::vector<uint8_t> zeros(size_t(current.lanePitch - current.count * current.elementSize), 0);
+
+				for (size_t i = 0; i < current.rows; i++)
+				{
+					if (!detail::seekFile(file, current.offset + i * current.lanePitch + current.count * current.elementSize) || !writeData(zeros.data(), zeros.size(), i))
+					{
+						return fail(ArchiveError::WriteFailed);
+					}
+				}
+
+				current.size = current.lanePitch * current.rows;
+			}
+
+			current.dataChecksum = detail::combineLaneChecksums(laneChecksums.data(), laneChecksums.size());
+			position = current.offset + current.size;
+			arrays.push_back(current);
+
+			return detail::seekFile(file, position) ? true : fail(ArchiveError::WriteFailed);
+		}
+
+		template<typename T>
+		bool writeArray(const char* name, const T* data, size_t count)
+		{
+			return beginArray<T>(name) && append(data, count) && endArray();
+		}
+
+		template<typename T, size_t C>
+		bool writeArray(const char* name, const VectorArray<T, C>& lanes)
+		{
+			return beginLanes<T, C>(name, lanes.size()) && appendLanes(lanes) && endArray();
+		}
+
+		// writes the directory and the header and closes the file, false if anything on the way failed
+		bool finish()
+		{
+			if (file == nullptr)
+			{
+				return status == ArchiveError::None;
+			}
+
+			if (inArray)
+			{
+				endArray();
+			}
+
+			if (status == ArchiveError::None && pad())
+			{
+				ArchiveHeader header = {};
+				std::memcpy(header.magic, detail::ARCHIVE_MAGIC, sizeof(header.magic));
+				header.version = ArchiveHeader::VERSION;
+				header.arrayCount = uint32_t(arrays.size());
+				header.directoryOffset = position;
+				header.fileSize = position + arrays.size() * sizeof(ArrayDescriptor);
+				header.directoryChecksum = detail::crc32c(0, arrays.data(), arrays.size() * sizeof(ArrayDescriptor));
+				header.headerChecksum = detail::headerChecksum(header);
+
+				if (writeBytes(arrays.data(), arrays.size() * sizeof(ArrayDescriptor)) && !detail::seekFile(file, 0))
+				{
+					fail(ArchiveError::WriteFailed);
+				}
+
+				if (status == ArchiveError::None)
+				{
+					writeBytes(&header, sizeof(ArchiveHeader));
+				}
+			}
+
+			if (std::fclose(file) != 0 && status == ArchiveError::None)
+			{
+				status = ArchiveError::WriteFailed;
+			}
+
+			file = nullptr;
+			return status == ArchiveError::None;
+		}
+
+		ArchiveError error() const
+		{
+			return status;
+		}
+
+	private:
+		static constexpr size_t CHUNK = 4096; //elements converted per write
+
+		bool begin(const char* name, ElementKind kind, ScalarType scalar, uint8_t rows, uint8_t cols, ArrayLayout layout, size_t elementSize, size_t count)
+		{
+			if (!ready(false))
+			{
+				return fail(ArchiveError::InvalidState);
+			}
+
+			if (!pad())
+			{
+				return false;
+			}
+
+			current = ArrayDescriptor{};
+			std::strncpy(current.name, name, sizeof(current.name) - 1);
+			current.kind = kind;
+			current.scalar = scalar;
+			current.rows = rows;
+			current.cols = cols;
+			current.layout = layout;
+			current.elementSize = uint32_t(elementSize);
+			current.count = count;
+			current.offset = position;
+			current.lanePitch = layout == ArrayLayout::SoA ? detail::alignArchive(count * elementSize) : 0;
+
+			laneChecksums.assign(layout == ArrayLayout::SoA ? rows : 1, 0);
+			written = 0;
+			inArray = true;
+			return true;
+		}
+
+		bool ready(bool needArray) const
+		{
+			return file != nullptr && status == ArchiveError::None && inArray == needArray;
+		}
+
+		bool advance(size_t count)
+		{
+			written += count;
+			return true;
+		}
+
+		bool fail(ArchiveError error)
+		{
+			if (status == ArchiveError::None)
+			{
+				status = error;
+			}
+
+			return false;
+		}
+
+		bool writeBytes(const void* data, size_t size)
+		{
+			if (size > 0 && std::fwrite(data, 1, size, file) != size)
+			{
+				return fail(ArchiveError::WriteFailed);
+			}
+
+			position += size;
+			return true;
+		}
+
+		bool writeData(const void* data, size_t size, size_t lane)
+		{
+			laneChecksums[lane] = detail::crc32c(laneChecksums[lane], data, size);
+			return writeBytes(data, size);
+		}
+
+		// zeros up to the next 64 byte boundary
+		bool pad()
+		{
+			static const uint8_t zeros[detail::ARCHIVE_ALIGNMENT] = {};
+			return writeBytes(zeros, size_t(detail::alignArchive(position) - position));
+		}
+
+		std::FILE* file = nullptr;
+		ArchiveError status = ArchiveError::None;
+		std::vector<ArrayDescriptor> arrays;
+		ArrayDescriptor current = {};
+		std::vector<uint32_t> laneChecksums;
+		uint64_t position = 0;
+		uint64_t written = 0;
+		bool inArray = false;
+	};
+
+	// an archive mapped into memory: open() validates it once, array() and lanes() then hand out pointers into the
+	// mapping, valid until close(), touching them reads the pages in, so a file larger than memory only costs what is used
+	class MappedArchive
+	{
+	public:
+		static constexpr size_t NOT_FOUND = size_t(-1);
+
+		MappedArchive() = default;
+
+		explicit MappedArchive(const char* path)
+		{
+			open(path);
+		}
+
+		MappedArchive(const MappedArchive&) = delete;
+		MappedArchive& operator=(const MappedArchive&) = delete;
+
+		bool open(const char* path)
+		{
+			close();
+
+			if (!mapping.open(path))
+			{
+				return fail(ArchiveError::OpenFailed);
+			}
+
+			if (mapping.size < sizeof(ArchiveHeader))
+			{
+				return fail(ArchiveError::NotAnArchive);
+			}
+
+			std::memcpy(&header, mapping.bytes, sizeof(ArchiveHeader));
+			status = detail::validateHeader(header, mapping.size);
+
+			if (status == ArchiveError::None)
+			{
+				directory = reinterpret_cast<const ArrayDescriptor*>(mapping.bytes + header.directoryOffset);
+
+				if (detail::crc32c(0, directory, header.arrayCount * sizeof(ArrayDescriptor)) != header.directoryChecksum)
+				{
+					status = ArchiveError::DirectoryChecksum;
+				}
+				else
+				{
+					status = detail::validateArchive(header, directory, mapping.size);
+				}
+			}
+
+			return status == ArchiveError::None ? true : fail(status);
+		}
+
+		void close()
+		{
+			mapping.close();
+			directory = nullptr;
+			header = ArchiveHeader{};
+			status = ArchiveError::None;
+		}
+
+		ArchiveError error() const
+		{
+			return status;
+		}
+
+		size_t size() const
+		{
+			return directory != nullptr ? header.arrayCount : 0;
+		}
+
+		const ArrayDescriptor& descriptor(size_t index) const
+		{
+			assert(index < size());
+			return directory[index];
+		}
+
+		size_t find(const char* name) const
+		{
+			for (size_t i = 0; i < size(); i++)
+			{
+				if (std::strncmp(directory[i].name, name, sizeof(directory[i].name)) == 0)
+				{
+					return i;
+				}
+			}
+
+			return NOT_FOUND;
+		}
+
+		// empty when the index is out of range or the array is not an AoS array of T
+		template<typename T>
+		ArrayView<T> array(size_t index) const
+		{
+			ArrayView<T> result;
+
+			if (index < size() && detail::describes<T>(directory[index], ArrayLayout::AoS))
+			{
+				result.data = reinterpret_cast<const T*>(mapping.bytes + directory[index].offset);
+				result.count = size_t(directory[index].count);
+			}
+
+			return result;
+		}
+
+		template<typename T>
+		ArrayView<T> array(const char* name) const
+		{
+			return array<T>(find(name));
+		}
+
+		template<typename T, size_t C>
+		LaneView<T, C> lanes(size_t index) const
+		{
+			LaneView<T, C> result;
+
+			if (index < size() && detail::describes<Vector<T, C>>(directory[index], ArrayLayout::SoA))
+			{
+				for (size_t i = 0; i < C; i++)
+				{
+					result.lanes[i] = reinterpret_cast<const T*>(mapping.bytes + directory[index].offset + i * directory[index].lanePitch);
+				}
+
+				result.count = size_t(directory[index].count);
+			}
+
+			return result;
+		}
+
+		template<typename T, size_t C>
+		LaneView<T, C> lanes(const char* name) const
+		{
+			return lanes<T, C>(find(name));
+		}
+
+		// recomputes the data checksum, this reads the whole array
+		bool verify(size_t index) const
+		{
+			if (index >= size())
+			{
+				return false;
+			}
+
+			const ArrayDescriptor& array = directory[index];
+			const size_t laneCount = array.layout == ArrayLayout::SoA ? array.rows : 1;
+			const uint64_t laneBytes = array.layout == ArrayLayout::SoA ? array.lanePitch : array.size;
+			std::vector<uint32_t> checksums(laneCount);
+
+			for (size_t i = 0; i < laneCount; i++)
+			{
+				checksums[i] = detail::crc32c(0, mapping.bytes + array.offset + i * laneBytes, size_t(laneBytes));
+			}
+
+			return detail::combineLaneChecksums(checksums.data(), laneCount) == array.dataChecksum;
+		}
+
+		// starts reading an array in ahead of use, e.g. the next clip while the current one plays
+		void prefetch(size_t index) const
+		{
+			if (index < size())
+			{
+				mapping.prefetch(directory[index].offset, directory[index].size);
+			}
+		}
+
+	private:
+		bool fail(ArchiveError error)
+		{
+			mapping.close();
+			directory = nullptr;
+			status = error;
+			return false;
+		}
+
+		detail::MappedFile mapping;
+		ArchiveHeader header = {};
+		const ArrayDescriptor* directory = nullptr;
+		ArchiveError status = ArchiveError::None;
+	};
+
+	// reads ranges of arrays into caller memory with plain file reads, for address-space limited targets or when the
+	// data is consumed once in chunks (upload to the GPU, conversion), validation is the same as MappedArchive's
+	class ArchiveReader
+	{
+	public:
+		static constexpr size_t NOT_FOUND = size_t(-1);
+
+		ArchiveReader() = default;
+
+		explicit ArchiveReader(const char* path)
+		{
+			open(path);
+		}
+
+		~ArchiveReader()
+		{
+			close();
+		}
+
+		ArchiveReader(const ArchiveReader&) = delete;
+		ArchiveReader& operator=(const ArchiveReader&) = delete;
+
+		bool open(const char* path)
+		{
+			close();
+			file = std::fopen(path, "rb");
+
+			if (file == nullptr)
+			{
+				return fail(ArchiveError::OpenFailed);
+			}
+
+#if defined(_WIN32)
+			bool sized = _fseeki64(file, 0, SEEK_END) == 0;
+			uint64_t fileSize = sized ? uint64_t(_ftelli64(file)) : 0;
+#else
+			bool sized = fseeko(file, 0, SEEK_END) == 0;
+			uint64_t fileSize = sized ? uint64_t(ftello(file)) : 0;
+#endif
+
+			if (!sized || fileSize < sizeof(ArchiveHeader) || !readAt(0, &header, sizeof(ArchiveHeader)))
+			{
+				return fail(sized ? ArchiveError::NotAnArchive : ArchiveError::ReadFailed);
+			}
+
+			ArchiveError result = detail::validateHeader(header, fileSize);
+
+			if (result != ArchiveError::None)
+			{
+				return fail(result);
+			}
+
+			directory.resize(header.arrayCount);
+
+			if (!readAt(header.directoryOffset, directory.data(), directory.size() * sizeof(ArrayDescriptor)))
+			{
+				return fail(ArchiveError::ReadFailed);
+			}
+
+			if (detail::crc32c(0, directory.data(), directory.size() * sizeof(ArrayDescriptor)) != header.directoryChecksum)
+			{
+				return fail(ArchiveError::DirectoryChecksum);
+			}
+
+			result = detail::validateArchive(header, directory.data(), fileSize);
+			return result == ArchiveError::None ? true : fail(result);
+		}
+
+		void close()
+		{
+			if (file != nullptr)
+			{
+				std::fclose(file);
+			}
+
+			file = nullptr;
+			directory.clear();
+			status = ArchiveError::None;
+		}
+
+		ArchiveError error() const
+		{
+			return status;
+		}
+
+		size_t size() const
+		{
+			return directory.size();
+		}
+
+		const ArrayDescriptor& descriptor(size_t index) const
+		{
+			assert(index < size());
+			return directory[index];
+		}
+
+		size_t find(const char* name) const
+		{
+			for (size_t i = 0; i < directory.size(); i++)
+			{
+				if (std::strncmp(directory[i].name, name, sizeof(directory[i].name)) == 0)
+				{
+					return i;
+				}
+			}
+
+			return NOT_FOUND;
+		}
+
+		// elements [ first, first + count ) of an AoS array of T into dst, returns how many there were (0 on a type mismatch)
+		template<typename T>
+		size_t read(size_t index, size_t first, size_t count, T* dst)
+		{
+			if (file == nullptr || index >= size() || !detail::describes<T>(directory[index], ArrayLayout::AoS) || first >= directory[index].count)
+			{
+				return 0;
+			}
+
+			count = size_t(std::min<uint64_t>(count, directory[index].count - first));
+			return readAt(directory[index].offset + first * sizeof(T), dst, count * sizeof(T)) ? count : 0;
+		}
+
+		// elements [ first, first + count ) of an SoA array into dst, resized to what was read
+		template<typename T, size_t C>
+		size_t readLanes(size_t index, size_t first, size_t count, VectorArray<T, C>& dst)
+		{
+			if (file == nullptr || index >= size() || !detail::describes<Vector<T, C>>(directory[index], ArrayLayout::SoA) || first >= directory[index].count)
+			{
+				dst.resize(0);
+				return 0;
+			}
+
+			count = size_t(std::min<uint64_t>(count, directory[index].count - first));
+			dst.resize(count);
+
+			for (size_t i = 0; i < C; i++)
+			{
+				if (!readAt(directory[index].offset + i * directory[index].lanePitch + first * sizeof(T), dst.lane(i), count * sizeof(T)))
+				{
+					dst.resize(0);
+					return 0;
+				}
+			}
+
+			return count;
+		}
+
+	private:
+		bool readAt(uint64_t offset, void* dst, size_t size)
+		{
+			if (size == 0)
+			{
+				return true;
+			}
+
+			if (!detail::seekFile(file, offset) || std::fread(dst, 1, size, file) != size)
+			{
+				status = ArchiveError::ReadFailed;
+				return false;
+			}
+
+			return true;
+		}
+
+		bool fail(ArchiveError error)
+		{
+			if (file != nullptr)
+			{
+				std::fclose(file);
+			}
+
+			file = nullptr;
+			directory.clear();
+			status = error;
+			return false;
+		}
+
+		std::FILE* file = nullptr;
+		ArchiveHeader header = {};
+		std::vector<ArrayDescriptor> directory;
+		ArchiveError status = ArchiveError::None;
+	};
+}
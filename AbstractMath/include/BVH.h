@@ -0,0 +1,986 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <assert.h>
+
+#include "Simd.h"
+#include "Profiling.h"
+#include "Vector.h"
+#include "Vec3.h"
+#include "Memory.h"
+#include "Parallel.h"
+#include "Intersection.h"
+
+namespace AbstractMath {
+
+	// the surface point nearest to a query point, index is the triangle's position in the array the BVH was built
+	// from or NO_HIT
+	template<typename T>
+	struct SurfacePoint
+	{
+		static constexpr uint32_t NO_HIT = UINT32_MAX;
+
+		Vector3<T> point;
+		T distanceSquared = std::numeric_limits<T>::infinity();
+		uint32_t index = NO_HIT;
+
+		constexpr bool hit() const
+		{
+			return index != NO_HIT;
+		}
+	};
+
+	namespace detail {
+
+		// one ray against the four child boxes of a BVH node (rows min x, y, z then max x, y, z), the slab to enter
+		// through is picked from the direction's sign once per ray so no min/max of the slab pair is needed per node
+		// the far distance is widened by a few ulps (Ize, Robust BVH Ray Traversal) so a hit exactly on a box face,
+		// which the triangle test accepts, is not lost to the rounding of the slab distances
+		template<typename T>
+		struct NodeRay
+		{
+			T origin[3], inverse[3];
+			size_t nearRow[3], farRow[3];
+			T tMin;
+
+			explicit NodeRay(const Ray<T>& ray) : tMin(ray.tMin)
+			{
+				Vector3<T> inverseDirection = ray.inverseDirection();
+
+				for (size_t axis = 0; axis < 3; axis++)
+				{
+					origin[axis] = ray.origin.data[axis];
+					inverse[axis] = inverseDirection.data[axis];
+					nearRow[axis] = std::signbit(inverse[axis]) ? 3 + axis : axis;
+					farRow[axis] = std::signbit(inverse[axis]) ? axis : 3 + axis;
+				}
+			}
+
+			// bit i set when child i is entered before tMax, tNear[i] is where (only meaningful for set bits)
+			int test(const T (&bounds)[6][4], T tMax, T* tNear) const
+			{
+				const T widen = T(1) + T(4) * std::numeric_limits<T>::epsilon();
+
+#if defined(ABSTRACTMATH_SSE)
+				if constexpr (std::is_same<T, float>::value)
+				{
+					//max_ps/min_ps return their second operand when the first is NaN (0 * inf of a ray lying in a slab
+					//plane), the running bound, so such a slab does not clip
+					__m128 enter = _mm_set1_ps(tMin), exit = _mm_set1_ps(tMax);
+
+					for (size_t axis = 0; axis < 3; axis++)
+					{
+						__m128 o = _mm_set1_ps(origin[axis]), inv = _mm_set1_ps(inverse[axis]);
+						enter = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(bounds[nearRow[axis]]), o), inv), enter);
+						exit = _mm_min_ps(_mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(bounds[farRow[axis]]), o), inv), _mm_set1_ps(widen)), exit);
+					}
+
+					_mm_store_ps(tNear, enter);
+					return _mm_movemask_ps(_mm_cmple_ps(enter, exit));
+				}
+				else
+#endif
+				{
+					int mask = 0;
+
+					for (size_t i = 0; i < 4; i++)
+					{
+						T enter = tMin, exit = tMax;
+
+						for (size_t axis = 0; axis < 3; axis++)
+						{
+							T t0 = (bounds[nearRow[axis]][i] - origin[axis]) * inverse[axis];
+							T t1 = (bounds[farRow[axis]][i] - origin[axis]) * inverse[axis] * widen;
+							enter = t0 > enter ? t0 : enter;
+							exit = t1 < exit ? t1 : exit;
+						}
+
+						tNear[i] = enter;
+						mask |= enter <= exit ? 1 << i : 0;
+					}
+
+					return mask;
+				}
+			}
+		};
+
+		// bit i set when child i's box overlaps box
+		template<typename T>
+		int overlapMask(const T (&bounds)[6][4], const AABB<T>& box)
+		{
+#if defined(ABSTRACTMATH_SSE)
+			if constexpr (std::is_same<T, float>::value)
+			{
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+				for (size_t axis = 0; axis < 3; axis++)
+				{
+					inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_load_ps(bounds[axis]), _mm_set1_ps(box.max.data[axis])));
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_load_ps(bounds[3 + axis]), _mm_set1_ps(box.min.data[axis])));
+				}
+
+				return _mm_movemask_ps(inside);
+			}
+			else
+#endif
+			{
+				int mask = 0;
+
+				for (size_t i = 0; i < 4; i++)
+				{
+					bool inside = true;
+
+					for (size_t axis = 0; axis < 3; axis++)
+					{
+						inside = inside && bounds[axis][i] <= box.max.data[axis] && bounds[3 + axis][i] >= box.min.data[axis];
+					}
+
+					mask |= inside ? 1 << i : 0;
+				}
+
+				return mask;
+			}
+		}
+
+		// bit i set when child i's box is nearer than sqrt(limit) to point, distances[i] is the squared distance
+		// (zero inside), empty children are infinitely far
+		template<typename T>
+		int pointMask(const T (&bounds)[6][4], const Vector<T, 3>& point, T limit, T* distances)
+		{
+#if defined(ABSTRACTMATH_SSE)
+			if constexpr (std::is_same<T, float>::value)
+			{
+				__m128 sum = _mm_setzero_ps();
+
+				for (size_t axis = 0; axis < 3; axis++)
+				{
+					__m128 p = _mm_set1_ps(point.data[axis]);
+					__m128 d = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(bounds[axis]), p), _mm_sub_ps(p, _mm_load_ps(bounds[3 + axis]))), _mm_setzero_ps());
+					sum = _mm_add_ps(sum, _mm_mul_ps(d, d));
+				}
+
+				_mm_store_ps(distances, sum);
+				return _mm_movemask_ps(_mm_cmplt_ps(sum, _mm_set1_ps(limit)));
+			}
+			else
+#endif
+			{
+				int mask = 0;
+
+				for (size_t i = 0; i < 4; i++)
+				{
+					T sum = T(0);
+
+					for (size_t axis = 0; axis < 3; axis++)
+					{
+						T d = std::max(std::max(bounds[axis][i] - point.data[axis], point.data[axis] - bounds[3 + axis][i]), T(0));
+						sum += d * d;
+					}
+
+					distances[i] = sum;
+					mask |= sum < limit ? 1 << i : 0;
+				}
+
+				return mask;
+			}
+		}
+	}
+
+	// 4-wide bounding volume hierarchy over triangles (ray casts, overlap and nearest-surface queries) or over plain
+	// boxes (overlap queries), built top-down with binned SAH and split across the job system
+	// a node holds the boxes of its four children as SoA rows so one SSE compare tests a ray, box or point against all
+	// of them, with the child links it is 128 bytes for float (two cache lines, aligned), nodes are stored depth-first
+	// so a child always comes after its parent
+	// leaves hold up to LEAF_SIZE primitives, their triangles are copied into a TriangleArray in leaf order and padded
+	// to whole blocks of eight so intersectClosest tests a leaf in AVX2 registers without a scalar tail
+	template<typename T>
+	class BVH
+	{
+		static_assert(std::is_floating_point<T>::value, "BVH requires a floating point type!");
+
+	public:
+		static constexpr size_t WIDTH = 4;
+		static constexpr size_t LEAF_SIZE = 8;
+		static constexpr uint32_t INVALID = UINT32_MAX;
+
+		struct alignas(CACHE_LINE_SIZE) Node
+		{
+			T bounds[6][WIDTH]; //min x, y, z then max x, y, z of each child, unused children are empty boxes
+			uint32_t child[WIDTH]; //node index, first slot of a leaf's primitives, or INVALID
+			uint32_t count[WIDTH]; //primitives of a leaf, 0 for an inner node
+
+			bool isLeaf(size_t i) const { return count[i] > 0; }
+			bool isEmpty(size_t i) const { return count[i] == 0 && child[i] == INVALID; }
+		};
+
+		static_assert(sizeof(T) != sizeof(float) || sizeof(Node) == 2 * CACHE_LINE_SIZE, "A float node must fill two cache lines!");
+
+		BVH() = default;
+
+		// rebuilds from scratch, the triangles are copied so the source can go away
+		void build(const Triangle<T>* triangles, size_t count)
+		{
+			ABSTRACTMATH_PROFILE_SCOPE(BvhBuild, count);
+			assert(count < size_t(INVALID));
+
+			std::vector<AABB<T>> boxes(count);
+			parallelTransform(triangles, boxes.data(), count, [](const Triangle<T>& triangle) { return triangle.bounds(); });
+			buildFromBounds(boxes);
+
+			this->triangles.clear(); //zeroes the old triangles, the padding slots must hold ones that never hit
+			this->triangles.resize(paddedCount);
+			parallelFor(0, paddedCount, detail::cacheGrain<sizeof(Triangle<T>)>(), [this, triangles](size_t first, size_t last)
+			{
+				for (size_t slot = first; slot < last; slot++)
+				{
+					if (primitives[slot] != INVALID)
+					{
+						this->triangles.set(slot, triangles[primitives[slot]]);
+					}
+				}
+			});
+		}
+
+		// a hierarchy of plain boxes (colliders, entities), only overlapping() applies to it
+		void build(const AABB<T>* boxes, size_t count)
+		{
+			ABSTRACTMATH_PROFILE_SCOPE(BvhBuild, count);
+			assert(count < size_t(INVALID));
+
+			triangles.clear();
+			buildFromBounds(std::vector<AABB<T>>(boxes, boxes + count));
+		}
+
+		// deforming geometry: the same triangles (same count and order as the build) moved, the tree keeps its
+		// topology and only its boxes are recomputed, which is far cheaper than a build but lets the boxes grow loose
+		// when the motion is large, rebuild then
+		void refit(const Triangle<T>* triangles)
+		{
+			ABSTRACTMATH_PROFILE_SCOPE(BvhBuild, primitiveCount);
+			assert(!this->triangles.empty() || primitiveCount == 0);
+
+			parallelFor(0, paddedCount, detail::cacheGrain<sizeof(Triangle<T>) + sizeof(AABB<T>)>(), [this, triangles](size_t first, size_t last)
+			{
+				for (size_t slot = first; slot < last; slot++)
+				{
+					if (primitives[slot] != INVALID)
+					{
+						const Triangle<T>& triangle = triangles[primitives[slot]];
+						this->triangles.set(slot, triangle);
+						primitiveBounds[slot] = triangle.bounds();
+					}
+				}
+			});
+
+			refitNodes();
+		}
+
+		void refit(const AABB<T>* boxes)
+		{
+			ABSTRACTMATH_PROFILE_SCOPE(BvhBuild, primitiveCount);
+			assert(this->triangles.empty());
+
+			parallelFor(0, paddedCount, detail::cacheGrain<sizeof(AABB<T>) * 2>(), [this, boxes](size_t first, size_t last)
+			{
+				for (size_t slot = first; slot < last; slot++)
+				{
+					if (primitives[slot] != INVALID)
+					{
+						primitiveBounds[slot] = boxes[primitives[slot]];
+					}
+				}
+			});
+
+			refitNodes();
+		}
+
+		size_t size() const { return primitiveCount; }
+		bool empty() const { return primitiveCount == 0; }
+		const aligned_vector<Node>& getNodes() const { return nodes; }
+
+		AABB<T> bounds() const
+		{
+			AABB<T> result;
+
+			for (size_t i = 0; !nodes.empty() && i < WIDTH; i++)
+			{
+				result.expand(childBounds(nodes[0], i));
+			}
+
+			return result;
+		}
+
+		// closest triangle hit along the ray, like intersectClosest only hits nearer than hit.t and the ray's tMax count,
+		// hit.index is the triangle's index in the build input
+		bool intersect(const Ray<T>& ray, RayHit<T>& hit) const
+		{
+			assert(!triangles.empty() || primitiveCount == 0);
+
+			if (nodes.empty())
+			{
+				return false;
+			}
+
+			const detail::NodeRay<T> nodeRay(ray);
+			RayHit<T> local; //slots of the leaf order, mapped back at the end
+			local.t = std::min(hit.t, ray.tMax);
+			StackEntry stack[STACK_SIZE];
+			size_t top = 0;
+			stack[top++] = StackEntry{ 0, ray.tMin };
+
+			while (top > 0)
+			{
+				const StackEntry entry = stack[--top];
+
+				if (entry.distance > local.t)
+				{
+					continue;
+				}
+
+				const Node& node = nodes[entry.node];
+				alignas(16) T tNear[WIDTH];
+				int mask = nodeRay.test(node.bounds, local.t, tNear);
+				size_t pushed = top;
+
+				for (size_t i = 0; i < WIDTH; i++)
+				{
+					if ((mask >> i) & 1)
+					{
+						if (node.isLeaf(i))
+						{
+							intersectClosest(ray, triangles, node.child[i], node.child[i] + paddedLeafSize(node.count[i]), local);
+						}
+						else
+						{
+							assert(top < STACK_SIZE);
+							stack[top++] = StackEntry{ node.child[i], tNear[i] };
+						}
+					}
+				}
+
+				//farthest first so the nearest child is popped next
+				std::sort(stack + pushed, stack + top, [](const StackEntry& a, const StackEntry& b) { return a.distance > b.distance; });
+			}
+
+			if (!local.hit())
+			{
+				return false;
+			}
+
+			hit.t = local.t;
+			hit.u = local.u;
+			hit.v = local.v;
+			hit.index = primitives[local.index];
+			return true;
+		}
+
+		// whether any triangle blocks the ray within [tMin, tMax], stops at the first one found
+		bool occluded(const Ray<T>& ray) const
+		{
+			assert(!triangles.empty() || primitiveCount == 0);
+
+			if (nodes.empty())
+			{
+				return false;
+			}
+
+			const detail::NodeRay<T> nodeRay(ray);
+			uint32_t stack[STACK_SIZE];
+			size_t top = 0;
+			stack[top++] = 0;
+
+			while (top > 0)
+			{
+				const Node& node = nodes[stack[--top]];
+				alignas(16) T tNear[WIDTH];
+				int mask = nodeRay.test(node.bounds, ray.tMax, tNear);
+
+				for (size_t i = 0; i < WIDTH; i++)
+				{
+					if ((mask >> i) & 1)
+					{
+						if (node.isLeaf(i))
+						{
+							if (intersectAny(ray, triangles, node.child[i], node.child[i] + paddedLeafSize(node.count[i])))
+							{
+								return true;
+							}
+						}
+						else
+						{
+							assert(top < STACK_SIZE);
+							stack[top++] = node.child[i];
+						}
+					}
+				}
+			}
+
+			return false;
+		}
+
+		// closest hits of many rays (picking, line of sight and audio batches), hits[i] is reset and filled for rays[i],
+		// the rays are split across the job system
+		void intersect(const RayArray<T>& rays, RayHit<T>* hits) const
+		{
+			ABSTRACTMATH_PROFILE_SCOPE(RayQuery, rays.size());
+
+			parallelFor(0, rays.size(), RAY_GRAIN, [this, &rays, hits](size_t first, size_t last)
+			{
+				for (size_t i = first; i < last; i++)
+				{
+					hits[i] = RayHit<T>();
+					intersect(rays.get(i), hits[i]);
+				}
+			});
+		}
+
+		// appends the build indices of the primitives whose boxes overlap box to result and returns how many were added
+		size_t overlapping(const AABB<T>& box, std::vector<uint32_t>& result) const
+		{
+			if (nodes.empty())
+			{
+				return 0;
+			}
+
+			const size_t before = result.size();
+			uint32_t stack[STACK_SIZE];
+			size_t top = 0;
+			stack[top++] = 0;
+
+			while (top > 0)
+			{
+				const Node& node = nodes[stack[--top]];
+				int mask = detail::overlapMask(node.bounds, box);
+
+				for (size_t i = 0; i < WIDTH; i++)
+				{
+					if ((mask >> i) & 1)
+					{
+						if (node.isLeaf(i))
+						{
+							for (uint32_t slot = node.child[i]; slot < node.child[i] + node.count[i]; slot++)
+							{
+								if (primitiveBounds[slot].overlaps(box))
+								{
+									result.push_back(primitives[slot]);
+								}
+							}
+						}
+						else
+						{
+							assert(top < STACK_SIZE);
+							stack[top++] = node.child[i];
+						}
+					}
+				}
+			}
+
+			return result.size() - before;
+		}
+
+		// the nearest point on any triangle within maxDistance of point, result is updated and true returned when one
+		// is found (a result already holding a closer point from another BVH is kept)
+		bool closestPoint(const Vector<T, 3>& point, SurfacePoint<T>& result, T maxDistance = std::numeric_limits<T>::infinity()) const
+		{
+			assert(!triangles.empty() || primitiveCount == 0);
+
+			if (nodes.empty())
+			{
+				return false;
+			}
+
+			T best = std::min(result.distanceSquared, maxDistance * maxDistance);
+			bool found = false;
+			StackEntry stack[STACK_SIZE];
+			size_t top = 0;
+			stack[top++] = StackEntry{ 0, T(0) };
+
+			while (top > 0)
+			{
+				const StackEntry entry = stack[--top];
+
+				if (entry.distance >= best)
+				{
+					continue;
+				}
+
+				const Node& node = nodes[entry.node];
+				alignas(16) T distances[WIDTH];
+				int mask = detail::pointMask(node.bounds, point, best, distances);
+				size_t pushed = top;
+
+				for (size_t i = 0; i < WIDTH; i++)
+				{
+					if (((mask >> i) & 1) == 0)
+					{
+						continue;
+					}
+
+					if (!node.isLeaf(i))
+					{
+						assert(top < STACK_SIZE);
+						stack[top++] = StackEntry{ node.child[i], distances[i] };
+						continue;
+					}
+
+					for (uint32_t slot = node.child[i]; slot < node.child[i] + node.count[i]; slot++)
+					{
+						Triangle<T> triangle = triangles.get(slot);
+						Vector3<T> nearest = closestPointOnTriangle(point, triangle.v0, triangle.v1, triangle.v2);
+						Vector<T, 3> offset = nearest - point;
+						T distanceSquared = offset.dot(offset);
+
+						if (distanceSquared < best)
+						{
+							best = distanceSquared;
+							result.point = nearest;
+							result.distanceSquared = distanceSquared;
+							result.index = primitives[slot];
+							found = true;
+						}
+					}
+				}
+
+				std::sort(stack + pushed, stack + top, [](const StackEntry& a, const StackEntry& b) { return a.distance > b.distance; });
+			}
+
+			return found;
+		}
+
+	private:
+		// SAH bins per split, more barely lowers the tree cost, fewer starts to
+		static constexpr size_t BIN_COUNT = 16;
+		// ranges at least this large have their bins filled and their subtrees built in parallel
+		static constexpr size_t PARALLEL_BUILD_SIZE = 1 << 14;
+		// levels split by SAH before falling back to median splits, which bounds the depth (and the traversal stack)
+		// whatever the input: below it every split at least halves a range
+		static constexpr size_t MAX_SAH_DEPTH = 48;
+		// every level holds at most three pending siblings, a median level at least halves a range (32 of them reach one
+		// primitive from 2^32)
+		static constexpr size_t STACK_SIZE = 3 * (MAX_SAH_DEPTH + 32) + WIDTH;
+		static constexpr size_t RAY_GRAIN = 64;
+
+		struct StackEntry
+		{
+			uint32_t node;
+			T distance; //where the ray enters the node's box, or the squared distance of the query point to it
+		};
+
+		struct Range
+		{
+			size_t begin, end;
+			AABB<T> bounds, centroids;
+
+			size_t size() const { return end - begin; }
+		};
+
+		struct Bin
+		{
+			AABB<T> bounds, centroids;
+			size_t count = 0;
+		};
+
+		static size_t paddedLeafSize(size_t count)
+		{
+			return (count + 7) / 8 * 8;
+		}
+
+		static AABB<T> childBounds(const Node& node, size_t i)
+		{
+			return AABB<T>(Vector3<T>(node.bounds[0][i], node.bounds[1][i], node.bounds[2][i]), Vector3<T>(node.bounds[3][i], node.bounds[4][i], node.bounds[5][i]));
+		}
+
+		static void setChildBounds(Node& node, size_t i, const AABB<T>& box)
+		{
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				node.bounds[axis][i] = box.min.data[axis];
+				node.bounds[3 + axis][i] = box.max.data[axis];
+			}
+		}
+
+		static Node emptyNode()
+		{
+			Node node;
+
+			for (size_t i = 0; i < WIDTH; i++)
+			{
+				setChildBounds(node, i, AABB<T>());
+				node.child[i] = INVALID;
+				node.count[i] = 0;
+			}
+
+			return node;
+		}
+
+		void buildFromBounds(std::vector<AABB<T>> boxes)
+		{
+			const size_t count = boxes.size();
+			primitiveCount = count;
+			nodes.clear();
+			order.resize(count);
+			centroids.resize(count);
+
+			if (count == 0)
+			{
+				primitives.clear();
+				primitiveBounds.clear();
+				paddedCount = 0;
+				return;
+			}
+
+			Range root{ 0, count, AABB<T>(), AABB<T>() };
+			std::vector<Range> partial((count + PARALLEL_BUILD_SIZE - 1) / PARALLEL_BUILD_SIZE);
+
+			parallelFor(0, count, PARALLEL_BUILD_SIZE, [this, &boxes, &partial](size_t first, size_t last)
+			{
+				Range& chunk = partial[first / PARALLEL_BUILD_SIZE];
+
+				for (size_t i = first; i < last; i++)
+				{
+					order[i] = uint32_t(i);
+					centroids[i] = boxes[i].center();
+					chunk.bounds.expand(boxes[i]);
+					chunk.centroids.expand(centroids[i]);
+				}
+			});
+
+			for (const Range& chunk : partial)
+			{
+				root.bounds.expand(chunk.bounds);
+				root.centroids.expand(chunk.centroids);
+			}
+
+			buildNode(nodes, boxes, root, 0);
+			layoutLeaves(boxes);
+
+			order = std::vector<uint32_t>();
+			centroids = std::vector<Vector3<T>>();
+		}
+
+		// the node for range and, recursively, its subtree appended to out (depth-first), returns its index in out
+		// the range is split into up to four children by splitting the child with the largest surface area again
+		// until there are four or none has more than LEAF_SIZE primitives
+		uint32_t buildNode(aligned_vector<Node>& out, const std::vector<AABB<T>>& boxes, const Range& range, size_t depth)
+		{
+			const uint32_t index = uint32_t(out.size());
+			out.push_back(emptyNode());
+
+			Range children[WIDTH] = { range };
+			size_t childCount = 1;
+
+			while (childCount < WIDTH)
+			{
+				size_t largest = WIDTH;
+				T largestArea = T(-1);
+
+				for (size_t i = 0; i < childCount; i++)
+				{
+					if (children[i].size() > LEAF_SIZE && children[i].bounds.surfaceArea() > largestArea)
+					{
+						largest = i;
+						largestArea = children[i].bounds.surfaceArea();
+					}
+				}
+
+				if (largest == WIDTH)
+				{
+					break;
+				}
+
+				Range left, right;
+				split(boxes, children[largest], depth, left, right);
+				children[largest] = left;
+				children[childCount++] = right;
+			}
+
+			uint32_t links[WIDTH] = { INVALID, INVALID, INVALID, INVALID };
+
+			if (range.size() >= PARALLEL_BUILD_SIZE)
+			{
+				//subtrees built side by side into their own arrays, then appended in child order with their links
+				//moved, so the layout is the same as a serial build's
+				aligned_vector<Node> subtrees[WIDTH];
+
+				parallelFor(0, childCount, 1, [&](size_t first, size_t last)
+				{
+					for (size_t i = first; i < last; i++)
+					{
+						if (children[i].size() > LEAF_SIZE)
+						{
+							buildNode(subtrees[i], boxes, children[i], depth + 1);
+						}
+					}
+				});
+
+				for (size_t i = 0; i < childCount; i++)
+				{
+					if (subtrees[i].empty())
+					{
+						continue;
+					}
+
+					const uint32_t offset = uint32_t(out.size());
+					links[i] = offset;
+
+					for (Node& node : subtrees[i])
+					{
+						for (size_t c = 0; c < WIDTH; c++)
+						{
+							node.child[c] += node.count[c] == 0 && node.child[c] != INVALID ? offset : 0;
+						}
+
+						out.push_back(node);
+					}
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < childCount; i++)
+				{
+					if (children[i].size() > LEAF_SIZE)
+					{
+						links[i] = buildNode(out, boxes, children[i], depth + 1);
+					}
+				}
+			}
+
+			Node& node = out[index];
+
+			for (size_t i = 0; i < childCount; i++)
+			{
+				setChildBounds(node, i, children[i].bounds);
+				const bool leaf = children[i].size() <= LEAF_SIZE;
+				node.child[i] = leaf ? uint32_t(children[i].begin) : links[i]; //leaves point into order until layoutLeaves()
+				node.count[i] = leaf ? uint32_t(children[i].size()) : 0;
+			}
+
+			return index;
+		}
+
+		// binned SAH along the longest axis of the centroids' bounds, order[range] is partitioned in place
+		void split(const std::vector<AABB<T>>& boxes, const Range& range, size_t depth, Range& left, Range& right)
+		{
+			size_t axis = 0;
+			Vector<T, 3> extent = range.centroids.max - range.centroids.min;
+			axis = extent.data[1] > extent.data[axis] ? 1 : axis;
+			axis = extent.data[2] > extent.data[axis] ? 2 : axis;
+
+			if (!(extent.data[axis] > T(0)) || depth >= MAX_SAH_DEPTH)
+			{
+				splitMedian(boxes, range, axis, left, right);
+				return;
+			}
+
+			const T origin = range.centroids.min.data[axis];
+			const T scale = T(BIN_COUNT) / extent.data[axis];
+			auto binOf = [this, origin, scale, axis](uint32_t primitive)
+			{
+				size_t bin = size_t((centroids[primitive].data[axis] - origin) * scale);
+				return bin < BIN_COUNT ? bin : BIN_COUNT - 1;
+			};
+
+			Bin bins[BIN_COUNT];
+			auto fill = [&](Bin* target, size_t first, size_t last)
+			{
+				for (size_t i = first; i < last; i++)
+				{
+					Bin& bin = target[binOf(order[i])];
+					bin.bounds.expand(boxes[order[i]]);
+					bin.centroids.expand(centroids[order[i]]);
+					bin.count++;
+				}
+			};
+
+			if (range.size() < PARALLEL_BUILD_SIZE)
+			{
+				fill(bins, range.begin, range.end);
+			}
+			else
+			{
+				//per chunk bins merged in chunk order, the same bounds whatever thread filled them
+				const size_t chunks = (range.size() + PARALLEL_BUILD_SIZE - 1) / PARALLEL_BUILD_SIZE;
+				std::vector<Bin> partial(chunks * BIN_COUNT);
+
+				parallelFor(range.begin, range.end, PARALLEL_BUILD_SIZE, [&](size_t first, size_t last)
+				{
+					fill(partial.data() + (first - range.begin) / PARALLEL_BUILD_SIZE * BIN_COUNT, first, last);
+				});
+
+				for (size_t c = 0; c < chunks; c++)
+				{
+					for (size_t b = 0; b < BIN_COUNT; b++)
+					{
+						const Bin& bin = partial[c * BIN_COUNT + b];
+						bins[b].bounds.expand(bin.bounds);
+						bins[b].centroids.expand(bin.centroids);
+						bins[b].count += bin.count;
+					}
+				}
+			}
+
+			//cost of splitting after bin k - 1 is area(left) * count(left) + area(right) * count(right)
+			T rightCost[BIN_COUNT] = {};
+			AABB<T> sweep;
+			size_t sweepCount = 0;
+
+			for (size_t k = BIN_COUNT - 1; k > 0; k--)
+			{
+				sweep.expand(bins[k].bounds);
+				sweepCount += bins[k].count;
+				rightCost[k] = sweep.surfaceArea() * T(sweepCount);
+			}
+
+			size_t best = 0;
+			T bestCost = std::numeric_limits<T>::infinity();
+			sweep = AABB<T>();
+			sweepCount = 0;
+
+			for (size_t k = 1; k < BIN_COUNT; k++)
+			{
+				sweep.expand(bins[k - 1].bounds);
+				sweepCount += bins[k - 1].count;
+				T cost = sweep.surfaceArea() * T(sweepCount) + rightCost[k];
+
+				if (sweepCount > 0 && sweepCount < range.size() && cost < bestCost)
+				{
+					best = k;
+					bestCost = cost;
+				}
+			}
+
+			if (best == 0)
+			{
+				splitMedian(boxes, range, axis, left, right);
+				return;
+			}
+
+			uint32_t* middle = std::partition(order.data() + range.begin, order.data() + range.end, [&](uint32_t primitive) { return binOf(primitive) < best; });
+
+			left = Range{ range.begin, size_t(middle - order.data()), AABB<T>(), AABB<T>() };
+			right = Range{ left.end, range.end, AABB<T>(), AABB<T>() };
+
+			for (size_t k = 0; k < BIN_COUNT; k++)
+			{
+				Range& side = k < best ? left : right;
+				side.bounds.expand(bins[k].bounds);
+				side.centroids.expand(bins[k].centroids);
+			}
+		}
+
+		// halves the range at the median centroid along axis (at the middle index when every centroid coincides)
+		void splitMedian(const std::vector<AABB<T>>& boxes, const Range& range, size_t axis, Range& left, Range& right)
+		{
+			const size_t middle = range.begin + range.size() / 2;
+			std::nth_element(order.data() + range.begin, order.data() + middle, order.data() + range.end,
+				[this, axis](uint32_t a, uint32_t b) { return centroids[a].data[axis] < centroids[b].data[axis]; });
+
+			left = Range{ range.begin, middle, AABB<T>(), AABB<T>() };
+			right = Range{ middle, range.end, AABB<T>(), AABB<T>() };
+
+			for (Range* side : { &left, &right })
+			{
+				for (size_t i = side->begin; i < side->end; i++)
+				{
+					side->bounds.expand(boxes[order[i]]);
+					side->centroids.expand(centroids[order[i]]);
+				}
+			}
+		}
+
+		// gives every leaf its slots in node order, each leaf starting on a block of eight, and fills the slot tables
+		void layoutLeaves(const std::vector<AABB<T>>& boxes)
+		{
+			size_t slots = 0;
+
+			for (const Node& node : nodes)
+			{
+				for (size_t i = 0; i < WIDTH; i++)
+				{
+					slots += node.isLeaf(i) ? paddedLeafSize(node.count[i]) : 0;
+				}
+			}
+
+			assert(slots < size_t(INVALID));
+			paddedCount = slots;
+			primitives.assign(paddedCount, INVALID);
+			primitiveBounds.assign(paddedCount, AABB<T>());
+			slots = 0;
+
+			for (Node& node : nodes)
+			{
+				for (size_t i = 0; i < WIDTH; i++)
+				{
+					if (!node.isLeaf(i))
+					{
+						continue;
+					}
+
+					const size_t begin = node.child[i];
+					node.child[i] = uint32_t(slots);
+
+					for (size_t k = 0; k < node.count[i]; k++)
+					{
+						primitives[slots + k] = order[begin + k];
+						primitiveBounds[slots + k] = boxes[order[begin + k]];
+					}
+
+					slots += paddedLeafSize(node.count[i]);
+				}
+			}
+		}
+
+		void refitNodes()
+		{
+			for (size_t n = nodes.size(); n-- > 0;)
+			{
+				Node& node = nodes[n];
+
+				for (size_t i = 0; i < WIDTH; i++)
+				{
+					if (node.isEmpty(i))
+					{
+						continue;
+					}
+
+					AABB<T> box;
+
+					if (node.isLeaf(i))
+					{
+						for (uint32_t slot = node.child[i]; slot < node.child[i] + node.count[i]; slot++)
+						{
+							box.expand(primitiveBounds[slot]);
+						}
+					}
+					else
+					{
+						const Node& child = nodes[node.child[i]];
+
+						for (size_t c = 0; c < WIDTH; c++)
+						{
+							box.expand(childBounds(child, c));
+						}
+					}
+
+					setChildBounds(node, i, box);
+				}
+			}
+		}
+
+		aligned_vector<Node> nodes;
+		TriangleArray<T> triangles; //leaf order, empty for a BVH of boxes
+		std::vector<AABB<T>> primitiveBounds; //leaf order
+		std::vector<uint32_t> primitives; //leaf slot to build index, INVALID for padding
+		size_t primitiveCount = 0;
+		size_t paddedCount = 0;
+
+		//build scratch, released when the build ends
+		std::vector<uint32_t> order;
+		std::vector<Vector3<T>> centroids;
+	};
+}
@@ -0,0 +1,317 @@
+#pragma once
+
+#include <type_traits>
+#include <cmath>
+#include <assert.h>
+
+#include "Simd.h"
+#include "Profiling.h"
+#include "Matrix.h"
+#include "Quaternion.h"
+#include "VectorArray.h"
+
+namespace AbstractMath {
+
+	// quaternion streams for animation blending, stored as VectorArray<T, 4> with lanes { x, y, z, w }
+	// every kernel takes the shorter arc per element and gives the same results as the matching Quaternion member
+	// float uses AVX2 when available (eight rotations per iteration), other types the scalar loop
+	// dst may be one of the sources (in-place)
+
+	typedef VectorArray<float, 4> QuaternionfArray;
+	typedef VectorArray<double, 4> QuaterniondArray;
+
+	namespace detail {
+
+		template<typename T>
+		inline Quaternion<T> loadQuaternion(const T* const* lanes, size_t i)
+		{
+			return Quaternion<T>(lanes[0][i], lanes[1][i], lanes[2][i], lanes[3][i]);
+		}
+
+		template<typename T>
+		inline void storeQuaternion(const Quaternion<T>& value, T* const* lanes, size_t i)
+		{
+			for (size_t c = 0; c < 4; c++)
+			{
+				lanes[c][i] = value.data[c];
+			}
+		}
+
+#if defined(ABSTRACTMATH_AVX2)
+		inline __m256 dot4(const __m256* a, const __m256* b)
+		{
+			return multiplyAdd(a[3], b[3], multiplyAdd(a[2], b[2], multiplyAdd(a[1], b[1], _mm256_mul_ps(a[0], b[0]))));
+		}
+
+		inline void normalize4(__m256* q)
+		{
+			__m256 length = _mm256_sqrt_ps(dot4(q, q));
+
+			for (size_t c = 0; c < 4; c++)
+			{
+				q[c] = _mm256_div_ps(q[c], length);
+			}
+		}
+
+		inline __m256 slerpWeight(__m256 t, __m256 cosAngleMinusOne)
+		{
+			const __m256 one = _mm256_set1_ps(1.0f);
+			__m256 tt = _mm256_mul_ps(t, t);
+			__m256 sum = one;
+
+			for (size_t i = SLERP_TERMS; i-- > 0;)
+			{
+				__m256 term = _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(float(slerpSeriesU(i))), tt), _mm256_set1_ps(float(slerpSeriesV(i))));
+				sum = multiplyAdd(_mm256_mul_ps(term, cosAngleMinusOne), sum, one);
+			}
+
+			return _mm256_mul_ps(t, sum);
+		}
+#endif
+
+		// amounts (optional) gives every element its own amount, otherwise amount is used for all of them
+		template<bool SLERP, typename T>
+		void interpolateQuaternions(const T* const* a, const T* const* b, const T* amounts, T amount, T* const* dst, size_t count)
+		{
+			ABSTRACTMATH_PROFILE_SCOPE(BatchQuaternion, count);
+			size_t i = 0;
+
+#if defined(ABSTRACTMATH_AVX2)
+			if constexpr (std::is_same<T, float>::value)
+			{
+				const __m256 one = _mm256_set1_ps(1.0f);
+				const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+				for (; i + 8 <= count; i += 8)
+				{
+					__m256 qa[4], qb[4], result[4];
+
+					for (size_t c = 0; c < 4; c++)
+					{
+						qa[c] = _mm256_loadu_ps(a[c] + i);
+						qb[c] = _mm256_loadu_ps(b[c] + i);
+					}
+
+					__m256 t = amounts ? _mm256_loadu_ps(amounts + i) : _mm256_set1_ps(amount);
+					__m256 cosAngle = dot4(qa, qb);
+					__m256 sign = _mm256_and_ps(cosAngle, signMask); //flip b to the shorter arc by xor-ing in the sign of the dot
+
+					__m256 weight, otherWeight;
+
+					if constexpr (SLERP)
+					{
+						__m256 cosAngleMinusOne = _mm256_sub_ps(_mm256_xor_ps(cosAngle, sign), one);
+						weight = slerpWeight(_mm256_sub_ps(one, t), cosAngleMinusOne);
+						otherWeight = _mm256_xor_ps(slerpWeight(t, cosAngleMinusOne), sign);
+					}
+					else
+					{
+						weight = _mm256_sub_ps(one, t);
+						otherWeight = _mm256_xor_ps(t, sign);
+					}
+
+					for (size_t c = 0; c < 4; c++)
+					{
+						result[c] = multiplyAdd(otherWeight, qb[c], _mm256_mul_ps(weight, qa[c]));
+					}
+
+					if constexpr (!SLERP)
+					{
+						normalize4(result);
+					}
+
+					for (size_t c = 0; c < 4; c++)
+					{
+						_mm256_storeu_ps(dst[c] + i, result[c]);
+					}
+				}
+			}
+#endif
+
+			for (; i < count; i++)
+			{
+				Quaternion<T> qa = loadQuaternion(a, i);
+				Quaternion<T> qb = loadQuaternion(b, i);
+				T t = amounts ? amounts[i] : amount;
+				storeQuaternion(SLERP ? qa.fastSlerp(qb, t) : qa.nlerp(qb, t), dst, i);
+			}
+		}
+
+		template<typename T>
+		inline void prepareBlend(const VectorArray<T, 4>& a, const VectorArray<T, 4>& b, VectorArray<T, 4>& dst, const T* (&aLanes)[4], const T* (&bLanes)[4], T* (&dstLanes)[4])
+		{
+			assert(a.size() == b.size());
+			prepareOutput(a, dst);
+
+			for (size_t c = 0; c < 4; c++)
+			{
+				aLanes[c] = a.lane(c);
+				bLanes[c] = b.lane(c);
+				dstLanes[c] = dst.lane(c);
+			}
+		}
+	}
+
+	template<typename T>
+	void nlerp(const VectorArray<T, 4>& a, const VectorArray<T, 4>& b, T amount, VectorArray<T, 4>& dst)
+	{
+		const T* aLanes[4]; const T* bLanes[4]; T* dstLanes[4];
+		detail::prepareBlend(a, b, dst, aLanes, bLanes, dstLanes);
+		detail::interpolateQuaternions<false>(aLanes, bLanes, static_cast<const T*>(nullptr), amount, dstLanes, a.size());
+	}
+
+	// amounts holds one amount per element
+	template<typename T>
+	void nlerp(const VectorArray<T, 4>& a, const VectorArray<T, 4>& b, const T* amounts, VectorArray<T, 4>& dst)
+	{
+		const T* aLanes[4]; const T* bLanes[4]; T* dstLanes[4];
+		detail::prepareBlend(a, b, dst, aLanes, bLanes, dstLanes);
+		detail::interpolateQuaternions<false>(aLanes, bLanes, amounts, T(0), dstLanes, a.size());
+	}
+
+	// Quaternion::fastSlerp per element, exact slerp has no batch form since the series is already below float precision
+	template<typename T>
+	void fastSlerp(const VectorArray<T, 4>& a, const VectorArray<T, 4>& b, T amount, VectorArray<T, 4>& dst)
+	{
+		const T* aLanes[4]; const T* bLanes[4]; T* dstLanes[4];
+		detail::prepareBlend(a, b, dst, aLanes, bLanes, dstLanes);
+		detail::interpolateQuaternions<true>(aLanes, bLanes, static_cast<const T*>(nullptr), amount, dstLanes, a.size());
+	}
+
+	template<typename T>
+	void fastSlerp(const VectorArray<T, 4>& a, const VectorArray<T, 4>& b, const T* amounts, VectorArray<T, 4>& dst)
+	{
+		const T* aLanes[4]; const T* bLanes[4]; T* dstLanes[4];
+		detail::prepareBlend(a, b, dst, aLanes, bLanes, dstLanes);
+		detail::interpolateQuaternions<true>(aLanes, bLanes, amounts, T(0), dstLanes, a.size());
+	}
+
+	// weighted blend of any number of poses: every pose is brought into the hemisphere of poses[0],
+	// scaled by its weight, summed and renormalized (a multi-way nlerp, weights need not add up to one)
+	template<typename T>
+	void blendRotations(const VectorArray<T, 4>* const* poses, const T* weights, size_t poseCount, VectorArray<T, 4>& dst)
+	{
+		assert(poseCount > 0);
+		const size_t count = poses[0]->size();
+
+		for (size_t p = 1; p < poseCount; p++)
+		{
+			assert(poses[p]->size() == count);
+		}
+
+		ABSTRACTMATH_PROFILE_SCOPE(BatchQuaternion, count);
+		dst.resize(count);
+		size_t i = 0;
+
+#if defined(ABSTRACTMATH_AVX2)
+		if constexpr (std::is_same<T, float>::value)
+		{
+			const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256 reference[4], sum[4];
+				__m256 weight = _mm256_set1_ps(weights[0]);
+
+				for (size_t c = 0; c < 4; c++)
+				{
+					reference[c] = _mm256_loadu_ps(poses[0]->lane(c) + i);
+					sum[c] = _mm256_mul_ps(reference[c], weight);
+				}
+
+				for (size_t p = 1; p < poseCount; p++)
+				{
+					__m256 pose[4];
+
+					for (size_t c = 0; c < 4; c++)
+					{
+						pose[c] = _mm256_loadu_ps(poses[p]->lane(c) + i);
+					}
+
+					__m256 signedWeight = _mm256_xor_ps(_mm256_set1_ps(weights[p]), _mm256_and_ps(detail::dot4(reference, pose), signMask));
+
+					for (size_t c = 0; c < 4; c++)
+					{
+						sum[c] = detail::multiplyAdd(signedWeight, pose[c], sum[c]);
+					}
+				}
+
+				detail::normalize4(sum);
+
+				for (size_t c = 0; c < 4; c++)
+				{
+					_mm256_storeu_ps(dst.lane(c) + i, sum[c]);
+				}
+			}
+		}
+#endif
+
+		for (; i < count; i++)
+		{
+			Vector<T, 4> reference = poses[0]->get(i);
+			Vector<T, 4> sum = reference * weights[0];
+
+			for (size_t p = 1; p < poseCount; p++)
+			{
+				Vector<T, 4> pose = poses[p]->get(i);
+				sum += pose * (reference.dot(pose) < T(0) ? -weights[p] : weights[p]);
+			}
+
+			dst.set(i, sum.normalized());
+		}
+	}
+
+	// Quaternion::toRotationMatrix for every element, written straight into a bone palette with room for rotations.size() matrices
+	template<typename T>
+	void toRotationMatrices(const VectorArray<T, 4>& rotations, Matrix<T, 4, 4>* palette)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchQuaternion, rotations.size());
+		const T* x = rotations.lane(0);
+		const T* y = rotations.lane(1);
+		const T* z = rotations.lane(2);
+		const T* w = rotations.lane(3);
+		size_t i = 0;
+
+#if defined(ABSTRACTMATH_AVX2)
+		if constexpr (std::is_same<T, float>::value)
+		{
+			const __m256 one = _mm256_set1_ps(1.0f);
+			const __m256 two = _mm256_set1_ps(2.0f);
+			const __m256 zero = _mm256_setzero_ps();
+
+			for (; i + 8 <= rotations.size(); i += 8)
+			{
+				__m256 vx = _mm256_load_ps(x + i), vy = _mm256_load_ps(y + i), vz = _mm256_load_ps(z + i), vw = _mm256_load_ps(w + i);
+				__m256 xx = _mm256_mul_ps(vx, vx), yy = _mm256_mul_ps(vy, vy), zz = _mm256_mul_ps(vz, vz);
+				__m256 xy = _mm256_mul_ps(vx, vy), xz = _mm256_mul_ps(vx, vz), yz = _mm256_mul_ps(vy, vz);
+				__m256 wx = _mm256_mul_ps(vw, vx), wy = _mm256_mul_ps(vw, vy), wz = _mm256_mul_ps(vw, vz);
+
+				//first and second half of every column-major matrix, the last column is always ( 0, 0, 0, 1 )
+				__m256 low[8] = {
+					_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), _mm256_mul_ps(two, _mm256_add_ps(xy, wz)), _mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), zero,
+					_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), _mm256_mul_ps(two, _mm256_add_ps(yz, wx)), zero
+				};
+
+				__m256 high[8] = {
+					_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), _mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), zero,
+					zero, zero, zero, one
+				};
+
+				detail::transpose8x8(low);
+				detail::transpose8x8(high);
+
+				for (size_t k = 0; k < 8; k++)
+				{
+					_mm256_storeu_ps(palette[i + k].data, low[k]);
+					_mm256_storeu_ps(palette[i + k].data + 8, high[k]);
+				}
+			}
+		}
+#endif
+
+		for (; i < rotations.size(); i++)
+		{
+			palette[i] = Quaternion<T>(x[i], y[i], z[i], w[i]).toRotationMatrix();
+		}
+	}
+}
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <type_traits>
+#include <assert.h>
+
+#include "Simd.h"
+#include "Profiling.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "VectorArray.h"
+
+namespace AbstractMath {
+
+	// bulk Matrix<T, 4, 4> transforms over vertex streams
+	// strides are in bytes, every element starts with its x, y, z components and only those are written back
+	// src and dst may be the same stream (in-place), they must not partially overlap
+
+	namespace detail {
+
+		template<typename T>
+		inline const T* strided(const void* base, size_t stride, size_t index)
+		{
+			return reinterpret_cast<const T*>(static_cast<const char*>(base) + stride * index);
+		}
+
+		template<typename T>
+		inline T* strided(void* base, size_t stride, size_t index)
+		{
+			return reinterpret_cast<T*>(static_cast<char*>(base) + stride * index);
+		}
+
+		// W is the implied w of the input: 1 for points, 0 for directions
+		template<typename T, int W>
+		inline void transformStream3(const Matrix<T, 4, 4>& matrix, const void* src, size_t srcStride, void* dst, size_t dstStride, size_t count, bool perspectiveDivide)
+		{
+			ABSTRACTMATH_PROFILE_SCOPE(BatchTransform, count);
+			const T* m = matrix.data;
+			size_t i = 0;
+
+#if defined(ABSTRACTMATH_SSE)
+			if constexpr (std::is_same<T, float>::value)
+			{
+				const __m128 col0 = _mm_loadu_ps(m + 0);
+				const __m128 col1 = _mm_loadu_ps(m + 4);
+				const __m128 col2 = _mm_loadu_ps(m + 8);
+				const __m128 col3 = W == 1 ? _mm_loadu_ps(m + 12) : _mm_setzero_ps();
+
+				for (; i < count; i++)
+				{
+					const float* in = strided<float>(src, srcStride, i);
+					float* out = strided<float>(dst, dstStride, i);
+
+					__m128 sum = multiplyAdd(col0, _mm_set1_ps(in[0]), col3);
+					sum = multiplyAdd(col1, _mm_set1_ps(in[1]), sum);
+					sum = multiplyAdd(col2, _mm_set1_ps(in[2]), sum);
+
+					if (perspectiveDivide)
+					{
+						sum = _mm_div_ps(sum, swizzle<3, 3, 3, 3>(sum));
+					}
+
+					//three separate lanes so a packed Vector3 stream is never written past its end
+					_mm_storel_pi(reinterpret_cast<__m64*>(out), sum);
+					_mm_store_ss(out + 2, _mm_movehl_ps(sum, sum));
+				}
+
+				return;
+			}
+#endif
+
+			for (; i < count; i++)
+			{
+				const T* in = strided<T>(src, srcStride, i);
+				T* out = strided<T>(dst, dstStride, i);
+
+				T x = in[0], y = in[1], z = in[2];
+				T rx = m[0] * x + m[4] * y + m[8] * z + m[12] * T(W);
+				T ry = m[1] * x + m[5] * y + m[9] * z + m[13] * T(W);
+				T rz = m[2] * x + m[6] * y + m[10] * z + m[14] * T(W);
+
+				if (perspectiveDivide)
+				{
+					T rw = m[3] * x + m[7] * y + m[11] * z + m[15] * T(W);
+					rx /= rw;
+					ry /= rw;
+					rz /= rw;
+				}
+
+				out[0] = rx;
+				out[1] = ry;
+				out[2] = rz;
+			}
+		}
+
+		// SoA variant, every matrix element is broadcast once and each output stream is one multiply-add chain
+		template<typename T, int W>
+		inline void transformLanes3(const Matrix<T, 4, 4>& matrix, const T* x, const T* y, const T* z, T* outX, T* outY, T* outZ, size_t count, bool perspectiveDivide)
+		{
+			ABSTRACTMATH_PROFILE_SCOPE(BatchTransform, count);
+			const T* m = matrix.data;
+			size_t i = 0;
+
+#if defined(ABSTRACTMATH_AVX2)
+			if constexpr (std::is_same<T, float>::value)
+			{
+				__m256 c[16];
+
+				for (size_t e = 0; e < 16; e++)
+				{
+					c[e] = _mm256_set1_ps(e >= 12 && W == 0 ? 0.0f : m[e]);
+				}
+
+				for (; i + 8 <= count; i += 8)
+				{
+					__m256 vx = _mm256_loadu_ps(x + i);
+					__m256 vy = _mm256_loadu_ps(y + i);
+					__m256 vz = _mm256_loadu_ps(z + i);
+
+					__m256 rx = multiplyAdd(c[8], vz, multiplyAdd(c[4], vy, multiplyAdd(c[0], vx, c[12])));
+					__m256 ry = multiplyAdd(c[9], vz, multiplyAdd(c[5], vy, multiplyAdd(c[1], vx, c[13])));
+					__m256 rz = multiplyAdd(c[10], vz, multiplyAdd(c[6], vy, multiplyAdd(c[2], vx, c[14])));
+
+					if (perspectiveDivide)
+					{
+						__m256 rw = multiplyAdd(c[11], vz, multiplyAdd(c[7], vy, multiplyAdd(c[3], vx, c[15])));
+						rx = _mm256_div_ps(rx, rw);
+						ry = _mm256_div_ps(ry, rw);
+						rz = _mm256_div_ps(rz, rw);
+					}
+
+					_mm256_storeu_ps(outX + i, rx);
+					_mm256_storeu_ps(outY + i, ry);
+					_mm256_storeu_ps(outZ + i, rz);
+				}
+			}
+#endif
+
+			const T tx = m[12] * T(W), ty = m[13] * T(W), tz = m[14] * T(W), tw = m[15] * T(W);
+
+			for (; i < count; i++)
+			{
+				T vx = x[i], vy = y[i], vz = z[i];
+				T rx = m[0] * vx + m[4] * vy + m[8] * vz + tx;
+				T ry = m[1] * vx + m[5] * vy + m[9] * vz + ty;
+				T rz = m[2] * vx + m[6] * vy + m[10] * vz + tz;
+
+				if (perspectiveDivide)
+				{
+					T rw = m[3] * vx + m[7] * vy + m[11] * vz + tw;
+					rx /= rw;
+					ry /= rw;
+					rz /= rw;
+				}
+
+				outX[i] = rx;
+				outY[i] = ry;
+				outZ[i] = rz;
+			}
+		}
+	}
+
+	template<typename T>
+	void transformPoints(const Matrix<T, 4, 4>& matrix, const void* src, size_t srcStride, void* dst, size_t dstStride, size_t count, bool perspectiveDivide = false)
+	{
+		detail::transformStream3<T, 1>(matrix, src, srcStride, dst, dstStride, count, perspectiveDivide);
+	}
+
+	template<typename T>
+	void transformDirections(const Matrix<T, 4, 4>& matrix, const void* src, size_t srcStride, void* dst, size_t dstStride, size_t count)
+	{
+		detail::transformStream3<T, 0>(matrix, src, srcStride, dst, dstStride, count, false);
+	}
+
+	// V is a packed array of Vector<T, 3>, Vector3<T>, or Vector<T, 4>/Vector4<T> whose w is ignored and left untouched
+	template<typename T, typename V>
+	void transformPoints(const Matrix<T, 4, 4>& matrix, const V* src, V* dst, size_t count, bool perspectiveDivide = false)
+	{
+		static_assert(std::is_same<typename V::type, T>::value, "Vector and Matrix types must match!");
+		transformPoints(matrix, static_cast<const void*>(src), sizeof(V), static_cast<void*>(dst), sizeof(V), count, perspectiveDivide);
+	}
+
+	template<typename T, typename V>
+	void transformDirections(const Matrix<T, 4, 4>& matrix, const V* src, V* dst, size_t count)
+	{
+		static_assert(std::is_same<typename V::type, T>::value, "Vector and Matrix types must match!");
+		transformDirections(matrix, static_cast<const void*>(src), sizeof(V), static_cast<void*>(dst), sizeof(V), count);
+	}
+
+	template<typename T>
+	void transformPoints(const Matrix<T, 4, 4>& matrix, const VectorArray<T, 3>& src, VectorArray<T, 3>& dst, bool perspectiveDivide = false)
+	{
+		if (&src != &dst)
+		{
+			dst.resize(src.size());
+		}
+
+		detail::transformLanes3<T, 1>(matrix, src.lane(0), src.lane(1), src.lane(2), dst.lane(0), dst.lane(1), dst.lane(2), src.size(), perspectiveDivide);
+	}
+
+	template<typename T>
+	void transformDirections(const Matrix<T, 4, 4>& matrix, const VectorArray<T, 3>& src, VectorArray<T, 3>& dst)
+	{
+		if (&src != &dst)
+		{
+			dst.resize(src.size());
+		}
+
+		detail::transformLanes3<T, 0>(matrix, src.lane(0), src.lane(1), src.lane(2), dst.lane(0), dst.lane(1), dst.lane(2), src.size(), false);
+	}
+
+	// full homogeneous product of packed Vector<T, 4>/Vector4<T> streams, the matrix stays in registers for the whole stream
+	template<typename T, typename V>
+	void transformVectors(const Matrix<T, 4, 4>& matrix, const V* src, V* dst, size_t count, bool perspectiveDivide = false)
+	{
+		static_assert(std::is_base_of<Vector<T, 4>, V>::value && sizeof(V) == sizeof(Vector<T, 4>), "Vectors must be Vector<T, 4>!");
+		ABSTRACTMATH_PROFILE_SCOPE(BatchTransform, count);
+		const T* m = matrix.data;
+
+#if defined(ABSTRACTMATH_SSE)
+		if constexpr (std::is_same<T, float>::value)
+		{
+			const __m128 col0 = _mm_loadu_ps(m + 0);
+			const __m128 col1 = _mm_loadu_ps(m + 4);
+			const __m128 col2 = _mm_loadu_ps(m + 8);
+			const __m128 col3 = _mm_loadu_ps(m + 12);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				const float* in = src[i].data;
+
+				__m128 sum = _mm_mul_ps(col0, _mm_set1_ps(in[0]));
+				sum = detail::multiplyAdd(col1, _mm_set1_ps(in[1]), sum);
+				sum = detail::multiplyAdd(col2, _mm_set1_ps(in[2]), sum);
+				sum = detail::multiplyAdd(col3, _mm_set1_ps(in[3]), sum);
+
+				if (perspectiveDivide)
+				{
+					sum = _mm_div_ps(sum, detail::swizzle<3, 3, 3, 3>(sum));
+				}
+
+				_mm_storeu_ps(dst[i].data, sum);
+			}
+
+			return;
+		}
+#endif
+
+		for (size_t i = 0; i < count; i++)
+		{
+			T x = src[i].data[0], y = src[i].data[1], z = src[i].data[2], w = src[i].data[3];
+			T result[4];
+
+			for (size_t row = 0; row < 4; row++)
+			{
+				result[row] = m[row] * x + m[4 + row] * y + m[8 + row] * z + m[12 + row] * w;
+			}
+
+			for (size_t row = 0; row < 4; row++)
+			{
+				dst[i].data[row] = perspectiveDivide ? result[row] / result[3] : result[row];
+			}
+		}
+	}
+}
\ No newline at end of file
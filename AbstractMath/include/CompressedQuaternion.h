@@ -0,0 +1,307 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <assert.h>
+
+#include "Simd.h"
+#include "Profiling.h"
+#include "MathFunctions.h"
+#include "Quaternion.h"
+#include "VectorArray.h"
+
+namespace AbstractMath {
+
+	// unit quaternion in smallest-three form: the largest component is dropped (q and -q are the same rotation, so the
+	// quaternion is flipped until it is positive) and rebuilt as sqrt(1 - a^2 - b^2 - c^2), the other three lie in
+	// [ -1/sqrt(2), 1/sqrt(2) ] and are stored as unsigned fixed point behind a two bit index of the dropped one
+	// 32 bits: three 10 bit components, every component within 2.1e-3 of the input, rotations within 0.25 degrees
+	// 48 bits: three 15 bit components, every component within 6.5e-5 of the input, rotations within 0.008 degrees
+	// decoded quaternions are unit length up to float rounding, ready for rotate() and toRotationMatrix()
+	template<size_t Bits_C>
+	class CompressedQuaternion
+	{
+		static_assert(Bits_C == 32 || Bits_C == 48, "Compressed quaternions are 32 or 48 bits!");
+
+	public:
+		static constexpr uint32_t COMPONENT_BITS = Bits_C == 32 ? 10 : 15;
+		static constexpr uint32_t COMPONENT_MAX = (1u << COMPONENT_BITS) - 1;
+
+		// 32 bits: index << 30 | a << 20 | b << 10 | c, little endian
+		// 48 bits: one component per word, the index in the top bits of the first two words
+		uint16_t words[Bits_C / 16];
+
+		CompressedQuaternion() = default;
+
+		template<typename T>
+		explicit CompressedQuaternion(const Quaternion<T>& rotation)
+		{
+			static_assert(std::is_floating_point<T>::value, "Compression requires a floating point quaternion!");
+
+			const T* q = rotation.data;
+			uint32_t largest = 0;
+
+			for (uint32_t i = 1; i < 4; i++)
+			{
+				largest = std::abs(q[i]) > std::abs(q[largest]) ? i : largest;
+			}
+
+			const T sign = q[largest] < T(0) ? T(-1) : T(1);
+			const T invLength = sign / math::sqrt(rotation.dot(rotation));
+			uint32_t codes[3] = {};
+
+			for (uint32_t i = 0, k = 0; i < 4; i++)
+			{
+				if (i != largest)
+				{
+					T scaled = (q[i] * invLength + T(INV_SQRT2)) * T(1.0 / DECODE_SCALE);
+					scaled = scaled < T(0) ? T(0) : (scaled > T(COMPONENT_MAX) ? T(COMPONENT_MAX) : scaled);
+					codes[k++] = uint32_t(scaled + T(0.5));
+				}
+			}
+
+			pack(largest, codes);
+		}
+
+		uint32_t largestIndex() const
+		{
+			if constexpr (Bits_C == 32)
+			{
+				return packed32() >> 30;
+			}
+			else
+			{
+				return (words[0] >> 15) | ((words[1] >> 15) << 1);
+			}
+		}
+
+		// the stored component codes in x, y, z, w order without the dropped one
+		void codes(uint32_t* dst) const
+		{
+			if constexpr (Bits_C == 32)
+			{
+				uint32_t bits = packed32();
+				dst[0] = (bits >> 20) & COMPONENT_MAX;
+				dst[1] = (bits >> 10) & COMPONENT_MAX;
+				dst[2] = bits & COMPONENT_MAX;
+			}
+			else
+			{
+				for (size_t k = 0; k < 3; k++)
+				{
+					dst[k] = words[k] & COMPONENT_MAX;
+				}
+			}
+		}
+
+		template<typename T = float>
+		Quaternion<T> decompress() const
+		{
+			static_assert(std::is_floating_point<T>::value, "Decompression requires a floating point quaternion!");
+
+			uint32_t stored[3];
+			codes(stored);
+
+			T values[3];
+			T sum = T(0);
+
+			for (size_t k = 0; k < 3; k++)
+			{
+				values[k] = T(stored[k]) * T(DECODE_SCALE) - T(INV_SQRT2);
+				sum += values[k] * values[k];
+			}
+
+			const uint32_t largest = largestIndex();
+			const T rebuilt = math::sqrt(sum < T(1) ? T(1) - sum : T(0));
+			Quaternion<T> result;
+
+			for (uint32_t i = 0, k = 0; i < 4; i++)
+			{
+				result.data[i] = i == largest ? rebuilt : values[k++];
+			}
+
+			return result;
+		}
+
+		static constexpr double INV_SQRT2 = 0.707106781186547524400844362104849039;
+		static constexpr double DECODE_SCALE = 2.0 * INV_SQRT2 / double(COMPONENT_MAX); //code to component, one quantization step
+
+	private:
+		uint32_t packed32() const
+		{
+			uint32_t bits = 0;
+			std::memcpy(&bits, words, sizeof(uint32_t));
+			return bits;
+		}
+
+		void pack(uint32_t largest, const uint32_t* codes)
+		{
+			if constexpr (Bits_C == 32)
+			{
+				uint32_t bits = (largest << 30) | (codes[0] << 20) | (codes[1] << 10) | codes[2];
+				std::memcpy(words, &bits, sizeof(uint32_t));
+			}
+			else
+			{
+				words[0] = uint16_t(codes[0] | ((largest & 1u) << 15));
+				words[1] = uint16_t(codes[1] | ((largest >> 1) << 15));
+				words[2] = uint16_t(codes[2]);
+			}
+		}
+	};
+
+	typedef CompressedQuaternion<32> Quaternion32;
+	typedef CompressedQuaternion<48> Quaternion48;
+
+	static_assert(sizeof(Quaternion32) == 4 && sizeof(Quaternion48) == 6, "Compressed quaternions must stay tightly packed!");
+
+	namespace detail {
+
+#if defined(ABSTRACTMATH_AVX2)
+		// eight records to x, y, z, w lanes: the three codes scaled, the dropped component rebuilt and blended into place
+		template<size_t Bits_C>
+		inline void decompressQuaternions8(const CompressedQuaternion<Bits_C>* src, __m256* q)
+		{
+			using C = CompressedQuaternion<Bits_C>;
+			const __m256i mask = _mm256_set1_epi32(int(C::COMPONENT_MAX));
+			__m256i index, a, b, c;
+
+			if constexpr (Bits_C == 32)
+			{
+				__m256i bits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+				index = _mm256_srli_epi32(bits, 30);
+				a = _mm256_and_si256(_mm256_srli_epi32(bits, 20), mask);
+				b = _mm256_and_si256(_mm256_srli_epi32(bits, 10), mask);
+				c = _mm256_and_si256(bits, mask);
+			}
+			else
+			{
+				// words 0-1 and words 1-2 of each six byte record, neither gather reads past the record
+				const __m256i offsets = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+				const int* base = reinterpret_cast<const int*>(src);
+				__m256i low = _mm256_i32gather_epi32(base, offsets, 1);
+				__m256i high = _mm256_i32gather_epi32(reinterpret_cast<const int*>(reinterpret_cast<const char*>(src) + 2), offsets, 1);
+
+				index = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(low, 15), _mm256_set1_epi32(1)), _mm256_and_si256(_mm256_srli_epi32(low, 30), _mm256_set1_epi32(2)));
+				a = _mm256_and_si256(low, mask);
+				b = _mm256_and_si256(_mm256_srli_epi32(low, 16), mask);
+				c = _mm256_and_si256(_mm256_srli_epi32(high, 16), mask);
+			}
+
+			const __m256 scale = _mm256_set1_ps(float(C::DECODE_SCALE));
+			const __m256 offset = _mm256_set1_ps(-float(C::INV_SQRT2));
+			const __m256 one = _mm256_set1_ps(1.0f);
+
+			__m256 va = multiplyAdd(_mm256_cvtepi32_ps(a), scale, offset);
+			__m256 vb = multiplyAdd(_mm256_cvtepi32_ps(b), scale, offset);
+			__m256 vc = multiplyAdd(_mm256_cvtepi32_ps(c), scale, offset);
+
+			__m256 sum = multiplyAdd(vc, vc, multiplyAdd(vb, vb, _mm256_mul_ps(va, va)));
+			__m256 rebuilt = _mm256_sqrt_ps(_mm256_max_ps(_mm256_sub_ps(one, sum), _mm256_setzero_ps()));
+
+			__m256 is0 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(index, _mm256_setzero_si256()));
+			__m256 is1 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(index, _mm256_set1_epi32(1)));
+			__m256 is2 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(index, _mm256_set1_epi32(2)));
+			__m256 is3 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(index, _mm256_set1_epi32(3)));
+
+			// component i is the rebuilt one, the stored one before it (below the dropped index) or after it
+			q[0] = _mm256_blendv_ps(va, rebuilt, is0);
+			q[1] = _mm256_blendv_ps(_mm256_blendv_ps(vb, va, is0), rebuilt, is1);
+			q[2] = _mm256_blendv_ps(_mm256_blendv_ps(vc, vb, _mm256_or_ps(is0, is1)), rebuilt, is2);
+			q[3] = _mm256_blendv_ps(vc, rebuilt, is3);
+		}
+#endif
+	}
+
+	// batch forms, quaternions are normalized while compressing so slightly drifted keyframes are fine
+	// float decompression uses AVX2 when available (eight rotations per iteration)
+
+	template<size_t Bits_C, typename T>
+	void compress(const Quaternion<T>* src, CompressedQuaternion<Bits_C>* dst, size_t count)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchConvert, count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			dst[i] = CompressedQuaternion<Bits_C>(src[i]);
+		}
+	}
+
+	template<size_t Bits_C, typename T>
+	void compress(const VectorArray<T, 4>& src, CompressedQuaternion<Bits_C>* dst)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchConvert, src.size());
+
+		for (size_t i = 0; i < src.size(); i++)
+		{
+			dst[i] = CompressedQuaternion<Bits_C>(Quaternion<T>(src.lane(0)[i], src.lane(1)[i], src.lane(2)[i], src.lane(3)[i]));
+		}
+	}
+
+	template<size_t Bits_C, typename T>
+	void decompress(const CompressedQuaternion<Bits_C>* src, Quaternion<T>* dst, size_t count)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchConvert, count);
+		size_t i = 0;
+
+#if defined(ABSTRACTMATH_AVX2)
+		if constexpr (std::is_same<T, float>::value)
+		{
+			static_assert(sizeof(Quaternion<float>) == 4 * sizeof(float), "Quaternions must be tightly packed!");
+
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256 q[4];
+				detail::decompressQuaternions8(src + i, q);
+
+				// 4x8 transpose into eight consecutive { x, y, z, w }
+				__m256 xy0 = _mm256_unpacklo_ps(q[0], q[1]), xy1 = _mm256_unpackhi_ps(q[0], q[1]);
+				__m256 zw0 = _mm256_unpacklo_ps(q[2], q[3]), zw1 = _mm256_unpackhi_ps(q[2], q[3]);
+				__m256 q04 = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(1, 0, 1, 0)), q15 = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(3, 2, 3, 2));
+				__m256 q26 = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(1, 0, 1, 0)), q37 = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(3, 2, 3, 2));
+
+				float* out = dst[i].data;
+				_mm256_storeu_ps(out + 0, _mm256_permute2f128_ps(q04, q15, 0x20));
+				_mm256_storeu_ps(out + 8, _mm256_permute2f128_ps(q26, q37, 0x20));
+				_mm256_storeu_ps(out + 16, _mm256_permute2f128_ps(q04, q15, 0x31));
+				_mm256_storeu_ps(out + 24, _mm256_permute2f128_ps(q26, q37, 0x31));
+			}
+		}
+#endif
+
+		for (; i < count; i++)
+		{
+			dst[i] = src[i].template decompress<T>();
+		}
+	}
+
+	template<size_t Bits_C, typename T>
+	void decompress(const CompressedQuaternion<Bits_C>* src, size_t count, VectorArray<T, 4>& dst)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchConvert, count);
+		dst.resize(count);
+		size_t i = 0;
+
+#if defined(ABSTRACTMATH_AVX2)
+		if constexpr (std::is_same<T, float>::value)
+		{
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256 q[4];
+				detail::decompressQuaternions8(src + i, q);
+
+				for (size_t c = 0; c < 4; c++)
+				{
+					_mm256_store_ps(dst.lane(c) + i, q[c]);
+				}
+			}
+		}
+#endif
+
+		for (; i < count; i++)
+		{
+			dst.set(i, src[i].template decompress<T>());
+		}
+	}
+}
@@ -0,0 +1,447 @@
+#pragma once
+
+#include <limits>
+#include <type_traits>
+
+#include "Simd.h"
+#include "Profiling.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "Quaternion.h"
+#include "Parallel.h"
+#include "Solvers.h"
+
+namespace AbstractMath {
+
+	// 3x3 eigen, singular value and polar decompositions (oriented bounding box fitting, inertia tensors, shape matching)
+	// every decomposition runs a fixed number of cyclic Jacobi sweeps with selects in place of branches, the same kernel
+	// serves a single matrix and, a SIMD register's worth of matrices per lane group, the batched overloads
+
+	// eigenvalues in descending order, vectors holds the matching unit eigenvectors as columns and is a rotation
+	// (determinant +1), so orientation() turns it into the axes of a box
+	template<typename T>
+	struct SymmetricEigen3
+	{
+		Vector<T, 3> values;
+		Matrix<T, 3, 3> vectors;
+
+		Quaternion<T> orientation() const
+		{
+			return Quaternion<T>::fromRotationMatrix(vectors);
+		}
+	};
+
+	// a = u * diag(sigma) * transpose(v) with u and v rotations, sigma descends in magnitude and only sigma[2] can be
+	// negative, which it is when a reflects
+	template<typename T>
+	struct SVD3
+	{
+		Matrix<T, 3, 3> u;
+		Vector<T, 3> sigma;
+		Matrix<T, 3, 3> v;
+	};
+
+	// a = rotation * stretch with stretch symmetric, rotation is always a rotation: when a reflects, stretch takes the
+	// reflection (one negative eigenvalue) rather than rotation, which is what shape matching wants
+	template<typename T>
+	struct PolarDecomposition3
+	{
+		Matrix<T, 3, 3> rotation;
+		Matrix<T, 3, 3> stretch;
+
+		Quaternion<T> orientation() const
+		{
+			return Quaternion<T>::fromRotationMatrix(rotation);
+		}
+	};
+
+	namespace detail {
+
+		// cyclic sweeps of the eigensolver (three rotations each), the off-diagonal shrinks quadratically so four leave
+		// floats at rounding level relative to the largest eigenvalue and doubles need one more
+		template<typename T>
+		struct JacobiSweeps { static const size_t value = sizeof(T) > 4 ? 5 : 4; };
+
+		// columns p and q of a matrix times the rotation of their plane, c and s are its cosine and sine
+		template<typename P>
+		inline void rotateColumns(typename P::Register c, typename P::Register s, typename P::Register* vp, typename P::Register* vq)
+		{
+			for (size_t i = 0; i < 3; i++)
+			{
+				typename P::Register p = vp[i];
+				vp[i] = P::add(P::mul(c, p), P::mul(s, vq[i]));
+				vq[i] = P::negMulAdd(s, p, P::mul(c, vq[i]));
+			}
+		}
+
+		// zeroes apq with a rotation of the (p, q) plane, app and aqq become the rotated diagonal, arp and arq are the
+		// other off-diagonal elements of rows p and q, and columns p and q of v are rotated along
+		// tan 2θ = 2 apq / (app - aqq), the smaller root of tan θ keeps the rotation under 45° and the same formulation
+		// gives t = 0 without dividing by apq when apq is already zero (both zero picks the identity too)
+		template<typename P, typename T>
+		inline void jacobiRotation(typename P::Register& app, typename P::Register& aqq, typename P::Register& apq, typename P::Register& arp,
+			typename P::Register& arq, typename P::Register* vp, typename P::Register* vq)
+		{
+			using Register = typename P::Register;
+
+			// an apq below rounding of the diagonal is dropped rather than rotated, so the converged off-diagonal ends at
+			// zero instead of shrinking into denormals (which cost a hundred cycles or more per operation on x86)
+			Register threshold = P::mul(P::set(std::numeric_limits<T>::epsilon()), P::add(P::abs(app), P::abs(aqq)));
+			apq = P::select(P::greater(P::abs(apq), threshold), apq, P::set(0));
+
+			Register d = P::sub(app, aqq);
+			Register e = P::add(apq, apq);
+			Register denominator = P::add(d, P::copySign(P::sqrt(P::add(P::mul(d, d), P::mul(e, e))), d));
+			Register t = P::select(P::notPositive(P::abs(denominator)), P::set(0), P::mul(e, P::reciprocal(denominator)));
+			Register c = P::reciprocal(P::sqrt(P::add(P::mul(t, t), P::set(1))));
+			Register s = P::mul(t, c);
+
+			Register cc = P::mul(c, c);
+			Register ss = P::mul(s, s);
+			Register cs2 = P::mul(P::add(c, c), s);
+			Register pp = P::add(P::add(P::mul(cc, app), P::mul(cs2, apq)), P::mul(ss, aqq));
+			Register qq = P::add(P::negMulAdd(cs2, apq, P::mul(ss, app)), P::mul(cc, aqq));
+			app = pp;
+			aqq = qq;
+			apq = P::set(0);
+
+			Register rp = P::add(P::mul(c, arp), P::mul(s, arq));
+			arq = P::negMulAdd(s, arp, P::mul(c, arq));
+			arp = rp;
+
+			rotateColumns<P>(c, s, vp, vq);
+		}
+
+		// the larger value first, its column moves along and the other column is negated to keep v a rotation
+		template<typename P>
+		inline void sortPair(typename P::Register& lp, typename P::Register& lq, typename P::Register* vp, typename P::Register* vq)
+		{
+			typename P::Mask swap = P::greater(lq, lp);
+			typename P::Register larger = P::select(swap, lq, lp);
+			lq = P::select(swap, lp, lq);
+			lp = larger;
+
+			for (size_t i = 0; i < 3; i++)
+			{
+				typename P::Register p = vp[i];
+				vp[i] = P::select(swap, vq[i], p);
+				vq[i] = P::select(swap, P::sub(P::set(0), p), vq[i]);
+			}
+		}
+
+		// s holds s00, s11, s22, s01, s02, s12 and is diagonalized in place, values receives the sorted eigenvalues
+		// and v (column-major) the eigenvectors
+		template<typename P, typename T>
+		inline void symmetricEigenTile(typename P::Register* s, typename P::Register* values, typename P::Register* v)
+		{
+			for (size_t e = 0; e < 9; e++)
+			{
+				v[e] = P::set(e % 4 == 0 ? T(1) : T(0));
+			}
+
+			for (size_t sweep = 0; sweep < JacobiSweeps<T>::value; sweep++)
+			{
+				jacobiRotation<P, T>(s[0], s[1], s[3], s[4], s[5], v, v + 3);
+				jacobiRotation<P, T>(s[0], s[2], s[4], s[3], s[5], v, v + 6);
+				jacobiRotation<P, T>(s[1], s[2], s[5], s[3], s[4], v + 3, v + 6);
+			}
+
+			values[0] = s[0];
+			values[1] = s[1];
+			values[2] = s[2];
+			sortPair<P>(values[0], values[1], v, v + 3);
+			sortPair<P>(values[0], values[2], v, v + 6);
+			sortPair<P>(values[1], values[2], v + 3, v + 6);
+		}
+
+		// the eigenvectors of transpose(a) * a are v, a * v has orthogonal columns and its QR decomposition by Givens
+		// rotations gives u and, on the diagonal of R, sigma (more accurate than the square roots of the eigenvalues,
+		// which lose the small singular values to the squared condition number)
+		template<typename P, typename T>
+		inline void svdTile(const typename P::Register* a, typename P::Register* u, typename P::Register* sigma, typename P::Register* v)
+		{
+			using Register = typename P::Register;
+			Register s[6];
+			const size_t pairs[6][2] = { { 0, 0 }, { 1, 1 }, { 2, 2 }, { 0, 1 }, { 0, 2 }, { 1, 2 } };
+
+			for (size_t k = 0; k < 6; k++)
+			{
+				const Register* ci = a + 3 * pairs[k][0];
+				const Register* cj = a + 3 * pairs[k][1];
+				s[k] = P::add(P::add(P::mul(ci[0], cj[0]), P::mul(ci[1], cj[1])), P::mul(ci[2], cj[2]));
+			}
+
+			Register values[3];
+			symmetricEigenTile<P, T>(s, values, v);
+
+			Register b[9];
+
+			for (size_t col = 0; col < 3; col++)
+			{
+				for (size_t row = 0; row < 3; row++)
+				{
+					b[col * 3 + row] = P::add(P::add(P::mul(a[row], v[col * 3]), P::mul(a[3 + row], v[col * 3 + 1])), P::mul(a[6 + row], v[col * 3 + 2]));
+				}
+			}
+
+			for (size_t e = 0; e < 9; e++)
+			{
+				u[e] = P::set(e % 4 == 0 ? T(1) : T(0));
+			}
+
+			// zero b10, b20 and b21 in turn, rows p and q of b rotate, columns p and q of u the opposite way
+			const size_t rotations[3][3] = { { 0, 1, 0 }, { 0, 2, 0 }, { 1, 2, 1 } };
+
+			for (const auto& rotation : rotations)
+			{
+				const size_t p = rotation[0], q = rotation[1], col = rotation[2];
+				Register x = b[col * 3 + p];
+				Register y = b[col * 3 + q];
+				Register lengthSquared = P::add(P::mul(x, x), P::mul(y, y));
+				typename P::Mask zero = P::notPositive(lengthSquared);
+				Register invLength = P::reciprocal(P::sqrt(lengthSquared));
+				Register c = P::select(zero, P::set(1), P::mul(x, invLength));
+				Register sn = P::select(zero, P::set(0), P::mul(y, invLength));
+
+				for (size_t k = col; k < 3; k++)
+				{
+					Register bp = b[k * 3 + p];
+					b[k * 3 + p] = P::add(P::mul(c, bp), P::mul(sn, b[k * 3 + q]));
+					b[k * 3 + q] = P::negMulAdd(sn, bp, P::mul(c, b[k * 3 + q]));
+				}
+
+				rotateColumns<P>(c, sn, u + 3 * p, u + 3 * q);
+			}
+
+			sigma[0] = b[0];
+			sigma[1] = b[4];
+			sigma[2] = b[8];
+		}
+
+		// rotation = u * transpose(v), stretch = v * diag(sigma) * transpose(v)
+		template<typename P, typename T>
+		inline void polarTile(const typename P::Register* a, typename P::Register* rotation, typename P::Register* stretch)
+		{
+			using Register = typename P::Register;
+			Register u[9], sigma[3], v[9];
+			svdTile<P, T>(a, u, sigma, v);
+
+			for (size_t col = 0; col < 3; col++)
+			{
+				for (size_t row = 0; row < 3; row++)
+				{
+					rotation[col * 3 + row] = P::add(P::add(P::mul(u[row], v[col]), P::mul(u[3 + row], v[3 + col])), P::mul(u[6 + row], v[6 + col]));
+
+					if (stretch != nullptr && row >= col)
+					{
+						Register sum = P::mul(P::mul(sigma[0], v[row]), v[col]);
+						sum = P::add(sum, P::mul(P::mul(sigma[1], v[3 + row]), v[3 + col]));
+						sum = P::add(sum, P::mul(P::mul(sigma[2], v[6 + row]), v[6 + col]));
+						stretch[col * 3 + row] = sum;
+						stretch[row * 3 + col] = sum;
+					}
+				}
+			}
+		}
+
+		// the batched decompositions, each loads WIDTH matrices transposed into registers (element e of every matrix
+		// in m[e]), runs its tile and stores the results the same way
+		struct EigenKernel
+		{
+			template<typename P, typename T>
+			static void run(const Matrix<T, 3, 3>* a, SymmetricEigen3<T>* result)
+			{
+				typename P::Register s[6], values[3], v[9];
+				const size_t lower[6] = { 0, 4, 8, 1, 2, 5 }; //s00, s11, s22, s10, s20, s21
+
+				for (size_t k = 0; k < 6; k++)
+				{
+					s[k] = P::gather(a[0].data + lower[k], 9);
+				}
+
+				symmetricEigenTile<P, T>(s, values, v);
+				const size_t stride = sizeof(SymmetricEigen3<T>) / sizeof(T);
+
+				for (size_t e = 0; e < 3; e++)
+				{
+					P::scatter(result[0].values.data + e, stride, values[e]);
+				}
+
+				for (size_t e = 0; e < 9; e++)
+				{
+					P::scatter(result[0].vectors.data + e, stride, v[e]);
+				}
+			}
+		};
+
+		struct SVDKernel
+		{
+			template<typename P, typename T>
+			static void run(const Matrix<T, 3, 3>* a, SVD3<T>* result)
+			{
+				typename P::Register m[9], u[9], sigma[3], v[9];
+
+				for (size_t e = 0; e < 9; e++)
+				{
+					m[e] = P::gather(a[0].data + e, 9);
+				}
+
+				svdTile<P, T>(m, u, sigma, v);
+				const size_t stride = sizeof(SVD3<T>) / sizeof(T);
+
+				for (size_t e = 0; e < 9; e++)
+				{
+					P::scatter(result[0].u.data + e, stride, u[e]);
+					P::scatter(result[0].v.data + e, stride, v[e]);
+				}
+
+				for (size_t e = 0; e < 3; e++)
+				{
+					P::scatter(result[0].sigma.data + e, stride, sigma[e]);
+				}
+			}
+		};
+
+		struct PolarKernel
+		{
+			template<typename P, typename T>
+			static void run(const Matrix<T, 3, 3>* a, PolarDecomposition3<T>* result)
+			{
+				typename P::Register m[9], rotation[9], stretch[9];
+
+				for (size_t e = 0; e < 9; e++)
+				{
+					m[e] = P::gather(a[0].data + e, 9);
+				}
+
+				polarTile<P, T>(m, rotation, stretch);
+				const size_t stride = sizeof(PolarDecomposition3<T>) / sizeof(T);
+
+				for (size_t e = 0; e < 9; e++)
+				{
+					P::scatter(result[0].rotation.data + e, stride, rotation[e]);
+					P::scatter(result[0].stretch.data + e, stride, stretch[e]);
+				}
+			}
+
+			// the rotation alone, as a matrix or converted to a quaternion
+			template<typename P, typename T>
+			static void run(const Matrix<T, 3, 3>* a, Matrix<T, 3, 3>* rotations)
+			{
+				typename P::Register m[9], rotation[9];
+
+				for (size_t e = 0; e < 9; e++)
+				{
+					m[e] = P::gather(a[0].data + e, 9);
+				}
+
+				polarTile<P, T>(m, rotation, nullptr);
+
+				for (size_t e = 0; e < 9; e++)
+				{
+					P::scatter(rotations[0].data + e, 9, rotation[e]);
+				}
+			}
+
+			template<typename P, typename T>
+			static void run(const Matrix<T, 3, 3>* a, Quaternion<T>* rotations)
+			{
+				Matrix<T, 3, 3> matrices[P::WIDTH];
+				run<P>(a, matrices);
+
+				for (size_t i = 0; i < P::WIDTH; i++)
+				{
+					rotations[i] = Quaternion<T>::fromRotationMatrix(matrices[i]);
+				}
+			}
+		};
+
+		template<typename Kernel, typename T, typename R>
+		void decomposeBatch(const Matrix<T, 3, 3>* a, R* result, size_t count)
+		{
+			static_assert(std::is_floating_point<T>::value, "Decompositions require a floating point type!");
+			static_assert(sizeof(Matrix<T, 3, 3>) == sizeof(T) * 9 && sizeof(R) % sizeof(T) == 0, "Matrices and results must be tightly packed!");
+			ABSTRACTMATH_PROFILE_SCOPE(MatrixDecomposition, count);
+
+			using Wide = SolvePack<T, BatchSolveWidth<T>::value>;
+			using Scalar = SolvePack<T, 1>;
+			const size_t grain = (cacheGrain<sizeof(Matrix<T, 3, 3>) + sizeof(R)>() + Wide::WIDTH - 1) / Wide::WIDTH * Wide::WIDTH;
+
+			parallelFor(0, count, grain, [a, result](size_t first, size_t last)
+			{
+				size_t i = first;
+
+				for (; i + Wide::WIDTH <= last; i += Wide::WIDTH)
+				{
+					Kernel::template run<Wide>(a + i, result + i);
+				}
+
+				for (; i < last; i++)
+				{
+					Kernel::template run<Scalar>(a + i, result + i);
+				}
+			});
+		}
+	}
+
+	// eigen decomposition of a symmetric matrix, only its lower triangle is read
+	template<typename T>
+	SymmetricEigen3<T> symmetricEigen(const Matrix<T, 3, 3>& a)
+	{
+		ABSTRACTMATH_PROFILE_COUNT(MatrixDecomposition, 1);
+		SymmetricEigen3<T> result;
+		detail::EigenKernel::run<detail::SolvePack<T, 1>>(&a, &result);
+		return result;
+	}
+
+	template<typename T>
+	SVD3<T> svd(const Matrix<T, 3, 3>& a)
+	{
+		ABSTRACTMATH_PROFILE_COUNT(MatrixDecomposition, 1);
+		SVD3<T> result;
+		detail::SVDKernel::run<detail::SolvePack<T, 1>>(&a, &result);
+		return result;
+	}
+
+	template<typename T>
+	PolarDecomposition3<T> polarDecomposition(const Matrix<T, 3, 3>& a)
+	{
+		ABSTRACTMATH_PROFILE_COUNT(MatrixDecomposition, 1);
+		PolarDecomposition3<T> result;
+		detail::PolarKernel::run<detail::SolvePack<T, 1>>(&a, &result);
+		return result;
+	}
+
+	// the same over arrays, 8 floats or 4 doubles to a register (4 floats without AVX2) and split across the job
+	// system, the results match the single-matrix functions up to the rounding of fused multiply-adds
+	template<typename T>
+	void symmetricEigen(const Matrix<T, 3, 3>* a, SymmetricEigen3<T>* result, size_t count)
+	{
+		detail::decomposeBatch<detail::EigenKernel>(a, result, count);
+	}
+
+	template<typename T>
+	void svd(const Matrix<T, 3, 3>* a, SVD3<T>* result, size_t count)
+	{
+		detail::decomposeBatch<detail::SVDKernel>(a, result, count);
+	}
+
+	template<typename T>
+	void polarDecomposition(const Matrix<T, 3, 3>* a, PolarDecomposition3<T>* result, size_t count)
+	{
+		detail::decomposeBatch<detail::PolarKernel>(a, result, count);
+	}
+
+	// only the rotations, as shape matching needs them (one per cluster and substep), stretch is never formed
+	template<typename T>
+	void polarDecomposition(const Matrix<T, 3, 3>* a, Matrix<T, 3, 3>* rotations, size_t count)
+	{
+		detail::decomposeBatch<detail::PolarKernel>(a, rotations, count);
+	}
+
+	template<typename T>
+	void polarDecomposition(const Matrix<T, 3, 3>* a, Quaternion<T>* rotations, size_t count)
+	{
+		detail::decomposeBatch<detail::PolarKernel>(a, rotations, count);
+	}
+}
@@ -0,0 +1,619 @@
+#pragma once
+
+#include <type_traits>
+#include <cstring>
+#include <algorithm>
+#include <assert.h>
+
+#include "Simd.h"
+#include "Profiling.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "Parallel.h"
+
+namespace AbstractMath {
+
+	// fixed-size window into a column-major buffer, reads and writes go straight to the parent storage
+	template<typename T, size_t Rows_C, size_t Cols_C>
+	class MatrixBlock
+	{
+	public:
+		MatrixBlock(T* origin, size_t leadingDimension) : origin(origin), leadingDimension(leadingDimension) {}
+
+		T& operator()(size_t row, size_t col)
+		{
+			assert(row < Rows_C && col < Cols_C);
+			return origin[col * leadingDimension + row];
+		}
+
+		const T& operator()(size_t row, size_t col) const
+		{
+			assert(row < Rows_C && col < Cols_C);
+			return origin[col * leadingDimension + row];
+		}
+
+		operator Matrix<T, Rows_C, Cols_C>() const
+		{
+			Matrix<T, Rows_C, Cols_C> result;
+
+			for (size_t col = 0; col < Cols_C; col++)
+			{
+				std::memcpy(&result.data[col * Rows_C], origin + col * leadingDimension, sizeof(T) * Rows_C);
+			}
+
+			return result;
+		}
+
+		MatrixBlock<T, Rows_C, Cols_C>& operator=(const Matrix<T, Rows_C, Cols_C>& other)
+		{
+			for (size_t col = 0; col < Cols_C; col++)
+			{
+				std::memcpy(origin + col * leadingDimension, &other.data[col * Rows_C], sizeof(T) * Rows_C);
+			}
+
+			return *this;
+		}
+
+		void operator+=(const Matrix<T, Rows_C, Cols_C>& other)
+		{
+			for (size_t col = 0; col < Cols_C; col++)
+			{
+				for (size_t row = 0; row < Rows_C; row++)
+				{
+					origin[col * leadingDimension + row] += other.data[col * Rows_C + row];
+				}
+			}
+		}
+
+		void operator-=(const Matrix<T, Rows_C, Cols_C>& other)
+		{
+			for (size_t col = 0; col < Cols_C; col++)
+			{
+				for (size_t row = 0; row < Rows_C; row++)
+				{
+					origin[col * leadingDimension + row] -= other.data[col * Rows_C + row];
+				}
+			}
+		}
+
+	private:
+		T* origin;
+		size_t leadingDimension;
+	};
+
+	// heap-backed, runtime-sized matrix with the same column-major layout as Matrix
+	template<typename T>
+	class DynamicMatrix
+	{
+		static_assert(std::is_arithmetic<T>::value, "Type must be number");
+
+	public:
+		using type = T;
+
+		DynamicMatrix() = default;
+
+		DynamicMatrix(size_t rows, size_t cols)
+		{
+			resize(rows, cols);
+		}
+
+		template<size_t Rows_C, size_t Cols_C>
+		explicit DynamicMatrix(const Matrix<T, Rows_C, Cols_C>& other)
+		{
+			resize(Rows_C, Cols_C);
+			std::memcpy(storage, other.data, sizeof(T) * Rows_C * Cols_C);
+		}
+
+		DynamicMatrix(const DynamicMatrix<T>& other)
+		{
+			resize(other.rowCount, other.colCount);
+			std::memcpy(storage, other.storage, sizeof(T) * size());
+		}
+
+		DynamicMatrix(DynamicMatrix<T>&& other) noexcept
+		{
+			swap(other);
+		}
+
+		~DynamicMatrix()
+		{
+			alignedFree(storage);
+		}
+
+		DynamicMatrix<T>& operator=(const DynamicMatrix<T>& other)
+		{
+			if (this != &other)
+			{
+				DynamicMatrix<T> copy(other);
+				swap(copy);
+			}
+
+			return *this;
+		}
+
+		DynamicMatrix<T>& operator=(DynamicMatrix<T>&& other) noexcept
+		{
+			swap(other);
+			return *this;
+		}
+
+		void swap(DynamicMatrix<T>& other) noexcept
+		{
+			std::swap(storage, other.storage);
+			std::swap(rowCount, other.rowCount);
+			std::swap(colCount, other.colCount);
+		}
+
+		size_t rows() const { return rowCount; }
+		size_t cols() const { return colCount; }
+		size_t size() const { return rowCount * colCount; }
+
+		T* data() { return storage; }
+		const T* data() const { return storage; }
+
+		T* column(size_t col)
+		{
+			assert(col < colCount);
+			return storage + col * rowCount;
+		}
+
+		const T* column(size_t col) const
+		{
+			assert(col < colCount);
+			return storage + col * rowCount;
+		}
+
+		T& operator()(size_t row, size_t col)
+		{
+			assert(row < rowCount && col < colCount);
+			return storage[col * rowCount + row];
+		}
+
+		const T& operator()(size_t row, size_t col) const
+		{
+			assert(row < rowCount && col < colCount);
+			return storage[col * rowCount + row];
+		}
+
+		// contents are discarded and zeroed
+		void resize(size_t rows, size_t cols)
+		{
+			if (rows * cols != size())
+			{
+				alignedFree(storage);
+				storage = static_cast<T*>(alignedAlloc(sizeof(T) * rows * cols));
+			}
+
+			rowCount = rows;
+			colCount = cols;
+			setZero();
+		}
+
+		void setZero()
+		{
+			if (storage != nullptr)
+			{
+				std::memset(storage, 0, sizeof(T) * size());
+			}
+		}
+
+		DynamicMatrix<T>& setIdentity()
+		{
+			setZero();
+
+			for (size_t i = 0; i < std::min(rowCount, colCount); i++)
+			{
+				storage[i * rowCount + i] = T(1);
+			}
+
+			return *this;
+		}
+
+		template<size_t Rows_C, size_t Cols_C>
+		MatrixBlock<T, Rows_C, Cols_C> block(size_t row, size_t col)
+		{
+			assert(row + Rows_C <= rowCount && col + Cols_C <= colCount);
+			return MatrixBlock<T, Rows_C, Cols_C>(storage + col * rowCount + row, rowCount);
+		}
+
+		template<size_t Rows_C, size_t Cols_C>
+		Matrix<T, Rows_C, Cols_C> block(size_t row, size_t col) const
+		{
+			assert(row + Rows_C <= rowCount && col + Cols_C <= colCount);
+			return MatrixBlock<T, Rows_C, Cols_C>(const_cast<T*>(storage) + col * rowCount + row, rowCount);
+		}
+
+		DynamicMatrix<T> transposed() const
+		{
+			DynamicMatrix<T> result(colCount, rowCount);
+
+			for (size_t col = 0; col < colCount; col++)
+			{
+				for (size_t row = 0; row < rowCount; row++)
+				{
+					result.storage[row * colCount + col] = storage[col * rowCount + row];
+				}
+			}
+
+			return result;
+		}
+
+		DynamicMatrix<T> operator+(const DynamicMatrix<T>& other) const
+		{
+			assert(rowCount == other.rowCount && colCount == other.colCount);
+			DynamicMatrix<T> result(*this);
+			result += other;
+			return result;
+		}
+
+		DynamicMatrix<T> operator-(const DynamicMatrix<T>& other) const
+		{
+			assert(rowCount == other.rowCount && colCount == other.colCount);
+			DynamicMatrix<T> result(*this);
+			result -= other;
+			return result;
+		}
+
+		DynamicMatrix<T> operator*(const DynamicMatrix<T>& right) const;
+
+		DynamicMatrix<T> operator*(T scalar) const
+		{
+			DynamicMatrix<T> result(*this);
+			result *= scalar;
+			return result;
+		}
+
+		void operator+=(const DynamicMatrix<T>& other)
+		{
+			assert(rowCount == other.rowCount && colCount == other.colCount);
+
+			for (size_t i = 0; i < size(); i++)
+			{
+				storage[i] += other.storage[i];
+			}
+		}
+
+		void operator-=(const DynamicMatrix<T>& other)
+		{
+			assert(rowCount == other.rowCount && colCount == other.colCount);
+
+			for (size_t i = 0; i < size(); i++)
+			{
+				storage[i] -= other.storage[i];
+			}
+		}
+
+		void operator*=(T scalar)
+		{
+			for (size_t i = 0; i < size(); i++)
+			{
+				storage[i] *= scalar;
+			}
+		}
+
+		// y = this * x, x has cols() entries and y has rows()
+		void multiply(const T* x, T* y) const
+		{
+			std::fill(y, y + rowCount, T(0));
+
+			for (size_t col = 0; col < colCount; col++)
+			{
+				const T* src = storage + col * rowCount;
+				T factor = x[col];
+
+				for (size_t row = 0; row < rowCount; row++)
+				{
+					y[row] += src[row] * factor;
+				}
+			}
+		}
+
+	private:
+		T* storage = nullptr;
+		size_t rowCount = 0;
+		size_t colCount = 0;
+	};
+
+	typedef DynamicMatrix<float> DynamicMatrixf;
+	typedef DynamicMatrix<double> DynamicMatrixd;
+
+	namespace detail {
+
+		// register tile (MR x NR) and cache blocks: a KC x NR sliver of B stays in L1, an MC x KC panel of A in L2
+		template<typename T>
+		struct GemmBlocking
+		{
+			static const size_t MR = 8;
+			static const size_t NR = 4;
+			static const size_t KC = 256;
+			static const size_t MC = 128;
+			static const size_t NC = 4096;
+		};
+
+#if defined(ABSTRACTMATH_AVX2)
+		template<>
+		struct GemmBlocking<float>
+		{
+			static const size_t MR = 16;
+			static const size_t NR = 6;
+			static const size_t KC = 256;
+			static const size_t MC = 128;
+			static const size_t NC = 3072;
+		};
+
+		template<>
+		struct GemmBlocking<double>
+		{
+			static const size_t MR = 8;
+			static const size_t NR = 6;
+			static const size_t KC = 256;
+			static const size_t MC = 96;
+			static const size_t NC = 3072;
+		};
+#endif
+
+		template<typename T>
+		class AlignedBuffer
+		{
+		public:
+			explicit AlignedBuffer(size_t count) : data(static_cast<T*>(alignedAlloc(sizeof(T) * count))) {}
+			~AlignedBuffer() { alignedFree(data); }
+
+			AlignedBuffer(const AlignedBuffer<T>&) = delete;
+			AlignedBuffer<T>& operator=(const AlignedBuffer<T>&) = delete;
+
+			T* data;
+		};
+
+		// rows x depth block of A into MR-tall micro panels, each laid out k-major, short panels are zero padded
+		template<typename T>
+		inline void packA(const T* a, size_t lda, size_t rows, size_t depth, T* packed)
+		{
+			const size_t MR = GemmBlocking<T>::MR;
+
+			for (size_t i = 0; i < rows; i += MR)
+			{
+				size_t height = std::min(MR, rows - i);
+
+				for (size_t k = 0; k < depth; k++)
+				{
+					const T* src = a + k * lda + i;
+					size_t r = 0;
+
+					for (; r < height; r++)
+					{
+						packed[r] = src[r];
+					}
+
+					for (; r < MR; r++)
+					{
+						packed[r] = T(0);
+					}
+
+					packed += MR;
+				}
+			}
+		}
+
+		// depth x cols block of B into NR-wide micro panels, each laid out k-major
+		template<typename T>
+		inline void packB(const T* b, size_t ldb, size_t depth, size_t cols, T* packed)
+		{
+			const size_t NR = GemmBlocking<T>::NR;
+
+			for (size_t j = 0; j < cols; j += NR)
+			{
+				size_t width = std::min(NR, cols - j);
+
+				for (size_t k = 0; k < depth; k++)
+				{
+					size_t c = 0;
+
+					for (; c < width; c++)
+					{
+						packed[c] = b[(j + c) * ldb + k];
+					}
+
+					for (; c < NR; c++)
+					{
+						packed[c] = T(0);
+					}
+
+					packed += NR;
+				}
+			}
+		}
+
+		// acc (column-major MR x NR) = packed A sliver * packed B sliver
+		template<typename T>
+		inline void gemmMicroKernel(size_t depth, const T* a, const T* b, T* acc)
+		{
+			const size_t MR = GemmBlocking<T>::MR;
+			const size_t NR = GemmBlocking<T>::NR;
+
+#if defined(ABSTRACTMATH_AVX2)
+			if constexpr (std::is_same<T, float>::value)
+			{
+				__m256 c[NR][2];
+
+				for (size_t j = 0; j < NR; j++)
+				{
+					c[j][0] = _mm256_setzero_ps();
+					c[j][1] = _mm256_setzero_ps();
+				}
+
+				for (size_t k = 0; k < depth; k++)
+				{
+					__m256 a0 = _mm256_load_ps(a);
+					__m256 a1 = _mm256_load_ps(a + 8);
+
+					for (size_t j = 0; j < NR; j++)
+					{
+						__m256 bj = _mm256_broadcast_ss(b + j);
+						c[j][0] = multiplyAdd(a0, bj, c[j][0]);
+						c[j][1] = multiplyAdd(a1, bj, c[j][1]);
+					}
+
+					a += MR;
+					b += NR;
+				}
+
+				for (size_t j = 0; j < NR; j++)
+				{
+					_mm256_storeu_ps(acc + j * MR, c[j][0]);
+					_mm256_storeu_ps(acc + j * MR + 8, c[j][1]);
+				}
+
+				return;
+			}
+			else if constexpr (std::is_same<T, double>::value)
+			{
+				__m256d c[NR][2];
+
+				for (size_t j = 0; j < NR; j++)
+				{
+					c[j][0] = _mm256_setzero_pd();
+					c[j][1] = _mm256_setzero_pd();
+				}
+
+				for (size_t k = 0; k < depth; k++)
+				{
+					__m256d a0 = _mm256_load_pd(a);
+					__m256d a1 = _mm256_load_pd(a + 4);
+
+					for (size_t j = 0; j < NR; j++)
+					{
+						__m256d bj = _mm256_broadcast_sd(b + j);
+#if defined(ABSTRACTMATH_FMA)
+						c[j][0] = _mm256_fmadd_pd(a0, bj, c[j][0]);
+						c[j][1] = _mm256_fmadd_pd(a1, bj, c[j][1]);
+#else
+						c[j][0] = _mm256_add_pd(_mm256_mul_pd(a0, bj), c[j][0]);
+						c[j][1] = _mm256_add_pd(_mm256_mul_pd(a1, bj), c[j][1]);
+#endif
+					}
+
+					a += MR;
+					b += NR;
+				}
+
+				for (size_t j = 0; j < NR; j++)
+				{
+					_mm256_storeu_pd(acc + j * MR, c[j][0]);
+					_mm256_storeu_pd(acc + j * MR + 4, c[j][1]);
+				}
+
+				return;
+			}
+#endif
+
+			T c[NR * MR] = {};
+
+			for (size_t k = 0; k < depth; k++)
+			{
+				for (size_t j = 0; j < NR; j++)
+				{
+					T bj = b[j];
+
+					for (size_t i = 0; i < MR; i++)
+					{
+						c[j * MR + i] += a[i] * bj;
+					}
+				}
+
+				a += MR;
+				b += NR;
+			}
+
+			std::memcpy(acc, c, sizeof(c));
+		}
+	}
+
+	// C = alpha * A * B + beta * C, cache blocked with packed panels and split across threads by MC row blocks of C
+	template<typename T>
+	void gemm(const DynamicMatrix<T>& a, const DynamicMatrix<T>& b, DynamicMatrix<T>& c, T alpha = T(1), T beta = T(0))
+	{
+		using Blocking = detail::GemmBlocking<T>;
+		const size_t MR = Blocking::MR, NR = Blocking::NR, KC = Blocking::KC, MC = Blocking::MC, NC = Blocking::NC;
+
+		assert(a.cols() == b.rows());
+		assert(&c != &a && &c != &b);
+
+		const size_t m = a.rows(), n = b.cols(), k = a.cols();
+		ABSTRACTMATH_PROFILE_SCOPE(Gemm, uint64_t(m) * n * k);
+
+		if (c.rows() != m || c.cols() != n)
+		{
+			c.resize(m, n);
+		}
+		else if (beta == T(0))
+		{
+			c.setZero();
+		}
+		else if (beta != T(1))
+		{
+			c *= beta;
+		}
+
+		if (m == 0 || n == 0 || k == 0)
+		{
+			return;
+		}
+
+		const size_t blocksPerRow = (m + MC - 1) / MC;
+		detail::AlignedBuffer<T> packedB(((std::min(NC, n) + NR - 1) / NR * NR) * KC);
+
+		for (size_t jc = 0; jc < n; jc += NC)
+		{
+			size_t nc = std::min(NC, n - jc);
+
+			for (size_t pc = 0; pc < k; pc += KC)
+			{
+				size_t kc = std::min(KC, k - pc);
+				detail::packB(b.data() + jc * k + pc, k, kc, nc, packedB.data);
+
+				parallelFor(0, blocksPerRow, 1, [&](size_t firstBlock, size_t lastBlock)
+				{
+					detail::AlignedBuffer<T> packedA(MC * KC);
+					alignas(SIMD_ALIGNMENT) T tile[MR * NR];
+
+					for (size_t block = firstBlock; block < lastBlock; block++)
+					{
+						size_t ic = block * MC;
+						size_t mc = std::min(MC, m - ic);
+						detail::packA(a.data() + pc * m + ic, m, mc, kc, packedA.data);
+
+						for (size_t jr = 0; jr < nc; jr += NR)
+						{
+							size_t width = std::min(NR, nc - jr);
+
+							for (size_t ir = 0; ir < mc; ir += MR)
+							{
+								size_t height = std::min(MR, mc - ir);
+								detail::gemmMicroKernel(kc, packedA.data + ir * kc, packedB.data + jr * kc, tile);
+
+								T* dest = c.data() + (jc + jr) * m + ic + ir;
+
+								for (size_t j = 0; j < width; j++)
+								{
+									for (size_t i = 0; i < height; i++)
+									{
+										dest[j * m + i] += alpha * tile[j * MR + i];
+									}
+								}
+							}
+						}
+					}
+				});
+			}
+		}
+	}
+
+	template<typename T>
+	DynamicMatrix<T> DynamicMatrix<T>::operator*(const DynamicMatrix<T>& right) const
+	{
+		DynamicMatrix<T> result(rowCount, right.colCount);
+		gemm(*this, right, result);
+		return result;
+	}
+}
\ No newline at end of file
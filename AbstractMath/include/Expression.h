@@ -0,0 +1,258 @@
+#pragma once
+
+#include <type_traits>
+#include <assert.h>
+
+#include "Vector.h"
+#include "Matrix.h"
+
+namespace AbstractMath {
+
+	// opt-in lazy arithmetic, start an expression with lazy(vector) or lazy(matrix)
+	// element-wise vector chains evaluate in one loop, matrix chains pick the cheapest association
+	// and a chain multiplied by a vector is applied right to left as matrix-vector products only
+	// operands are referenced, an expression must not outlive the vectors and matrices it was built from
+
+	template<typename E, typename T, size_t C>
+	struct VectorExpression
+	{
+		using type = T;
+		static const size_t COMPONENTS = C;
+
+		constexpr const E& self() const { return static_cast<const E&>(*this); }
+
+		constexpr Vector<T, C> eval() const
+		{
+			Vector<T, C> result;
+
+			for (size_t i = 0; i < C; i++)
+			{
+				result.data[i] = self()[i];
+			}
+
+			return result;
+		}
+
+		constexpr operator Vector<T, C>() const
+		{
+			return eval();
+		}
+	};
+
+	template<typename T, size_t C>
+	struct VectorRef : public VectorExpression<VectorRef<T, C>, T, C>
+	{
+		const Vector<T, C>& vector;
+
+		constexpr explicit VectorRef(const Vector<T, C>& vector) : vector(vector) {}
+
+		constexpr T operator[](size_t index) const { return vector.data[index]; }
+	};
+
+	template<typename Op, typename L, typename R, typename T, size_t C>
+	struct VectorBinary : public VectorExpression<VectorBinary<Op, L, R, T, C>, T, C>
+	{
+		L left;
+		R right;
+
+		constexpr VectorBinary(const L& left, const R& right) : left(left), right(right) {}
+
+		constexpr T operator[](size_t index) const { return Op::apply(left[index], right[index]); }
+	};
+
+	template<typename Op, typename L, typename S, typename T, size_t C>
+	struct VectorScalar : public VectorExpression<VectorScalar<Op, L, S, T, C>, T, C>
+	{
+		L left;
+		S scalar;
+
+		constexpr VectorScalar(const L& left, const S& scalar) : left(left), scalar(scalar) {}
+
+		constexpr T operator[](size_t index) const { return Op::apply(left[index], scalar); }
+	};
+
+	template<typename Op, typename S, typename R, typename T, size_t C>
+	struct ScalarVector : public VectorExpression<ScalarVector<Op, S, R, T, C>, T, C>
+	{
+		S scalar;
+		R right;
+
+		constexpr ScalarVector(const S& scalar, const R& right) : scalar(scalar), right(right) {}
+
+		constexpr T operator[](size_t index) const { return Op::apply(scalar, right[index]); }
+	};
+
+	template<typename L, typename T, size_t C>
+	struct VectorNegate : public VectorExpression<VectorNegate<L, T, C>, T, C>
+	{
+		L left;
+
+		constexpr explicit VectorNegate(const L& left) : left(left) {}
+
+		constexpr T operator[](size_t index) const { return -left[index]; }
+	};
+
+	namespace detail {
+
+		struct AddOp { template<typename A, typename B> static constexpr auto apply(const A& a, const B& b) { return a + b; } };
+		struct SubtractOp { template<typename A, typename B> static constexpr auto apply(const A& a, const B& b) { return a - b; } };
+		struct MultiplyOp { template<typename A, typename B> static constexpr auto apply(const A& a, const B& b) { return a * b; } };
+		struct DivideOp { template<typename A, typename B> static constexpr auto apply(const A& a, const B& b) { return a / b; } };
+
+		template<typename Op, typename A, typename B>
+		using op_result = decltype(Op::apply(A(1), B(1)));
+	}
+
+	template<typename T, size_t C>
+	constexpr VectorRef<T, C> lazy(const Vector<T, C>& vector)
+	{
+		return VectorRef<T, C>(vector);
+	}
+
+#define ABSTRACTMATH_VECTOR_EXPRESSION_OPERATOR(symbol, Op) \
+	template<typename L, typename LT, typename R, typename RT, size_t C> \
+	constexpr VectorBinary<Op, L, R, detail::op_result<Op, LT, RT>, C> operator symbol(const VectorExpression<L, LT, C>& left, const VectorExpression<R, RT, C>& right) \
+	{ \
+		return VectorBinary<Op, L, R, detail::op_result<Op, LT, RT>, C>(left.self(), right.self()); \
+	} \
+	\
+	template<typename L, typename LT, typename RT, size_t C> \
+	constexpr VectorBinary<Op, L, VectorRef<RT, C>, detail::op_result<Op, LT, RT>, C> operator symbol(const VectorExpression<L, LT, C>& left, const Vector<RT, C>& right) \
+	{ \
+		return VectorBinary<Op, L, VectorRef<RT, C>, detail::op_result<Op, LT, RT>, C>(left.self(), VectorRef<RT, C>(right)); \
+	} \
+	\
+	template<typename LT, typename R, typename RT, size_t C> \
+	constexpr VectorBinary<Op, VectorRef<LT, C>, R, detail::op_result<Op, LT, RT>, C> operator symbol(const Vector<LT, C>& left, const VectorExpression<R, RT, C>& right) \
+	{ \
+		return VectorBinary<Op, VectorRef<LT, C>, R, detail::op_result<Op, LT, RT>, C>(VectorRef<LT, C>(left), right.self()); \
+	} \
+	\
+	template<typename L, typename LT, size_t C, typename S, typename = typename std::enable_if<std::is_arithmetic<S>::value>::type> \
+	constexpr VectorScalar<Op, L, S, detail::op_result<Op, LT, S>, C> operator symbol(const VectorExpression<L, LT, C>& left, const S& right) \
+	{ \
+		return VectorScalar<Op, L, S, detail::op_result<Op, LT, S>, C>(left.self(), right); \
+	} \
+	\
+	template<typename S, typename R, typename RT, size_t C, typename = typename std::enable_if<std::is_arithmetic<S>::value>::type> \
+	constexpr ScalarVector<Op, S, R, detail::op_result<Op, S, RT>, C> operator symbol(const S& left, const VectorExpression<R, RT, C>& right) \
+	{ \
+		return ScalarVector<Op, S, R, detail::op_result<Op, S, RT>, C>(left, right.self()); \
+	}
+
+	ABSTRACTMATH_VECTOR_EXPRESSION_OPERATOR(+, detail::AddOp)
+	ABSTRACTMATH_VECTOR_EXPRESSION_OPERATOR(-, detail::SubtractOp)
+	ABSTRACTMATH_VECTOR_EXPRESSION_OPERATOR(*, detail::MultiplyOp)
+	ABSTRACTMATH_VECTOR_EXPRESSION_OPERATOR(/, detail::DivideOp)
+
+#undef ABSTRACTMATH_VECTOR_EXPRESSION_OPERATOR
+
+	template<typename L, typename LT, size_t C>
+	constexpr VectorNegate<L, LT, C> operator-(const VectorExpression<L, LT, C>& left)
+	{
+		return VectorNegate<L, LT, C>(left.self());
+	}
+
+	template<typename E, typename T, size_t Rows_C, size_t Cols_C>
+	struct MatrixExpression
+	{
+		using type = T;
+		static const size_t ROWS = Rows_C;
+		static const size_t COLS = Cols_C;
+
+		constexpr const E& self() const { return static_cast<const E&>(*this); }
+
+		constexpr Matrix<T, Rows_C, Cols_C> eval() const { return self().evaluate(); }
+
+		constexpr operator Matrix<T, Rows_C, Cols_C>() const { return eval(); }
+	};
+
+	template<typename T, size_t Rows_C, size_t Cols_C>
+	struct MatrixRef : public MatrixExpression<MatrixRef<T, Rows_C, Cols_C>, T, Rows_C, Cols_C>
+	{
+		static const bool IS_PRODUCT = false;
+		const Matrix<T, Rows_C, Cols_C>& matrix;
+
+		constexpr explicit MatrixRef(const Matrix<T, Rows_C, Cols_C>& matrix) : matrix(matrix) {}
+
+		constexpr const Matrix<T, Rows_C, Cols_C>& evaluate() const { return matrix; }
+
+		template<typename Ty>
+		constexpr auto apply(const Vector<Ty, Cols_C>& vector) const { return matrix * vector; }
+	};
+
+	template<typename L, typename R, typename T>
+	struct MatrixProduct : public MatrixExpression<MatrixProduct<L, R, T>, T, L::ROWS, R::COLS>
+	{
+		static_assert(L::COLS == R::ROWS, "Inner dimensions of a matrix product must match!");
+		static const bool IS_PRODUCT = true;
+
+		L left;
+		R right;
+
+		constexpr MatrixProduct(const L& left, const R& right) : left(left), right(right) {}
+
+		// ((A B) C) costs rows(A) * cols(A) * cols(B) + rows(A) * cols(B) * cols(C) multiplies,
+		// (A (B C)) costs rows(B) * cols(B) * cols(C) + rows(A) * cols(A) * cols(C), regroup when that is cheaper
+		constexpr Matrix<T, L::ROWS, R::COLS> evaluate() const
+		{
+			if constexpr (L::IS_PRODUCT)
+			{
+				using A = decltype(left.left);
+				using B = decltype(left.right);
+
+				constexpr size_t leftFirst = A::ROWS * A::COLS * B::COLS + A::ROWS * B::COLS * R::COLS;
+				constexpr size_t rightFirst = B::ROWS * B::COLS * R::COLS + A::ROWS * A::COLS * R::COLS;
+
+				if constexpr (rightFirst < leftFirst)
+				{
+					using inner_type = decltype(typename B::type(1) * typename R::type(1));
+					MatrixProduct<B, R, inner_type> inner(left.right, right);
+					return Matrix<T, L::ROWS, R::COLS>(left.left.evaluate() * inner.evaluate());
+				}
+			}
+
+			return Matrix<T, L::ROWS, R::COLS>(left.evaluate() * right.evaluate());
+		}
+
+		template<typename Ty>
+		constexpr auto apply(const Vector<Ty, R::COLS>& vector) const { return left.apply(right.apply(vector)); }
+	};
+
+	template<typename T, size_t Rows_C, size_t Cols_C>
+	constexpr MatrixRef<T, Rows_C, Cols_C> lazy(const Matrix<T, Rows_C, Cols_C>& matrix)
+	{
+		return MatrixRef<T, Rows_C, Cols_C>(matrix);
+	}
+
+	template<typename L, typename LT, size_t Rows_C, size_t Inner_C, typename R, typename RT, size_t Cols_C>
+	constexpr MatrixProduct<L, R, decltype(LT(1)* RT(1))> operator*(const MatrixExpression<L, LT, Rows_C, Inner_C>& left, const MatrixExpression<R, RT, Inner_C, Cols_C>& right)
+	{
+		return MatrixProduct<L, R, decltype(LT(1)* RT(1))>(left.self(), right.self());
+	}
+
+	template<typename L, typename LT, size_t Rows_C, size_t Inner_C, typename RT, size_t Cols_C>
+	constexpr MatrixProduct<L, MatrixRef<RT, Inner_C, Cols_C>, decltype(LT(1)* RT(1))> operator*(const MatrixExpression<L, LT, Rows_C, Inner_C>& left, const Matrix<RT, Inner_C, Cols_C>& right)
+	{
+		return MatrixProduct<L, MatrixRef<RT, Inner_C, Cols_C>, decltype(LT(1)* RT(1))>(left.self(), MatrixRef<RT, Inner_C, Cols_C>(right));
+	}
+
+	template<typename LT, size_t Rows_C, size_t Inner_C, typename R, typename RT, size_t Cols_C>
+	constexpr MatrixProduct<MatrixRef<LT, Rows_C, Inner_C>, R, decltype(LT(1)* RT(1))> operator*(const Matrix<LT, Rows_C, Inner_C>& left, const MatrixExpression<R, RT, Inner_C, Cols_C>& right)
+	{
+		return MatrixProduct<MatrixRef<LT, Rows_C, Inner_C>, R, decltype(LT(1)* RT(1))>(MatrixRef<LT, Rows_C, Inner_C>(left), right.self());
+	}
+
+	// a chain times a vector never forms a matrix-matrix product
+	template<typename L, typename LT, size_t Rows_C, size_t Cols_C, typename Ty>
+	constexpr auto operator*(const MatrixExpression<L, LT, Rows_C, Cols_C>& left, const Vector<Ty, Cols_C>& right)
+	{
+		return left.self().apply(right);
+	}
+
+	template<typename L, typename LT, size_t Rows_C, size_t Cols_C, typename R, typename RT>
+	constexpr auto operator*(const MatrixExpression<L, LT, Rows_C, Cols_C>& left, const VectorExpression<R, RT, Cols_C>& right)
+	{
+		return left.self().apply(right.eval());
+	}
+}
\ No newline at end of file
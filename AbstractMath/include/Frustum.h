@@ -0,0 +1,381 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <algorithm>
+#include <vector>
+#include <assert.h>
+
+#include "Simd.h"
+#include "MathFunctions.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "VectorArray.h"
+#include "Parallel.h"
+
+namespace AbstractMath {
+
+	// clip-space depth range a projection maps its near and far planes to
+	enum class DepthRange
+	{
+		ZeroToOne,			//perspective(), orthographic()
+		NegativeOneToOne	//perspectiveOGL(), orthographicOGL()
+	};
+
+	template<typename T>
+	class Frustum;
+
+	namespace detail {
+
+		// six planes as columns, padded to eight with planes that never reject so a lane index can pick any of them
+		template<typename T>
+		struct alignas(SIMD_ALIGNMENT) FrustumPlaneTable
+		{
+			T a[8] = {};
+			T b[8] = {};
+			T c[8] = {};
+			T d[8] = {};
+		};
+
+		// signed distance to the plane widened by the bounds, negative means fully outside
+		// spheres are lanes { x, y, z, radius }, boxes are lanes { centerX, centerY, centerZ, extentX, extentY, extentZ }
+		template<bool BOX, typename T>
+		inline T planeMargin(const Vector<T, 4>& plane, const T* const* lanes, size_t i)
+		{
+			T distance = plane.data[0] * lanes[0][i] + plane.data[1] * lanes[1][i] + plane.data[2] * lanes[2][i] + plane.data[3];
+
+			if constexpr (BOX)
+			{
+				return distance + std::abs(plane.data[0]) * lanes[3][i] + std::abs(plane.data[1]) * lanes[4][i] + std::abs(plane.data[2]) * lanes[5][i];
+			}
+			else
+			{
+				return distance + lanes[3][i];
+			}
+		}
+
+#if defined(ABSTRACTMATH_AVX2)
+		template<bool BOX>
+		inline __m256 planeOutside(__m256 a, __m256 b, __m256 c, __m256 d, const __m256* bounds)
+		{
+			__m256 margin = multiplyAdd(c, bounds[2], multiplyAdd(b, bounds[1], multiplyAdd(a, bounds[0], d)));
+
+			if constexpr (BOX)
+			{
+				const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+				margin = multiplyAdd(_mm256_and_ps(a, absMask), bounds[3], margin);
+				margin = multiplyAdd(_mm256_and_ps(b, absMask), bounds[4], margin);
+				margin = multiplyAdd(_mm256_and_ps(c, absMask), bounds[5], margin);
+			}
+			else
+			{
+				margin = _mm256_add_ps(margin, bounds[3]);
+			}
+
+			return _mm256_cmp_ps(margin, _mm256_setzero_ps(), _CMP_LT_OQ);
+		}
+#endif
+
+		// writes the indices in [begin, end) that survive every plane to visible[0...] and returns how many there are
+		// coherency (optional, one byte per object, start at zero) remembers the plane that last rejected each object
+		// and tests it first, objects (or whole simd blocks) that stay outside then cost a single plane
+		template<bool BOX, typename T>
+		size_t cullRange(const Frustum<T>& frustum, const T* const* lanes, size_t begin, size_t end, uint32_t* visible, uint8_t* coherency)
+		{
+			constexpr size_t PLANES = Frustum<T>::PLANE_COUNT;
+			size_t found = 0;
+			size_t i = begin;
+
+#if defined(ABSTRACTMATH_AVX2)
+			if constexpr (std::is_same<T, float>::value)
+			{
+				constexpr size_t BOUNDS = BOX ? 6 : 4;
+				FrustumPlaneTable<float> table;
+
+				for (size_t p = 0; p < PLANES; p++)
+				{
+					table.a[p] = frustum.planes[p].data[0];
+					table.b[p] = frustum.planes[p].data[1];
+					table.c[p] = frustum.planes[p].data[2];
+					table.d[p] = frustum.planes[p].data[3];
+				}
+
+				const __m256 tableA = _mm256_load_ps(table.a);
+				const __m256 tableB = _mm256_load_ps(table.b);
+				const __m256 tableC = _mm256_load_ps(table.c);
+				const __m256 tableD = _mm256_load_ps(table.d);
+
+				for (; i + 8 <= end; i += 8)
+				{
+					__m256 bounds[BOUNDS];
+
+					for (size_t l = 0; l < BOUNDS; l++)
+					{
+						bounds[l] = _mm256_loadu_ps(lanes[l] + i);
+					}
+
+					__m256 culled = _mm256_setzero_ps();
+					__m256i rejecting = _mm256_setzero_si256();
+
+					if (coherency)
+					{
+						rejecting = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(coherency + i)));
+						culled = planeOutside<BOX>(_mm256_permutevar8x32_ps(tableA, rejecting), _mm256_permutevar8x32_ps(tableB, rejecting),
+							_mm256_permutevar8x32_ps(tableC, rejecting), _mm256_permutevar8x32_ps(tableD, rejecting), bounds);
+
+						if (_mm256_movemask_ps(culled) == 0xff)
+						{
+							continue;
+						}
+					}
+
+					for (size_t p = 0; p < PLANES; p++)
+					{
+						__m256 outside = planeOutside<BOX>(_mm256_set1_ps(table.a[p]), _mm256_set1_ps(table.b[p]), _mm256_set1_ps(table.c[p]), _mm256_set1_ps(table.d[p]), bounds);
+
+						if (coherency)
+						{
+							__m256 newlyCulled = _mm256_andnot_ps(culled, outside);
+							rejecting = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(rejecting), _mm256_castsi256_ps(_mm256_set1_epi32(int(p))), newlyCulled));
+						}
+
+						culled = _mm256_or_ps(culled, outside); //no per-plane early out, the branch costs more than the two planes it saves
+					}
+
+					if (coherency)
+					{
+						//eight 32-bit plane indices down to eight bytes, packs work per 128-bit half so gather the halves' low words
+						__m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(rejecting, rejecting), _mm256_setzero_si256());
+						packed = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0));
+						_mm_storel_epi64(reinterpret_cast<__m128i*>(coherency + i), _mm256_castsi256_si128(packed));
+					}
+
+					//branch-free compaction: every lane is written, only visible ones advance the cursor
+					int visibleMask = ~_mm256_movemask_ps(culled) & 0xff;
+
+					for (size_t k = 0; k < 8; k++)
+					{
+						visible[found] = uint32_t(i + k);
+						found += (visibleMask >> k) & 1;
+					}
+				}
+			}
+#endif
+
+			if (!coherency)
+			{
+				//every plane and no branches, outside objects are far too common for an early out to predict well
+				for (; i < end; i++)
+				{
+					bool outside = false;
+
+					for (size_t p = 0; p < PLANES; p++)
+					{
+						outside |= planeMargin<BOX>(frustum.planes[p], lanes, i) < T(0);
+					}
+
+					visible[found] = uint32_t(i);
+					found += outside ? 0 : 1;
+				}
+			}
+
+			for (; i < end; i++)
+			{
+				size_t cached = coherency[i] % PLANES;
+
+				if (planeMargin<BOX>(frustum.planes[cached], lanes, i) < T(0))
+				{
+					continue;
+				}
+
+				bool inside = true;
+
+				for (size_t p = 0; p < PLANES; p++)
+				{
+					if (p != cached && planeMargin<BOX>(frustum.planes[p], lanes, i) < T(0))
+					{
+						inside = false;
+						coherency[i] = uint8_t(p);
+						break;
+					}
+				}
+
+				if (inside)
+				{
+					visible[found++] = uint32_t(i);
+				}
+			}
+
+			return found;
+		}
+
+		// every partition compacts into its own slice of visible, the slices are then packed together in order
+		// so the result is identical to the single-threaded one
+		template<bool BOX, typename T>
+		size_t cullPartitioned(const Frustum<T>& frustum, const T* const* lanes, size_t count, uint32_t* visible, uint8_t* coherency, size_t grain)
+		{
+			grain = std::max<size_t>((grain + 7) / 8 * 8, 8);
+			size_t partitions = (count + grain - 1) / grain;
+			std::vector<size_t> found(partitions, 0);
+
+			parallelFor(0, partitions, 1, [&](size_t first, size_t last)
+			{
+				for (size_t p = first; p < last; p++)
+				{
+					size_t begin = p * grain;
+					found[p] = cullRange<BOX>(frustum, lanes, begin, std::min(count, begin + grain), visible + begin, coherency);
+				}
+			});
+
+			size_t total = 0;
+
+			for (size_t p = 0; p < partitions; p++)
+			{
+				if (total != p * grain)
+				{
+					std::memmove(visible + total, visible + p * grain, sizeof(uint32_t) * found[p]);
+				}
+
+				total += found[p];
+			}
+
+			return total;
+		}
+	}
+
+	// view frustum as six normalized planes pulled from a view-projection matrix (Gribb-Hartmann)
+	// planes are in the space the matrix transforms from: a projection gives view-space planes, projection * view world-space ones
+	template<typename T>
+	class Frustum
+	{
+		static_assert(std::is_floating_point<T>::value, "Frustum requires a floating point type!");
+
+	public:
+		static const size_t PLANE_COUNT = 6;
+		static const size_t PARALLEL_GRAIN = 16384; //objects per partition in the parallel modes
+
+		// left, right, bottom, top, near, far as ( nx, ny, nz, d ) with unit normals pointing inside: dot(n, p) + d >= 0
+		Vector<T, 4> planes[PLANE_COUNT];
+
+	public:
+		constexpr Frustum() = default;
+
+		constexpr explicit Frustum(const Matrix<T, 4, 4>& viewProjection, DepthRange depth = DepthRange::ZeroToOne)
+		{
+			const T* m = viewProjection.data; //row r, column c is m[c * 4 + r]
+
+			for (size_t c = 0; c < 4; c++)
+			{
+				T row0 = m[c * 4 + 0], row1 = m[c * 4 + 1], row2 = m[c * 4 + 2], row3 = m[c * 4 + 3];
+
+				planes[0].data[c] = row3 + row0;
+				planes[1].data[c] = row3 - row0;
+				planes[2].data[c] = row3 + row1;
+				planes[3].data[c] = row3 - row1;
+				planes[4].data[c] = depth == DepthRange::ZeroToOne ? row2 : row3 + row2;
+				planes[5].data[c] = row3 - row2;
+			}
+
+			for (size_t p = 0; p < PLANE_COUNT; p++)
+			{
+				T length = math::sqrt(planes[p].data[0] * planes[p].data[0] + planes[p].data[1] * planes[p].data[1] + planes[p].data[2] * planes[p].data[2]);
+
+				if (length > T(0))
+				{
+					for (size_t c = 0; c < 4; c++)
+					{
+						planes[p].data[c] /= length;
+					}
+				}
+			}
+		}
+
+		constexpr T distance(size_t plane, const Vector<T, 3>& point) const
+		{
+			assert(plane < PLANE_COUNT);
+			const Vector<T, 4>& p = planes[plane];
+			return p.data[0] * point.data[0] + p.data[1] * point.data[1] + p.data[2] * point.data[2] + p.data[3];
+		}
+
+		constexpr bool containsPoint(const Vector<T, 3>& point) const
+		{
+			return intersectsSphere(point, T(0));
+		}
+
+		constexpr bool intersectsSphere(const Vector<T, 3>& center, T radius) const
+		{
+			for (size_t p = 0; p < PLANE_COUNT; p++)
+			{
+				if (distance(p, center) < -radius)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		// axis aligned box as center and half extents
+		constexpr bool intersectsBox(const Vector<T, 3>& center, const Vector<T, 3>& extents) const
+		{
+			for (size_t p = 0; p < PLANE_COUNT; p++)
+			{
+				const Vector<T, 4>& plane = planes[p];
+				T radius = (plane.data[0] < T(0) ? -plane.data[0] : plane.data[0]) * extents.data[0]
+					+ (plane.data[1] < T(0) ? -plane.data[1] : plane.data[1]) * extents.data[1]
+					+ (plane.data[2] < T(0) ? -plane.data[2] : plane.data[2]) * extents.data[2];
+
+				if (distance(p, center) < -radius)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		// batch tests, conservative like the single ones (objects near a frustum corner may pass)
+		// visible needs room for one index per object and receives the surviving indices in increasing order
+		// coherency is optional, one byte per object zero-initialized once and kept between frames
+		// float uses AVX2 when available (eight objects per iteration), other types the scalar loop
+
+		// spheres lanes are { x, y, z, radius }
+		size_t cullSpheres(const VectorArray<T, 4>& spheres, uint32_t* visible, uint8_t* coherency = nullptr) const
+		{
+			const T* lanes[4] = { spheres.lane(0), spheres.lane(1), spheres.lane(2), spheres.lane(3) };
+			return detail::cullRange<false>(*this, lanes, 0, checkedCount(spheres.size()), visible, coherency);
+		}
+
+		size_t cullBoxes(const VectorArray<T, 3>& centers, const VectorArray<T, 3>& extents, uint32_t* visible, uint8_t* coherency = nullptr) const
+		{
+			assert(centers.size() == extents.size());
+			const T* lanes[6] = { centers.lane(0), centers.lane(1), centers.lane(2), extents.lane(0), extents.lane(1), extents.lane(2) };
+			return detail::cullRange<true>(*this, lanes, 0, checkedCount(centers.size()), visible, coherency);
+		}
+
+		// partitioned over parallelFor, same output as the single-threaded versions
+		size_t cullSpheresParallel(const VectorArray<T, 4>& spheres, uint32_t* visible, uint8_t* coherency = nullptr, size_t grain = PARALLEL_GRAIN) const
+		{
+			const T* lanes[4] = { spheres.lane(0), spheres.lane(1), spheres.lane(2), spheres.lane(3) };
+			return detail::cullPartitioned<false>(*this, lanes, checkedCount(spheres.size()), visible, coherency, grain);
+		}
+
+		size_t cullBoxesParallel(const VectorArray<T, 3>& centers, const VectorArray<T, 3>& extents, uint32_t* visible, uint8_t* coherency = nullptr, size_t grain = PARALLEL_GRAIN) const
+		{
+			assert(centers.size() == extents.size());
+			const T* lanes[6] = { centers.lane(0), centers.lane(1), centers.lane(2), extents.lane(0), extents.lane(1), extents.lane(2) };
+			return detail::cullPartitioned<true>(*this, lanes, checkedCount(centers.size()), visible, coherency, grain);
+		}
+
+	private:
+		static size_t checkedCount(size_t count)
+		{
+			assert(count <= size_t(UINT32_MAX));
+			return count;
+		}
+	};
+
+	typedef Frustum<float> Frustumf;
+	typedef Frustum<double> Frustumd;
+}
\ No newline at end of file
@@ -0,0 +1,753 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <algorithm>
+#include <assert.h>
+
+#include "Simd.h"
+#include "Profiling.h"
+#include "Vector.h"
+#include "Vec2.h"
+#include "Vec3.h"
+#include "VectorArray.h"
+#include "Parallel.h"
+
+namespace AbstractMath {
+
+	// segment of a line, the points at origin + t * direction for t in [tMin, tMax], direction need not be unit
+	// length (t is then in its units)
+	template<typename T>
+	struct Ray
+	{
+		static_assert(std::is_floating_point<T>::value, "Ray requires a floating point type!");
+
+		Vector3<T> origin;
+		Vector3<T> direction;
+		T tMin = T(0);
+		T tMax = std::numeric_limits<T>::infinity();
+
+		constexpr Ray() = default;
+
+		constexpr Ray(const Vector3<T>& origin, const Vector3<T>& direction, T tMin = T(0), T tMax = std::numeric_limits<T>::infinity())
+			: origin(origin), direction(direction), tMin(tMin), tMax(tMax) {}
+
+		constexpr Vector3<T> at(T t) const
+		{
+			return Vector3<T>(origin.data[0] + direction.data[0] * t, origin.data[1] + direction.data[1] * t, origin.data[2] + direction.data[2] * t);
+		}
+
+		// what the slab tests multiply by, a zero component gives an infinity of the matching sign
+		constexpr Vector3<T> inverseDirection() const
+		{
+			return Vector3<T>(T(1) / direction.data[0], T(1) / direction.data[1], T(1) / direction.data[2]);
+		}
+	};
+
+	// axis aligned box as its corners, default constructed it is empty (min above max) so expanding it by anything
+	// gives that thing's bounds
+	template<typename T>
+	struct AABB
+	{
+		static_assert(std::is_floating_point<T>::value, "AABB requires a floating point type!");
+
+		Vector3<T> min = Vector3<T>(std::numeric_limits<T>::max(), std::numeric_limits<T>::max(), std::numeric_limits<T>::max());
+		Vector3<T> max = Vector3<T>(std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest());
+
+		constexpr AABB() = default;
+
+		constexpr AABB(const Vector3<T>& min, const Vector3<T>& max) : min(min), max(max) {}
+
+		constexpr bool isEmpty() const
+		{
+			return min.data[0] > max.data[0] || min.data[1] > max.data[1] || min.data[2] > max.data[2];
+		}
+
+		constexpr Vector3<T> center() const
+		{
+			return Vector3<T>((min.data[0] + max.data[0]) * T(0.5), (min.data[1] + max.data[1]) * T(0.5), (min.data[2] + max.data[2]) * T(0.5));
+		}
+
+		// half the size along each axis, what Frustum::intersectBox takes
+		constexpr Vector3<T> extents() const
+		{
+			return Vector3<T>((max.data[0] - min.data[0]) * T(0.5), (max.data[1] - min.data[1]) * T(0.5), (max.data[2] - min.data[2]) * T(0.5));
+		}
+
+		// zero for an empty box
+		constexpr T surfaceArea() const
+		{
+			if (isEmpty())
+			{
+				return T(0);
+			}
+
+			T x = max.data[0] - min.data[0], y = max.data[1] - min.data[1], z = max.data[2] - min.data[2];
+			return T(2) * (x * y + y * z + z * x);
+		}
+
+		constexpr bool contains(const Vector<T, 3>& point) const
+		{
+			return point.data[0] >= min.data[0] && point.data[0] <= max.data[0] && point.data[1] >= min.data[1] && point.data[1] <= max.data[1]
+				&& point.data[2] >= min.data[2] && point.data[2] <= max.data[2];
+		}
+
+		constexpr bool overlaps(const AABB<T>& other) const
+		{
+			return min.data[0] <= other.max.data[0] && max.data[0] >= other.min.data[0] && min.data[1] <= other.max.data[1] && max.data[1] >= other.min.data[1]
+				&& min.data[2] <= other.max.data[2] && max.data[2] >= other.min.data[2];
+		}
+
+		constexpr AABB<T>& expand(const Vector<T, 3>& point)
+		{
+			for (size_t i = 0; i < 3; i++)
+			{
+				min.data[i] = point.data[i] < min.data[i] ? point.data[i] : min.data[i];
+				max.data[i] = point.data[i] > max.data[i] ? point.data[i] : max.data[i];
+			}
+
+			return *this;
+		}
+
+		constexpr AABB<T>& expand(const AABB<T>& other)
+		{
+			for (size_t i = 0; i < 3; i++)
+			{
+				min.data[i] = other.min.data[i] < min.data[i] ? other.min.data[i] : min.data[i];
+				max.data[i] = other.max.data[i] > max.data[i] ? other.max.data[i] : max.data[i];
+			}
+
+			return *this;
+		}
+	};
+
+	template<typename T>
+	struct Triangle
+	{
+		static_assert(std::is_floating_point<T>::value, "Triangle requires a floating point type!");
+
+		Vector3<T> v0, v1, v2;
+
+		constexpr Triangle() = default;
+
+		constexpr Triangle(const Vector3<T>& v0, const Vector3<T>& v1, const Vector3<T>& v2) : v0(v0), v1(v1), v2(v2) {}
+
+		constexpr AABB<T> bounds() const
+		{
+			return AABB<T>(v0, v0).expand(v1).expand(v2);
+		}
+
+		// the point at barycentrics (u, v) of a hit, v0 + u * (v1 - v0) + v * (v2 - v0)
+		constexpr Vector3<T> pointAt(T u, T v) const
+		{
+			T w = T(1) - u - v;
+			return Vector3<T>(w * v0.data[0] + u * v1.data[0] + v * v2.data[0], w * v0.data[1] + u * v1.data[1] + v * v2.data[1], w * v0.data[2] + u * v1.data[2] + v * v2.data[2]);
+		}
+	};
+
+	// the closest hit so far, t starts at infinity so every query narrows it, index is the triangle's position in
+	// the array that was searched or NO_HIT
+	template<typename T>
+	struct RayHit
+	{
+		static const uint32_t NO_HIT = UINT32_MAX;
+
+		T t = std::numeric_limits<T>::infinity();
+		T u = T(0);
+		T v = T(0);
+		uint32_t index = NO_HIT;
+
+		constexpr bool hit() const
+		{
+			return index != NO_HIT;
+		}
+	};
+
+	// Möller-Trumbore on the vertex and the two edges from it, t, u and v are written only on a hit
+	// both faces are hit, a triangle with no area or a ray in its plane never is
+	template<typename T>
+	constexpr bool intersectTriangle(const Ray<T>& ray, const Vector<T, 3>& v0, const Vector<T, 3>& edge1, const Vector<T, 3>& edge2, T& t, T& u, T& v)
+	{
+		const T* d = ray.direction.data;
+		const T* e1 = edge1.data;
+		const T* e2 = edge2.data;
+
+		T px = d[1] * e2[2] - d[2] * e2[1], py = d[2] * e2[0] - d[0] * e2[2], pz = d[0] * e2[1] - d[1] * e2[0];
+		T determinant = e1[0] * px + e1[1] * py + e1[2] * pz;
+
+		if (determinant == T(0))
+		{
+			return false;
+		}
+
+		T invDeterminant = T(1) / determinant;
+		T sx = ray.origin.data[0] - v0.data[0], sy = ray.origin.data[1] - v0.data[1], sz = ray.origin.data[2] - v0.data[2];
+		T hitU = (sx * px + sy * py + sz * pz) * invDeterminant;
+
+		if (!(hitU >= T(0) && hitU <= T(1)))
+		{
+			return false;
+		}
+
+		T qx = sy * e1[2] - sz * e1[1], qy = sz * e1[0] - sx * e1[2], qz = sx * e1[1] - sy * e1[0];
+		T hitV = (d[0] * qx + d[1] * qy + d[2] * qz) * invDeterminant;
+		T hitT = (e2[0] * qx + e2[1] * qy + e2[2] * qz) * invDeterminant;
+
+		if (!(hitV >= T(0) && hitU + hitV <= T(1) && hitT >= ray.tMin && hitT <= ray.tMax))
+		{
+			return false;
+		}
+
+		t = hitT;
+		u = hitU;
+		v = hitV;
+		return true;
+	}
+
+	template<typename T>
+	constexpr bool intersectTriangle(const Ray<T>& ray, const Triangle<T>& triangle, T& t, T& u, T& v)
+	{
+		Vector<T, 3> edge1, edge2;
+
+		for (size_t i = 0; i < 3; i++)
+		{
+			edge1.data[i] = triangle.v1.data[i] - triangle.v0.data[i];
+			edge2.data[i] = triangle.v2.data[i] - triangle.v0.data[i];
+		}
+
+		return intersectTriangle(ray, triangle.v0, edge1, edge2, t, u, v);
+	}
+
+	// the point of triangle (a, b, c) nearest to point, by the Voronoi region of the triangle it falls in (Ericson, Real-Time
+	// Collision Detection 5.1.5), a triangle with no area still gives a point on it
+	template<typename T>
+	constexpr Vector3<T> closestPointOnTriangle(const Vector<T, 3>& point, const Vector<T, 3>& a, const Vector<T, 3>& b, const Vector<T, 3>& c)
+	{
+		const Vector<T, 3> ab = b - a, ac = c - a, ap = point - a;
+		T d1 = ab.dot(ap), d2 = ac.dot(ap);
+
+		if (d1 <= T(0) && d2 <= T(0))
+		{
+			return a;
+		}
+
+		const Vector<T, 3> bp = point - b;
+		T d3 = ab.dot(bp), d4 = ac.dot(bp);
+
+		if (d3 >= T(0) && d4 <= d3)
+		{
+			return b;
+		}
+
+		T vc = d1 * d4 - d3 * d2;
+
+		if (vc <= T(0) && d1 >= T(0) && d3 <= T(0))
+		{
+			return a + ab * (d1 / (d1 - d3));
+		}
+
+		const Vector<T, 3> cp = point - c;
+		T d5 = ab.dot(cp), d6 = ac.dot(cp);
+
+		if (d6 >= T(0) && d5 <= d6)
+		{
+			return c;
+		}
+
+		T vb = d5 * d2 - d1 * d6;
+
+		if (vb <= T(0) && d2 >= T(0) && d6 <= T(0))
+		{
+			return a + ac * (d2 / (d2 - d6));
+		}
+
+		T va = d3 * d6 - d5 * d4;
+
+		if (va <= T(0) && d4 - d3 >= T(0) && d5 - d6 >= T(0))
+		{
+			return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+		}
+
+		T sum = va + vb + vc;
+
+		if (!(sum > T(0)))
+		{
+			return a; //only reached by a collinear triangle through rounding, its edges were all tested above
+		}
+
+		return a + ab * (vb / sum) + ac * (vc / sum);
+	}
+
+	// slab test, tNear and tFar are where the ray enters and leaves the box clipped to [tMin, tMax], a ray starting
+	// inside enters at tMin
+	template<typename T>
+	constexpr bool intersectBox(const Ray<T>& ray, const Vector<T, 3>& inverseDirection, const AABB<T>& box, T& tNear, T& tFar)
+	{
+		T nearest = ray.tMin, farthest = ray.tMax;
+
+		for (size_t i = 0; i < 3; i++)
+		{
+			T t0 = (box.min.data[i] - ray.origin.data[i]) * inverseDirection.data[i];
+			T t1 = (box.max.data[i] - ray.origin.data[i]) * inverseDirection.data[i];
+
+			if (t0 > t1)
+			{
+				T swap = t0;
+				t0 = t1;
+				t1 = swap;
+			}
+
+			//written so a NaN (origin on a slab of a zero direction component) leaves the interval unchanged
+			nearest = t0 > nearest ? t0 : nearest;
+			farthest = t1 < farthest ? t1 : farthest;
+		}
+
+		tNear = nearest;
+		tFar = farthest;
+		return nearest <= farthest;
+	}
+
+	template<typename T>
+	constexpr bool intersectBox(const Ray<T>& ray, const AABB<T>& box, T& tNear, T& tFar)
+	{
+		return intersectBox(ray, ray.inverseDirection(), box, tNear, tFar);
+	}
+
+	// structure of arrays triangles for the packet kernels, stored as a vertex and its two edges (what Möller-Trumbore
+	// reads), the zero padding of the streams is triangles with no area that nothing hits
+	template<typename T>
+	class TriangleArray
+	{
+	public:
+		TriangleArray() = default;
+
+		TriangleArray(const Triangle<T>* triangles, size_t count)
+		{
+			reserve(count);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				push_back(triangles[i]);
+			}
+		}
+
+		size_t size() const { return vertices.size(); }
+		size_t paddedSize() const { return vertices.paddedSize(); }
+		bool empty() const { return vertices.empty(); }
+
+		void reserve(size_t count)
+		{
+			vertices.reserve(count);
+			edges1.reserve(count);
+			edges2.reserve(count);
+		}
+
+		void resize(size_t count)
+		{
+			vertices.resize(count);
+			edges1.resize(count);
+			edges2.resize(count);
+		}
+
+		void clear()
+		{
+			resize(0);
+		}
+
+		void push_back(const Triangle<T>& triangle)
+		{
+			vertices.push_back(triangle.v0);
+			edges1.push_back(triangle.v1 - triangle.v0);
+			edges2.push_back(triangle.v2 - triangle.v0);
+		}
+
+		void set(size_t index, const Triangle<T>& triangle)
+		{
+			vertices.set(index, triangle.v0);
+			edges1.set(index, triangle.v1 - triangle.v0);
+			edges2.set(index, triangle.v2 - triangle.v0);
+		}
+
+		Triangle<T> get(size_t index) const
+		{
+			Vector<T, 3> v0 = vertices.get(index);
+			return Triangle<T>(v0, v0 + edges1.get(index), v0 + edges2.get(index));
+		}
+
+		const VectorArray<T, 3>& vertex0() const { return vertices; }
+		const VectorArray<T, 3>& edge1() const { return edges1; }
+		const VectorArray<T, 3>& edge2() const { return edges2; }
+
+	private:
+		VectorArray<T, 3> vertices, edges1, edges2;
+	};
+
+	// structure of arrays rays for the packet kernels, the inverse directions are kept next to the directions
+	template<typename T>
+	class RayArray
+	{
+	public:
+		RayArray() = default;
+
+		RayArray(const Ray<T>* rays, size_t count)
+		{
+			reserve(count);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				push_back(rays[i]);
+			}
+		}
+
+		size_t size() const { return origins.size(); }
+		size_t paddedSize() const { return origins.paddedSize(); }
+		bool empty() const { return origins.empty(); }
+
+		void reserve(size_t count)
+		{
+			origins.reserve(count);
+			directions.reserve(count);
+			inverseDirections.reserve(count);
+			ranges.reserve(count);
+		}
+
+		void clear()
+		{
+			origins.clear();
+			directions.clear();
+			inverseDirections.clear();
+			ranges.clear();
+		}
+
+		void push_back(const Ray<T>& ray)
+		{
+			origins.push_back(ray.origin);
+			directions.push_back(ray.direction);
+			inverseDirections.push_back(ray.inverseDirection());
+			ranges.push_back(Vector2<T>(ray.tMin, ray.tMax));
+		}
+
+		Ray<T> get(size_t index) const
+		{
+			Vector<T, 2> range = ranges.get(index);
+			return Ray<T>(origins.get(index), directions.get(index), range.data[0], range.data[1]);
+		}
+
+		const VectorArray<T, 3>& origin() const { return origins; }
+		const VectorArray<T, 3>& direction() const { return directions; }
+		const VectorArray<T, 3>& inverseDirection() const { return inverseDirections; }
+		const VectorArray<T, 2>& range() const { return ranges; } // { tMin, tMax }
+
+	private:
+		VectorArray<T, 3> origins, directions, inverseDirections;
+		VectorArray<T, 2> ranges;
+	};
+
+	namespace detail {
+
+		template<typename T>
+		inline bool intersectTriangleAt(const Ray<T>& ray, const TriangleArray<T>& triangles, size_t i, T& t, T& u, T& v)
+		{
+			const VectorArray<T, 3>& v0 = triangles.vertex0();
+			const VectorArray<T, 3>& e1 = triangles.edge1();
+			const VectorArray<T, 3>& e2 = triangles.edge2();
+
+			return intersectTriangle(ray, Vector3<T>(v0.lane(0)[i], v0.lane(1)[i], v0.lane(2)[i]), Vector3<T>(e1.lane(0)[i], e1.lane(1)[i], e1.lane(2)[i]),
+				Vector3<T>(e2.lane(0)[i], e2.lane(1)[i], e2.lane(2)[i]), t, u, v);
+		}
+
+#if defined(ABSTRACTMATH_AVX2)
+		// the ray broadcast to every lane
+		struct RayLanes
+		{
+			__m256 origin[3];
+			__m256 direction[3];
+			__m256 tMin;
+
+			explicit RayLanes(const Ray<float>& ray)
+			{
+				for (size_t i = 0; i < 3; i++)
+				{
+					origin[i] = _mm256_set1_ps(ray.origin.data[i]);
+					direction[i] = _mm256_set1_ps(ray.direction.data[i]);
+				}
+
+				tMin = _mm256_set1_ps(ray.tMin);
+			}
+		};
+
+		// Möller-Trumbore for triangles i...i + 7, the mask is set where the ray crosses the triangle at t >= tMin and
+		// the caller bounds t from above, a zero determinant turns u, v or t into NaN or infinity which the ordered
+		// compares reject
+		inline __m256 intersectTriangles8(const RayLanes& ray, const TriangleArray<float>& triangles, size_t i, __m256& t, __m256& u, __m256& v)
+		{
+			const __m256 e1x = _mm256_loadu_ps(triangles.edge1().lane(0) + i), e1y = _mm256_loadu_ps(triangles.edge1().lane(1) + i), e1z = _mm256_loadu_ps(triangles.edge1().lane(2) + i);
+			const __m256 e2x = _mm256_loadu_ps(triangles.edge2().lane(0) + i), e2y = _mm256_loadu_ps(triangles.edge2().lane(1) + i), e2z = _mm256_loadu_ps(triangles.edge2().lane(2) + i);
+			const __m256 dx = ray.direction[0], dy = ray.direction[1], dz = ray.direction[2];
+
+			__m256 px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+			__m256 py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+			__m256 pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+			__m256 invDeterminant = _mm256_div_ps(_mm256_set1_ps(1.0f), multiplyAdd(e1z, pz, multiplyAdd(e1y, py, _mm256_mul_ps(e1x, px))));
+
+			__m256 sx = _mm256_sub_ps(ray.origin[0], _mm256_loadu_ps(triangles.vertex0().lane(0) + i));
+			__m256 sy = _mm256_sub_ps(ray.origin[1], _mm256_loadu_ps(triangles.vertex0().lane(1) + i));
+			__m256 sz = _mm256_sub_ps(ray.origin[2], _mm256_loadu_ps(triangles.vertex0().lane(2) + i));
+			u = _mm256_mul_ps(multiplyAdd(sz, pz, multiplyAdd(sy, py, _mm256_mul_ps(sx, px))), invDeterminant);
+
+			__m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+			__m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+			__m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+			v = _mm256_mul_ps(multiplyAdd(dz, qz, multiplyAdd(dy, qy, _mm256_mul_ps(dx, qx))), invDeterminant);
+			t = _mm256_mul_ps(multiplyAdd(e2z, qz, multiplyAdd(e2y, qy, _mm256_mul_ps(e2x, qx))), invDeterminant);
+
+			const __m256 zero = _mm256_setzero_ps();
+			__m256 inside = _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(u, v), _mm256_set1_ps(1.0f), _CMP_LE_OQ));
+
+			return _mm256_and_ps(inside, _mm256_cmp_ps(t, ray.tMin, _CMP_GE_OQ));
+		}
+#endif
+	}
+
+	// closest hit of one ray among triangles [begin, end) (a BVH leaf or a whole mesh), only hits at t >= tMin and
+	// nearer than both hit.t and tMax count, hit is updated when one is found and true returned
+	// float tests eight triangles per AVX2 iteration, other types the scalar loop
+	template<typename T>
+	bool intersectClosest(const Ray<T>& ray, const TriangleArray<T>& triangles, size_t begin, size_t end, RayHit<T>& hit)
+	{
+		assert(begin <= end && end <= triangles.size());
+		assert(end <= size_t(UINT32_MAX));
+
+		T tBest = std::min(hit.t, ray.tMax);
+		bool found = false;
+		size_t i = begin;
+
+#if defined(ABSTRACTMATH_AVX2)
+		if constexpr (std::is_same<T, float>::value)
+		{
+			const detail::RayLanes lanes(ray);
+			__m256 bestT = _mm256_set1_ps(tBest);
+			__m256 bestU = _mm256_setzero_ps(), bestV = _mm256_setzero_ps();
+			__m256i bestIndex = _mm256_set1_epi32(-1);
+			__m256i index = _mm256_add_epi32(_mm256_set1_epi32(int(i)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+			//the padding past size() never hits, so a range running to the end needs no scalar remainder
+			size_t vectorEnd = end == triangles.size() ? triangles.paddedSize() : end;
+
+			for (; i + 8 <= vectorEnd; i += 8, index = _mm256_add_epi32(index, _mm256_set1_epi32(8)))
+			{
+				__m256 t, u, v;
+				__m256 closer = detail::intersectTriangles8(lanes, triangles, i, t, u, v);
+				closer = _mm256_and_ps(closer, _mm256_cmp_ps(t, bestT, _CMP_LT_OQ));
+
+				bestT = _mm256_blendv_ps(bestT, t, closer);
+				bestU = _mm256_blendv_ps(bestU, u, closer);
+				bestV = _mm256_blendv_ps(bestV, v, closer);
+				bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(index), closer));
+			}
+
+			alignas(32) float laneT[8], laneU[8], laneV[8];
+			alignas(32) int32_t laneIndex[8];
+			_mm256_store_ps(laneT, bestT);
+			_mm256_store_ps(laneU, bestU);
+			_mm256_store_ps(laneV, bestV);
+			_mm256_store_si256(reinterpret_cast<__m256i*>(laneIndex), bestIndex);
+
+			//the lowest index among equal distances, as the scalar loop would pick
+			for (size_t lane = 0; lane < 8; lane++)
+			{
+				if (laneIndex[lane] >= 0 && (laneT[lane] < tBest || (laneT[lane] == tBest && uint32_t(laneIndex[lane]) < hit.index)))
+				{
+					tBest = laneT[lane];
+					hit.t = laneT[lane];
+					hit.u = laneU[lane];
+					hit.v = laneV[lane];
+					hit.index = uint32_t(laneIndex[lane]);
+					found = true;
+				}
+			}
+
+			i = std::min(i, end);
+		}
+#endif
+
+		Ray<T> clipped = ray;
+
+		for (; i < end; i++)
+		{
+			T t = T(0), u = T(0), v = T(0);
+			clipped.tMax = tBest;
+
+			if (detail::intersectTriangleAt(clipped, triangles, i, t, u, v) && t < tBest)
+			{
+				tBest = t;
+				hit.t = t;
+				hit.u = u;
+				hit.v = v;
+				hit.index = uint32_t(i);
+				found = true;
+			}
+		}
+
+		return found;
+	}
+
+	template<typename T>
+	bool intersectClosest(const Ray<T>& ray, const TriangleArray<T>& triangles, RayHit<T>& hit)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(RayQuery, triangles.size());
+		return intersectClosest(ray, triangles, 0, triangles.size(), hit);
+	}
+
+	// whether anything in [begin, end) blocks the ray within [tMin, tMax] (line of sight, shadow and occlusion
+	// rays), stops at the first block of eight with a hit
+	template<typename T>
+	bool intersectAny(const Ray<T>& ray, const TriangleArray<T>& triangles, size_t begin, size_t end)
+	{
+		assert(begin <= end && end <= triangles.size());
+		size_t i = begin;
+
+#if defined(ABSTRACTMATH_AVX2)
+		if constexpr (std::is_same<T, float>::value)
+		{
+			const detail::RayLanes lanes(ray);
+			const __m256 tMax = _mm256_set1_ps(ray.tMax);
+			size_t vectorEnd = end == triangles.size() ? triangles.paddedSize() : end;
+
+			for (; i + 8 <= vectorEnd; i += 8)
+			{
+				__m256 t, u, v;
+				__m256 hits = detail::intersectTriangles8(lanes, triangles, i, t, u, v);
+				hits = _mm256_and_ps(hits, _mm256_cmp_ps(t, tMax, _CMP_LE_OQ));
+
+				if (_mm256_movemask_ps(hits) != 0)
+				{
+					return true;
+				}
+			}
+
+			i = std::min(i, end);
+		}
+#endif
+
+		for (; i < end; i++)
+		{
+			T t = T(0), u = T(0), v = T(0);
+
+			if (detail::intersectTriangleAt(ray, triangles, i, t, u, v))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	template<typename T>
+	bool intersectAny(const Ray<T>& ray, const TriangleArray<T>& triangles)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(RayQuery, triangles.size());
+		return intersectAny(ray, triangles, 0, triangles.size());
+	}
+
+	// closest hits of many rays against the same triangles (picking or audio occlusion batches), hits[i] is reset
+	// and filled for rays[i], the rays are split across the job system
+	template<typename T>
+	void intersectClosest(const RayArray<T>& rays, const TriangleArray<T>& triangles, RayHit<T>* hits)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(RayQuery, rays.size() * triangles.size());
+
+		//a ray costs a pass over every triangle, so a few rays already make a chunk worth handing out
+		const size_t grain = std::max<size_t>(1, size_t(1 << 16) / std::max<size_t>(1, triangles.size()));
+
+		parallelFor(0, rays.size(), grain, [&rays, &triangles, hits](size_t first, size_t last)
+		{
+			for (size_t i = first; i < last; i++)
+			{
+				hits[i] = RayHit<T>();
+				intersectClosest(rays.get(i), triangles, 0, triangles.size(), hits[i]);
+			}
+		});
+	}
+
+	// the indices of the rays that cross box within their [tMin, tMax], written to hits[0...] in increasing order and
+	// counted, tNear (optional, one per ray) receives where each of them enters
+	// float tests eight rays per AVX2 iteration, other types the scalar loop
+	template<typename T>
+	size_t intersectBox(const AABB<T>& box, const RayArray<T>& rays, uint32_t* hits, T* tNear = nullptr)
+	{
+		assert(rays.size() <= size_t(UINT32_MAX));
+		ABSTRACTMATH_PROFILE_SCOPE(RayQuery, rays.size());
+
+		const size_t count = rays.size();
+		size_t found = 0;
+		size_t i = 0;
+
+#if defined(ABSTRACTMATH_AVX2)
+		if constexpr (std::is_same<T, float>::value)
+		{
+			const __m256 boxMin[3] = { _mm256_set1_ps(box.min.data[0]), _mm256_set1_ps(box.min.data[1]), _mm256_set1_ps(box.min.data[2]) };
+			const __m256 boxMax[3] = { _mm256_set1_ps(box.max.data[0]), _mm256_set1_ps(box.max.data[1]), _mm256_set1_ps(box.max.data[2]) };
+
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256 nearest = _mm256_load_ps(rays.range().lane(0) + i);
+				__m256 farthest = _mm256_load_ps(rays.range().lane(1) + i);
+
+				for (size_t axis = 0; axis < 3; axis++)
+				{
+					__m256 origin = _mm256_load_ps(rays.origin().lane(axis) + i);
+					__m256 inverse = _mm256_load_ps(rays.inverseDirection().lane(axis) + i);
+					__m256 t0 = _mm256_mul_ps(_mm256_sub_ps(boxMin[axis], origin), inverse);
+					__m256 t1 = _mm256_mul_ps(_mm256_sub_ps(boxMax[axis], origin), inverse);
+					__m256 swap = _mm256_cmp_ps(t0, t1, _CMP_GT_OQ);
+
+					//the scalar test's order, max/min return their second operand for a NaN so it leaves the interval as it was
+					nearest = _mm256_max_ps(_mm256_blendv_ps(t0, t1, swap), nearest);
+					farthest = _mm256_min_ps(_mm256_blendv_ps(t1, t0, swap), farthest);
+				}
+
+				int hitMask = _mm256_movemask_ps(_mm256_cmp_ps(nearest, farthest, _CMP_LE_OQ));
+
+				if (tNear != nullptr)
+				{
+					_mm256_storeu_ps(tNear + i, nearest);
+				}
+
+				//branch-free compaction: every lane is written, only hits advance the cursor
+				for (size_t k = 0; k < 8; k++)
+				{
+					hits[found] = uint32_t(i + k);
+					found += (hitMask >> k) & 1;
+				}
+			}
+		}
+#endif
+
+		for (; i < count; i++)
+		{
+			T nearest = T(0), farthest = T(0);
+			Ray<T> ray = rays.get(i);
+			bool hit = intersectBox(ray, rays.inverseDirection().get(i), box, nearest, farthest);
+
+			if (tNear != nullptr)
+			{
+				tNear[i] = nearest;
+			}
+
+			hits[found] = uint32_t(i);
+			found += hit ? 1 : 0;
+		}
+
+		return found;
+	}
+
+	typedef Ray<float> Rayf;
+	typedef Ray<double> Rayd;
+	typedef AABB<float> AABBf;
+	typedef AABB<double> AABBd;
+	typedef Triangle<float> Trianglef;
+	typedef Triangle<double> Triangled;
+}
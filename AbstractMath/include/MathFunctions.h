@@ -0,0 +1,364 @@
+#pragma once
+
+#include <type_traits>
+#include <limits>
+#include <cmath>
+
+#include "Simd.h"
+
+namespace AbstractMath {
+
+	// precision policies, passed as a template argument to normalized(), math::rsqrt/sincos/atan2/asin and the Quaternion
+	// functions built on them, errors measured against double precision libm over the whole argument range
+	// Precise: libm and a real division, what every function without a policy argument does
+	// Fast: float rsqrt estimate plus one newton step (relative error below 2.5e-7), sin/cos/atan polynomials within
+	// 2 float ulp (absolute error below 1e-7 in sin/cos and 3e-7 in atan2/asin), double keeps sqrt and division and
+	// gets the same polynomials (absolute error below 1e-8)
+	// Approx: Fast's rsqrt, lower degree polynomials with absolute error below 1.5e-5 in sin/cos and 2e-5 in atan2/asin
+	// both approximations assume |angle| well below 1e5 (the quarter-turn reduction is done in T)
+	struct Precise {};
+	struct Fast {};
+	struct Approx {};
+
+	// sqrt/sin/cos/tan usable in constant expressions: libm at runtime, the scalar series below while the compiler
+	// evaluates a constant expression, so identity/translation/projection/rotation constants fold into static data
+	namespace math {
+
+		namespace detail {
+
+			// float and integers are computed in double, wider types in themselves
+			template<typename T>
+			using compute_type = typename std::conditional<std::is_same<T, long double>::value, long double, double>::type;
+
+			template<typename T>
+			constexpr bool isNaN(T value)
+			{
+				return value != value;
+			}
+
+			template<typename T>
+			constexpr bool isInfinite(T value)
+			{
+				return value == std::numeric_limits<T>::infinity() || value == -std::numeric_limits<T>::infinity();
+			}
+
+			// newton iteration from above the root, it decreases monotonically until it stops improving
+			template<typename T>
+			constexpr T sqrt(T value)
+			{
+				if (isNaN(value) || value < T(0))
+				{
+					return std::numeric_limits<T>::quiet_NaN();
+				}
+
+				if (value == T(0) || isInfinite(value))
+				{
+					return value;
+				}
+
+				T current = value > T(1) ? value : T(1);
+
+				while (true)
+				{
+					T next = T(0.5) * (current + value / current);
+
+					if (next >= current)
+					{
+						return current;
+					}
+
+					current = next;
+				}
+			}
+
+			// taylor series on [ -pi/4, pi/4 ], the terms past x^17 are below double precision there
+			template<typename T>
+			constexpr T sinSeries(T x)
+			{
+				T x2 = x * x;
+				T term = x;
+				T sum = x;
+
+				for (int n = 1; n <= 9; n++)
+				{
+					term *= -x2 / T((2 * n) * (2 * n + 1));
+					sum += term;
+				}
+
+				return sum;
+			}
+
+			template<typename T>
+			constexpr T cosSeries(T x)
+			{
+				T x2 = x * x;
+				T term = T(1);
+				T sum = T(1);
+
+				for (int n = 1; n <= 9; n++)
+				{
+					term *= -x2 / T((2 * n - 1) * (2 * n));
+					sum += term;
+				}
+
+				return sum;
+			}
+
+			// x = quadrant * pi/2 + remainder, pi/2 split in two (cody-waite) so the subtraction stays exact
+			// accurate while |x| is well below 2^26, plenty for angles
+			template<typename T>
+			constexpr T reduceQuarterTurns(T x, long long& quadrant)
+			{
+				constexpr T TWO_OVER_PI = T(0.636619772367581343075535053490057448L);
+				constexpr T PI_OVER_TWO_HIGH = T(1.57079632673412561417e+00L);
+				constexpr T PI_OVER_TWO_LOW = T(6.07710050650619224932e-11L);
+
+				T scaled = x * TWO_OVER_PI;
+				quadrant = static_cast<long long>(scaled < T(0) ? scaled - T(0.5) : scaled + T(0.5));
+
+				return (x - T(quadrant) * PI_OVER_TWO_HIGH) - T(quadrant) * PI_OVER_TWO_LOW;
+			}
+
+			template<typename T>
+			constexpr T sin(T x)
+			{
+				if (isNaN(x) || isInfinite(x))
+				{
+					return std::numeric_limits<T>::quiet_NaN();
+				}
+
+				long long quadrant = 0;
+				T r = reduceQuarterTurns(x, quadrant);
+
+				switch (quadrant & 3)
+				{
+				case 0: return sinSeries(r);
+				case 1: return cosSeries(r);
+				case 2: return -sinSeries(r);
+				default: return -cosSeries(r);
+				}
+			}
+
+			template<typename T>
+			constexpr T cos(T x)
+			{
+				if (isNaN(x) || isInfinite(x))
+				{
+					return std::numeric_limits<T>::quiet_NaN();
+				}
+
+				long long quadrant = 0;
+				T r = reduceQuarterTurns(x, quadrant);
+
+				switch (quadrant & 3)
+				{
+				case 0: return cosSeries(r);
+				case 1: return -sinSeries(r);
+				case 2: return -cosSeries(r);
+				default: return sinSeries(r);
+				}
+			}
+
+			template<typename T>
+			constexpr T tan(T x)
+			{
+				if (isNaN(x) || isInfinite(x))
+				{
+					return std::numeric_limits<T>::quiet_NaN();
+				}
+
+				long long quadrant = 0;
+				T r = reduceQuarterTurns(x, quadrant);
+
+				return (quadrant & 1) ? -cosSeries(r) / sinSeries(r) : sinSeries(r) / cosSeries(r);
+			}
+
+			template<typename Precision>
+			constexpr bool isApproximate()
+			{
+				static_assert(std::is_same<Precision, Precise>::value || std::is_same<Precision, Fast>::value || std::is_same<Precision, Approx>::value,
+					"Precision must be Precise, Fast or Approx!");
+
+				return !std::is_same<Precision, Precise>::value;
+			}
+
+			// same reduction as reduceQuarterTurns but in T, pi/2 split in three so the first two products stay exact in float
+			template<typename T>
+			constexpr T reduceQuarterTurnsFast(T x, int& quadrant)
+			{
+				T scaled = x * T(0.636619772367581343075535053490057448);
+				quadrant = int(scaled < T(0) ? scaled - T(0.5) : scaled + T(0.5));
+
+				T q = T(quadrant);
+				return ((x - q * T(1.5703125)) - q * T(4.837512969970703125e-4)) - q * T(7.54978995489188216e-8);
+			}
+
+			// on [ -pi/4, pi/4 ]: cephes sinf/cosf minimax for Fast, degree 5 and 4 least-error fits for Approx
+			template<typename Precision, typename T>
+			constexpr void sinCosPolynomial(T r, T& sin, T& cos)
+			{
+				T z = r * r;
+
+				if constexpr (std::is_same<Precision, Approx>::value)
+				{
+					sin = r + r * z * (T(-1.6662833727310647e-1) + z * T(8.152990917218477e-3));
+					cos = T(1) + z * (T(-4.9977630704404113e-1) + z * T(4.048893597758226e-2));
+				}
+				else
+				{
+					sin = r + r * z * (T(-1.6666654611e-1) + z * (T(8.3321608736e-3) + z * T(-1.9515295891e-4)));
+					cos = T(1) - T(0.5) * z + z * z * (T(4.166664568298827e-2) + z * (T(-1.388731625493765e-3) + z * T(2.443315711809948e-5)));
+				}
+			}
+
+			// atan of a in [ 0, 1 ], Fast folds a above tan(pi/8) onto [ -tan(pi/8), tan(pi/8) ] first like cephes atanf
+			template<typename Precision, typename T>
+			constexpr T atanUnit(T a)
+			{
+				if constexpr (std::is_same<Precision, Approx>::value)
+				{
+					T z = a * a;
+					return a + a * z * (T(-3.3168512699396424e-1) + z * (T(1.8449015954687914e-1) + z * (T(-9.044931906142675e-2) + z * T(2.305965425783683e-2))));
+				}
+				else
+				{
+					T offset = T(0);
+
+					if (a > T(0.414213562373095048801688724209698079))
+					{
+						offset = T(0.785398163397448309615660845819875721);
+						a = (a - T(1)) / (a + T(1));
+					}
+
+					T z = a * a;
+					return offset + a + a * z * (T(-3.33329491539e-1) + z * (T(1.99777106478e-1) + z * (T(-1.38776856032e-1) + z * T(8.05374449538e-2))));
+				}
+			}
+		}
+
+		template<typename T>
+		constexpr T sqrt(T value)
+		{
+			if (AbstractMath::detail::isConstantEvaluated())
+			{
+				return T(detail::sqrt(detail::compute_type<T>(value)));
+			}
+
+			return T(std::sqrt(value));
+		}
+
+		template<typename T>
+		constexpr T sin(T value)
+		{
+			if (AbstractMath::detail::isConstantEvaluated())
+			{
+				return T(detail::sin(detail::compute_type<T>(value)));
+			}
+
+			return T(std::sin(value));
+		}
+
+		template<typename T>
+		constexpr T cos(T value)
+		{
+			if (AbstractMath::detail::isConstantEvaluated())
+			{
+				return T(detail::cos(detail::compute_type<T>(value)));
+			}
+
+			return T(std::cos(value));
+		}
+
+		template<typename T>
+		constexpr T tan(T value)
+		{
+			if (AbstractMath::detail::isConstantEvaluated())
+			{
+				return T(detail::tan(detail::compute_type<T>(value)));
+			}
+
+			return T(std::tan(value));
+		}
+
+		template<typename Precision = Precise, typename T>
+		constexpr T rsqrt(T value)
+		{
+			if constexpr (detail::isApproximate<Precision>() && std::is_same<T, float>::value)
+			{
+#if defined(ABSTRACTMATH_SSE)
+				if (!AbstractMath::detail::isConstantEvaluated())
+				{
+					float estimate = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(value)));
+					return estimate * (1.5f - 0.5f * value * estimate * estimate);
+				}
+#endif
+			}
+
+			return T(1) / sqrt(value);
+		}
+
+		// both from one range reduction, Precise calls libm twice
+		template<typename Precision = Precise, typename T>
+		constexpr void sincos(T angle, T& sin, T& cos)
+		{
+			if constexpr (detail::isApproximate<Precision>())
+			{
+				int quadrant = 0;
+				T s = T(0), c = T(0);
+				detail::sinCosPolynomial<Precision>(detail::reduceQuarterTurnsFast(angle, quadrant), s, c);
+
+				sin = (quadrant & 1) ? c : s;
+				cos = (quadrant & 1) ? s : c;
+				sin = (quadrant & 2) ? -sin : sin;
+				cos = ((quadrant + 1) & 2) ? -cos : cos;
+			}
+			else
+			{
+				sin = math::sin(angle);
+				cos = math::cos(angle);
+			}
+		}
+
+		template<typename Precision = Precise, typename T>
+		T atan2(T y, T x)
+		{
+			if constexpr (detail::isApproximate<Precision>())
+			{
+				T absY = y < T(0) ? -y : y;
+				T absX = x < T(0) ? -x : x;
+				T high = absY > absX ? absY : absX;
+
+				if (high == T(0))
+				{
+					return T(0);
+				}
+
+				T low = absY > absX ? absX : absY;
+				T angle = detail::atanUnit<Precision>(low / high);
+
+				angle = absY > absX ? T(1.57079632679489661923132169163975144) - angle : angle;
+				angle = x < T(0) ? T(3.14159265358979323846264338327950288) - angle : angle;
+				return y < T(0) ? -angle : angle;
+			}
+			else
+			{
+				return std::atan2(y, x);
+			}
+		}
+
+		// the approximations clamp to [ -1, 1 ] where libm returns NaN
+		template<typename Precision = Precise, typename T>
+		T asin(T value)
+		{
+			if constexpr (detail::isApproximate<Precision>())
+			{
+				value = value > T(1) ? T(1) : (value < T(-1) ? T(-1) : value);
+				return atan2<Precision>(value, T(std::sqrt((T(1) - value) * (T(1) + value))));
+			}
+			else
+			{
+				return std::asin(value);
+			}
+		}
+	}
+}
\ No newline at end of file
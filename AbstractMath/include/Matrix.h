@@ -1,10 +1,14 @@
  #pragma once
 
 #include <type_traits>
+#include <initializer_list>
 #include <memory>
 #include <assert.h>
 #include <cmath>
 
+#include "Simd.h"
+#include "Profiling.h"
+#include "MathFunctions.h"
 #include "Vector.h"
 
 namespace AbstractMath {
@@ -14,6 +18,9 @@ namespace AbstractMath {
 	{
 		static_assert(std::is_arithmetic<T>::value&& Rows_C > 0 && Cols_C > 0, "Type must be number; rows and columns must be non-zero");
 
+		template<typename Ty, size_t R, size_t C>
+		friend class Matrix;
+
 	public:
 		T data[Rows_C * Cols_C] = { 0 }; // treat as array of Columns vectors
 		static const size_t SIZE = Rows_C * Cols_C * sizeof(T); //this shouldn't be used to determine class size! potential bug if used!
@@ -64,8 +71,20 @@ namespace AbstractMath {
 		{
 			using return_type = decltype(T(1)* Ty(1));
 			Matrix<return_type, Rows_C, R_Cols> result;
+			ABSTRACTMATH_PROFILE_COUNT(MatrixMultiply, 1);
+
+#if defined(ABSTRACTMATH_SSE)
+			if constexpr (std::is_same<T, float>::value && std::is_same<Ty, float>::value && Rows_C == 4 && Cols_C == 4 && R_Cols == 4)
+			{
+				if (!detail::isConstantEvaluated())
+				{
+					detail::multiplyMatrix4f(data, right.data, result.data);
+					return result;
+				}
+			}
+#endif
 
-			size_t leftIndex, rightIndex, destIndex = 0;
+			size_t leftIndex = 0, rightIndex = 0, destIndex = 0;
 			size_t leftOffset = 0, rightOffset = 0;
 
 			for (/*size_t destIndex = 0*/; destIndex < Rows_C * R_Cols; destIndex++)
@@ -95,29 +114,389 @@ namespace AbstractMath {
 		constexpr Vector<decltype(T(1)* Ty(1)), Rows_C> operator*(const Vector<Ty, Cols_C>& other) const
 		{
 			Vector<decltype(T(1)* Ty(1)), Rows_C> result;
+			ABSTRACTMATH_PROFILE_COUNT(MatrixVector, 1);
 
-			for (size_t matIn = 0; matIn < Rows_C * Cols_C; matIn++)
+#if defined(ABSTRACTMATH_SSE)
+			if constexpr (std::is_same<T, float>::value && std::is_same<Ty, float>::value && Rows_C == 4 && Cols_C == 4)
 			{
-				size_t rowIn = matIn % Rows_C;
-				size_t colIn = matIn / Rows_C;
+				if (!detail::isConstantEvaluated())
+				{
+					detail::multiplyMatrix4fVector4f(data, other.data, result.data);
+					return result;
+				}
+			}
+#endif
 
-				result[rowIn] += data[matIn] * other[colIn];
+			for (size_t colIn = 0; colIn < Cols_C; colIn++)
+			{
+				for (size_t rowIn = 0; rowIn < Rows_C; rowIn++)
+				{
+					result.data[rowIn] += data[colIn * Rows_C + rowIn] * other.data[colIn];
+				}
 			}
 
 			return result;
 		}
 
-		//TODO: man up and implement inverse and determinate
+		constexpr T determinant() const
+		{
+			static_assert(Rows_C == Cols_C, "Determinant requires a square matrix!");
+
+			if constexpr (Rows_C == 1)
+			{
+				return data[0];
+			}
+			else if constexpr (Rows_C == 2)
+			{
+				return data[0] * data[3] - data[2] * data[1];
+			}
+			else if constexpr (Rows_C == 3)
+			{
+				return data[0] * (data[4] * data[8] - data[7] * data[5])
+					- data[3] * (data[1] * data[8] - data[7] * data[2])
+					+ data[6] * (data[1] * data[5] - data[4] * data[2]);
+			}
+			else if constexpr (Rows_C == 4)
+			{
+				T s[6] = {}, c[6] = {};
+				cofactorPairs4(s, c);
+
+				return s[0] * c[5] - s[1] * c[4] + s[2] * c[3] + s[3] * c[2] - s[4] * c[1] + s[5] * c[0];
+			}
+			else
+			{
+				using compute_type = typename std::conditional<std::is_floating_point<T>::value, T, double>::type;
+				Matrix<compute_type, Rows_C, Cols_C> lu(*this);
+				size_t pivots[Rows_C] = {};
+				bool oddSwaps = false;
+
+				if (!decomposeLU(lu.data, pivots, oddSwaps))
+				{
+					return T(0);
+				}
+
+				compute_type det = oddSwaps ? compute_type(-1) : compute_type(1);
+
+				for (size_t i = 0; i < Rows_C; i++)
+				{
+					det *= lu.data[i * Rows_C + i];
+				}
+
+				return T(det);
+			}
+		}
+
+		// closed-form cofactors up to 4x4 (SSE for float 4x4), LU with partial pivoting above that
+		constexpr Matrix<T, Rows_C, Cols_C> inverted() const
+		{
+			static_assert(Rows_C == Cols_C, "Inverse requires a square matrix!");
+			static_assert(std::is_floating_point<T>::value, "Inverse requires a floating point type!");
+			ABSTRACTMATH_PROFILE_COUNT(MatrixInverse, 1);
+
+			Matrix<T, Rows_C, Cols_C> result;
+
+			if constexpr (Rows_C == 1)
+			{
+				assert(data[0] != T(0));
+				result.data[0] = T(1) / data[0];
+			}
+			else if constexpr (Rows_C == 2)
+			{
+				T det = determinant();
+				assert(det != T(0));
+				T invDet = T(1) / det;
+
+				result.data[0] = data[3] * invDet;
+				result.data[1] = -data[1] * invDet;
+				result.data[2] = -data[2] * invDet;
+				result.data[3] = data[0] * invDet;
+			}
+			else if constexpr (Rows_C == 3)
+			{
+				result.element(0, 0) = element(1, 1) * element(2, 2) - element(1, 2) * element(2, 1);
+				result.element(0, 1) = element(0, 2) * element(2, 1) - element(0, 1) * element(2, 2);
+				result.element(0, 2) = element(0, 1) * element(1, 2) - element(0, 2) * element(1, 1);
+				result.element(1, 0) = element(1, 2) * element(2, 0) - element(1, 0) * element(2, 2);
+				result.element(1, 1) = element(0, 0) * element(2, 2) - element(0, 2) * element(2, 0);
+				result.element(1, 2) = element(0, 2) * element(1, 0) - element(0, 0) * element(1, 2);
+				result.element(2, 0) = element(1, 0) * element(2, 1) - element(1, 1) * element(2, 0);
+				result.element(2, 1) = element(0, 1) * element(2, 0) - element(0, 0) * element(2, 1);
+				result.element(2, 2) = element(0, 0) * element(1, 1) - element(0, 1) * element(1, 0);
+
+				T det = element(0, 0) * result.element(0, 0) + element(0, 1) * result.element(1, 0) + element(0, 2) * result.element(2, 0);
+				assert(det != T(0));
+				T invDet = T(1) / det;
+
+				for (size_t i = 0; i < 9; i++)
+				{
+					result.data[i] *= invDet;
+				}
+			}
+			else if constexpr (Rows_C == 4)
+			{
+#if defined(ABSTRACTMATH_SSE)
+				if constexpr (std::is_same<T, float>::value)
+				{
+					if (!detail::isConstantEvaluated())
+					{
+						float det = detail::invertMatrix4f(data, result.data);
+						assert(det != 0.0f);
+						(void)det;
+						return result;
+					}
+				}
+#endif
+
+				T s[6] = {}, c[6] = {};
+				cofactorPairs4(s, c);
+
+				T det = s[0] * c[5] - s[1] * c[4] + s[2] * c[3] + s[3] * c[2] - s[4] * c[1] + s[5] * c[0];
+				assert(det != T(0));
+				T invDet = T(1) / det;
+
+				result.element(0, 0) = (element(1, 1) * c[5] - element(1, 2) * c[4] + element(1, 3) * c[3]) * invDet;
+				result.element(0, 1) = (-element(0, 1) * c[5] + element(0, 2) * c[4] - element(0, 3) * c[3]) * invDet;
+				result.element(0, 2) = (element(3, 1) * s[5] - element(3, 2) * s[4] + element(3, 3) * s[3]) * invDet;
+				result.element(0, 3) = (-element(2, 1) * s[5] + element(2, 2) * s[4] - element(2, 3) * s[3]) * invDet;
+
+				result.element(1, 0) = (-element(1, 0) * c[5] + element(1, 2) * c[2] - element(1, 3) * c[1]) * invDet;
+				result.element(1, 1) = (element(0, 0) * c[5] - element(0, 2) * c[2] + element(0, 3) * c[1]) * invDet;
+				result.element(1, 2) = (-element(3, 0) * s[5] + element(3, 2) * s[2] - element(3, 3) * s[1]) * invDet;
+				result.element(1, 3) = (element(2, 0) * s[5] - element(2, 2) * s[2] + element(2, 3) * s[1]) * invDet;
+
+				result.element(2, 0) = (element(1, 0) * c[4] - element(1, 1) * c[2] + element(1, 3) * c[0]) * invDet;
+				result.element(2, 1) = (-element(0, 0) * c[4] + element(0, 1) * c[2] - element(0, 3) * c[0]) * invDet;
+				result.element(2, 2) = (element(3, 0) * s[4] - element(3, 1) * s[2] + element(3, 3) * s[0]) * invDet;
+				result.element(2, 3) = (-element(2, 0) * s[4] + element(2, 1) * s[2] - element(2, 3) * s[0]) * invDet;
+
+				result.element(3, 0) = (-element(1, 0) * c[3] + element(1, 1) * c[1] - element(1, 2) * c[0]) * invDet;
+				result.element(3, 1) = (element(0, 0) * c[3] - element(0, 1) * c[1] + element(0, 2) * c[0]) * invDet;
+				result.element(3, 2) = (-element(3, 0) * s[3] + element(3, 1) * s[1] - element(3, 2) * s[0]) * invDet;
+				result.element(3, 3) = (element(2, 0) * s[3] - element(2, 1) * s[1] + element(2, 2) * s[0]) * invDet;
+			}
+			else
+			{
+				// the sizes this type holds fit in L1, so a plain (unblocked) LU is already the fastest option here
+				Matrix<T, Rows_C, Cols_C> lu(*this);
+				size_t pivots[Rows_C] = {};
+				bool oddSwaps = false;
+
+				bool invertible = decomposeLU(lu.data, pivots, oddSwaps);
+				assert(invertible);
+				(void)invertible;
+
+				for (size_t col = 0; col < Cols_C; col++)
+				{
+					T* x = &result.data[col * Rows_C];
+
+					for (size_t row = 0; row < Rows_C; row++)
+					{
+						x[row] = pivots[row] == col ? T(1) : T(0);
+					}
+
+					for (size_t row = 0; row < Rows_C; row++)
+					{
+						for (size_t k = 0; k < row; k++)
+						{
+							x[row] -= lu.data[k * Rows_C + row] * x[k];
+						}
+					}
+
+					for (size_t row = Rows_C; row-- > 0;)
+					{
+						for (size_t k = row + 1; k < Rows_C; k++)
+						{
+							x[row] -= lu.data[k * Rows_C + row] * x[k];
+						}
+
+						x[row] /= lu.data[row * Rows_C + row];
+					}
+				}
+			}
+
+			return result;
+		}
+
+		// inverse of a matrix whose last row is ( 0, ..., 0, 1 ), like the ones from translation(), scale() and Quaternion::toRotationMatrix()
+		constexpr Matrix<T, Rows_C, Cols_C> affineInverse() const
+		{
+			static_assert(Rows_C == Cols_C && Rows_C > 1, "Affine inverse requires a square matrix!");
+			constexpr size_t N = Rows_C - 1;
+
+			Matrix<T, N, N> linear;
+
+			for (size_t col = 0; col < N; col++)
+			{
+				for (size_t row = 0; row < N; row++)
+				{
+					linear.data[col * N + row] = element(row, col);
+				}
+			}
+
+			return fromLinearInverse(linear.inverted());
+		}
+
+		// inverse of a rigid transform (rotation and translation only): transposed rotation, rotated and negated translation
+		constexpr Matrix<T, Rows_C, Cols_C> orthonormalInverse() const
+		{
+			static_assert(Rows_C == Cols_C && Rows_C > 1, "Orthonormal inverse requires a square matrix!");
+			constexpr size_t N = Rows_C - 1;
+			ABSTRACTMATH_PROFILE_COUNT(MatrixInverse, 1);
+
+			Matrix<T, N, N> linear;
+
+			for (size_t col = 0; col < N; col++)
+			{
+				for (size_t row = 0; row < N; row++)
+				{
+					linear.data[col * N + row] = element(col, row);
+				}
+			}
+
+			return fromLinearInverse(linear);
+		}
 
 	private:
+		constexpr T& element(size_t row, size_t col)
+		{
+			return data[col * Rows_C + row];
+		}
+
+		constexpr const T& element(size_t row, size_t col) const
+		{
+			return data[col * Rows_C + row];
+		}
+
+		// 2x2 determinants of the top two and bottom two rows shared by the 4x4 determinant and inverse
+		constexpr void cofactorPairs4(T* s, T* c) const
+		{
+			s[0] = element(0, 0) * element(1, 1) - element(1, 0) * element(0, 1);
+			s[1] = element(0, 0) * element(1, 2) - element(1, 0) * element(0, 2);
+			s[2] = element(0, 0) * element(1, 3) - element(1, 0) * element(0, 3);
+			s[3] = element(0, 1) * element(1, 2) - element(1, 1) * element(0, 2);
+			s[4] = element(0, 1) * element(1, 3) - element(1, 1) * element(0, 3);
+			s[5] = element(0, 2) * element(1, 3) - element(1, 2) * element(0, 3);
+
+			c[5] = element(2, 2) * element(3, 3) - element(3, 2) * element(2, 3);
+			c[4] = element(2, 1) * element(3, 3) - element(3, 1) * element(2, 3);
+			c[3] = element(2, 1) * element(3, 2) - element(3, 1) * element(2, 2);
+			c[2] = element(2, 0) * element(3, 3) - element(3, 0) * element(2, 3);
+			c[1] = element(2, 0) * element(3, 2) - element(3, 0) * element(2, 2);
+			c[0] = element(2, 0) * element(3, 1) - element(3, 0) * element(2, 1);
+		}
+
+		// builds [ inverse | -inverse * t ] over [ 0 | 1 ] from the inverted upper-left block and this matrix's translation column
+		template<size_t N>
+		constexpr Matrix<T, Rows_C, Cols_C> fromLinearInverse(const Matrix<T, N, N>& inverse) const
+		{
+			Matrix<T, Rows_C, Cols_C> result;
+
+			for (size_t col = 0; col < N; col++)
+			{
+				for (size_t row = 0; row < N; row++)
+				{
+					result.element(row, col) = inverse.data[col * N + row];
+				}
+			}
+
+			for (size_t row = 0; row < N; row++)
+			{
+				T sum = 0;
+
+				for (size_t col = 0; col < N; col++)
+				{
+					sum += inverse.data[col * N + row] * element(col, N);
+				}
+
+				result.element(row, N) = -sum;
+			}
+
+			result.element(N, N) = T(1);
+
+			return result;
+		}
+
+		// in-place Doolittle LU on column-major storage, pivots[row] is the source row of each output row
+		template<typename Ty>
+		static constexpr bool decomposeLU(Ty* lu, size_t* pivots, bool& oddSwaps)
+		{
+			constexpr size_t N = Rows_C;
+
+			for (size_t i = 0; i < N; i++)
+			{
+				pivots[i] = i;
+			}
+
+			for (size_t k = 0; k < N; k++)
+			{
+				size_t pivot = k;
+				Ty largest = lu[k * N + k] < 0 ? -lu[k * N + k] : lu[k * N + k];
+
+				for (size_t row = k + 1; row < N; row++)
+				{
+					Ty value = lu[k * N + row] < 0 ? -lu[k * N + row] : lu[k * N + row];
+
+					if (value > largest)
+					{
+						largest = value;
+						pivot = row;
+					}
+				}
+
+				if (largest == Ty(0))
+				{
+					return false;
+				}
+
+				if (pivot != k)
+				{
+					for (size_t col = 0; col < N; col++)
+					{
+						Ty temp = lu[col * N + k];
+						lu[col * N + k] = lu[col * N + pivot];
+						lu[col * N + pivot] = temp;
+					}
+
+					size_t tempIndex = pivots[k];
+					pivots[k] = pivots[pivot];
+					pivots[pivot] = tempIndex;
+					oddSwaps = !oddSwaps;
+				}
+
+				Ty invPivot = Ty(1) / lu[k * N + k];
+
+				for (size_t row = k + 1; row < N; row++)
+				{
+					lu[k * N + row] *= invPivot;
+				}
+
+				for (size_t col = k + 1; col < N; col++)
+				{
+					Ty factor = lu[col * N + k];
+
+					for (size_t row = k + 1; row < N; row++)
+					{
+						lu[col * N + row] -= lu[k * N + row] * factor;
+					}
+				}
+			}
+
+			return true;
+		}
+
 		constexpr void copyFrom(const T* src, const size_t srcSize = SIZE)
 		{
-			memcpy_s(this->data, SIZE, src, srcSize);
+			size_t count = (srcSize < SIZE ? srcSize : SIZE) / sizeof(T);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				data[i] = src[i];
+			}
 		}
 
 		constexpr void transposeCopy(const T* src, const size_t srcElements = (Rows_C * Cols_C))
 		{
-			static const size_t destElements = Rows_C * Cols_C;
+			const size_t destElements = Rows_C * Cols_C;
 
 			size_t srcIndex = 0;
 			size_t offset = 0;
@@ -137,104 +516,116 @@ namespace AbstractMath {
 		}
 	};
 
+	// the builders write data[] directly (column-major, col * N + row): operator[] goes through a reinterpret_cast,
+	// which a constant expression can not evaluate
 	template<typename T, size_t N>
-	constexpr Matrix<T, N, N>& identity(Matrix<T, N, N>& matrix)
+	constexpr Matrix<T, N, N> identity()
 	{
-		memset(&matrix[0][0], 0, sizeof(T) * N * N);
+		Matrix<T, N, N> result;
 
 		for (size_t i = 0; i < N; i++)
 		{
-			matrix[i][i] = 1;
+			result.data[i * N + i] = T(1);
 		}
 
-		return matrix;
+		return result;
 	}
 
 	template<typename T, size_t N>
-	constexpr Matrix<T, N, N>& translation(Matrix<T, N, N>& matrix, const Vector<T, (N - 1)>& translation)
+	constexpr Matrix<T, N, N>& identity(Matrix<T, N, N>& matrix)
+	{
+		matrix = identity<T, N>();
+		return matrix;
+	}
+
+	template<typename T, size_t C>
+	constexpr Matrix<T, C + 1, C + 1> translation(const Vector<T, C>& translation)
 	{
-		memset(&matrix[0][0], 0, sizeof(T) * N * N);
+		Matrix<T, C + 1, C + 1> result = identity<T, C + 1>();
 
-		for (size_t i = 0; i < N; i++)
+		for (size_t i = 0; i < C; i++)
 		{
-			matrix[i][i] = 1;
+			result.data[C * (C + 1) + i] = translation[i];
 		}
 
-		memcpy_s(&matrix[N - 1], sizeof(T) * N, &translation, sizeof(T) * (N - 1));
+		return result;
+	}
 
+	template<typename T, size_t N>
+	constexpr Matrix<T, N, N>& translation(Matrix<T, N, N>& matrix, const Vector<T, (N - 1)>& translation)
+	{
+		matrix = AbstractMath::translation(translation);
 		return matrix;
 	}
 
 	template<typename T, size_t N>
-	constexpr Matrix<T, N, N>& scale(Matrix<T, N, N>& matrix, const Vector<T, N>& scale)
+	constexpr Matrix<T, N, N> scale(const Vector<T, N>& scale)
 	{
-		memset(&matrix[0][0], 0, sizeof(T) * N * N);
+		Matrix<T, N, N> result;
 
 		for (size_t i = 0; i < N; i++)
 		{
-			matrix[i][i] = scale[i];
+			result.data[i * N + i] = scale[i];
 		}
 
+		return result;
+	}
+
+	template<typename T, size_t N>
+	constexpr Matrix<T, N, N>& scale(Matrix<T, N, N>& matrix, const Vector<T, N>& scale)
+	{
+		matrix = AbstractMath::scale(scale);
 		return matrix;
 	}
 
+	// the initializer lists below are row-major, laid out like the matrices they build
 	template<typename T>
 	constexpr Matrix<T, 4, 4> perspective(T aspectRatio, T fieldOfView, T nearPlane, T farPlane)
 	{
-		T f = T(1) / std::tan(T(0.5) * fieldOfView);
+		T f = T(1) / math::tan(T(0.5) * fieldOfView);
 		T zRange = nearPlane - farPlane;
 
-		Matrix<T, 4, 4> result;
-
-		result[0][0] = f / aspectRatio; result[1][0] = T(0); result[2][0] = T(0);				result[3][0] = T(0);
-		result[0][1] = T(0);			result[1][1] = -f;   result[2][1] = T(0);				result[3][1] = T(0);
-		result[0][2] = T(0);			result[1][2] = T(0); result[2][2] = farPlane / zRange;  result[3][2] = (nearPlane * farPlane) / zRange;
-		result[0][3] = T(0);			result[1][3] = T(0); result[2][3] = T(-1);				result[3][3] = T(0);
-
-
-		return result;
+		return Matrix<T, 4, 4>{
+			f / aspectRatio, T(0), T(0),				 T(0),
+			T(0),			 -f,   T(0),				 T(0),
+			T(0),			 T(0), farPlane / zRange,	 (nearPlane * farPlane) / zRange,
+			T(0),			 T(0), T(-1),				 T(0)
+		};
 	}
 
 	template<typename T>
 	constexpr Matrix<T, 4, 4> perspectiveOGL(T aspectRatio, T fieldOfView, T nearPlane, T farPlane)
 	{
-		T f = T(1) / std::tan(T(0.5) * fieldOfView);
+		T f = T(1) / math::tan(T(0.5) * fieldOfView);
 		T zRange = nearPlane - farPlane;
 
-		Matrix<T, 4, 4> result;
-
-		result[0][0] = f / aspectRatio; result[1][0] = T(0); result[2][0] = T(0);								result[3][0] = T(0);
-		result[0][1] = T(0);			result[1][1] = f;    result[2][1] = T(0);								result[3][1] = T(0);
-		result[0][2] = T(0);			result[1][2] = T(0); result[2][2] = (-nearPlane - farPlane) / zRange;   result[3][2] = (2 * nearPlane * farPlane) / zRange;
-		result[0][3] = T(0);			result[1][3] = T(0); result[2][3] = T(1);								result[3][3] = T(0);
-
-
-		return result;
+		return Matrix<T, 4, 4>{
+			f / aspectRatio, T(0), T(0),								T(0),
+			T(0),			 f,	   T(0),								T(0),
+			T(0),			 T(0), (-nearPlane - farPlane) / zRange,	(2 * nearPlane * farPlane) / zRange,
+			T(0),			 T(0), T(1),								T(0)
+		};
 	}
 
 	template<typename T>
 	constexpr Matrix<T, 4, 4> orthographic(T left, T right, T bottom, T top, T near, T far)
 	{
-		Matrix<T, 4, 4> result;
-
-		result[0][0] = T(2) / (right - left); result[1][0] = T(0);					  result[2][0] = T(0);				  result[3][0] = (right + left) / (left - right);
-		result[0][1] = T(0);				  result[1][1] = T(2) / (bottom - top);   result[2][1] = T(0);				  result[3][1] = (bottom + top) / (top - bottom);
-		result[0][2] = T(0);				  result[1][2] = T(0);					  result[2][2] = T(1) / (near - far); result[3][2] = near / (near - far);
-		result[0][3] = T(0);				  result[1][3] = T(0);					  result[2][3] = T(0);				  result[3][3] = T(1);
-
-		return result;
+		return Matrix<T, 4, 4>{
+			T(2) / (right - left), T(0),				  T(0),				  (right + left) / (left - right),
+			T(0),				   T(2) / (bottom - top), T(0),				  (bottom + top) / (top - bottom),
+			T(0),				   T(0),				  T(1) / (near - far), near / (near - far),
+			T(0),				   T(0),				  T(0),				  T(1)
+		};
 	}
 
 	template<typename T>
 	constexpr Matrix<T, 4, 4> orthographicOGL(T left, T right, T bottom, T top, T near, T far)
 	{
-		Matrix<T, 4, 4> result;
-
-		result[0][0] = T(2) / (right - left); result[1][0] = T(0);					  result[2][0] = T(0);				  result[3][0] = (right + left) / (left - right);
-		result[0][1] = T(0);				  result[1][1] = T(2) / (top - bottom);   result[2][1] = T(0);				  result[3][1] = (bottom + top) / (bottom - top);
-		result[0][2] = T(0);				  result[1][2] = T(0);					  result[2][2] = T(2) / (near - far); result[3][2] = (far + near) / (near - far);
-		result[0][3] = T(0);				  result[1][3] = T(0);					  result[2][3] = T(0);				  result[3][3] = T(1);
-
-		return result;
+		return Matrix<T, 4, 4>{
+			T(2) / (right - left), T(0),				  T(0),				  (right + left) / (left - right),
+			T(0),				   T(2) / (top - bottom), T(0),				  (bottom + top) / (bottom - top),
+			T(0),				   T(0),				  T(2) / (near - far), (far + near) / (near - far),
+			T(0),				   T(0),				  T(0),				  T(1)
+		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,357 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <type_traits>
+#include <assert.h>
+
+#include "Simd.h"
+#include "Vector.h"
+#include "Vec3.h"
+#include "Vec4.h"
+#include "Matrix.h"
+
+namespace AbstractMath {
+
+	static constexpr size_t CACHE_LINE_SIZE = 64;
+
+	// V with its alignment raised to Alignment_C (and its size rounded up to it), usable anywhere a V is since it is one:
+	// an AlignedVector4f never straddles a cache line and an AlignedMatrix4f fills exactly one
+	// the result of arithmetic is still a V, V's constructors are inherited and converting from V brings it back
+	template<typename V, size_t Alignment_C = SIMD_ALIGNMENT>
+	struct alignas(Alignment_C) Aligned : public V
+	{
+		static_assert((Alignment_C & (Alignment_C - 1)) == 0 && Alignment_C >= alignof(V), "Alignment must be a power of two no smaller than the type's own!");
+
+		using V::V;
+
+		constexpr Aligned() = default;
+
+		constexpr Aligned(const V& other) : V(other) {}
+	};
+
+	typedef Aligned<Vector3<float>, 16> AlignedVector3f; // padded to 16 bytes, one SSE register per element
+	typedef Aligned<Vector4<float>, 16> AlignedVector4f;
+	typedef Aligned<Vector4<double>, 32> AlignedVector4d;
+	typedef Aligned<Matrix<float, 4, 4>, CACHE_LINE_SIZE> AlignedMatrix4f;
+	typedef Aligned<Matrix<double, 4, 4>, CACHE_LINE_SIZE> AlignedMatrix4d;
+
+	static_assert(sizeof(AlignedVector3f) == 16 && sizeof(AlignedVector4f) == 16 && sizeof(AlignedMatrix4f) == 64, "Aligned types must only pad up to their alignment!");
+
+	// std allocator over alignedAlloc(), so a std::vector of Aligned types (or plain floats) starts on an Alignment_C boundary
+	// operator new only promises alignof(std::max_align_t) before C++17 aligned new, and no more than that for plain T
+	template<typename T, size_t Alignment_C = (alignof(T) > SIMD_ALIGNMENT ? alignof(T) : SIMD_ALIGNMENT)>
+	class AlignedAllocator
+	{
+		static_assert((Alignment_C & (Alignment_C - 1)) == 0 && Alignment_C >= alignof(T), "Alignment must be a power of two no smaller than the type's own!");
+
+	public:
+		using value_type = T;
+
+		template<typename U>
+		struct rebind
+		{
+			using other = AlignedAllocator<U, Alignment_C>;
+		};
+
+		AlignedAllocator() noexcept = default;
+
+		template<typename U>
+		AlignedAllocator(const AlignedAllocator<U, Alignment_C>&) noexcept {}
+
+		T* allocate(size_t count)
+		{
+			if (count > size_t(-1) / sizeof(T))
+			{
+				throw std::bad_alloc();
+			}
+
+			void* ptr = alignedAlloc(sizeof(T) * count, Alignment_C);
+
+			if (ptr == nullptr && count > 0)
+			{
+				throw std::bad_alloc();
+			}
+
+			return static_cast<T*>(ptr);
+		}
+
+		void deallocate(T* ptr, size_t)
+		{
+			alignedFree(ptr);
+		}
+
+		template<typename U>
+		bool operator==(const AlignedAllocator<U, Alignment_C>&) const noexcept
+		{
+			return true;
+		}
+
+		template<typename U>
+		bool operator!=(const AlignedAllocator<U, Alignment_C>&) const noexcept
+		{
+			return false;
+		}
+	};
+
+	template<typename T>
+	using aligned_vector = std::vector<T, AlignedAllocator<T>>;
+
+	// bump allocator for per-frame scratch (skinning palettes, culled transforms, temporaries of batch passes):
+	// allocation is an aligned pointer increment, nothing is freed individually and reset() rewinds everything at once
+	// memory is kept between frames, when a frame overflows the first chunk more chunks are chained and reset() merges
+	// them into one so the next frame of the same size needs a single chunk again
+	// not thread safe, local() gives every thread its own arena
+	class FrameArena
+	{
+	public:
+		static constexpr size_t DEFAULT_CHUNK_SIZE = size_t(1) << 20;
+
+		// rewind point for scratch that only lives within part of a frame
+		struct Marker
+		{
+			size_t chunk;
+			size_t offset;
+		};
+
+		// the first chunk is allocated on first use
+		explicit FrameArena(size_t chunkSize = DEFAULT_CHUNK_SIZE) : chunkSize(chunkSize == 0 ? DEFAULT_CHUNK_SIZE : chunkSize) {}
+
+		~FrameArena()
+		{
+			release();
+		}
+
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		void* allocateBytes(size_t size, size_t alignment = SIMD_ALIGNMENT)
+		{
+			assert((alignment & (alignment - 1)) == 0);
+
+			while (current < chunks.size())
+			{
+				void* ptr = bump(chunks[current], size, alignment);
+
+				if (ptr != nullptr)
+				{
+					return ptr;
+				}
+
+				current++; //a rewound frame may still fit in a later chunk
+				offset = 0;
+			}
+
+			//each new chunk doubles the last one
+			size_t grown = chunks.empty() ? chunkSize : chunks.back().size * 2;
+			size_t required = size + (alignment > SIMD_ALIGNMENT ? alignment : 0);
+			Chunk chunk = { nullptr, required > grown ? required : grown };
+			chunk.data = static_cast<unsigned char*>(alignedAlloc(chunk.size));
+
+			if (chunk.data == nullptr)
+			{
+				throw std::bad_alloc();
+			}
+
+			chunks.push_back(chunk);
+			current = chunks.size() - 1;
+			offset = 0;
+
+			return bump(chunks[current], size, alignment);
+		}
+
+		// count uninitialized Ts when T is trivially default constructible (floats, storage types), value-initialized
+		// (zeroed) ones otherwise like Vector and Matrix, no destructors run on reset so T must not need one
+		template<typename T>
+		T* allocate(size_t count, size_t alignment = (alignof(T) > SIMD_ALIGNMENT ? alignof(T) : SIMD_ALIGNMENT))
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors!");
+
+			if (count > size_t(-1) / sizeof(T))
+			{
+				throw std::bad_alloc();
+			}
+
+			T* result = static_cast<T*>(allocateBytes(sizeof(T) * count, alignment));
+
+			if constexpr (!std::is_trivially_default_constructible<T>::value)
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					new (result + i) T();
+				}
+			}
+
+			return result;
+		}
+
+		Marker mark() const
+		{
+			return Marker{ current, offset };
+		}
+
+		// everything allocated since marker becomes free again
+		void rewind(const Marker& marker)
+		{
+			assert(marker.chunk < current || (marker.chunk == current && marker.offset <= offset));
+
+			current = marker.chunk;
+			offset = marker.offset;
+		}
+
+		// start of frame, everything allocated so far becomes free again
+		void reset()
+		{
+			if (chunks.size() > 1)
+			{
+				size_t total = capacity();
+				release();
+
+				Chunk chunk = { static_cast<unsigned char*>(alignedAlloc(total)), total };
+
+				if (chunk.data != nullptr)
+				{
+					chunks.push_back(chunk);
+				}
+			}
+
+			current = 0;
+			offset = 0;
+		}
+
+		// bytes handed out since the last reset, including alignment padding
+		size_t used() const
+		{
+			size_t result = offset;
+
+			for (size_t i = 0; i < current && i < chunks.size(); i++)
+			{
+				result += chunks[i].size;
+			}
+
+			return result;
+		}
+
+		size_t capacity() const
+		{
+			size_t result = 0;
+
+			for (const Chunk& chunk : chunks)
+			{
+				result += chunk.size;
+			}
+
+			return result;
+		}
+
+		// the calling thread's arena, the thread that owns a frame resets it, ThreadPool workers never reset theirs so
+		// scratch taken inside a parallelFor body belongs in an ArenaScope
+		static FrameArena& local()
+		{
+			thread_local FrameArena arena;
+			return arena;
+		}
+
+	private:
+		struct Chunk
+		{
+			unsigned char* data;
+			size_t size;
+		};
+
+		void* bump(const Chunk& chunk, size_t size, size_t alignment)
+		{
+			uintptr_t base = reinterpret_cast<uintptr_t>(chunk.data);
+			size_t start = size_t(((base + offset + alignment - 1) & ~uintptr_t(alignment - 1)) - base);
+
+			if (start > chunk.size || size > chunk.size - start)
+			{
+				return nullptr;
+			}
+
+			offset = start + size;
+			return chunk.data + start;
+		}
+
+		void release()
+		{
+			for (Chunk& chunk : chunks)
+			{
+				alignedFree(chunk.data);
+			}
+
+			chunks.clear();
+			current = 0;
+			offset = 0;
+		}
+
+		std::vector<Chunk> chunks;
+		size_t chunkSize;
+		size_t current = 0;
+		size_t offset = 0;
+	};
+
+	// rewinds the arena to where it was at construction, for scratch scoped to one pass
+	class ArenaScope
+	{
+	public:
+		explicit ArenaScope(FrameArena& arena = FrameArena::local()) : arena(arena), marker(arena.mark()) {}
+
+		~ArenaScope()
+		{
+			arena.rewind(marker);
+		}
+
+		ArenaScope(const ArenaScope&) = delete;
+		ArenaScope& operator=(const ArenaScope&) = delete;
+
+	private:
+		FrameArena& arena;
+		FrameArena::Marker marker;
+	};
+
+	// std allocator on a FrameArena, deallocation is a no-op so containers using it must not outlive the next reset()
+	template<typename T>
+	class ArenaAllocator
+	{
+	public:
+		using value_type = T;
+
+		explicit ArenaAllocator(FrameArena& arena = FrameArena::local()) noexcept : arena(&arena) {}
+
+		template<typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+		T* allocate(size_t count)
+		{
+			if (count > size_t(-1) / sizeof(T))
+			{
+				throw std::bad_alloc();
+			}
+
+			return static_cast<T*>(arena->allocateBytes(sizeof(T) * count, alignof(T) > SIMD_ALIGNMENT ? alignof(T) : SIMD_ALIGNMENT));
+		}
+
+		void deallocate(T*, size_t) {}
+
+		template<typename U>
+		bool operator==(const ArenaAllocator<U>& other) const noexcept
+		{
+			return arena == other.arena;
+		}
+
+		template<typename U>
+		bool operator!=(const ArenaAllocator<U>& other) const noexcept
+		{
+			return arena != other.arena;
+		}
+
+	private:
+		template<typename U>
+		friend class ArenaAllocator;
+
+		FrameArena* arena;
+	};
+}
@@ -0,0 +1,403 @@
+#pragma once
+
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <type_traits>
+
+namespace AbstractMath {
+
+	inline size_t hardwareThreads()
+	{
+		unsigned int count = std::thread::hardware_concurrency();
+		return count == 0 ? 1 : count;
+	}
+
+	// where parallelFor and the helpers below send their work, derive from it to run them on an engine's own job system
+	// run() must call task(context, i) exactly once for every i in [ 0, count ) on any threads in any order and return
+	// once all of them have finished, it is also called from inside tasks (nested parallelFor) so it must not block a
+	// worker without letting it help
+	class JobSystem
+	{
+	public:
+		virtual ~JobSystem() = default;
+
+		virtual void run(size_t count, void (*task)(void* context, size_t index), void* context) = 0;
+
+		// threads that can execute tasks at once, including the caller
+		virtual size_t concurrency() const = 0;
+	};
+
+	// the built-in JobSystem: a fixed set of workers with one deque each, a thread splits its ranges in half and keeps
+	// the first half, pushing the second onto the back of its deque, and pops from the back (depth first, cache warm)
+	// while idle threads steal from the front (the biggest remaining ranges)
+	// a thread waiting on a run() keeps executing tasks until its own are done, which is what makes nesting safe
+	// threads outside the pool share one extra deque and help the same way, a pool of zero workers runs everything inline
+	class ThreadPool : public JobSystem
+	{
+	public:
+		explicit ThreadPool(size_t workers = hardwareThreads() - 1) : queues(workers + 1)
+		{
+			threads.reserve(workers);
+
+			for (size_t i = 0; i < workers; i++)
+			{
+				threads.emplace_back([this, i]() { workerLoop(i); });
+			}
+		}
+
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(sleepMutex);
+				stopping = true;
+			}
+
+			wake.notify_all();
+
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		void run(size_t count, void (*task)(void* context, size_t index), void* context) override
+		{
+			if (count == 0)
+			{
+				return;
+			}
+
+			if (threads.empty() || count == 1)
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					task(context, i);
+				}
+
+				return;
+			}
+
+			Group group;
+			group.task = task;
+			group.context = context;
+			group.pending.store(count, std::memory_order_relaxed);
+
+			size_t queue = ownQueue();
+			execute(Range{ &group, 0, count }, queue);
+
+			while (group.pending.load(std::memory_order_acquire) != 0)
+			{
+				Range range;
+
+				if (findWork(queue, range))
+				{
+					execute(range, queue);
+				}
+				else
+				{
+					std::this_thread::yield(); //the last ranges are running on other threads
+				}
+			}
+
+			if (group.error)
+			{
+				std::rethrow_exception(group.error);
+			}
+		}
+
+		size_t concurrency() const override
+		{
+			return threads.size() + 1;
+		}
+
+		// the pool behind jobSystem() unless another one is installed, one worker per hardware thread besides the caller
+		static ThreadPool& global()
+		{
+			static ThreadPool pool;
+			return pool;
+		}
+
+	private:
+		struct Group
+		{
+			void (*task)(void*, size_t);
+			void* context;
+			std::atomic<size_t> pending;
+			std::atomic<bool> failed{ false };
+			std::exception_ptr error;
+		};
+
+		struct Range
+		{
+			Group* group;
+			size_t first;
+			size_t last;
+		};
+
+		struct Queue
+		{
+			std::mutex mutex;
+			std::deque<Range> ranges;
+		};
+
+		// worker i owns queue i, every other thread shares the last one
+		size_t ownQueue() const
+		{
+			return currentPool() == this ? currentWorker() : queues.size() - 1;
+		}
+
+		void execute(Range range, size_t queue)
+		{
+			while (range.last - range.first > 1)
+			{
+				size_t middle = range.first + (range.last - range.first) / 2;
+				push(Range{ range.group, middle, range.last }, queue);
+				range.last = middle;
+			}
+
+			Group& group = *range.group;
+
+			try
+			{
+				group.task(group.context, range.first);
+			}
+			catch (...)
+			{
+				if (!group.failed.exchange(true))
+				{
+					group.error = std::current_exception();
+				}
+			}
+
+			group.pending.fetch_sub(1, std::memory_order_acq_rel);
+		}
+
+		void push(const Range& range, size_t queue)
+		{
+			{
+				std::lock_guard<std::mutex> lock(queues[queue].mutex);
+				queues[queue].ranges.push_back(range);
+			}
+
+			queued.fetch_add(1, std::memory_order_release);
+
+			{
+				std::lock_guard<std::mutex> lock(sleepMutex); //orders the push before a sleeper's check of queued
+			}
+
+			wake.notify_one();
+		}
+
+		// own queue from the back, then everybody else's from the front starting at the next one
+		bool findWork(size_t queue, Range& range)
+		{
+			if (queued.load(std::memory_order_acquire) == 0)
+			{
+				return false;
+			}
+
+			for (size_t i = 0; i < queues.size(); i++)
+			{
+				Queue& victim = queues[(queue + i) % queues.size()];
+				std::lock_guard<std::mutex> lock(victim.mutex);
+
+				if (!victim.ranges.empty())
+				{
+					if (i == 0)
+					{
+						range = victim.ranges.back();
+						victim.ranges.pop_back();
+					}
+					else
+					{
+						range = victim.ranges.front();
+						victim.ranges.pop_front();
+					}
+
+					queued.fetch_sub(1, std::memory_order_relaxed);
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		void workerLoop(size_t index)
+		{
+			currentPool() = this;
+			currentWorker() = index;
+
+			while (true)
+			{
+				Range range;
+
+				if (findWork(index, range))
+				{
+					execute(range, index);
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(sleepMutex);
+				wake.wait(lock, [this]() { return stopping || queued.load(std::memory_order_acquire) != 0; });
+
+				if (stopping)
+				{
+					return;
+				}
+			}
+		}
+
+		static const ThreadPool*& currentPool()
+		{
+			thread_local const ThreadPool* pool = nullptr;
+			return pool;
+		}
+
+		static size_t& currentWorker()
+		{
+			thread_local size_t worker = 0;
+			return worker;
+		}
+
+		std::vector<Queue> queues;
+		std::vector<std::thread> threads;
+		std::atomic<size_t> queued{ 0 };
+		std::mutex sleepMutex;
+		std::condition_variable wake;
+		bool stopping = false;
+	};
+
+	namespace detail {
+
+		inline std::atomic<JobSystem*>& installedJobSystem()
+		{
+			static std::atomic<JobSystem*> system{ nullptr };
+			return system;
+		}
+
+		template<typename F>
+		struct ChunkTask
+		{
+			F* body;
+			size_t begin;
+			size_t end;
+			size_t grain;
+
+			static void invoke(void* context, size_t index)
+			{
+				const ChunkTask<F>& self = *static_cast<const ChunkTask<F>*>(context);
+				size_t first = self.begin + index * self.grain;
+				(*self.body)(first, std::min(self.end, first + self.grain));
+			}
+		};
+	}
+
+	// nullptr goes back to ThreadPool::global(), the system must outlive every parallelFor that can see it
+	inline void setJobSystem(JobSystem* system)
+	{
+		detail::installedJobSystem().store(system, std::memory_order_release);
+	}
+
+	inline JobSystem& jobSystem()
+	{
+		JobSystem* system = detail::installedJobSystem().load(std::memory_order_acquire);
+		return system != nullptr ? *system : ThreadPool::global();
+	}
+
+	// splits [begin, end) into chunks of exactly grain indices (the last one shorter) and runs body(chunkBegin, chunkEnd)
+	// on each through jobSystem(), the chunk boundaries never depend on the thread count so per-chunk results (partial
+	// sums, compacted slices) are the same on every machine, body may call parallelFor itself
+	// the first exception thrown by body is rethrown here once every chunk has finished
+	template<typename F>
+	void parallelFor(size_t begin, size_t end, size_t grain, F&& body)
+	{
+		if (begin >= end)
+		{
+			return;
+		}
+
+		grain = grain == 0 ? 1 : grain;
+		size_t chunks = (end - begin + grain - 1) / grain;
+
+		if (chunks == 1)
+		{
+			body(begin, end);
+			return;
+		}
+
+		using Body = typename std::remove_reference<F>::type;
+		detail::ChunkTask<Body> task{ &body, begin, end, grain };
+		jobSystem().run(chunks, &detail::ChunkTask<Body>::invoke, &task);
+	}
+
+	// bytes of elements per chunk in the element-wise helpers, small enough for a chunk's input and output to stay in
+	// L1/L2 while it is processed and for the chunks to balance, big enough that scheduling is noise
+	static constexpr size_t PARALLEL_CHUNK_BYTES = 16 * 1024;
+
+	namespace detail {
+
+		template<size_t Bytes_C>
+		constexpr size_t cacheGrain()
+		{
+			return PARALLEL_CHUNK_BYTES / Bytes_C > 0 ? PARALLEL_CHUNK_BYTES / Bytes_C : 1;
+		}
+	}
+
+	// op(data[i]) for every element, data can be any Vector, Matrix or Quaternion array
+	template<typename T, typename F>
+	void parallelFor(T* data, size_t count, F&& op)
+	{
+		parallelFor(0, count, detail::cacheGrain<sizeof(T)>(), [data, &op](size_t first, size_t last)
+		{
+			for (size_t i = first; i < last; i++)
+			{
+				op(data[i]);
+			}
+		});
+	}
+
+	// dst[i] = op(src[i]), dst may be src
+	template<typename S, typename D, typename F>
+	void parallelTransform(const S* src, D* dst, size_t count, F&& op)
+	{
+		parallelFor(0, count, detail::cacheGrain<sizeof(S) + sizeof(D)>(), [src, dst, &op](size_t first, size_t last)
+		{
+			for (size_t i = first; i < last; i++)
+			{
+				dst[i] = op(src[i]);
+			}
+		});
+	}
+
+	// dst[i] = op(a[i], b[i]), e.g. blending two poses
+	template<typename A, typename B, typename D, typename F>
+	void parallelTransform(const A* a, const B* b, D* dst, size_t count, F&& op)
+	{
+		parallelFor(0, count, detail::cacheGrain<sizeof(A) + sizeof(B) + sizeof(D)>(), [a, b, dst, &op](size_t first, size_t last)
+		{
+			for (size_t i = first; i < last; i++)
+			{
+				dst[i] = op(a[i], b[i]);
+			}
+		});
+	}
+
+	// kernel(src + first, dst + first, chunkCount) per chunk, to run a batch kernel (transformPoints, convert, ...) in parallel
+	template<typename S, typename D, typename F>
+	void parallelBatch(const S* src, D* dst, size_t count, F&& kernel)
+	{
+		parallelFor(0, count, detail::cacheGrain<sizeof(S) + sizeof(D)>(), [src, dst, &kernel](size_t first, size_t last)
+		{
+			kernel(src + first, dst + first, last - first);
+		});
+	}
+}
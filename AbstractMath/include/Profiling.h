@@ -0,0 +1,313 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+
+#include "Simd.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+#endif
+
+// opt-in operation counters, off unless ABSTRACTMATH_PROFILE is defined for every translation unit (the hooks below
+// expand to nothing otherwise, so a default build carries no trace of them)
+// ABSTRACTMATH_PROFILE_TIMING adds sampled timing of the batch kernels, every 2^ABSTRACTMATH_PROFILE_SAMPLE_SHIFT-th call
+// per thread and operation is timed with rdtsc (reference cycles) on x86 or steady_clock (nanoseconds) elsewhere and
+// with ABSTRACTMATH_PROFILE_STEADY_CLOCK; single-element operations are only counted, timing them would cost more than
+// they do, and counting them inside a constant expression needs detail::isConstantEvaluated() support from the compiler
+#if defined(ABSTRACTMATH_PROFILE_TIMING) && !defined(ABSTRACTMATH_PROFILE_SAMPLE_SHIFT)
+	#define ABSTRACTMATH_PROFILE_SAMPLE_SHIFT 3
+#endif
+
+namespace AbstractMath { namespace profile {
+
+	// an operation built on others counts them as well (rotate() its multiplies, nlerp its normalize)
+	enum class Operation : uint32_t
+	{
+		MatrixMultiply, //matrix * matrix, any size
+		MatrixVector,
+		MatrixInverse, //inverted() (so affineInverse() too), orthonormalInverse()
+		Normalize, //Vector::normalized()
+		QuaternionMultiply,
+		QuaternionRotate,
+		QuaternionBlend, //nlerp, slerp, fastSlerp
+		BatchTransform, //transformPoints/Directions/Vectors, composeTRS/decomposeTRS over arrays, elements are vectors or matrices
+		BatchVector, //VectorArray arithmetic, elements are vectors
+		BatchQuaternion, //BatchQuaternion.h, elements are quaternions
+		BatchConvert, //storage conversion and quaternion compression, elements are scalars or quaternions
+		Gemm, //DynamicMatrix gemm, elements are multiply-adds
+		SparseMultiply, //SparseMatrix/BlockSparseMatrix products, elements are nonzero scalars
+		LinearSolve, //LU/Cholesky/QR decompositions and the batched solves, elements are systems
+		MatrixDecomposition, //3x3 symmetric eigen, SVD and polar decompositions, elements are matrices
+		RayQuery, //ray-triangle and ray-box queries over arrays, elements are ray-triangle or ray-box tests (rays for a BVH)
+		BvhBuild, //BVH builds and refits, elements are primitives
+		Count
+	};
+
+	static constexpr size_t OPERATION_COUNT = size_t(Operation::Count);
+
+	inline const char* name(Operation operation)
+	{
+		static const char* const NAMES[OPERATION_COUNT] = { "matrix_multiply", "matrix_vector", "matrix_inverse", "normalize", "quaternion_multiply",
+			"quaternion_rotate", "quaternion_blend", "batch_transform", "batch_vector", "batch_quaternion", "batch_convert", "gemm", "sparse_multiply",
+			"linear_solve", "matrix_decomposition", "ray_query", "bvh_build" };
+
+		return operation < Operation::Count ? NAMES[size_t(operation)] : "unknown";
+	}
+
+	struct OperationStats
+	{
+		uint64_t calls = 0;
+		uint64_t elements = 0;
+		uint64_t samples = 0; //timed calls
+		uint64_t sampledTicks = 0; //ticks spent in the timed calls
+
+		// the sampled mean scaled up to every call
+		uint64_t estimatedTicks() const
+		{
+			return samples == 0 ? 0 : uint64_t(double(sampledTicks) / double(samples) * double(calls));
+		}
+	};
+
+	// totals over every thread at one point, subtract two to attribute the work between them (one engine system's update)
+	struct Snapshot
+	{
+		OperationStats operations[OPERATION_COUNT];
+
+		const OperationStats& operator[](Operation operation) const
+		{
+			return operations[size_t(operation)];
+		}
+
+		Snapshot operator-(const Snapshot& earlier) const
+		{
+			Snapshot result;
+
+			for (size_t i = 0; i < OPERATION_COUNT; i++)
+			{
+				result.operations[i].calls = operations[i].calls - earlier.operations[i].calls;
+				result.operations[i].elements = operations[i].elements - earlier.operations[i].elements;
+				result.operations[i].samples = operations[i].samples - earlier.operations[i].samples;
+				result.operations[i].sampledTicks = operations[i].sampledTicks - earlier.operations[i].sampledTicks;
+			}
+
+			return result;
+		}
+
+		// { "tick_unit": "...", "operations": { "matrix_multiply": { "calls": ..., ... }, ... } }, operations never called are left out
+		std::string toJson() const
+		{
+			std::string json = "{\n  \"tick_unit\": \"";
+			json += tickUnit();
+			json += "\",\n  \"operations\": {";
+			bool first = true;
+
+			for (size_t i = 0; i < OPERATION_COUNT; i++)
+			{
+				const OperationStats& stats = operations[i];
+
+				if (stats.calls == 0)
+				{
+					continue;
+				}
+
+				json += first ? "\n" : ",\n";
+				json += std::string("    \"") + name(Operation(i)) + "\": { \"calls\": " + std::to_string(stats.calls) + ", \"elements\": " + std::to_string(stats.elements)
+					+ ", \"samples\": " + std::to_string(stats.samples) + ", \"sampled_ticks\": " + std::to_string(stats.sampledTicks)
+					+ ", \"estimated_ticks\": " + std::to_string(stats.estimatedTicks()) + " }";
+				first = false;
+			}
+
+			json += first ? "}\n}\n" : "\n  }\n}\n";
+			return json;
+		}
+
+		static const char* tickUnit()
+		{
+#if defined(ABSTRACTMATH_PROFILE_TIMING) && !defined(ABSTRACTMATH_PROFILE_STEADY_CLOCK) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+			return "cycles";
+#else
+			return "nanoseconds";
+#endif
+		}
+	};
+
+	namespace detail {
+
+		// one block per thread, only its thread writes it (plain load and store, no locked instructions) and snapshot()
+		// reads it from any thread, blocks of threads that have exited are folded into the retired totals
+		struct ThreadCounters
+		{
+			std::atomic<uint64_t> calls[OPERATION_COUNT] = {};
+			std::atomic<uint64_t> elements[OPERATION_COUNT] = {};
+			std::atomic<uint64_t> samples[OPERATION_COUNT] = {};
+			std::atomic<uint64_t> ticks[OPERATION_COUNT] = {};
+		};
+
+		struct Registry
+		{
+			std::mutex mutex;
+			std::vector<ThreadCounters*> live;
+			Snapshot retired;
+
+			static Registry& get()
+			{
+				static Registry registry;
+				return registry;
+			}
+		};
+
+		inline void bump(std::atomic<uint64_t>& counter, uint64_t amount)
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+		}
+
+		inline void accumulate(Snapshot& totals, const ThreadCounters& counters)
+		{
+			for (size_t i = 0; i < OPERATION_COUNT; i++)
+			{
+				totals.operations[i].calls += counters.calls[i].load(std::memory_order_relaxed);
+				totals.operations[i].elements += counters.elements[i].load(std::memory_order_relaxed);
+				totals.operations[i].samples += counters.samples[i].load(std::memory_order_relaxed);
+				totals.operations[i].sampledTicks += counters.ticks[i].load(std::memory_order_relaxed);
+			}
+		}
+
+		class ThreadSlot
+		{
+		public:
+			ThreadSlot()
+			{
+				Registry& registry = Registry::get();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				registry.live.push_back(&counters);
+			}
+
+			~ThreadSlot()
+			{
+				Registry& registry = Registry::get();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				accumulate(registry.retired, counters);
+				registry.live.erase(std::find(registry.live.begin(), registry.live.end(), &counters));
+			}
+
+			ThreadCounters counters;
+		};
+
+		inline ThreadCounters& local()
+		{
+			thread_local ThreadSlot slot;
+			return slot.counters;
+		}
+
+		inline void count(Operation operation, uint64_t elements)
+		{
+			ThreadCounters& counters = local();
+			bump(counters.calls[size_t(operation)], 1);
+			bump(counters.elements[size_t(operation)], elements);
+		}
+
+		inline uint64_t ticks()
+		{
+#if !defined(ABSTRACTMATH_PROFILE_STEADY_CLOCK) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+			return __rdtsc();
+#else
+			return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+		}
+
+		// counts on construction, times the sampled calls until destruction
+		class Scope
+		{
+		public:
+			Scope(Operation operation, uint64_t elements) : index(size_t(operation)), counters(local())
+			{
+				uint64_t calls = counters.calls[index].load(std::memory_order_relaxed);
+				bump(counters.calls[index], 1);
+				bump(counters.elements[index], elements);
+
+#if defined(ABSTRACTMATH_PROFILE_TIMING)
+				sampled = (calls & ((uint64_t(1) << ABSTRACTMATH_PROFILE_SAMPLE_SHIFT) - 1)) == 0;
+				start = sampled ? ticks() : 0;
+#else
+				(void)calls;
+#endif
+			}
+
+			~Scope()
+			{
+#if defined(ABSTRACTMATH_PROFILE_TIMING)
+				if (sampled)
+				{
+					bump(counters.ticks[index], ticks() - start);
+					bump(counters.samples[index], 1);
+				}
+#endif
+			}
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			size_t index;
+			ThreadCounters& counters;
+			bool sampled = false;
+			uint64_t start = 0;
+		};
+	}
+
+	// totals of every thread, the running threads' counters are read as they are (each value exact, the set not atomic)
+	inline Snapshot snapshot()
+	{
+		detail::Registry& registry = detail::Registry::get();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		Snapshot result = registry.retired;
+
+		for (const detail::ThreadCounters* counters : registry.live)
+		{
+			detail::accumulate(result, *counters);
+		}
+
+		return result;
+	}
+
+	// zeroes every counter, call it while no instrumented work runs (a running thread's update can be lost otherwise),
+	// or prefer subtracting snapshots
+	inline void reset()
+	{
+		detail::Registry& registry = detail::Registry::get();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		registry.retired = Snapshot();
+
+		for (detail::ThreadCounters* counters : registry.live)
+		{
+			for (size_t i = 0; i < OPERATION_COUNT; i++)
+			{
+				counters->calls[i].store(0, std::memory_order_relaxed);
+				counters->elements[i].store(0, std::memory_order_relaxed);
+				counters->samples[i].store(0, std::memory_order_relaxed);
+				counters->ticks[i].store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+} }
+
+#if defined(ABSTRACTMATH_PROFILE)
+	// usable in constexpr functions, skipped while the compiler evaluates a constant expression
+	#define ABSTRACTMATH_PROFILE_COUNT(operation, elements) \
+		do { if (!::AbstractMath::detail::isConstantEvaluated()) { ::AbstractMath::profile::detail::count(::AbstractMath::profile::Operation::operation, uint64_t(elements)); } } while (false)
+
+	// counts and, with ABSTRACTMATH_PROFILE_TIMING, times the rest of the enclosing block, not for constexpr functions
+	#define ABSTRACTMATH_PROFILE_SCOPE(operation, elements) \
+		::AbstractMath::profile::detail::Scope abstractMathProfileScope(::AbstractMath::profile::Operation::operation, uint64_t(elements))
+#else
+	#define ABSTRACTMATH_PROFILE_COUNT(operation, elements) do {} while (false)
+	#define ABSTRACTMATH_PROFILE_SCOPE(operation, elements) do {} while (false)
+#endif
@@ -6,27 +6,54 @@
 
 namespace AbstractMath {
 
+	namespace detail {
+
+		// trig-free slerp weights (Eberly, "A Fast and Accurate Algorithm for Computing SLERP"): sin(t * angle) / sin(angle)
+		// as a series in cos(angle) - 1 cut after SLERP_TERMS terms, the last one scaled by SLERP_CORRECTION to spread the
+		// truncation error over the range, for cos(angle) in [0, 1] every weight is within 2e-5 of the exact one
+		static constexpr size_t SLERP_TERMS = 8;
+		static constexpr double SLERP_CORRECTION = 1.85298109240830;
+
+		// term i is ( t^2 - (i + 1)^2 ) / ( (i + 1)(2i + 3) ) * (cos(angle) - 1), split into u * t^2 - v
+		constexpr double slerpSeriesU(size_t i)
+		{
+			return (i + 1 == SLERP_TERMS ? SLERP_CORRECTION : 1.0) / double((i + 1) * (2 * i + 3));
+		}
+
+		constexpr double slerpSeriesV(size_t i)
+		{
+			return (i + 1 == SLERP_TERMS ? SLERP_CORRECTION : 1.0) * double(i + 1) / double(2 * i + 3);
+		}
+
+		template<typename T>
+		constexpr T slerpWeight(T t, T cosAngleMinusOne)
+		{
+			T sum = T(1);
+
+			for (size_t i = SLERP_TERMS; i-- > 0;)
+			{
+				sum = T(1) + (T(slerpSeriesU(i)) * t * t - T(slerpSeriesV(i))) * cosAngleMinusOne * sum;
+			}
+
+			return t * sum;
+		}
+	}
+
 	template<typename T>
 	class Quaternion : public Vector<T, 4>
 	{
 	public:
 		constexpr Quaternion(T x = T(0), T y = T(0), T z = T(0), T w = T(1))
 		{
-			this->x = x;
-			this->y = y;
-			this->z = z;
-			this->w = w;
+			this->data[0] = x;
+			this->data[1] = y;
+			this->data[2] = z;
+			this->data[3] = w;
 		}
 
 		constexpr Quaternion(const Vector<T, 3>& axis, T angle)
 		{
-			T sin = std::sin(angle / 2.0);
-			T cos = std::cos(angle / 2.0);
-
-			this->x = axis[0] * sin;
-			this->y = axis[1] * sin;
-			this->z = axis[2] * sin;
-			this->w = cos;
+			this->copyFrom(fromAxisAngle(axis, angle).data);
 		}
 
 		constexpr Quaternion(const Vector<T, 4>& other) : Vector<T, 4>()
@@ -34,19 +61,78 @@ namespace AbstractMath {
 			this->copyFrom(other.data);
 		}
 
+		// the axis-angle constructor with a precision policy, Fast and Approx share one polynomial sincos
+		template<typename Precision = Precise>
+		static constexpr Quaternion<T> fromAxisAngle(const Vector<T, 3>& axis, T angle)
+		{
+			T sin = T(0), cos = T(1);
+			math::sincos<Precision>(angle / T(2), sin, cos);
+
+			return Quaternion<T>(axis[0] * sin, axis[1] * sin, axis[2] * sin, cos);
+		}
+
+		// rotation from the upper-left 3x3 of a matrix whose columns are orthonormal (Shepperd's method): the square root is
+		// taken of the largest of w, x, y, z so it never nears zero, the other three follow from the off-diagonal sums
+		template<size_t Rows_C, size_t Cols_C>
+		static constexpr Quaternion<T> fromRotationMatrix(const Matrix<T, Rows_C, Cols_C>& matrix)
+		{
+			static_assert(std::is_floating_point<T>::value && Rows_C >= 3 && Cols_C >= 3, "Rotation requires a floating point matrix of at least 3x3!");
+
+			const T* m = matrix.data; //row r, column c is m[c * Rows_C + r]
+			const T m00 = m[0], m10 = m[1], m20 = m[2];
+			const T m01 = m[Rows_C], m11 = m[Rows_C + 1], m21 = m[Rows_C + 2];
+			const T m02 = m[2 * Rows_C], m12 = m[2 * Rows_C + 1], m22 = m[2 * Rows_C + 2];
+			const T trace = m00 + m11 + m22;
+
+			if (trace > T(0))
+			{
+				T s = math::sqrt(trace + T(1)) * T(2); // 4w
+				return Quaternion<T>((m21 - m12) / s, (m02 - m20) / s, (m10 - m01) / s, s / T(4));
+			}
+			else if (m00 > m11 && m00 > m22)
+			{
+				T s = math::sqrt(T(1) + m00 - m11 - m22) * T(2); // 4x
+				return Quaternion<T>(s / T(4), (m01 + m10) / s, (m02 + m20) / s, (m21 - m12) / s);
+			}
+			else if (m11 > m22)
+			{
+				T s = math::sqrt(T(1) + m11 - m00 - m22) * T(2); // 4y
+				return Quaternion<T>((m01 + m10) / s, s / T(4), (m12 + m21) / s, (m02 - m20) / s);
+			}
+			else
+			{
+				T s = math::sqrt(T(1) + m22 - m00 - m11) * T(2); // 4z
+				return Quaternion<T>((m02 + m20) / s, (m12 + m21) / s, s / T(4), (m10 - m01) / s);
+			}
+		}
+
 		constexpr Quaternion<T> conjugate() const
 		{
-			return Quaternion<T>(-(this->x), -(this->y), -(this->z), this->w);
+			return Quaternion<T>(-(this->data[0]), -(this->data[1]), -(this->data[2]), this->data[3]);
 		}
 
 		template<typename Ty>
 		constexpr Quaternion<decltype(T(1)* Ty(1))> operator*(const Quaternion<Ty>& other) const
 		{
 			using return_type = decltype(T(1)* Ty(1));
-			return_type w = this->w * other.w - this->x * other.x - this->y * other.y - this->z * other.z;
-			return_type x = this->w * other.x + this->x * other.w + this->y * other.z - this->z * other.y;
-			return_type y = this->w * other.y + this->y * other.w + this->z * other.x - this->x * other.z;
-			return_type z = this->w * other.z + this->z * other.w + this->x * other.y - this->y * other.x;
+			ABSTRACTMATH_PROFILE_COUNT(QuaternionMultiply, 1);
+
+#if defined(ABSTRACTMATH_SSE)
+			if constexpr (std::is_same<T, float>::value && std::is_same<Ty, float>::value)
+			{
+				if (!detail::isConstantEvaluated())
+				{
+					Quaternion<float> result;
+					detail::multiplyQuaternionf(this->data, other.data, result.data);
+					return result;
+				}
+			}
+#endif
+
+			return_type w = this->data[3] * other.data[3] - this->data[0] * other.data[0] - this->data[1] * other.data[1] - this->data[2] * other.data[2];
+			return_type x = this->data[3] * other.data[0] + this->data[0] * other.data[3] + this->data[1] * other.data[2] - this->data[2] * other.data[1];
+			return_type y = this->data[3] * other.data[1] + this->data[1] * other.data[3] + this->data[2] * other.data[0] - this->data[0] * other.data[2];
+			return_type z = this->data[3] * other.data[2] + this->data[2] * other.data[3] + this->data[0] * other.data[1] - this->data[1] * other.data[0];
 
 			return Quaternion<return_type>(x, y, z, w);
 		}
@@ -55,10 +141,10 @@ namespace AbstractMath {
 		constexpr Quaternion<decltype(T(1)* Ty(1))> operator*(const Vector<Ty, 3>& other) const
 		{
 			using return_type = decltype(T(1)* Ty(1));
-			return_type w = -(this->x * other[0]) - this->y * other[1] - this->z * other[2];
-			return_type x = this->w * other[0] + this->y * other[2] - this->z * other[1];
-			return_type y = this->w * other[1] + this->z * other[0] - this->x * other[2];
-			return_type z = this->w * other[2] + this->x * other[1] - this->y * other[0];
+			return_type w = -(this->data[0] * other[0]) - this->data[1] * other[1] - this->data[2] * other[2];
+			return_type x = this->data[3] * other[0] + this->data[1] * other[2] - this->data[2] * other[1];
+			return_type y = this->data[3] * other[1] + this->data[2] * other[0] - this->data[0] * other[2];
+			return_type z = this->data[3] * other[2] + this->data[0] * other[1] - this->data[1] * other[0];
 
 			return Quaternion<return_type>(x, y, z, w);
 		}
@@ -67,10 +153,10 @@ namespace AbstractMath {
 		constexpr Quaternion<decltype(T(1) / Ty(1))> operator/(const Quaternion<Ty>& other) const
 		{
 			using return_type = decltype(T(1) / Ty(1));
-			return_type w = this->w * other.w + this->x * other.x + this->y * other.y + this->z * other.z;
-			return_type x = this->x * other.w - this->w * other.x - this->y * other.z + this->z * other.y;
-			return_type y = this->y * other.w - this->w * other.y - this->z * other.x + this->x * other.z;
-			return_type z = this->z * other.w - this->w * other.z - this->x * other.y + this->y * other.x;
+			return_type w = this->data[3] * other.data[3] + this->data[0] * other.data[0] + this->data[1] * other.data[1] + this->data[2] * other.data[2];
+			return_type x = this->data[0] * other.data[3] - this->data[3] * other.data[0] - this->data[1] * other.data[2] + this->data[2] * other.data[1];
+			return_type y = this->data[1] * other.data[3] - this->data[3] * other.data[1] - this->data[2] * other.data[0] + this->data[0] * other.data[2];
+			return_type z = this->data[2] * other.data[3] - this->data[3] * other.data[2] - this->data[0] * other.data[1] + this->data[1] * other.data[0];
 
 			return Quaternion<return_type>(x, y, z, w);
 		}
@@ -78,59 +164,141 @@ namespace AbstractMath {
 		template<typename Ty>
 		constexpr void operator*=(const Quaternion<Ty>& other)
 		{
-			this->w = this->w * other.w - this->x * other.x - this->y * other.y - this->z * other.z;
-			this->x = this->w * other.x + this->x * other.w + this->y * other.z - this->z * other.y;
-			this->y = this->w * other.y + this->y * other.w + this->z * other.x - this->x * other.z;
-			this->z = this->w * other.z + this->z * other.w + this->x * other.y - this->y * other.x;
+			*this = Quaternion<T>(operator*(other)); //through a temporary, every component needs the old w
 		}
 
 		template<typename Ty>
 		constexpr void operator/=(const Quaternion<Ty>& other)
 		{
-			this->w = this->w * other.w + this->x * other.x + this->y * other.y + this->z * other.z;
-			this->x = this->x * other.w - this->w * other.x - this->y * other.z + this->z * other.y;
-			this->y = this->y * other.w - this->w * other.y - this->z * other.x + this->x * other.z;
-			this->z = this->z * other.w - this->w * other.z - this->x * other.y + this->y * other.x;
+			*this = Quaternion<T>(operator/(other));
 		}
 
 		template<typename Ty>
 		constexpr Vector<decltype(T(1)* Ty(1)), 3> rotate(const Vector<Ty, 3>& other) const
 		{
+			ABSTRACTMATH_PROFILE_COUNT(QuaternionRotate, 1);
 			Quaternion<decltype(T(1)* Ty(1))> pure = conjugate() * other * (*this);
-			return { pure.x, pure.y, pure.z };
+			return { pure.data[0], pure.data[1], pure.data[2] };
 		}
 
+		// roll, pitch and yaw through math::atan2/asin, the basis vectors below take the policy for their normalize
+		template<typename Precision = Precise>
 		constexpr Vector<T, 3> eulerAngles() const
 		{
-			return Vector<T, 3>{ std::atan2(2 * (this->w * this->x + this->y * this->z), 1 - 2 * (this->x * this->x + this->y * this->y)),
-				std::asin(2 * (this->w * this->y - this->x * this->z)),
-				std::atan2(2 * (this->w * this->z + this->x * this->y), 1 - 2 * (this->y * this->y + this->z * this->z)) };
+			return Vector<T, 3>{ getRoll<Precision>(), getPitch<Precision>(), getYaw<Precision>() };
+		}
+
+		template<typename Precision = Precise>
+		constexpr T getRoll() const { return math::atan2<Precision>(T(2) * (this->w * this->x + this->y * this->z), T(1) - T(2) * (this->x * this->x + this->y * this->y)); }
+		template<typename Precision = Precise>
+		constexpr T getPitch() const { return math::asin<Precision>(T(2) * (this->w * this->y - this->x * this->z)); }
+		template<typename Precision = Precise>
+		constexpr T getYaw() const { return math::atan2<Precision>(T(2) * (this->w * this->z + this->x * this->y), T(1) - T(2) * (this->y * this->y + this->z * this->z)); }
+
+		template<typename Precision = Precise>
+		constexpr Vector<T, 3> getRight()	const { Vector<T, 3> res = { this->x * this->x - this->y * this->y - this->z * this->z + this->w * this->w,  T(2) * this->x * this->y + T(2) * this->z * this->w, T(2) * this->x * this->z - T(2) * this->y * this->w }; return res.template normalized<Precision>(); }
+		template<typename Precision = Precise>
+		constexpr Vector<T, 3> getLeft()	const { Vector<T, 3> res = { -this->x * this->x + this->y * this->y + this->z * this->z - this->w * this->w, -T(2) * this->x * this->y - T(2) * this->z * this->w, T(2) * this->y * this->w - T(2) * this->x * this->z }; return res.template normalized<Precision>(); }
+		template<typename Precision = Precise>
+		constexpr Vector<T, 3> getUp()		const { Vector<T, 3> res = { T(2) * this->x * this->y - T(2) * this->z * this->w, -this->x * this->x + this->y * this->y - this->z * this->z + this->w * this->w,  T(2) * this->y * this->z + T(2) * this->x * this->w }; return res.template normalized<Precision>(); }
+		template<typename Precision = Precise>
+		constexpr Vector<T, 3> getDown()	const { Vector<T, 3> res = { T(2) * this->z * this->w - T(2) * this->x * this->y,  this->x * this->x - this->y * this->y + this->z * this->z - this->w * this->w, -T(2) * this->y * this->z - T(2) * this->x * this->w }; return res.template normalized<Precision>(); }
+		template<typename Precision = Precise>
+		constexpr Vector<T, 3> getForward() const { Vector<T, 3> res = { T(2) * this->x * this->z + T(2) * this->y * this->w, T(2) * this->y * this->z - T(2) * this->x * this->w, -this->x * this->x - this->y * this->y + this->z * this->z + this->w * this->w }; return res.template normalized<Precision>(); }
+		template<typename Precision = Precise>
+		constexpr Vector<T, 3> getBack()	const { Vector<T, 3> res = { -T(2) * this->x * this->z - T(2) * this->y * this->w, T(2) * this->x * this->w - T(2) * this->y * this->z,  this->x * this->x + this->y * this->y - this->z * this->z - this->w * this->w }; return res.template normalized<Precision>(); }
+
+		// reads data[] rather than x/y/z/w so constant expressions stay on the union's active member
+		constexpr Matrix<T, 4, 4> toRotationMatrix() const
+		{
+			const T x = this->data[0], y = this->data[1], z = this->data[2], w = this->data[3];
+
+			return Matrix<T, 4, 4>{
+				T(1) - T(2) * (y * y + z * z), T(2) * (x * y - w * z),		  T(2) * (x * z + w * y),		 T(0),
+				T(2) * (x * y + w * z),		   T(1) - T(2) * (x * x + z * z), T(2) * (y * z - w * x),		 T(0),
+				T(2) * (x * z - w * y),		   T(2) * (y * z + w * x),		  T(1) - T(2) * (x * x + y * y), T(0),
+				T(0),						   T(0),						  T(0),							 T(1)
+			};
 		}
 
-		constexpr T getRoll() const { return std::atan2(2 * (this->w * this->x + this->y * this->z), 1 - 2 * (this->x * this->x + this->y * this->y)); }
-		constexpr T getPitch() const { return std::asin(2 * (this->w * this->y - this->x * this->z)); }
-		constexpr T getYaw() const { return std::atan2(2 * (this->w * this->z + this->x * this->y), 1 - 2 * (this->y * this->y + this->z * this->z)); }
+		// interpolation between unit quaternions, all three take the shorter arc (q and -q are the same rotation)
+
+		// normalized component-wise blend, cheapest of the three but the rotation speed is not constant over the arc
+		template<typename Fy>
+		constexpr Quaternion<T> nlerp(const Quaternion<T>& other, Fy amount) const
+		{
+			static_assert(std::is_floating_point<T>::value && std::is_floating_point<Fy>::value, "Interpolation requires floating point types!");
+			ABSTRACTMATH_PROFILE_COUNT(QuaternionBlend, 1);
+
+			T weight = T(amount);
+			T otherWeight = this->dot(other) < T(0) ? -weight : weight;
+			Quaternion<T> result;
+
+			for (size_t i = 0; i < 4; i++)
+			{
+				result.data[i] = (T(1) - weight) * this->data[i] + otherWeight * other.data[i];
+			}
 
-		constexpr Vector<T, 3> getRight()	const { Vector<T, 3> res = { this->x * this->x - this->y * this->y - this->z * this->z + this->w * this->w,  2.0 * this->x * this->y + 2.0 * this->z * this->w, 2.0 * this->x * this->z - 2.0 * this->y * this->w }; return res.normalized(); }
-		constexpr Vector<T, 3> getLeft()	const { Vector<T, 3> res = { -this->x * this->x + this->y * this->y + this->z * this->z - this->w * this->w, -2.0 * this->x * this->y - 2.0 * this->z * this->w, 2.0 * this->y * this->w - 2.0 * this->x * this->z }; return res.normalized(); }
-		constexpr Vector<T, 3> getUp()		const { Vector<T, 3> res = { 2.0 * this->x * this->y - 2.0 * this->z * this->w, -this->x * this->x + this->y * this->y - this->z * this->z + this->w * this->w,  2.0 * this->y * this->z + 2.0 * this->x * this->w }; return res.normalized(); }
-		constexpr Vector<T, 3> getDown()	const { Vector<T, 3> res = { 2.0 * this->z * this->w - 2.0 * this->x * this->y,  this->x * this->x - this->y * this->y + this->z * this->z - this->w * this->w, -2.0 * this->y * this->z - 2.0 * this->x * this->w }; return res.normalized(); }
-		constexpr Vector<T, 3> getForward() const { Vector<T, 3> res = { 2.0 * this->x * this->z + 2.0 * this->y * this->w, 2.0 * this->y * this->z - 2.0 * this->x * this->w, -this->x * this->x - this->y * this->y + this->z * this->z + this->w * this->w }; return res.normalized(); }
-		constexpr Vector<T, 3> getBack()	const { Vector<T, 3> res = { -2.0 * this->x * this->z - 2.0 * this->y * this->w, 2.0 * this->x * this->w - 2.0 * this->y * this->z,  this->x * this->x + this->y * this->y - this->z * this->z - this->w * this->w }; return res.normalized(); }
+			return result.normalized();
+		}
 
-		constexpr Matrix<T, 4, 4> toRotationMatrix()
+		// constant angular velocity, falls back to nlerp once the rotations are too close for sin(angle) to divide by
+		template<typename Fy>
+		Quaternion<T> slerp(const Quaternion<T>& other, Fy amount) const
 		{
-			Matrix<T, 4, 4> result;
+			static_assert(std::is_floating_point<T>::value && std::is_floating_point<Fy>::value, "Interpolation requires floating point types!");
 
-			result[0][0] = T(1) - T(2) * (this->y * this->y + this->z * this->z); result[1][0] = T(2) * (this->x * this->y - this->w * this->z);		result[2][0] = T(2) * (this->x * this->z + this->w * this->y);		   result[3][0] = T(0);
-			result[0][1] = T(2) * (this->x * this->y + this->w * this->z);		  result[1][1] = T(1) - T(2) * (this->x * this->x + this->z * this->z); result[2][1] = T(2) * (this->y * this->z - this->w * this->x);		   result[3][1] = T(0);
-			result[0][2] = T(2) * (this->x * this->z - this->w * this->y);		  result[1][2] = T(2) * (this->y * this->z + this->w * this->x);		result[2][2] = T(1) - T(2) * (this->x * this->x + this->y * this->y); result[3][2] = T(0);
-			
-			result[0][3] = T(0); result[1][3] = T(0); result[2][3] = T(0); result[3][3] = T(1);
+			T cosAngle = this->dot(other);
+			T sign = cosAngle < T(0) ? T(-1) : T(1);
+			cosAngle *= sign;
+
+			if (cosAngle > T(0.9995))
+			{
+				return nlerp(other, amount);
+			}
+
+			ABSTRACTMATH_PROFILE_COUNT(QuaternionBlend, 1);
+			T angle = std::acos(cosAngle);
+			T invSin = T(1) / std::sin(angle);
+			T weight = std::sin((T(1) - T(amount)) * angle) * invSin;
+			T otherWeight = std::sin(T(amount) * angle) * invSin * sign;
+			Quaternion<T> result;
+
+			for (size_t i = 0; i < 4; i++)
+			{
+				result.data[i] = weight * this->data[i] + otherWeight * other.data[i];
+			}
 
 			return result;
 		}
 
+		// slerp with the weights from detail::slerpWeight, no trig or division, components within 4e-5 of slerp()
+		// the result is not renormalized, its length is off from one by about as much
+		template<typename Fy>
+		constexpr Quaternion<T> fastSlerp(const Quaternion<T>& other, Fy amount) const
+		{
+			static_assert(std::is_floating_point<T>::value && std::is_floating_point<Fy>::value, "Interpolation requires floating point types!");
+			ABSTRACTMATH_PROFILE_COUNT(QuaternionBlend, 1);
+
+			T cosAngle = this->dot(other);
+			T sign = cosAngle < T(0) ? T(-1) : T(1);
+			T cosAngleMinusOne = cosAngle * sign - T(1);
+			T weight = detail::slerpWeight(T(1) - T(amount), cosAngleMinusOne);
+			T otherWeight = detail::slerpWeight(T(amount), cosAngleMinusOne) * sign;
+			Quaternion<T> result;
+
+			for (size_t i = 0; i < 4; i++)
+			{
+				result.data[i] = weight * this->data[i] + otherWeight * other.data[i];
+			}
+
+			return result;
+		}
+
+		// Vector::lerp neither renormalizes nor picks the shorter arc, use nlerp, slerp or fastSlerp
+		template<typename Ty, typename Fy>
+		constexpr Vector<decltype(T(0) + Ty(0)), 4> lerp(const Vector<Ty, 4>& other, Fy amount) = delete;
+
 		template<typename Ty>
 		constexpr Quaternion<decltype(T(0) + Ty(0))> operator+(const Ty& other) = delete;
 		template<typename Ty>
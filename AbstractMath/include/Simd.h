@@ -0,0 +1,291 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <type_traits>
+
+// compile-time instruction set selection, define ABSTRACTMATH_NO_SIMD to force the scalar paths
+#if !defined(ABSTRACTMATH_NO_SIMD)
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define ABSTRACTMATH_SSE 1
+	#endif
+
+	#if defined(__SSE4_1__) || defined(__AVX__)
+		#define ABSTRACTMATH_SSE41 1
+	#endif
+
+	#if defined(__SSE4_2__) || defined(__AVX__)
+		#define ABSTRACTMATH_SSE42 1
+	#endif
+
+	#if defined(__AVX2__)
+		#define ABSTRACTMATH_AVX2 1
+	#endif
+
+	#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+		#define ABSTRACTMATH_FMA 1
+	#endif
+
+	#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+		#define ABSTRACTMATH_F16C 1
+	#endif
+#endif
+
+#if defined(ABSTRACTMATH_SSE)
+	#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+	#define ABSTRACTMATH_RESTRICT __restrict
+#else
+	#define ABSTRACTMATH_RESTRICT __restrict__
+#endif
+
+namespace AbstractMath {
+
+	static constexpr size_t SIMD_ALIGNMENT = 32; //widest register we target (AVX2)
+
+	namespace detail {
+
+		// true while the compiler evaluates a constant expression, constexpr functions use it to skip intrinsics
+		// and libm calls (neither can run at compile time) and take their portable scalar path instead
+		constexpr bool isConstantEvaluated() noexcept
+		{
+#if defined(__cpp_lib_is_constant_evaluated)
+			return std::is_constant_evaluated();
+#elif (defined(__GNUC__) && __GNUC__ >= 9) || (defined(__clang_major__) && __clang_major__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+			return __builtin_is_constant_evaluated();
+#else
+			return false; //no way to tell, always take the runtime path
+#endif
+		}
+	}
+
+	inline void* alignedAlloc(size_t size, size_t alignment = SIMD_ALIGNMENT)
+	{
+		size = (size + alignment - 1) / alignment * alignment; //aligned_alloc wants a multiple of the alignment
+
+		if (size == 0)
+		{
+			return nullptr;
+		}
+
+#if defined(_MSC_VER)
+		return _aligned_malloc(size, alignment);
+#else
+		return std::aligned_alloc(alignment, size);
+#endif
+	}
+
+	inline void alignedFree(void* ptr)
+	{
+#if defined(_MSC_VER)
+		_aligned_free(ptr);
+#else
+		std::free(ptr);
+#endif
+	}
+
+	namespace detail {
+
+#if defined(ABSTRACTMATH_SSE)
+		inline __m128 multiplyAdd(__m128 a, __m128 b, __m128 c)
+		{
+#if defined(ABSTRACTMATH_FMA)
+			return _mm_fmadd_ps(a, b, c);
+#else
+			return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+		}
+
+#if defined(ABSTRACTMATH_AVX2)
+		inline __m256 multiplyAdd(__m256 a, __m256 b, __m256 c)
+		{
+#if defined(ABSTRACTMATH_FMA)
+			return _mm256_fmadd_ps(a, b, c);
+#else
+			return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+		}
+#endif
+
+		// column-major 4x4, each result column is four broadcast multiply-adds over the left columns
+		// without FMA this matches the scalar loop bit for bit (same summation order starting from zero),
+		// with FMA each column differs by at most one rounding per step
+		inline void multiplyMatrix4f(const float* left, const float* right, float* dest)
+		{
+			__m128 col0 = _mm_loadu_ps(left + 0);
+			__m128 col1 = _mm_loadu_ps(left + 4);
+			__m128 col2 = _mm_loadu_ps(left + 8);
+			__m128 col3 = _mm_loadu_ps(left + 12);
+
+			for (size_t i = 0; i < 4; i++)
+			{
+				const float* r = right + i * 4;
+				__m128 sum = multiplyAdd(col0, _mm_set1_ps(r[0]), _mm_setzero_ps());
+				sum = multiplyAdd(col1, _mm_set1_ps(r[1]), sum);
+				sum = multiplyAdd(col2, _mm_set1_ps(r[2]), sum);
+				sum = multiplyAdd(col3, _mm_set1_ps(r[3]), sum);
+				_mm_storeu_ps(dest + i * 4, sum);
+			}
+		}
+
+		inline void multiplyMatrix4fVector4f(const float* matrix, const float* vector, float* dest)
+		{
+			__m128 sum = multiplyAdd(_mm_loadu_ps(matrix + 0), _mm_set1_ps(vector[0]), _mm_setzero_ps());
+			sum = multiplyAdd(_mm_loadu_ps(matrix + 4), _mm_set1_ps(vector[1]), sum);
+			sum = multiplyAdd(_mm_loadu_ps(matrix + 8), _mm_set1_ps(vector[2]), sum);
+			sum = multiplyAdd(_mm_loadu_ps(matrix + 12), _mm_set1_ps(vector[3]), sum);
+			_mm_storeu_ps(dest, sum);
+		}
+
+		inline void multiplyVector4f(const float* left, const float* right, float* dest)
+		{
+			_mm_storeu_ps(dest, _mm_mul_ps(_mm_loadu_ps(left), _mm_loadu_ps(right)));
+		}
+
+		// the squared length summed into every lane, then the rsqrt estimate plus one newton step
+		inline void normalizeVector4f(const float* src, float* dest)
+		{
+			__m128 v = _mm_loadu_ps(src);
+			__m128 sum = _mm_mul_ps(v, v);
+			sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1)));
+			sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+
+			__m128 estimate = _mm_rsqrt_ps(sum);
+			__m128 halfSum = _mm_mul_ps(_mm_set1_ps(0.5f), sum);
+			__m128 scale = _mm_mul_ps(estimate, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(halfSum, _mm_mul_ps(estimate, estimate))));
+			_mm_storeu_ps(dest, _mm_mul_ps(v, scale));
+		}
+
+		// hamilton product on { x, y, z, w }, the terms are summed in a different order than the scalar
+		// version so results may differ by a couple of ulp
+		inline void multiplyQuaternionf(const float* left, const float* right, float* dest)
+		{
+			const __m128 signW = _mm_castsi128_ps(_mm_set_epi32(int(0x80000000), 0, 0, 0));
+			__m128 l = _mm_loadu_ps(left);
+			__m128 r = _mm_loadu_ps(right);
+
+			__m128 a = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 2, 1, 0)), _mm_shuffle_ps(r, r, _MM_SHUFFLE(0, 3, 3, 3)));
+			__m128 b = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 0, 2, 1)), _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 1, 0, 2)));
+			__m128 c = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 1, 0, 2)), _mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 0, 2, 1)));
+
+			__m128 result = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r);
+			result = _mm_add_ps(result, _mm_xor_ps(a, signW));
+			result = _mm_add_ps(result, _mm_xor_ps(b, signW));
+			result = _mm_sub_ps(result, c);
+
+			_mm_storeu_ps(dest, result);
+		}
+
+		template<int X, int Y, int Z, int W>
+		inline __m128 swizzle(__m128 v)
+		{
+			return _mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(v), _MM_SHUFFLE(W, Z, Y, X)));
+		}
+
+		template<int X, int Y, int Z, int W>
+		inline __m128 shuffle(__m128 a, __m128 b)
+		{
+			return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X));
+		}
+
+#if defined(ABSTRACTMATH_AVX2)
+		// rows[r] holds element r of eight objects, afterwards rows[k] holds the eight elements of object k
+		inline void transpose8x8(__m256* rows)
+		{
+			__m256 t[8], s[8];
+
+			for (size_t i = 0; i < 4; i++)
+			{
+				t[2 * i + 0] = _mm256_unpacklo_ps(rows[2 * i], rows[2 * i + 1]);
+				t[2 * i + 1] = _mm256_unpackhi_ps(rows[2 * i], rows[2 * i + 1]);
+			}
+
+			for (size_t i = 0; i < 2; i++)
+			{
+				s[4 * i + 0] = _mm256_shuffle_ps(t[4 * i + 0], t[4 * i + 2], _MM_SHUFFLE(1, 0, 1, 0));
+				s[4 * i + 1] = _mm256_shuffle_ps(t[4 * i + 0], t[4 * i + 2], _MM_SHUFFLE(3, 2, 3, 2));
+				s[4 * i + 2] = _mm256_shuffle_ps(t[4 * i + 1], t[4 * i + 3], _MM_SHUFFLE(1, 0, 1, 0));
+				s[4 * i + 3] = _mm256_shuffle_ps(t[4 * i + 1], t[4 * i + 3], _MM_SHUFFLE(3, 2, 3, 2));
+			}
+
+			for (size_t i = 0; i < 4; i++)
+			{
+				rows[i] = _mm256_permute2f128_ps(s[i], s[i + 4], 0x20);
+				rows[i + 4] = _mm256_permute2f128_ps(s[i], s[i + 4], 0x31);
+			}
+		}
+#endif
+
+		// 2x2 blocks packed as { m00, m01, m10, m11 }: a * b, adj(a) * b and a * adj(b)
+		inline __m128 multiply2x2(__m128 a, __m128 b)
+		{
+			return _mm_add_ps(_mm_mul_ps(a, swizzle<0, 3, 0, 3>(b)), _mm_mul_ps(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+		}
+
+		inline __m128 adjugateMultiply2x2(__m128 a, __m128 b)
+		{
+			return _mm_sub_ps(_mm_mul_ps(swizzle<3, 3, 0, 0>(a), b), _mm_mul_ps(swizzle<1, 1, 2, 2>(a), swizzle<2, 3, 0, 1>(b)));
+		}
+
+		inline __m128 multiplyAdjugate2x2(__m128 a, __m128 b)
+		{
+			return _mm_sub_ps(_mm_mul_ps(a, swizzle<3, 0, 3, 0>(b)), _mm_mul_ps(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+		}
+
+		// block-wise 4x4 inverse (2x2 sub matrices and their adjugates), returns the determinant
+		// the layout does not matter since inverse(transpose(M)) == transpose(inverse(M))
+		inline float invertMatrix4f(const float* src, float* dest)
+		{
+			__m128 col0 = _mm_loadu_ps(src + 0);
+			__m128 col1 = _mm_loadu_ps(src + 4);
+			__m128 col2 = _mm_loadu_ps(src + 8);
+			__m128 col3 = _mm_loadu_ps(src + 12);
+
+			__m128 a = _mm_movelh_ps(col0, col1);
+			__m128 b = _mm_movehl_ps(col1, col0);
+			__m128 c = _mm_movelh_ps(col2, col3);
+			__m128 d = _mm_movehl_ps(col3, col2);
+
+			// ( |A|, |B|, |C|, |D| )
+			__m128 subDeterminants = _mm_sub_ps(
+				_mm_mul_ps(shuffle<0, 2, 0, 2>(col0, col2), shuffle<1, 3, 1, 3>(col1, col3)),
+				_mm_mul_ps(shuffle<1, 3, 1, 3>(col0, col2), shuffle<0, 2, 0, 2>(col1, col3)));
+
+			__m128 detA = swizzle<0, 0, 0, 0>(subDeterminants);
+			__m128 detB = swizzle<1, 1, 1, 1>(subDeterminants);
+			__m128 detC = swizzle<2, 2, 2, 2>(subDeterminants);
+			__m128 detD = swizzle<3, 3, 3, 3>(subDeterminants);
+
+			__m128 adjDC = adjugateMultiply2x2(d, c);
+			__m128 adjAB = adjugateMultiply2x2(a, b);
+
+			__m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), multiply2x2(b, adjDC));
+			__m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), multiply2x2(c, adjAB));
+			__m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), multiplyAdjugate2x2(d, adjAB));
+			__m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), multiplyAdjugate2x2(a, adjDC));
+
+			// |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+			__m128 trace = _mm_mul_ps(adjAB, swizzle<0, 2, 1, 3>(adjDC));
+			trace = _mm_add_ps(trace, swizzle<2, 3, 0, 1>(trace));
+			trace = _mm_add_ps(trace, swizzle<1, 0, 3, 2>(trace));
+
+			__m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), trace);
+			__m128 invDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+
+			x = _mm_mul_ps(x, invDet);
+			y = _mm_mul_ps(y, invDet);
+			z = _mm_mul_ps(z, invDet);
+			w = _mm_mul_ps(w, invDet);
+
+			_mm_storeu_ps(dest + 0, shuffle<3, 1, 3, 1>(x, y));
+			_mm_storeu_ps(dest + 4, shuffle<2, 0, 2, 0>(x, y));
+			_mm_storeu_ps(dest + 8, shuffle<3, 1, 3, 1>(z, w));
+			_mm_storeu_ps(dest + 12, shuffle<2, 0, 2, 0>(z, w));
+
+			return _mm_cvtss_f32(det);
+		}
+#endif
+	}
+}
\ No newline at end of file
@@ -0,0 +1,850 @@
+#pragma once
+
+#include <cmath>
+#include <atomic>
+#include <type_traits>
+#include <assert.h>
+
+#include "Simd.h"
+#include "Profiling.h"
+#include "MathFunctions.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "Parallel.h"
+
+namespace AbstractMath {
+
+	// direct solvers for small fixed-size systems, all loop bounds are compile-time so the compiler unrolls them, the
+	// factorization is kept so one decomposition serves several right-hand sides
+	// above 4x4 they beat inverted() followed by a product (about 1.7x for 6x6, 4x for 12x12) and round less, up to
+	// 4x4 the closed-form inverse is cheaper for a single right-hand side, many systems at once go to solveLU/solveCholesky
+
+	// partial pivoting LU, any square matrix that is not singular
+	template<typename T, size_t N>
+	class LUDecomposition
+	{
+		static_assert(std::is_floating_point<T>::value, "Decompositions require a floating point type!");
+
+	public:
+		constexpr explicit LUDecomposition(const Matrix<T, N, N>& matrix) : lu(matrix)
+		{
+			ABSTRACTMATH_PROFILE_COUNT(LinearSolve, 1);
+
+			for (size_t i = 0; i < N; i++)
+			{
+				pivots[i] = i;
+			}
+
+			for (size_t k = 0; k < N; k++)
+			{
+				size_t pivot = k;
+				T largest = magnitude(lu.data[k * N + k]);
+
+				for (size_t row = k + 1; row < N; row++)
+				{
+					if (magnitude(lu.data[k * N + row]) > largest)
+					{
+						largest = magnitude(lu.data[k * N + row]);
+						pivot = row;
+					}
+				}
+
+				if (largest == T(0))
+				{
+					invertible = false;
+					continue;
+				}
+
+				if (pivot != k)
+				{
+					for (size_t col = 0; col < N; col++)
+					{
+						T temp = lu.data[col * N + k];
+						lu.data[col * N + k] = lu.data[col * N + pivot];
+						lu.data[col * N + pivot] = temp;
+					}
+
+					size_t tempIndex = pivots[k];
+					pivots[k] = pivots[pivot];
+					pivots[pivot] = tempIndex;
+					oddSwaps = !oddSwaps;
+				}
+
+				T invPivot = T(1) / lu.data[k * N + k];
+
+				for (size_t row = k + 1; row < N; row++)
+				{
+					lu.data[k * N + row] *= invPivot;
+				}
+
+				for (size_t col = k + 1; col < N; col++)
+				{
+					T factor = lu.data[col * N + k];
+
+					for (size_t row = k + 1; row < N; row++)
+					{
+						lu.data[col * N + row] -= lu.data[k * N + row] * factor;
+					}
+				}
+			}
+		}
+
+		constexpr bool isInvertible() const { return invertible; }
+
+		constexpr T determinant() const
+		{
+			T det = oddSwaps ? T(-1) : T(1);
+
+			for (size_t i = 0; i < N; i++)
+			{
+				det *= lu.data[i * N + i];
+			}
+
+			return det;
+		}
+
+		// x with matrix * x = b, only meaningful if isInvertible()
+		constexpr Vector<T, N> solve(const Vector<T, N>& b) const
+		{
+			assert(invertible);
+			Vector<T, N> x;
+
+			for (size_t row = 0; row < N; row++)
+			{
+				x.data[row] = b.data[pivots[row]];
+
+				for (size_t k = 0; k < row; k++)
+				{
+					x.data[row] -= lu.data[k * N + row] * x.data[k];
+				}
+			}
+
+			for (size_t row = N; row-- > 0;)
+			{
+				for (size_t k = row + 1; k < N; k++)
+				{
+					x.data[row] -= lu.data[k * N + row] * x.data[k];
+				}
+
+				x.data[row] /= lu.data[row * N + row];
+			}
+
+			return x;
+		}
+
+		// every column of b solved at once
+		template<size_t Cols_C>
+		constexpr Matrix<T, N, Cols_C> solve(const Matrix<T, N, Cols_C>& b) const
+		{
+			Matrix<T, N, Cols_C> x;
+
+			for (size_t col = 0; col < Cols_C; col++)
+			{
+				Vector<T, N> column;
+
+				for (size_t row = 0; row < N; row++)
+				{
+					column.data[row] = b.data[col * N + row];
+				}
+
+				column = solve(column);
+
+				for (size_t row = 0; row < N; row++)
+				{
+					x.data[col * N + row] = column.data[row];
+				}
+			}
+
+			return x;
+		}
+
+	private:
+		static constexpr T magnitude(T value) { return value < T(0) ? -value : value; }
+
+		Matrix<T, N, N> lu; //unit lower and upper triangle in one, rows permuted by pivots
+		size_t pivots[N] = {}; //pivots[row] is the source row of each row
+		bool invertible = true;
+		bool oddSwaps = false;
+	};
+
+	// A = L * L^T for symmetric positive definite matrices (effective mass, stiffness and normal equations), about half
+	// the work of LU and no pivoting, only the lower triangle of the matrix is read
+	template<typename T, size_t N>
+	class CholeskyDecomposition
+	{
+		static_assert(std::is_floating_point<T>::value, "Decompositions require a floating point type!");
+
+	public:
+		constexpr explicit CholeskyDecomposition(const Matrix<T, N, N>& matrix)
+		{
+			ABSTRACTMATH_PROFILE_COUNT(LinearSolve, 1);
+
+			for (size_t j = 0; j < N; j++)
+			{
+				T diagonal = matrix.data[j * N + j];
+
+				for (size_t k = 0; k < j; k++)
+				{
+					diagonal -= l.data[k * N + j] * l.data[k * N + j];
+				}
+
+				if (!(diagonal > T(0)))
+				{
+					positiveDefinite = false;
+					return;
+				}
+
+				T root = math::sqrt(diagonal);
+				l.data[j * N + j] = root;
+				inverseDiagonal[j] = T(1) / root;
+
+				for (size_t i = j + 1; i < N; i++)
+				{
+					T sum = matrix.data[j * N + i];
+
+					for (size_t k = 0; k < j; k++)
+					{
+						sum -= l.data[k * N + i] * l.data[k * N + j];
+					}
+
+					l.data[j * N + i] = sum * inverseDiagonal[j];
+				}
+			}
+		}
+
+		constexpr bool isPositiveDefinite() const { return positiveDefinite; }
+
+		// L, zero above the diagonal
+		constexpr const Matrix<T, N, N>& lower() const { return l; }
+
+		constexpr T determinant() const
+		{
+			T det = T(1);
+
+			for (size_t i = 0; i < N; i++)
+			{
+				det *= l.data[i * N + i];
+			}
+
+			return det * det;
+		}
+
+		constexpr Vector<T, N> solve(const Vector<T, N>& b) const
+		{
+			assert(positiveDefinite);
+			Vector<T, N> x;
+
+			for (size_t i = 0; i < N; i++)
+			{
+				T sum = b.data[i];
+
+				for (size_t k = 0; k < i; k++)
+				{
+					sum -= l.data[k * N + i] * x.data[k];
+				}
+
+				x.data[i] = sum * inverseDiagonal[i];
+			}
+
+			for (size_t i = N; i-- > 0;)
+			{
+				T sum = x.data[i];
+
+				for (size_t k = i + 1; k < N; k++)
+				{
+					sum -= l.data[i * N + k] * x.data[k];
+				}
+
+				x.data[i] = sum * inverseDiagonal[i];
+			}
+
+			return x;
+		}
+
+		template<size_t Cols_C>
+		constexpr Matrix<T, N, Cols_C> solve(const Matrix<T, N, Cols_C>& b) const
+		{
+			Matrix<T, N, Cols_C> x;
+
+			for (size_t col = 0; col < Cols_C; col++)
+			{
+				Vector<T, N> column;
+
+				for (size_t row = 0; row < N; row++)
+				{
+					column.data[row] = b.data[col * N + row];
+				}
+
+				column = solve(column);
+
+				for (size_t row = 0; row < N; row++)
+				{
+					x.data[col * N + row] = column.data[row];
+				}
+			}
+
+			return x;
+		}
+
+	private:
+		Matrix<T, N, N> l;
+		T inverseDiagonal[N] = {};
+		bool positiveDefinite = true;
+	};
+
+	// Householder QR of a Rows_C x Cols_C matrix with Rows_C >= Cols_C, solve() is the least squares solution of an
+	// overdetermined system (curve and plane fits) without forming the worse conditioned normal equations
+	template<typename T, size_t Rows_C, size_t Cols_C>
+	class QRDecomposition
+	{
+		static_assert(std::is_floating_point<T>::value && Rows_C >= Cols_C, "QR requires a floating point type and at least as many rows as columns!");
+
+	public:
+		constexpr explicit QRDecomposition(const Matrix<T, Rows_C, Cols_C>& matrix) : qr(matrix)
+		{
+			ABSTRACTMATH_PROFILE_COUNT(LinearSolve, 1);
+
+			for (size_t k = 0; k < Cols_C; k++)
+			{
+				T norm = T(0);
+
+				for (size_t i = k; i < Rows_C; i++)
+				{
+					norm += qr.data[k * Rows_C + i] * qr.data[k * Rows_C + i];
+				}
+
+				norm = math::sqrt(norm);
+
+				if (norm != T(0))
+				{
+					//the reflection that maps the column onto -sign * norm * e_k, away from the column to avoid cancellation
+					if (qr.data[k * Rows_C + k] < T(0))
+					{
+						norm = -norm;
+					}
+
+					for (size_t i = k; i < Rows_C; i++)
+					{
+						qr.data[k * Rows_C + i] /= norm;
+					}
+
+					qr.data[k * Rows_C + k] += T(1);
+
+					for (size_t j = k + 1; j < Cols_C; j++)
+					{
+						T sum = T(0);
+
+						for (size_t i = k; i < Rows_C; i++)
+						{
+							sum += qr.data[k * Rows_C + i] * qr.data[j * Rows_C + i];
+						}
+
+						sum = -sum / qr.data[k * Rows_C + k];
+
+						for (size_t i = k; i < Rows_C; i++)
+						{
+							qr.data[j * Rows_C + i] += sum * qr.data[k * Rows_C + i];
+						}
+					}
+				}
+
+				rDiagonal[k] = -norm;
+			}
+		}
+
+		// false when a column is a combination of the others (exactly), the least squares solution is not unique then
+		constexpr bool isFullRank() const
+		{
+			for (size_t k = 0; k < Cols_C; k++)
+			{
+				if (rDiagonal[k] == T(0))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		// x minimizing |matrix * x - b|, the exact solution for square systems
+		constexpr Vector<T, Cols_C> solve(const Vector<T, Rows_C>& b) const
+		{
+			assert(isFullRank());
+			Vector<T, Rows_C> y = b;
+
+			//y = Q^T * b
+			for (size_t k = 0; k < Cols_C; k++)
+			{
+				T sum = T(0);
+
+				for (size_t i = k; i < Rows_C; i++)
+				{
+					sum += qr.data[k * Rows_C + i] * y.data[i];
+				}
+
+				sum = -sum / qr.data[k * Rows_C + k];
+
+				for (size_t i = k; i < Rows_C; i++)
+				{
+					y.data[i] += sum * qr.data[k * Rows_C + i];
+				}
+			}
+
+			Vector<T, Cols_C> x;
+
+			for (size_t k = Cols_C; k-- > 0;)
+			{
+				T sum = y.data[k];
+
+				for (size_t j = k + 1; j < Cols_C; j++)
+				{
+					sum -= qr.data[j * Rows_C + k] * x.data[j];
+				}
+
+				x.data[k] = sum / rDiagonal[k];
+			}
+
+			return x;
+		}
+
+		// the upper triangular factor
+		constexpr Matrix<T, Cols_C, Cols_C> r() const
+		{
+			Matrix<T, Cols_C, Cols_C> result;
+
+			for (size_t col = 0; col < Cols_C; col++)
+			{
+				for (size_t row = 0; row < col; row++)
+				{
+					result.data[col * Cols_C + row] = qr.data[col * Rows_C + row];
+				}
+
+				result.data[col * Cols_C + col] = rDiagonal[col];
+			}
+
+			return result;
+		}
+
+	private:
+		Matrix<T, Rows_C, Cols_C> qr; //R above the diagonal, the Householder vectors from the diagonal down
+		T rDiagonal[Cols_C] = {};
+	};
+
+	template<typename T, size_t N>
+	constexpr Vector<T, N> solve(const Matrix<T, N, N>& a, const Vector<T, N>& b)
+	{
+		return LUDecomposition<T, N>(a).solve(b);
+	}
+
+	template<typename T, size_t Rows_C, size_t Cols_C>
+	constexpr Vector<T, Cols_C> leastSquares(const Matrix<T, Rows_C, Cols_C>& a, const Vector<T, Rows_C>& b)
+	{
+		return QRDecomposition<T, Rows_C, Cols_C>(a).solve(b);
+	}
+
+	namespace detail {
+
+		// set bits of a movemask, popcnt is not implied by the SIMD flags
+		inline size_t countBits(int bits)
+		{
+			size_t result = 0;
+
+			for (; bits != 0; bits &= bits - 1)
+			{
+				result++;
+			}
+
+			return result;
+		}
+
+		// the lane operations of the batched kernels (here and in Decomposition3.h), one system per lane: SolvePack<T, 1>
+		// is plain scalar code, the SIMD packs hold 8 floats or 4 doubles (4 floats without AVX2), masks are all ones
+		// where a lane failed
+		template<typename T, size_t Width_C>
+		struct SolvePack
+		{
+			using Register = T;
+			using Mask = bool;
+			static const size_t WIDTH = 1;
+
+			static Register set(T value) { return value; }
+			static Register gather(const T* src, size_t) { return *src; }
+			static void scatter(T* dst, size_t, Register value) { *dst = value; }
+			static Register add(Register a, Register b) { return a + b; }
+			static Register sub(Register a, Register b) { return a - b; }
+			static Register mul(Register a, Register b) { return a * b; }
+			static Register negMulAdd(Register a, Register b, Register c) { return c - a * b; }
+			static Register reciprocal(Register a) { return T(1) / a; }
+			static Register sqrt(Register a) { return std::sqrt(a); }
+			static Register abs(Register a) { return a < T(0) ? -a : a; }
+			static Register copySign(Register magnitude, Register sign) { return std::copysign(magnitude, sign); }
+			static Mask greater(Register a, Register b) { return a > b; }
+			static Mask notPositive(Register a) { return !(a > T(0)); }
+			static Mask either(Mask a, Mask b) { return a || b; }
+			static Register select(Mask mask, Register a, Register b) { return mask ? a : b; }
+			static size_t count(Mask mask) { return mask ? 1 : 0; }
+		};
+
+#if defined(ABSTRACTMATH_AVX2)
+		template<>
+		struct SolvePack<float, 8>
+		{
+			using Register = __m256;
+			using Mask = __m256;
+			static const size_t WIDTH = 8;
+
+			static Register set(float value) { return _mm256_set1_ps(value); }
+
+			static Register gather(const float* src, size_t stride)
+			{
+				return _mm256_setr_ps(src[0], src[stride], src[2 * stride], src[3 * stride], src[4 * stride], src[5 * stride], src[6 * stride], src[7 * stride]);
+			}
+
+			static void scatter(float* dst, size_t stride, Register value)
+			{
+				alignas(32) float lanes[8];
+				_mm256_store_ps(lanes, value);
+
+				for (size_t i = 0; i < 8; i++)
+				{
+					dst[i * stride] = lanes[i];
+				}
+			}
+
+			static Register add(Register a, Register b) { return _mm256_add_ps(a, b); }
+			static Register sub(Register a, Register b) { return _mm256_sub_ps(a, b); }
+			static Register mul(Register a, Register b) { return _mm256_mul_ps(a, b); }
+
+			static Register negMulAdd(Register a, Register b, Register c)
+			{
+#if defined(ABSTRACTMATH_FMA)
+				return _mm256_fnmadd_ps(a, b, c);
+#else
+				return _mm256_sub_ps(c, _mm256_mul_ps(a, b));
+#endif
+			}
+
+			static Register reciprocal(Register a) { return _mm256_div_ps(_mm256_set1_ps(1.0f), a); }
+			static Register sqrt(Register a) { return _mm256_sqrt_ps(a); }
+			static Register abs(Register a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+
+			static Register copySign(Register magnitude, Register sign)
+			{
+				const Register signBit = _mm256_set1_ps(-0.0f);
+				return _mm256_or_ps(_mm256_and_ps(signBit, sign), _mm256_andnot_ps(signBit, magnitude));
+			}
+
+			static Mask greater(Register a, Register b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+			static Mask notPositive(Register a) { return _mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_NGT_UQ); }
+			static Mask either(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+			static Register select(Mask mask, Register a, Register b) { return _mm256_blendv_ps(b, a, mask); }
+			static size_t count(Mask mask) { return countBits(_mm256_movemask_ps(mask)); }
+		};
+
+		template<>
+		struct SolvePack<double, 4>
+		{
+			using Register = __m256d;
+			using Mask = __m256d;
+			static const size_t WIDTH = 4;
+
+			static Register set(double value) { return _mm256_set1_pd(value); }
+			static Register gather(const double* src, size_t stride) { return _mm256_setr_pd(src[0], src[stride], src[2 * stride], src[3 * stride]); }
+
+			static void scatter(double* dst, size_t stride, Register value)
+			{
+				alignas(32) double lanes[4];
+				_mm256_store_pd(lanes, value);
+
+				for (size_t i = 0; i < 4; i++)
+				{
+					dst[i * stride] = lanes[i];
+				}
+			}
+
+			static Register add(Register a, Register b) { return _mm256_add_pd(a, b); }
+			static Register sub(Register a, Register b) { return _mm256_sub_pd(a, b); }
+			static Register mul(Register a, Register b) { return _mm256_mul_pd(a, b); }
+
+			static Register negMulAdd(Register a, Register b, Register c)
+			{
+#if defined(ABSTRACTMATH_FMA)
+				return _mm256_fnmadd_pd(a, b, c);
+#else
+				return _mm256_sub_pd(c, _mm256_mul_pd(a, b));
+#endif
+			}
+
+			static Register reciprocal(Register a) { return _mm256_div_pd(_mm256_set1_pd(1.0), a); }
+			static Register sqrt(Register a) { return _mm256_sqrt_pd(a); }
+			static Register abs(Register a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+
+			static Register copySign(Register magnitude, Register sign)
+			{
+				const Register signBit = _mm256_set1_pd(-0.0);
+				return _mm256_or_pd(_mm256_and_pd(signBit, sign), _mm256_andnot_pd(signBit, magnitude));
+			}
+
+			static Mask greater(Register a, Register b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+			static Mask notPositive(Register a) { return _mm256_cmp_pd(a, _mm256_setzero_pd(), _CMP_NGT_UQ); }
+			static Mask either(Mask a, Mask b) { return _mm256_or_pd(a, b); }
+			static Register select(Mask mask, Register a, Register b) { return _mm256_blendv_pd(b, a, mask); }
+			static size_t count(Mask mask) { return countBits(_mm256_movemask_pd(mask)); }
+		};
+
+		template<typename T>
+		struct BatchSolveWidth { static const size_t value = SIMD_ALIGNMENT / sizeof(T); };
+#elif defined(ABSTRACTMATH_SSE41)
+		template<>
+		struct SolvePack<float, 4>
+		{
+			using Register = __m128;
+			using Mask = __m128;
+			static const size_t WIDTH = 4;
+
+			static Register set(float value) { return _mm_set1_ps(value); }
+			static Register gather(const float* src, size_t stride) { return _mm_setr_ps(src[0], src[stride], src[2 * stride], src[3 * stride]); }
+
+			static void scatter(float* dst, size_t stride, Register value)
+			{
+				alignas(16) float lanes[4];
+				_mm_store_ps(lanes, value);
+
+				for (size_t i = 0; i < 4; i++)
+				{
+					dst[i * stride] = lanes[i];
+				}
+			}
+
+			static Register add(Register a, Register b) { return _mm_add_ps(a, b); }
+			static Register sub(Register a, Register b) { return _mm_sub_ps(a, b); }
+			static Register mul(Register a, Register b) { return _mm_mul_ps(a, b); }
+			static Register negMulAdd(Register a, Register b, Register c) { return _mm_sub_ps(c, _mm_mul_ps(a, b)); }
+			static Register reciprocal(Register a) { return _mm_div_ps(_mm_set1_ps(1.0f), a); }
+			static Register sqrt(Register a) { return _mm_sqrt_ps(a); }
+			static Register abs(Register a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+			static Register copySign(Register magnitude, Register sign)
+			{
+				const Register signBit = _mm_set1_ps(-0.0f);
+				return _mm_or_ps(_mm_and_ps(signBit, sign), _mm_andnot_ps(signBit, magnitude));
+			}
+
+			static Mask greater(Register a, Register b) { return _mm_cmpgt_ps(a, b); }
+			static Mask notPositive(Register a) { return _mm_cmpngt_ps(a, _mm_setzero_ps()); }
+			static Mask either(Mask a, Mask b) { return _mm_or_ps(a, b); }
+			static Register select(Mask mask, Register a, Register b) { return _mm_blendv_ps(b, a, mask); }
+
+			static size_t count(Mask mask) { return countBits(_mm_movemask_ps(mask)); }
+		};
+
+		template<typename T>
+		struct BatchSolveWidth { static const size_t value = std::is_same<T, float>::value ? 4 : 1; };
+#else
+		template<typename T>
+		struct BatchSolveWidth { static const size_t value = 1; };
+#endif
+
+		// Gaussian elimination with partial pivoting on the registers of one tile, v is the right-hand side and
+		// receives the solution, the pivot search swaps a row up whenever a lane finds a larger candidate so every lane
+		// follows its own pivot order without branching
+		template<typename P, size_t N>
+		inline typename P::Mask luSolveTile(typename P::Register* m, typename P::Register* v)
+		{
+			using Register = typename P::Register;
+			typename P::Mask singular = P::notPositive(P::set(1));
+
+			for (size_t k = 0; k < N; k++)
+			{
+				Register largest = P::abs(m[k * N + k]);
+
+				for (size_t row = k + 1; row < N; row++)
+				{
+					Register candidate = P::abs(m[k * N + row]);
+					typename P::Mask larger = P::greater(candidate, largest);
+					largest = P::select(larger, candidate, largest);
+
+					for (size_t col = k; col < N; col++)
+					{
+						Register top = m[col * N + k];
+						m[col * N + k] = P::select(larger, m[col * N + row], top);
+						m[col * N + row] = P::select(larger, top, m[col * N + row]);
+					}
+
+					Register top = v[k];
+					v[k] = P::select(larger, v[row], top);
+					v[row] = P::select(larger, top, v[row]);
+				}
+
+				singular = P::either(singular, P::notPositive(largest));
+				Register invPivot = P::reciprocal(m[k * N + k]);
+				m[k * N + k] = invPivot;
+
+				for (size_t row = k + 1; row < N; row++)
+				{
+					Register factor = P::mul(m[k * N + row], invPivot);
+
+					for (size_t col = k + 1; col < N; col++)
+					{
+						m[col * N + row] = P::negMulAdd(factor, m[col * N + k], m[col * N + row]);
+					}
+
+					v[row] = P::negMulAdd(factor, v[k], v[row]);
+				}
+			}
+
+			for (size_t row = N; row-- > 0;)
+			{
+				Register sum = v[row];
+
+				for (size_t col = row + 1; col < N; col++)
+				{
+					sum = P::negMulAdd(m[col * N + row], v[col], sum);
+				}
+
+				v[row] = P::mul(sum, m[row * N + row]);
+			}
+
+			return singular;
+		}
+
+		// Cholesky and both triangular solves on the registers of one tile, L overwrites the lower triangle with the
+		// reciprocals of its diagonal on the diagonal
+		template<typename P, size_t N>
+		inline typename P::Mask choleskySolveTile(typename P::Register* m, typename P::Register* v)
+		{
+			using Register = typename P::Register;
+			typename P::Mask indefinite = P::notPositive(P::set(1));
+
+			for (size_t j = 0; j < N; j++)
+			{
+				Register diagonal = m[j * N + j];
+
+				for (size_t k = 0; k < j; k++)
+				{
+					diagonal = P::negMulAdd(m[k * N + j], m[k * N + j], diagonal);
+				}
+
+				indefinite = P::either(indefinite, P::notPositive(diagonal));
+				Register invRoot = P::reciprocal(P::sqrt(diagonal));
+				m[j * N + j] = invRoot;
+
+				for (size_t i = j + 1; i < N; i++)
+				{
+					Register sum = m[j * N + i];
+
+					for (size_t k = 0; k < j; k++)
+					{
+						sum = P::negMulAdd(m[k * N + i], m[k * N + j], sum);
+					}
+
+					m[j * N + i] = P::mul(sum, invRoot);
+				}
+			}
+
+			for (size_t i = 0; i < N; i++)
+			{
+				Register sum = v[i];
+
+				for (size_t k = 0; k < i; k++)
+				{
+					sum = P::negMulAdd(m[k * N + i], v[k], sum);
+				}
+
+				v[i] = P::mul(sum, m[i * N + i]);
+			}
+
+			for (size_t i = N; i-- > 0;)
+			{
+				Register sum = v[i];
+
+				for (size_t k = i + 1; k < N; k++)
+				{
+					sum = P::negMulAdd(m[i * N + k], v[k], sum);
+				}
+
+				v[i] = P::mul(sum, m[i * N + i]);
+			}
+
+			return indefinite;
+		}
+
+		// WIDTH systems transposed into one tile of registers (element e of every system in m[e]), solved, and the
+		// solutions transposed back
+		template<typename P, bool CHOLESKY, size_t N, typename T>
+		inline size_t solveTile(const Matrix<T, N, N>* a, const Vector<T, N>* b, Vector<T, N>* x)
+		{
+			typename P::Register m[N * N];
+			typename P::Register v[N];
+
+			for (size_t e = 0; e < N * N; e++)
+			{
+				m[e] = P::gather(a[0].data + e, N * N);
+			}
+
+			for (size_t e = 0; e < N; e++)
+			{
+				v[e] = P::gather(b[0].data + e, N);
+			}
+
+			size_t failed = P::count(CHOLESKY ? choleskySolveTile<P, N>(m, v) : luSolveTile<P, N>(m, v));
+
+			for (size_t e = 0; e < N; e++)
+			{
+				P::scatter(x[0].data + e, N, v[e]);
+			}
+
+			return failed;
+		}
+
+		template<bool CHOLESKY, typename T, size_t N>
+		size_t solveBatch(const Matrix<T, N, N>* a, const Vector<T, N>* b, Vector<T, N>* x, size_t count)
+		{
+			static_assert(std::is_floating_point<T>::value, "Solvers require a floating point type!");
+			static_assert(sizeof(Matrix<T, N, N>) == sizeof(T) * N * N && sizeof(Vector<T, N>) == sizeof(T) * N, "Matrices and vectors must be tightly packed!");
+			ABSTRACTMATH_PROFILE_SCOPE(LinearSolve, count);
+
+			using Wide = SolvePack<T, BatchSolveWidth<T>::value>;
+			using Scalar = SolvePack<T, 1>;
+			const size_t grain = (cacheGrain<sizeof(Matrix<T, N, N>) + 2 * sizeof(Vector<T, N>)>() + Wide::WIDTH - 1) / Wide::WIDTH * Wide::WIDTH;
+			std::atomic<size_t> failures{ 0 };
+
+			parallelFor(0, count, grain, [&](size_t first, size_t last)
+			{
+				size_t failed = 0;
+				size_t i = first;
+
+				for (; i + Wide::WIDTH <= last; i += Wide::WIDTH)
+				{
+					failed += solveTile<Wide, CHOLESKY>(a + i, b + i, x + i);
+				}
+
+				for (; i < last; i++)
+				{
+					failed += solveTile<Scalar, CHOLESKY>(a + i, b + i, x + i);
+				}
+
+				failures.fetch_add(failed, std::memory_order_relaxed);
+			});
+
+			return failures.load(std::memory_order_relaxed);
+		}
+	}
+
+	// a[i] * x[i] = b[i] for count independent systems (per-contact or per-joint blocks), solved a SIMD register's
+	// worth at a time in SoA form and split across the job system, x may be b
+	// returns the number of singular systems, their x is not finite
+	template<typename T, size_t N>
+	size_t solveLU(const Matrix<T, N, N>* a, const Vector<T, N>* b, Vector<T, N>* x, size_t count)
+	{
+		return detail::solveBatch<false>(a, b, x, count);
+	}
+
+	// the same for symmetric positive definite a[i], only their lower triangles are read, returns the number of
+	// systems that were not positive definite
+	template<typename T, size_t N>
+	size_t solveCholesky(const Matrix<T, N, N>* a, const Vector<T, N>* b, Vector<T, N>* x, size_t count)
+	{
+		return detail::solveBatch<true>(a, b, x, count);
+	}
+}
@@ -0,0 +1,720 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <assert.h>
+
+#include "Simd.h"
+#include "Profiling.h"
+#include "Vector.h"
+#include "Vec3.h"
+#include "Matrix.h"
+#include "Memory.h"
+#include "Parallel.h"
+
+namespace AbstractMath {
+
+	// column indices and row offsets are 32 bit, half the index traffic of size_t, for up to 2G rows, columns and nonzeros
+	// (the gather kernels read indices as signed)
+	typedef uint32_t SparseIndex;
+
+	// one entry of a system being assembled, duplicates of a (row, col) are summed
+	template<typename T>
+	struct Triplet
+	{
+		SparseIndex row;
+		SparseIndex col;
+		T value;
+	};
+
+	template<typename T>
+	struct BlockTriplet
+	{
+		SparseIndex row;
+		SparseIndex col;
+		Matrix<T, 3, 3> value;
+	};
+
+	namespace detail {
+
+		template<typename T>
+		inline void addEntry(T& sum, const T& value)
+		{
+			sum += value;
+		}
+
+		template<typename T, size_t Rows_C, size_t Cols_C>
+		inline void addEntry(Matrix<T, Rows_C, Cols_C>& sum, const Matrix<T, Rows_C, Cols_C>& value)
+		{
+			for (size_t i = 0; i < Rows_C * Cols_C; i++)
+			{
+				sum.data[i] += value.data[i];
+			}
+		}
+
+		// the compressed row layout shared by SparseMatrix and BlockSparseMatrix, Value is a scalar or a 3x3 block
+		// rows are also cut into partitions of roughly PARALLEL_CHUNK_BYTES of values and indices each, the units
+		// products are split into, so a row of many nonzeros does not leave one thread with most of the work
+		template<typename Value>
+		struct CompressedRows
+		{
+			std::vector<SparseIndex> offsets; //rows + 1, row r owns [ offsets[r], offsets[r + 1] )
+			std::vector<SparseIndex> columns;
+			aligned_vector<Value> values;
+			std::vector<SparseIndex> partitions; //first row of every partition, then the row count
+			size_t colCount = 0;
+
+			size_t rows() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+			size_t nonZeros() const { return columns.size(); }
+
+			// padding extra zero values stay allocated past the last one, for kernels that load a little beyond a value
+			template<typename Entry>
+			void build(size_t rowCount, size_t cols, const Entry* entries, size_t count, size_t padding)
+			{
+				assert(rowCount <= size_t(INT32_MAX) && cols <= size_t(INT32_MAX) && count <= size_t(INT32_MAX));
+				colCount = cols;
+
+				//counting sort of the entries by row, stable so duplicates keep their input order
+				std::vector<SparseIndex> starts(rowCount + 1, 0);
+
+				for (size_t i = 0; i < count; i++)
+				{
+					assert(entries[i].row < rowCount && entries[i].col < cols);
+					starts[entries[i].row + 1]++;
+				}
+
+				for (size_t r = 0; r < rowCount; r++)
+				{
+					starts[r + 1] += starts[r];
+				}
+
+				std::vector<SparseIndex> order(count);
+				std::vector<SparseIndex> fill(starts.begin(), starts.end() - 1);
+
+				for (size_t i = 0; i < count; i++)
+				{
+					order[fill[entries[i].row]++] = SparseIndex(i);
+				}
+
+				offsets.assign(rowCount + 1, 0);
+				columns.clear();
+				columns.reserve(count);
+				values.clear();
+				values.reserve(count + padding);
+
+				for (size_t r = 0; r < rowCount; r++)
+				{
+					SparseIndex* first = order.data() + starts[r];
+					SparseIndex* last = order.data() + starts[r + 1];
+					std::stable_sort(first, last, [entries](SparseIndex a, SparseIndex b) { return entries[a].col < entries[b].col; });
+
+					for (SparseIndex* it = first; it != last; it++)
+					{
+						const Entry& entry = entries[*it];
+
+						if (columns.size() > offsets[r] && columns.back() == entry.col)
+						{
+							addEntry(values.back(), entry.value);
+						}
+						else
+						{
+							columns.push_back(entry.col);
+							values.push_back(entry.value);
+						}
+					}
+
+					offsets[r + 1] = SparseIndex(columns.size());
+				}
+
+				values.resize(columns.size() + padding, Value());
+				partition();
+			}
+
+			void partition()
+			{
+				const size_t target = PARALLEL_CHUNK_BYTES / (sizeof(Value) + sizeof(SparseIndex)) > 0 ? PARALLEL_CHUNK_BYTES / (sizeof(Value) + sizeof(SparseIndex)) : 1;
+				partitions.clear();
+				partitions.push_back(0);
+
+				size_t begin = 0;
+
+				for (size_t r = 0; r < rows(); r++)
+				{
+					if (offsets[r + 1] - begin >= target)
+					{
+						partitions.push_back(SparseIndex(r + 1));
+						begin = offsets[r + 1];
+					}
+				}
+
+				if (partitions.back() != rows())
+				{
+					partitions.push_back(SparseIndex(rows()));
+				}
+			}
+
+			// kernel(firstRow, lastRow) over every partition, in parallel
+			template<typename F>
+			void forPartitions(F&& kernel) const
+			{
+				parallelFor(0, partitions.size() - 1, 1, [this, &kernel](size_t first, size_t last)
+				{
+					for (size_t p = first; p < last; p++)
+					{
+						kernel(partitions[p], partitions[p + 1]);
+					}
+				});
+			}
+
+			// the stored value at (row, col) or a zero one
+			Value find(size_t row, size_t col) const
+			{
+				assert(row < rows() && col < colCount);
+				const SparseIndex* first = columns.data() + offsets[row];
+				const SparseIndex* last = columns.data() + offsets[row + 1];
+				const SparseIndex* it = std::lower_bound(first, last, SparseIndex(col));
+
+				return it != last && *it == col ? values[it - columns.data()] : Value();
+			}
+		};
+
+#if defined(ABSTRACTMATH_SSE)
+		// packed Vector<float, 3> without touching the float after it
+		inline __m128 load3(const float* src)
+		{
+			return _mm_movelh_ps(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src))), _mm_load_ss(src + 2));
+		}
+
+		inline void store3(float* dst, __m128 value)
+		{
+			_mm_storel_pi(reinterpret_cast<__m64*>(dst), value);
+			_mm_store_ss(dst + 2, _mm_movehl_ps(value, value));
+		}
+#endif
+
+#if defined(ABSTRACTMATH_AVX2)
+		inline float horizontalSum(__m256 value)
+		{
+			__m128 sum = _mm_add_ps(_mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1));
+			sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+			return _mm_cvtss_f32(_mm_add_ss(sum, _mm_movehdup_ps(sum)));
+		}
+
+		inline double horizontalSum(__m256d value)
+		{
+			__m128d sum = _mm_add_pd(_mm256_castpd256_pd128(value), _mm256_extractf128_pd(value, 1));
+			return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+		}
+#endif
+
+		template<typename T>
+		inline T sparseRowDot(const T* values, const SparseIndex* columns, size_t count, const T* x)
+		{
+			size_t k = 0;
+			T sum = T(0);
+
+#if defined(ABSTRACTMATH_AVX2)
+			if constexpr (std::is_same<T, float>::value)
+			{
+				//masked gathers with an explicit source, gcc warns about the undefined one of the plain gathers
+				const __m256 all = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+				__m256 acc = _mm256_setzero_ps();
+
+				for (; k + 8 <= count; k += 8)
+				{
+					__m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns + k));
+					acc = multiplyAdd(_mm256_loadu_ps(values + k), _mm256_mask_i32gather_ps(_mm256_setzero_ps(), x, index, all, 4), acc);
+				}
+
+				sum = horizontalSum(acc);
+			}
+			else if constexpr (std::is_same<T, double>::value)
+			{
+				const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+				__m256d acc = _mm256_setzero_pd();
+
+				for (; k + 4 <= count; k += 4)
+				{
+					__m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columns + k));
+#if defined(ABSTRACTMATH_FMA)
+					acc = _mm256_fmadd_pd(_mm256_loadu_pd(values + k), _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x, index, all, 8), acc);
+#else
+					acc = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(values + k), _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x, index, all, 8)), acc);
+#endif
+				}
+
+				sum = horizontalSum(acc);
+			}
+#endif
+
+			for (; k < count; k++)
+			{
+				sum += values[k] * x[columns[k]];
+			}
+
+			return sum;
+		}
+
+		// the same value array applied to every component of a Vector<T, 3> stream
+		template<typename T>
+		inline void sparseRowDot3(const T* values, const SparseIndex* columns, size_t count, const T* x, T* dst)
+		{
+#if defined(ABSTRACTMATH_SSE)
+			if constexpr (std::is_same<T, float>::value)
+			{
+				__m128 acc = _mm_setzero_ps();
+
+				for (size_t k = 0; k < count; k++)
+				{
+					acc = multiplyAdd(_mm_set1_ps(values[k]), load3(x + size_t(columns[k]) * 3), acc);
+				}
+
+				store3(dst, acc);
+				return;
+			}
+#endif
+
+			T sx = T(0), sy = T(0), sz = T(0);
+
+			for (size_t k = 0; k < count; k++)
+			{
+				const T* v = x + size_t(columns[k]) * 3;
+				sx += values[k] * v[0];
+				sy += values[k] * v[1];
+				sz += values[k] * v[2];
+			}
+
+			dst[0] = sx;
+			dst[1] = sy;
+			dst[2] = sz;
+		}
+
+		// one block row of a 3x3 BSR product, every block is read with unaligned loads of its columns which reach one
+		// float past it, hence the padding block after the last
+		template<typename T>
+		inline void blockRowProduct(const Matrix<T, 3, 3>* blocks, const SparseIndex* columns, size_t count, const T* x, T* dst)
+		{
+#if defined(ABSTRACTMATH_SSE)
+			if constexpr (std::is_same<T, float>::value)
+			{
+				__m128 acc = _mm_setzero_ps();
+
+				for (size_t k = 0; k < count; k++)
+				{
+					const float* m = blocks[k].data;
+					const float* v = x + size_t(columns[k]) * 3;
+					acc = multiplyAdd(_mm_loadu_ps(m + 0), _mm_set1_ps(v[0]), acc);
+					acc = multiplyAdd(_mm_loadu_ps(m + 3), _mm_set1_ps(v[1]), acc);
+					acc = multiplyAdd(_mm_loadu_ps(m + 6), _mm_set1_ps(v[2]), acc);
+				}
+
+				store3(dst, acc);
+				return;
+			}
+#endif
+
+			T sx = T(0), sy = T(0), sz = T(0);
+
+			for (size_t k = 0; k < count; k++)
+			{
+				const T* m = blocks[k].data;
+				const T* v = x + size_t(columns[k]) * 3;
+				sx += m[0] * v[0] + m[3] * v[1] + m[6] * v[2];
+				sy += m[1] * v[0] + m[4] * v[1] + m[7] * v[2];
+				sz += m[2] * v[0] + m[5] * v[1] + m[8] * v[2];
+			}
+
+			dst[0] = sx;
+			dst[1] = sy;
+			dst[2] = sz;
+		}
+
+		template<typename T, typename V>
+		inline void assertVector3()
+		{
+			static_assert(std::is_base_of<Vector<T, 3>, V>::value && sizeof(V) == sizeof(T) * 3, "Vectors must be tightly packed Vector<T, 3>!");
+		}
+	}
+
+	// compressed sparse rows, built once from triplets and then multiplied many times (solver iterations)
+	// products run in parallel over row partitions balanced by nonzeros, x and y must not overlap
+	template<typename T>
+	class SparseMatrix
+	{
+		static_assert(std::is_floating_point<T>::value, "Sparse matrices require a floating point type!");
+
+	public:
+		using type = T;
+
+		SparseMatrix() = default;
+
+		SparseMatrix(size_t rows, size_t cols, const Triplet<T>* triplets, size_t count)
+		{
+			setFromTriplets(rows, cols, triplets, count);
+		}
+
+		SparseMatrix(size_t rows, size_t cols, const std::vector<Triplet<T>>& triplets) : SparseMatrix(rows, cols, triplets.data(), triplets.size()) {}
+
+		void setFromTriplets(size_t rows, size_t cols, const Triplet<T>* triplets, size_t count)
+		{
+			storage.build(rows, cols, triplets, count, 0);
+		}
+
+		size_t rows() const { return storage.rows(); }
+		size_t cols() const { return storage.colCount; }
+		size_t nonZeros() const { return storage.nonZeros(); }
+
+		const SparseIndex* rowOffsets() const { return storage.offsets.data(); }
+		const SparseIndex* columnIndices() const { return storage.columns.data(); }
+		T* values() { return storage.values.data(); }
+		const T* values() const { return storage.values.data(); }
+
+		T operator()(size_t row, size_t col) const
+		{
+			return storage.find(row, col);
+		}
+
+		// dst needs rows() values, zero where the diagonal is not stored
+		void diagonal(T* dst) const
+		{
+			for (size_t r = 0; r < rows(); r++)
+			{
+				dst[r] = r < cols() ? storage.find(r, r) : T(0);
+			}
+		}
+
+		// y = this * x, x has cols() values and y rows()
+		void multiply(const T* x, T* y) const
+		{
+			ABSTRACTMATH_PROFILE_SCOPE(SparseMultiply, nonZeros());
+			assert(nonZeros() == 0 || x != y);
+
+			storage.forPartitions([this, x, y](size_t first, size_t last)
+			{
+				const SparseIndex* offsets = storage.offsets.data();
+
+				for (size_t r = first; r < last; r++)
+				{
+					y[r] = detail::sparseRowDot(storage.values.data() + offsets[r], storage.columns.data() + offsets[r], offsets[r + 1] - offsets[r], x);
+				}
+			});
+		}
+
+		// the same product for every component of Vector<T, 3>/Vector3<T> streams, e.g. a cloth Laplacian over positions
+		template<typename V>
+		void multiply(const V* x, V* y) const
+		{
+			detail::assertVector3<T, V>();
+			ABSTRACTMATH_PROFILE_SCOPE(SparseMultiply, nonZeros());
+			assert(nonZeros() == 0 || static_cast<const void*>(x) != static_cast<const void*>(y));
+
+			const T* src = reinterpret_cast<const T*>(x);
+			T* dst = reinterpret_cast<T*>(y);
+
+			storage.forPartitions([this, src, dst](size_t first, size_t last)
+			{
+				const SparseIndex* offsets = storage.offsets.data();
+
+				for (size_t r = first; r < last; r++)
+				{
+					detail::sparseRowDot3(storage.values.data() + offsets[r], storage.columns.data() + offsets[r], offsets[r + 1] - offsets[r], src, dst + r * 3);
+				}
+			});
+		}
+
+	private:
+		detail::CompressedRows<T> storage;
+	};
+
+	// block compressed sparse rows of Matrix<T, 3, 3>, one block couples two particles or bodies of a 3D system,
+	// sizes are in blocks and products read and write Vector<T, 3>/Vector3<T> streams
+	template<typename T>
+	class BlockSparseMatrix
+	{
+		static_assert(std::is_floating_point<T>::value, "Sparse matrices require a floating point type!");
+
+	public:
+		using type = T;
+		using Block = Matrix<T, 3, 3>;
+
+		BlockSparseMatrix() = default;
+
+		BlockSparseMatrix(size_t blockRows, size_t blockCols, const BlockTriplet<T>* triplets, size_t count)
+		{
+			setFromTriplets(blockRows, blockCols, triplets, count);
+		}
+
+		BlockSparseMatrix(size_t blockRows, size_t blockCols, const std::vector<BlockTriplet<T>>& triplets) : BlockSparseMatrix(blockRows, blockCols, triplets.data(), triplets.size()) {}
+
+		void setFromTriplets(size_t blockRows, size_t blockCols, const BlockTriplet<T>* triplets, size_t count)
+		{
+			storage.build(blockRows, blockCols, triplets, count, 1);
+		}
+
+		size_t blockRows() const { return storage.rows(); }
+		size_t blockCols() const { return storage.colCount; }
+		size_t nonZeroBlocks() const { return storage.nonZeros(); }
+
+		const SparseIndex* rowOffsets() const { return storage.offsets.data(); }
+		const SparseIndex* columnIndices() const { return storage.columns.data(); }
+		Block* blocks() { return storage.values.data(); }
+		const Block* blocks() const { return storage.values.data(); }
+
+		Block operator()(size_t blockRow, size_t blockCol) const
+		{
+			return storage.find(blockRow, blockCol);
+		}
+
+		// dst needs blockRows() blocks, zero where the diagonal block is not stored
+		void diagonal(Block* dst) const
+		{
+			for (size_t r = 0; r < blockRows(); r++)
+			{
+				dst[r] = r < blockCols() ? storage.find(r, r) : Block();
+			}
+		}
+
+		// y = this * x, x has blockCols() vectors and y blockRows()
+		template<typename V>
+		void multiply(const V* x, V* y) const
+		{
+			detail::assertVector3<T, V>();
+			ABSTRACTMATH_PROFILE_SCOPE(SparseMultiply, nonZeroBlocks() * 9);
+			assert(nonZeroBlocks() == 0 || static_cast<const void*>(x) != static_cast<const void*>(y));
+
+			const T* src = reinterpret_cast<const T*>(x);
+			T* dst = reinterpret_cast<T*>(y);
+
+			storage.forPartitions([this, src, dst](size_t first, size_t last)
+			{
+				const SparseIndex* offsets = storage.offsets.data();
+
+				for (size_t r = first; r < last; r++)
+				{
+					detail::blockRowProduct(storage.values.data() + offsets[r], storage.columns.data() + offsets[r], offsets[r + 1] - offsets[r], src, dst + r * 3);
+				}
+			});
+		}
+
+	private:
+		detail::CompressedRows<Block> storage;
+	};
+
+	typedef SparseMatrix<float> SparseMatrixf;
+	typedef SparseMatrix<double> SparseMatrixd;
+	typedef BlockSparseMatrix<float> BlockSparseMatrixf;
+	typedef BlockSparseMatrix<double> BlockSparseMatrixd;
+
+	template<typename T>
+	struct ConjugateGradientResult
+	{
+		size_t iterations;
+		T residual; //|b - Ax| / |b| at exit
+		bool converged;
+	};
+
+	namespace detail {
+
+		template<typename T>
+		inline T denseDot(const T* a, const T* b, size_t count)
+		{
+			size_t i = 0;
+			T sum = T(0);
+
+#if defined(ABSTRACTMATH_AVX2)
+			if constexpr (std::is_same<T, float>::value)
+			{
+				__m256 acc = _mm256_setzero_ps();
+
+				for (; i + 8 <= count; i += 8)
+				{
+					acc = multiplyAdd(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc);
+				}
+
+				sum = horizontalSum(acc);
+			}
+			else if constexpr (std::is_same<T, double>::value)
+			{
+				__m256d acc = _mm256_setzero_pd();
+
+				for (; i + 4 <= count; i += 4)
+				{
+#if defined(ABSTRACTMATH_FMA)
+					acc = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc);
+#else
+					acc = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)), acc);
+#endif
+				}
+
+				sum = horizontalSum(acc);
+			}
+#endif
+
+			for (; i < count; i++)
+			{
+				sum += a[i] * b[i];
+			}
+
+			return sum;
+		}
+
+		// sum of a[i] * b[i] in fixed-size chunks added in order, the same result for any thread count
+		template<typename T>
+		inline T parallelDot(const T* a, const T* b, size_t count)
+		{
+			const size_t grain = cacheGrain<sizeof(T) * 2>();
+			std::vector<T> partial((count + grain - 1) / grain, T(0));
+
+			parallelFor(0, count, grain, [a, b, grain, &partial](size_t first, size_t last)
+			{
+				partial[first / grain] = denseDot(a + first, b + first, last - first);
+			});
+
+			T sum = T(0);
+
+			for (T value : partial)
+			{
+				sum += value;
+			}
+
+			return sum;
+		}
+
+		// preconditioned conjugate gradient on count scalars, apply(in, out) is out = A * in and precondition(in, out)
+		// out = M^-1 * in, A must be symmetric positive definite
+		template<typename T, typename Apply, typename Precondition>
+		ConjugateGradientResult<T> conjugateGradient(size_t count, Apply&& apply, Precondition&& precondition, const T* b, T* x, size_t maxIterations, T tolerance)
+		{
+			aligned_vector<T> r(count), z(count), p(count), ap(count);
+			const size_t grain = cacheGrain<sizeof(T) * 3>();
+
+			T bNorm = std::sqrt(parallelDot(b, b, count));
+
+			if (bNorm == T(0))
+			{
+				std::fill(x, x + count, T(0));
+				return { 0, T(0), true };
+			}
+
+			apply(x, ap.data());
+
+			parallelFor(0, count, grain, [&](size_t first, size_t last)
+			{
+				for (size_t i = first; i < last; i++)
+				{
+					r[i] = b[i] - ap[i];
+				}
+			});
+
+			T residual = std::sqrt(parallelDot(r.data(), r.data(), count)) / bNorm;
+
+			if (residual <= tolerance)
+			{
+				return { 0, residual, true };
+			}
+
+			precondition(r.data(), z.data());
+			std::copy(z.begin(), z.end(), p.begin());
+			T rz = parallelDot(r.data(), z.data(), count);
+
+			for (size_t iteration = 1; iteration <= maxIterations; iteration++)
+			{
+				apply(p.data(), ap.data());
+				T pap = parallelDot(p.data(), ap.data(), count);
+
+				if (!(pap > T(0)))
+				{
+					return { iteration, residual, false }; //not positive definite, or broken down
+				}
+
+				T alpha = rz / pap;
+
+				parallelFor(0, count, grain, [&](size_t first, size_t last)
+				{
+					for (size_t i = first; i < last; i++)
+					{
+						x[i] += alpha * p[i];
+						r[i] -= alpha * ap[i];
+					}
+				});
+
+				residual = std::sqrt(parallelDot(r.data(), r.data(), count)) / bNorm;
+
+				if (residual <= tolerance)
+				{
+					return { iteration, residual, true };
+				}
+
+				precondition(r.data(), z.data());
+				T rzNext = parallelDot(r.data(), z.data(), count);
+				T beta = rzNext / rz;
+				rz = rzNext;
+
+				parallelFor(0, count, grain, [&](size_t first, size_t last)
+				{
+					for (size_t i = first; i < last; i++)
+					{
+						p[i] = z[i] + beta * p[i];
+					}
+				});
+			}
+
+			return { maxIterations, residual, false };
+		}
+	}
+
+	// solves a * x = b for a symmetric positive definite a (stiffness, mass-spring or constraint systems), Jacobi
+	// preconditioned, x holds the initial guess (the last frame's solution is a good one) and receives the result
+	// stops once |b - ax| <= tolerance * |b| or after maxIterations, 0 means rows()
+	template<typename T>
+	ConjugateGradientResult<T> conjugateGradient(const SparseMatrix<T>& a, const T* b, T* x, T tolerance = T(1e-6), size_t maxIterations = 0)
+	{
+		assert(a.rows() == a.cols());
+		const size_t count = a.rows();
+		aligned_vector<T> inverseDiagonal(count);
+		a.diagonal(inverseDiagonal.data());
+
+		for (T& value : inverseDiagonal)
+		{
+			value = value != T(0) ? T(1) / value : T(1);
+		}
+
+		return detail::conjugateGradient<T>(count,
+			[&a](const T* in, T* out) { a.multiply(in, out); },
+			[&inverseDiagonal, count](const T* in, T* out)
+			{
+				parallelTransform(inverseDiagonal.data(), in, out, count, [](T scale, T value) { return scale * value; });
+			},
+			b, x, maxIterations == 0 ? count : maxIterations, tolerance);
+	}
+
+	// the block form, preconditioned with the inverted 3x3 diagonal blocks (block Jacobi)
+	template<typename T, typename V>
+	ConjugateGradientResult<T> conjugateGradient(const BlockSparseMatrix<T>& a, const V* b, V* x, T tolerance = T(1e-6), size_t maxIterations = 0)
+	{
+		detail::assertVector3<T, V>();
+		assert(a.blockRows() == a.blockCols());
+
+		using Block = typename BlockSparseMatrix<T>::Block;
+		const size_t blocks = a.blockRows();
+		aligned_vector<Block> inverseDiagonal(blocks);
+		a.diagonal(inverseDiagonal.data());
+
+		for (Block& block : inverseDiagonal)
+		{
+			block = block.determinant() != T(0) ? block.inverted() : identity<T, 3>();
+		}
+
+		return detail::conjugateGradient<T>(blocks * 3,
+			[&a](const T* in, T* out) { a.multiply(reinterpret_cast<const Vector<T, 3>*>(in), reinterpret_cast<Vector<T, 3>*>(out)); },
+			[&inverseDiagonal, blocks](const T* in, T* out)
+			{
+				parallelTransform(inverseDiagonal.data(), reinterpret_cast<const Vector<T, 3>*>(in), reinterpret_cast<Vector<T, 3>*>(out), blocks,
+					[](const Block& block, const Vector<T, 3>& value) { return block * value; });
+			},
+			reinterpret_cast<const T*>(b), reinterpret_cast<T*>(x), maxIterations == 0 ? blocks * 3 : maxIterations, tolerance);
+	}
+}
@@ -0,0 +1,362 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <limits>
+
+#include "Simd.h"
+#include "Profiling.h"
+
+namespace AbstractMath {
+
+	// storage-only scalars for vertex and keyframe streams, they hold a value in fewer bits and widen to float for any
+	// arithmetic: Vector<half, 3> + Vector<half, 3> is a Vector<float, 3>, assigning a float narrows it again
+	// half is IEEE binary16 (round to nearest even, overflow to infinity, NaN stays NaN)
+	// snorm<I> maps [ -1, 1 ] and unorm<I> [ 0, 1 ] onto the integer range (the D3D/Vulkan rules: clamped, round to
+	// nearest even, NaN encodes as 0, the lowest snorm code decodes to -1 like the one above it)
+	// all of them default construct uninitialized like float, Vector's value initialization still zeroes them
+
+	namespace detail {
+
+		// Giesen's branch-light conversions on the bit patterns, the portable path when F16C is unavailable
+		inline uint16_t floatToHalfBits(float value)
+		{
+			uint32_t bits = 0;
+			std::memcpy(&bits, &value, sizeof(float));
+
+			const uint32_t sign = (bits >> 16) & 0x8000u;
+			bits &= 0x7fffffffu;
+
+			if (bits >= 0x47800000u) //65536 and up, infinity and NaN
+			{
+				return uint16_t(sign | (bits > 0x7f800000u ? 0x7e00u : 0x7c00u));
+			}
+
+			if (bits < 0x38800000u) //below the smallest normal half, let the float adder round the subnormal
+			{
+				float magnitude = 0.0f;
+				std::memcpy(&magnitude, &bits, sizeof(float));
+				magnitude += 0.5f;
+				std::memcpy(&bits, &magnitude, sizeof(float));
+
+				return uint16_t(sign | (bits - 0x3f000000u));
+			}
+
+			bits += 0xc8000fffu + ((bits >> 13) & 1u); //rebias the exponent, round to nearest even
+			return uint16_t(sign | (bits >> 13));
+		}
+
+		inline float halfBitsToFloat(uint16_t half)
+		{
+			uint32_t bits = uint32_t(half & 0x7fffu) << 13;
+			const uint32_t exponent = bits & 0x0f800000u;
+			float result = 0.0f;
+
+			bits += 0x38000000u;
+
+			if (exponent == 0x0f800000u) //infinity and NaN
+			{
+				bits += 0x38000000u;
+				std::memcpy(&result, &bits, sizeof(float));
+			}
+			else if (exponent == 0) //zero and subnormals
+			{
+				bits += 0x00800000u;
+				std::memcpy(&result, &bits, sizeof(float));
+				result -= 6.103515625e-05f;
+			}
+			else
+			{
+				std::memcpy(&result, &bits, sizeof(float));
+			}
+
+			bits = 0;
+			std::memcpy(&bits, &result, sizeof(float));
+			bits |= uint32_t(half & 0x8000u) << 16;
+			std::memcpy(&result, &bits, sizeof(float));
+
+			return result;
+		}
+
+		// round to nearest even without libm (constexpr) matching _mm_cvtps_epi32, valid below 2^23
+		constexpr float roundNearestEven(float value)
+		{
+			return value >= 0.0f ? (value + 8388608.0f) - 8388608.0f : (value - 8388608.0f) + 8388608.0f;
+		}
+	}
+
+	struct half
+	{
+		uint16_t bits;
+
+		half() = default;
+
+		half(float value)
+		{
+#if defined(ABSTRACTMATH_F16C)
+			bits = uint16_t(_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT));
+#else
+			bits = detail::floatToHalfBits(value);
+#endif
+		}
+
+		operator float() const
+		{
+#if defined(ABSTRACTMATH_F16C)
+			return _cvtsh_ss(bits);
+#else
+			return detail::halfBitsToFloat(bits);
+#endif
+		}
+
+		static constexpr half fromBits(uint16_t bits)
+		{
+			half result = half();
+			result.bits = bits;
+			return result;
+		}
+	};
+
+	template<typename I>
+	struct snorm
+	{
+		static_assert(std::is_integral<I>::value && std::is_signed<I>::value && sizeof(I) <= 2, "snorm requires an 8 or 16 bit signed integer!");
+		static constexpr float MAX = float(std::numeric_limits<I>::max());
+
+		I bits;
+
+		snorm() = default;
+
+		constexpr snorm(float value) : bits(I(detail::roundNearestEven((value != value ? 0.0f : value < -1.0f ? -1.0f : value > 1.0f ? 1.0f : value) * MAX))) {}
+
+		constexpr operator float() const
+		{
+			float value = float(bits) / MAX;
+			return value < -1.0f ? -1.0f : value;
+		}
+
+		static constexpr snorm<I> fromBits(I bits)
+		{
+			snorm<I> result = snorm<I>();
+			result.bits = bits;
+			return result;
+		}
+	};
+
+	template<typename I>
+	struct unorm
+	{
+		static_assert(std::is_integral<I>::value && std::is_unsigned<I>::value && sizeof(I) <= 2, "unorm requires an 8 or 16 bit unsigned integer!");
+		static constexpr float MAX = float(std::numeric_limits<I>::max());
+
+		I bits;
+
+		unorm() = default;
+
+		constexpr unorm(float value) : bits(I(detail::roundNearestEven((value != value ? 0.0f : value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value) * MAX))) {}
+
+		constexpr operator float() const
+		{
+			return float(bits) / MAX;
+		}
+
+		static constexpr unorm<I> fromBits(I bits)
+		{
+			unorm<I> result = unorm<I>();
+			result.bits = bits;
+			return result;
+		}
+	};
+
+	typedef snorm<int16_t> snorm16;
+	typedef snorm<int8_t> snorm8;
+	typedef unorm<uint16_t> unorm16;
+	typedef unorm<uint8_t> unorm8;
+
+	static_assert(sizeof(half) == 2 && sizeof(snorm16) == 2 && sizeof(snorm8) == 1 && sizeof(unorm16) == 2 && sizeof(unorm8) == 1, "Storage types must not be padded!");
+
+	namespace detail {
+
+		template<typename T>
+		struct is_storage_type : std::false_type {};
+
+		template<>
+		struct is_storage_type<half> : std::true_type {};
+
+		template<typename I>
+		struct is_storage_type<snorm<I>> : std::true_type {};
+
+		template<typename I>
+		struct is_storage_type<unorm<I>> : std::true_type {};
+
+		// what arithmetic on T produces, float for the storage types and T itself otherwise
+		template<typename T>
+		using widened = typename std::conditional<is_storage_type<T>::value, float, T>::type;
+
+		template<typename T>
+		struct is_normalized : std::false_type {};
+
+		template<typename I>
+		struct is_normalized<snorm<I>> : std::true_type {};
+
+		template<typename I>
+		struct is_normalized<unorm<I>> : std::true_type {};
+
+#if defined(ABSTRACTMATH_AVX2)
+		// eight normalized integers widened to int32, then the reverse with saturation (the values are already clamped)
+		template<typename I>
+		inline __m256i loadNormalized8(const I* src)
+		{
+			if constexpr (sizeof(I) == 2)
+			{
+				__m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+				return std::is_signed<I>::value ? _mm256_cvtepi16_epi32(packed) : _mm256_cvtepu16_epi32(packed);
+			}
+			else
+			{
+				__m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+				return std::is_signed<I>::value ? _mm256_cvtepi8_epi32(packed) : _mm256_cvtepu8_epi32(packed);
+			}
+		}
+
+		template<typename I>
+		inline void storeNormalized8(__m256i values, I* dst)
+		{
+			__m128i low = _mm256_castsi256_si128(values);
+			__m128i high = _mm256_extracti128_si256(values, 1);
+			__m128i packed = std::is_signed<I>::value ? _mm_packs_epi32(low, high) : _mm_packus_epi32(low, high);
+
+			if constexpr (sizeof(I) == 2)
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), packed);
+			}
+			else
+			{
+				packed = std::is_signed<I>::value ? _mm_packs_epi16(packed, packed) : _mm_packus_epi16(packed, packed);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(dst), packed);
+			}
+		}
+#endif
+
+		inline void encodeHalf(const float* src, half* dst, size_t count)
+		{
+			size_t i = 0;
+
+#if defined(ABSTRACTMATH_F16C)
+			for (; i + 8 <= count; i += 8)
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+			}
+#endif
+
+			for (; i < count; i++)
+			{
+				dst[i] = half(src[i]);
+			}
+		}
+
+		inline void decodeHalf(const half* src, float* dst, size_t count)
+		{
+			size_t i = 0;
+
+#if defined(ABSTRACTMATH_F16C)
+			for (; i + 8 <= count; i += 8)
+			{
+				_mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+			}
+#endif
+
+			for (; i < count; i++)
+			{
+				dst[i] = float(src[i]);
+			}
+		}
+
+		template<typename N>
+		void encodeNormalized(const float* src, N* dst, size_t count)
+		{
+			size_t i = 0;
+
+#if defined(ABSTRACTMATH_AVX2)
+			using I = decltype(N::bits);
+			const __m256 low = _mm256_set1_ps(std::is_signed<I>::value ? -1.0f : 0.0f);
+			const __m256 high = _mm256_set1_ps(1.0f);
+			const __m256 scale = _mm256_set1_ps(N::MAX);
+
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256 v = _mm256_loadu_ps(src + i);
+				v = _mm256_and_ps(v, _mm256_cmp_ps(v, v, _CMP_ORD_Q)); //NaN to zero
+				v = _mm256_min_ps(_mm256_max_ps(v, low), high);
+				storeNormalized8(_mm256_cvtps_epi32(_mm256_mul_ps(v, scale)), reinterpret_cast<I*>(dst + i));
+			}
+#endif
+
+			for (; i < count; i++)
+			{
+				dst[i] = N(src[i]);
+			}
+		}
+
+		template<typename N>
+		void decodeNormalized(const N* src, float* dst, size_t count)
+		{
+			size_t i = 0;
+
+#if defined(ABSTRACTMATH_AVX2)
+			using I = decltype(N::bits);
+			const __m256 low = _mm256_set1_ps(std::is_signed<I>::value ? -1.0f : 0.0f);
+			const __m256 scale = _mm256_set1_ps(N::MAX);
+
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256 v = _mm256_div_ps(_mm256_cvtepi32_ps(loadNormalized8(reinterpret_cast<const I*>(src + i))), scale);
+				_mm256_storeu_ps(dst + i, _mm256_max_ps(v, low));
+			}
+#endif
+
+			for (; i < count; i++)
+			{
+				dst[i] = float(src[i]);
+			}
+		}
+	}
+
+	// bulk conversion between scalar streams, dst[i] = D(src[i]) with float in between for two storage types
+	// float to and from half uses F16C eight at a time, float to and from snorm/unorm AVX2, the rest is scalar
+	template<typename S, typename D, typename = typename std::enable_if<(std::is_arithmetic<S>::value || detail::is_storage_type<S>::value)
+		&& (std::is_arithmetic<D>::value || detail::is_storage_type<D>::value)>::type>
+	void convert(const S* src, D* dst, size_t count)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchConvert, count);
+
+		if constexpr (std::is_same<S, D>::value)
+		{
+			std::memcpy(dst, src, sizeof(S) * count);
+		}
+		else if constexpr (std::is_same<S, float>::value && std::is_same<D, half>::value)
+		{
+			detail::encodeHalf(src, dst, count);
+		}
+		else if constexpr (std::is_same<S, half>::value && std::is_same<D, float>::value)
+		{
+			detail::decodeHalf(src, dst, count);
+		}
+		else if constexpr (std::is_same<S, float>::value && detail::is_normalized<D>::value)
+		{
+			detail::encodeNormalized(src, dst, count);
+		}
+		else if constexpr (detail::is_normalized<S>::value && std::is_same<D, float>::value)
+		{
+			detail::decodeNormalized(src, dst, count);
+		}
+		else
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				dst[i] = D(detail::widened<S>(src[i]));
+			}
+		}
+	}
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <type_traits>
+#include <assert.h>
+
+#include "Simd.h"
+#include "Profiling.h"
+#include "MathFunctions.h"
+#include "Vector.h"
+#include "Vec3.h"
+#include "Matrix.h"
+#include "Quaternion.h"
+#include "VectorArray.h"
+
+namespace AbstractMath {
+
+	// translation * rotation * scale written straight into a matrix, and split back out of one
+	// the 4x4 form is Matrix<T, 4, 4>, the affine form Matrix<T, 3, 4> (the 4x4 without its ( 0, 0, 0, 1 ) row)
+
+	template<typename T>
+	struct TRS
+	{
+		Vector3<T> translation;
+		Quaternion<T> rotation;
+		Vector3<T> scale = Vector3<T>(T(1), T(1), T(1));
+	};
+
+	typedef TRS<float> TRSf;
+	typedef TRS<double> TRSd;
+
+	namespace detail {
+
+		// upper 3x4 of the product, columns Rows_C apart: scaled rotation columns then the translation
+		template<typename T, size_t Rows_C>
+		constexpr void composeTRS(T tx, T ty, T tz, T x, T y, T z, T w, T sx, T sy, T sz, T* dst)
+		{
+			T x2 = x + x, y2 = y + y, z2 = z + z;
+			T xx = x * x2, yy = y * y2, zz = z * z2;
+			T xy = x * y2, xz = x * z2, yz = y * z2;
+			T wx = w * x2, wy = w * y2, wz = w * z2;
+
+			dst[0] = (T(1) - (yy + zz)) * sx;
+			dst[1] = (xy + wz) * sx;
+			dst[2] = (xz - wy) * sx;
+
+			dst[Rows_C + 0] = (xy - wz) * sy;
+			dst[Rows_C + 1] = (T(1) - (xx + zz)) * sy;
+			dst[Rows_C + 2] = (yz + wx) * sy;
+
+			dst[2 * Rows_C + 0] = (xz + wy) * sz;
+			dst[2 * Rows_C + 1] = (yz - wx) * sz;
+			dst[2 * Rows_C + 2] = (T(1) - (xx + yy)) * sz;
+
+			dst[3 * Rows_C + 0] = tx;
+			dst[3 * Rows_C + 1] = ty;
+			dst[3 * Rows_C + 2] = tz;
+
+			if constexpr (Rows_C == 4)
+			{
+				dst[3] = T(0);
+				dst[7] = T(0);
+				dst[11] = T(0);
+				dst[15] = T(1);
+			}
+		}
+	}
+
+	template<typename T, size_t Rows_C>
+	constexpr Matrix<T, Rows_C, 4>& composeTRS(Matrix<T, Rows_C, 4>& matrix, const Vector<T, 3>& translation, const Quaternion<T>& rotation, const Vector<T, 3>& scale)
+	{
+		static_assert(std::is_floating_point<T>::value && (Rows_C == 3 || Rows_C == 4), "TRS requires a floating point 3x4 or 4x4 matrix!");
+
+		detail::composeTRS<T, Rows_C>(translation.data[0], translation.data[1], translation.data[2],
+			rotation.data[0], rotation.data[1], rotation.data[2], rotation.data[3],
+			scale.data[0], scale.data[1], scale.data[2], matrix.data);
+
+		return matrix;
+	}
+
+	// same as translation(t) * rotation.toRotationMatrix() * scale(s) without the two matrix products
+	template<typename T>
+	constexpr Matrix<T, 4, 4> composeTRS(const Vector<T, 3>& translation, const Quaternion<T>& rotation, const Vector<T, 3>& scale)
+	{
+		Matrix<T, 4, 4> result;
+		return composeTRS(result, translation, rotation, scale);
+	}
+
+	template<typename T>
+	constexpr Matrix<T, 4, 4> composeTRS(const TRS<T>& parts)
+	{
+		return composeTRS(parts.translation, parts.rotation, parts.scale);
+	}
+
+	// scale is the length of each basis column, negated on x when the basis is mirrored so the rest stays a proper rotation
+	// the rotation is read from the normalized columns, shear is dropped and a zero scale leaves the rotation undefined
+	template<typename T, size_t Rows_C>
+	constexpr TRS<T> decomposeTRS(const Matrix<T, Rows_C, 4>& matrix)
+	{
+		static_assert(std::is_floating_point<T>::value && (Rows_C == 3 || Rows_C == 4), "TRS requires a floating point 3x4 or 4x4 matrix!");
+
+		const T* m = matrix.data;
+		TRS<T> result;
+		Matrix<T, 3, 3> rotation;
+
+		for (size_t col = 0; col < 3; col++)
+		{
+			const T* column = m + col * Rows_C;
+			result.scale.data[col] = math::sqrt(column[0] * column[0] + column[1] * column[1] + column[2] * column[2]);
+			result.translation.data[col] = m[3 * Rows_C + col];
+		}
+
+		T det = m[0] * (m[Rows_C + 1] * m[2 * Rows_C + 2] - m[Rows_C + 2] * m[2 * Rows_C + 1])
+			- m[Rows_C] * (m[1] * m[2 * Rows_C + 2] - m[2] * m[2 * Rows_C + 1])
+			+ m[2 * Rows_C] * (m[1] * m[Rows_C + 2] - m[2] * m[Rows_C + 1]);
+
+		if (det < T(0))
+		{
+			result.scale.data[0] = -result.scale.data[0];
+		}
+
+		for (size_t col = 0; col < 3; col++)
+		{
+			T invScale = result.scale.data[col] != T(0) ? T(1) / result.scale.data[col] : T(0);
+
+			for (size_t row = 0; row < 3; row++)
+			{
+				rotation.data[col * 3 + row] = m[col * Rows_C + row] * invScale;
+			}
+		}
+
+		result.rotation = Quaternion<T>::fromRotationMatrix(rotation).normalized();
+		return result;
+	}
+
+	// batch forms over structure of arrays parts, dst/src hold one matrix per element
+	// float compose uses AVX2 when available (eight matrices per iteration), decompose is scalar (it branches per matrix)
+
+	template<typename T, size_t Rows_C>
+	void composeTRS(const VectorArray<T, 3>& translations, const VectorArray<T, 4>& rotations, const VectorArray<T, 3>& scales, Matrix<T, Rows_C, 4>* dst)
+	{
+		static_assert(std::is_floating_point<T>::value && (Rows_C == 3 || Rows_C == 4), "TRS requires a floating point 3x4 or 4x4 matrix!");
+		assert(translations.size() == rotations.size() && rotations.size() == scales.size());
+
+		const size_t count = rotations.size();
+		ABSTRACTMATH_PROFILE_SCOPE(BatchTransform, count);
+		size_t i = 0;
+
+#if defined(ABSTRACTMATH_AVX2)
+		if constexpr (std::is_same<T, float>::value)
+		{
+			const __m256 one = _mm256_set1_ps(1.0f);
+			const __m256 zero = _mm256_setzero_ps();
+
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256 x = _mm256_load_ps(rotations.lane(0) + i), y = _mm256_load_ps(rotations.lane(1) + i);
+				__m256 z = _mm256_load_ps(rotations.lane(2) + i), w = _mm256_load_ps(rotations.lane(3) + i);
+				__m256 sx = _mm256_load_ps(scales.lane(0) + i), sy = _mm256_load_ps(scales.lane(1) + i), sz = _mm256_load_ps(scales.lane(2) + i);
+				__m256 tx = _mm256_load_ps(translations.lane(0) + i), ty = _mm256_load_ps(translations.lane(1) + i), tz = _mm256_load_ps(translations.lane(2) + i);
+
+				__m256 x2 = _mm256_add_ps(x, x), y2 = _mm256_add_ps(y, y), z2 = _mm256_add_ps(z, z);
+				__m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+				__m256 xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2), yz = _mm256_mul_ps(y, z2);
+				__m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2), wz = _mm256_mul_ps(w, z2);
+
+				__m256 basis[9] = {
+					_mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx), _mm256_mul_ps(_mm256_add_ps(xy, wz), sx), _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx),
+					_mm256_mul_ps(_mm256_sub_ps(xy, wz), sy), _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy), _mm256_mul_ps(_mm256_add_ps(yz, wx), sy),
+					_mm256_mul_ps(_mm256_add_ps(xz, wy), sz), _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz), _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz)
+				};
+
+				if constexpr (Rows_C == 4)
+				{
+					__m256 low[8] = { basis[0], basis[1], basis[2], zero, basis[3], basis[4], basis[5], zero };
+					__m256 high[8] = { basis[6], basis[7], basis[8], zero, tx, ty, tz, one };
+
+					detail::transpose8x8(low);
+					detail::transpose8x8(high);
+
+					for (size_t k = 0; k < 8; k++)
+					{
+						_mm256_storeu_ps(dst[i + k].data, low[k]);
+						_mm256_storeu_ps(dst[i + k].data + 8, high[k]);
+					}
+				}
+				else
+				{
+					//twelve floats per matrix: eight from the first transpose, four from the low half of the second
+					__m256 low[8] = { basis[0], basis[1], basis[2], basis[3], basis[4], basis[5], basis[6], basis[7] };
+					__m256 high[8] = { basis[8], tx, ty, tz, zero, zero, zero, zero };
+
+					detail::transpose8x8(low);
+					detail::transpose8x8(high);
+
+					for (size_t k = 0; k < 8; k++)
+					{
+						_mm256_storeu_ps(dst[i + k].data, low[k]);
+						_mm_storeu_ps(dst[i + k].data + 8, _mm256_castps256_ps128(high[k]));
+					}
+				}
+			}
+		}
+#endif
+
+		for (; i < count; i++)
+		{
+			detail::composeTRS<T, Rows_C>(translations.lane(0)[i], translations.lane(1)[i], translations.lane(2)[i],
+				rotations.lane(0)[i], rotations.lane(1)[i], rotations.lane(2)[i], rotations.lane(3)[i],
+				scales.lane(0)[i], scales.lane(1)[i], scales.lane(2)[i], dst[i].data);
+		}
+	}
+
+	template<typename T, size_t Rows_C>
+	void decomposeTRS(const Matrix<T, Rows_C, 4>* src, size_t count, VectorArray<T, 3>& translations, VectorArray<T, 4>& rotations, VectorArray<T, 3>& scales)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchTransform, count);
+		translations.resize(count);
+		rotations.resize(count);
+		scales.resize(count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			TRS<T> parts = decomposeTRS(src[i]);
+			translations.set(i, parts.translation);
+			rotations.set(i, parts.rotation);
+			scales.set(i, parts.scale);
+		}
+	}
+}
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+
+#include "Vector.h"
+#include "Vec3.h"
+#include "Matrix.h"
+#include "Quaternion.h"
+#include "TRS.h"
+#include "VectorArray.h"
+#include "Parallel.h"
+
+namespace AbstractMath {
+
+	// scene graph transforms: every node has a local translation, rotation and scale and a world matrix
+	// world = parentWorld * translation * rotation * scale
+	// nodes are kept sorted breadth-first in structure of arrays storage so each level only reads the one above it,
+	// setters mark nodes dirty and update() recomputes just the dirty nodes and their descendants
+	// nodes are addressed by the handle addNode() returns, it stays valid while storage is re-sorted
+	template<typename T>
+	class TransformHierarchy
+	{
+		static_assert(std::is_floating_point<T>::value, "TransformHierarchy requires a floating point type!");
+
+	public:
+		static constexpr uint32_t NO_PARENT = UINT32_MAX;
+		static constexpr size_t PARALLEL_GRAIN = 1024; //nodes per chunk in updateParallel
+
+		TransformHierarchy() = default;
+
+		// the parent has to exist already, new nodes start dirty
+		uint32_t addNode(uint32_t parent = NO_PARENT, const Vector<T, 3>& translation = Vector3<T>(), const Quaternion<T>& rotation = Quaternion<T>(), const Vector<T, 3>& scale = Vector3<T>(T(1), T(1), T(1)))
+		{
+			assert(parent == NO_PARENT || parent < handleToIndex.size());
+			assert(handleToIndex.size() < size_t(NO_PARENT));
+
+			uint32_t handle = uint32_t(handleToIndex.size());
+			uint32_t parentIndex = parent == NO_PARENT ? NO_PARENT : handleToIndex[parent];
+			uint32_t depth = parent == NO_PARENT ? 0 : depths[parentIndex] + 1;
+
+			if (!depths.empty() && depth < depths.back())
+			{
+				sorted = false;
+			}
+
+			levelsStale = true;
+
+			handleToIndex.push_back(handle);
+			indexToHandle.push_back(handle);
+			parents.push_back(parentIndex);
+			depths.push_back(depth);
+			translations.push_back(translation);
+			rotations.push_back(rotation);
+			scales.push_back(scale);
+			worlds.push_back(identity<T, 4>());
+			dirty.push_back(1);
+			anyDirty = true;
+
+			return handle;
+		}
+
+		void clear()
+		{
+			*this = TransformHierarchy<T>();
+		}
+
+		size_t size() const { return handleToIndex.size(); }
+		bool empty() const { return handleToIndex.empty(); }
+
+		uint32_t parent(uint32_t node) const
+		{
+			uint32_t parentIndex = parents[indexOf(node)];
+			return parentIndex == NO_PARENT ? NO_PARENT : indexToHandle[parentIndex];
+		}
+
+		Vector3<T> translation(uint32_t node) const { return translations.get(indexOf(node)); }
+		Quaternion<T> rotation(uint32_t node) const { return rotations.get(indexOf(node)); }
+		Vector3<T> scale(uint32_t node) const { return scales.get(indexOf(node)); }
+
+		void setTranslation(uint32_t node, const Vector<T, 3>& translation)
+		{
+			size_t index = indexOf(node);
+			translations.set(index, translation);
+			markDirty(index);
+		}
+
+		void setRotation(uint32_t node, const Quaternion<T>& rotation)
+		{
+			size_t index = indexOf(node);
+			rotations.set(index, rotation);
+			markDirty(index);
+		}
+
+		void setScale(uint32_t node, const Vector<T, 3>& scale)
+		{
+			size_t index = indexOf(node);
+			scales.set(index, scale);
+			markDirty(index);
+		}
+
+		void setLocal(uint32_t node, const Vector<T, 3>& translation, const Quaternion<T>& rotation, const Vector<T, 3>& scale)
+		{
+			size_t index = indexOf(node);
+			translations.set(index, translation);
+			rotations.set(index, rotation);
+			scales.set(index, scale);
+			markDirty(index);
+		}
+
+		Matrix<T, 4, 4> localMatrix(uint32_t node) const
+		{
+			return localMatrixAt(indexOf(node));
+		}
+
+		// as of the last update()
+		const Matrix<T, 4, 4>& worldMatrix(uint32_t node) const
+		{
+			return worlds[indexOf(node)];
+		}
+
+		// handles whose world matrix the last update() rewrote, in breadth-first order, for partial GPU uploads
+		const std::vector<uint32_t>& changedNodes() const
+		{
+			return changed;
+		}
+
+		void update()
+		{
+			propagate(0);
+		}
+
+		// every level is split over parallelFor, levels narrower than grain stay on the calling thread
+		void updateParallel(size_t grain = PARALLEL_GRAIN)
+		{
+			propagate(grain);
+		}
+
+	private:
+		size_t indexOf(uint32_t node) const
+		{
+			assert(node < handleToIndex.size());
+			return handleToIndex[node];
+		}
+
+		void markDirty(size_t index)
+		{
+			dirty[index] = 1;
+			anyDirty = true;
+		}
+
+		Matrix<T, 4, 4> localMatrixAt(size_t index) const
+		{
+			Matrix<T, 4, 4> local;
+			detail::composeTRS<T, 4>(translations.lane(0)[index], translations.lane(1)[index], translations.lane(2)[index],
+				rotations.lane(0)[index], rotations.lane(1)[index], rotations.lane(2)[index], rotations.lane(3)[index],
+				scales.lane(0)[index], scales.lane(1)[index], scales.lane(2)[index], local.data);
+
+			return local;
+		}
+
+		void updateRange(size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				uint32_t parentIndex = parents[i];
+
+				if (parentIndex != NO_PARENT && dirty[parentIndex])
+				{
+					dirty[i] = 1;
+				}
+
+				if (dirty[i])
+				{
+					worlds[i] = parentIndex == NO_PARENT ? localMatrixAt(i) : worlds[parentIndex] * localMatrixAt(i);
+				}
+			}
+		}
+
+		// grain 0 runs single-threaded, a level's nodes only read their parents' flags and matrices from the level above
+		void propagate(size_t grain)
+		{
+			changed.clear();
+
+			if (!anyDirty)
+			{
+				return;
+			}
+
+			if (!sorted)
+			{
+				sortBreadthFirst();
+			}
+
+			if (levelsStale)
+			{
+				rebuildLevels();
+			}
+
+			for (size_t level = 0; level + 1 < levelStarts.size(); level++)
+			{
+				size_t begin = levelStarts[level], end = levelStarts[level + 1];
+
+				if (grain == 0)
+				{
+					updateRange(begin, end);
+				}
+				else
+				{
+					parallelFor(begin, end, grain, [this](size_t first, size_t last) { updateRange(first, last); });
+				}
+			}
+
+			for (size_t i = 0; i < dirty.size(); i++)
+			{
+				if (dirty[i])
+				{
+					changed.push_back(indexToHandle[i]);
+					dirty[i] = 0;
+				}
+			}
+
+			anyDirty = false;
+		}
+
+		// stable sort by depth, parents stay ahead of their children and every level becomes one contiguous range
+		void sortBreadthFirst()
+		{
+			size_t count = depths.size();
+			std::vector<uint32_t> order(count);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				order[i] = uint32_t(i);
+			}
+
+			std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return depths[a] < depths[b]; });
+
+			std::vector<uint32_t> newIndex(count);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				newIndex[order[i]] = uint32_t(i);
+			}
+
+			TransformHierarchy<T> result;
+			result.translations = VectorArray<T, 3>(count);
+			result.rotations = VectorArray<T, 4>(count);
+			result.scales = VectorArray<T, 3>(count);
+			result.handleToIndex.resize(count);
+			result.indexToHandle.resize(count);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				uint32_t old = order[i];
+				uint32_t handle = indexToHandle[old];
+
+				result.handleToIndex[handle] = uint32_t(i);
+				result.indexToHandle[i] = handle;
+				result.parents.push_back(parents[old] == NO_PARENT ? NO_PARENT : newIndex[parents[old]]);
+				result.depths.push_back(depths[old]);
+				result.translations.set(i, translations.get(old));
+				result.rotations.set(i, rotations.get(old));
+				result.scales.set(i, scales.get(old));
+				result.worlds.push_back(worlds[old]);
+				result.dirty.push_back(dirty[old]);
+			}
+
+			result.anyDirty = anyDirty;
+			result.levelsStale = true;
+			*this = std::move(result);
+		}
+
+		void rebuildLevels()
+		{
+			levelStarts.clear();
+
+			for (size_t i = 0; i < depths.size(); i++)
+			{
+				if (levelStarts.empty() || depths[i] != depths[i - 1])
+				{
+					levelStarts.push_back(i);
+				}
+			}
+
+			levelStarts.push_back(depths.size());
+			levelsStale = false;
+		}
+
+		VectorArray<T, 3> translations;
+		VectorArray<T, 4> rotations;
+		VectorArray<T, 3> scales;
+		std::vector<Matrix<T, 4, 4>> worlds;
+		std::vector<uint32_t> parents; //storage index of the parent or NO_PARENT
+		std::vector<uint32_t> depths;
+		std::vector<uint8_t> dirty;
+		std::vector<size_t> levelStarts; //first storage index of every level, plus one past the end
+		std::vector<uint32_t> handleToIndex, indexToHandle;
+		std::vector<uint32_t> changed;
+		bool sorted = true;
+		bool levelsStale = false;
+		bool anyDirty = false;
+	};
+
+	typedef TransformHierarchy<float> TransformHierarchyf;
+	typedef TransformHierarchy<double> TransformHierarchyd;
+}
@@ -10,8 +10,8 @@ namespace AbstractMath {
 	public:
 		constexpr Vector2(T x = T(0), T y = T(0))
 		{
-			this->x = x;
-			this->y = y;
+			this->data[0] = x;
+			this->data[1] = y;
 		}
 
 		constexpr Vector2(const Vector<T, 2>& other)
@@ -20,7 +20,7 @@ namespace AbstractMath {
 		}
 
 		template<typename Ty>
-		constexpr decltype(T(0) - Ty(0)) cross(const Vector2<Ty>& other)
+		constexpr decltype(T(0) - Ty(0)) cross(const Vector2<Ty>& other) const
 		{
 			return this->x * other.y - this->y * other.x;
 		}
@@ -10,9 +10,9 @@ namespace AbstractMath {
 	public:
 		constexpr Vector3(T x = T(0), T y = T(0), T z = T(0)) : Vector<T, 3>()
 		{
-			this->x = x;
-			this->y = y;
-			this->z = z;
+			this->data[0] = x;
+			this->data[1] = y;
+			this->data[2] = z;
 		}
 
 		constexpr Vector3(const Vector<T, 3>& other)
@@ -21,7 +21,7 @@ namespace AbstractMath {
 		}
 
 		template<typename Ty>
-		constexpr Vector3<decltype(T(0) - Ty(0))> cross(const Vector3<Ty>& other)
+		constexpr Vector3<decltype(T(0) - Ty(0))> cross(const Vector3<Ty>& other) const
 		{
 			using return_type = decltype(T(0) - Ty(0));
 			return_type x = this->y * other.z - this->z * other.y;
@@ -18,7 +18,7 @@ namespace AbstractMath {
 
 		constexpr Vector4(const Vector<T, 4>& other)
 		{
-			copyFrom(other.data);
+			this->copyFrom(other.data);
 		}
 	};
 
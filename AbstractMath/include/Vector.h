@@ -1,9 +1,16 @@
 #pragma once
 
 #include <type_traits>
+#include <initializer_list>
 #include <memory>
+#include <cmath>
 #include <assert.h>
 
+#include "Simd.h"
+#include "MathFunctions.h"
+#include "StorageTypes.h"
+#include "Profiling.h"
+
 namespace AbstractMath {
 
 	template<typename T, size_t C, typename = void>
@@ -12,7 +19,7 @@ namespace AbstractMath {
 	public:
 		union
 		{
-			T data[C] = { 0 };
+			T data[C];
 
 			struct
 			{
@@ -23,7 +30,7 @@ namespace AbstractMath {
 			};
 		};
 
-		constexpr BaseVectorData() = default;
+		constexpr BaseVectorData() : data{} {} //a default member initializer inside the union is not enough for a constexpr constructor on gcc
 	};
 
 	template<typename T, size_t C>
@@ -32,7 +39,7 @@ namespace AbstractMath {
 	public:
 		union
 		{
-			T data[C] = { 0 };
+			T data[C];
 
 			struct
 			{
@@ -41,7 +48,7 @@ namespace AbstractMath {
 			};
 		};
 
-		constexpr BaseVectorData() = default;
+		constexpr BaseVectorData() : data{} {}
 	};
 
 	template<typename T, size_t C>
@@ -50,7 +57,7 @@ namespace AbstractMath {
 	public:
 		union
 		{
-			T data[C] = { 0 };
+			T data[C];
 
 			struct
 			{
@@ -60,13 +67,13 @@ namespace AbstractMath {
 			};
 		};
 
-		constexpr BaseVectorData() = default;
+		constexpr BaseVectorData() : data{} {}
 	};
 
 	template<typename T, size_t C>
 	class Vector : public BaseVectorData<T, C>
 	{
-		static_assert(std::is_arithmetic<T>::value&& C > 1, "Type must be number and There must be more than one element!");
+		static_assert((std::is_arithmetic<T>::value || detail::is_storage_type<T>::value) && C > 1, "Type must be number or storage type and There must be more than one element!");
 
 	protected:
 		static const size_t SIZE = C * sizeof(T); //this shouldn't be used to determine class size! potential bug if used!
@@ -170,6 +177,17 @@ namespace AbstractMath {
 		{
 			Vector<decltype(T(1)* Ty(1)), C> result;
 
+#if defined(ABSTRACTMATH_SSE)
+			if constexpr (std::is_same<T, float>::value && std::is_same<Ty, float>::value && C == 4)
+			{
+				if (!detail::isConstantEvaluated())
+				{
+					detail::multiplyVector4f(this->data, other.data, result.data);
+					return result;
+				}
+			}
+#endif
+
 			for (size_t i = 0; i < C; i++)
 			{
 				result[i] = this->data[i] * other.data[i];
@@ -305,26 +323,50 @@ namespace AbstractMath {
 			return true;
 		}
 
-		constexpr T length() const
+		// storage types (half, snorm, unorm) are summed and returned as float
+		constexpr detail::widened<T> length() const
 		{
-			T sum = 0.0;
+			detail::widened<T> sum = 0.0;
 
 			for (size_t i = 0; i < C; i++)
 			{
 				sum += this->data[i] * this->data[i];
 			}
 
-			return T(sqrt(sum));
+			return math::sqrt(sum);
 		}
 
-		constexpr Vector<T, C> normalized() const
+		// Fast and Approx multiply by math::rsqrt of the squared length instead of dividing by length()
+		template<typename Precision = Precise>
+		constexpr Vector<detail::widened<T>, C> normalized() const
 		{
-			T len = length();
-			return this->operator/(len);
+			ABSTRACTMATH_PROFILE_COUNT(Normalize, 1);
+
+			if constexpr (math::detail::isApproximate<Precision>())
+			{
+#if defined(ABSTRACTMATH_SSE)
+				if constexpr (std::is_same<T, float>::value && C == 4)
+				{
+					if (!detail::isConstantEvaluated())
+					{
+						Vector<T, C> result;
+						detail::normalizeVector4f(this->data, result.data);
+						return result;
+					}
+				}
+#endif
+
+				return this->operator*(math::rsqrt<Precision>(dot(*this)));
+			}
+			else
+			{
+				detail::widened<T> len = length();
+				return this->operator/(len);
+			}
 		}
 
 		template<typename Ty>
-		constexpr decltype(T(1)* Ty(1)) dot(const Vector<Ty, C>& other)
+		constexpr decltype(T(1)* Ty(1)) dot(const Vector<Ty, C>& other) const
 		{
 			using return_type = decltype(T(1)* Ty(1));
 			return_type productSum = 0;
@@ -355,7 +397,12 @@ namespace AbstractMath {
 	protected:
 		constexpr void copyFrom(const T* src, size_t srcSize = SIZE)
 		{
-			memcpy_s(this->data, SIZE, src, srcSize);
+			size_t count = (srcSize < SIZE ? srcSize : SIZE) / sizeof(T);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				this->data[i] = src[i];
+			}
 		}
 	};
 
@@ -0,0 +1,710 @@
+#pragma once
+
+#include <type_traits>
+#include <cstring>
+#include <cmath>
+#include <assert.h>
+
+#include "Simd.h"
+#include "Vector.h"
+#include "Profiling.h"
+
+namespace AbstractMath {
+
+	// structure of arrays storage for many Vector<T, C>, every component lives in its own aligned stream
+	// streams are padded to a whole SIMD register and the padding is kept at zero so kernels never need a remainder loop
+	template<typename T, size_t C>
+	class VectorArray
+	{
+		static_assert((std::is_arithmetic<T>::value || detail::is_storage_type<T>::value) && C > 1 && C <= 4, "Type must be number or storage type and there must be two to four elements!");
+
+	public:
+		using type = T;
+		static const size_t LANE_WIDTH = SIMD_ALIGNMENT / sizeof(T) > 0 ? SIMD_ALIGNMENT / sizeof(T) : 1;
+
+		VectorArray() = default;
+
+		explicit VectorArray(size_t count)
+		{
+			resize(count);
+		}
+
+		template<typename V>
+		VectorArray(const V* src, size_t count)
+		{
+			load(src, count);
+		}
+
+		VectorArray(const VectorArray<T, C>& other)
+		{
+			resize(other.count);
+
+			for (size_t i = 0; i < C; i++)
+			{
+				std::memcpy(streams[i], other.streams[i], sizeof(T) * count);
+			}
+		}
+
+		VectorArray(VectorArray<T, C>&& other) noexcept
+		{
+			swap(other);
+		}
+
+		~VectorArray()
+		{
+			alignedFree(streams[0]);
+		}
+
+		VectorArray<T, C>& operator=(const VectorArray<T, C>& other)
+		{
+			if (this != &other)
+			{
+				VectorArray<T, C> copy(other);
+				swap(copy);
+			}
+
+			return *this;
+		}
+
+		VectorArray<T, C>& operator=(VectorArray<T, C>&& other) noexcept
+		{
+			swap(other);
+			return *this;
+		}
+
+		void swap(VectorArray<T, C>& other) noexcept
+		{
+			for (size_t i = 0; i < C; i++)
+			{
+				T* temp = streams[i];
+				streams[i] = other.streams[i];
+				other.streams[i] = temp;
+			}
+
+			size_t tempCount = count;
+			count = other.count;
+			other.count = tempCount;
+
+			size_t tempAllocated = allocated;
+			allocated = other.allocated;
+			other.allocated = tempAllocated;
+		}
+
+		size_t size() const { return count; }
+		size_t capacity() const { return allocated; }
+		bool empty() const { return count == 0; }
+
+		// number of elements kernels walk over, always a multiple of LANE_WIDTH
+		size_t paddedSize() const { return roundUp(count); }
+
+		T* lane(size_t component)
+		{
+			assert(component < C);
+			return streams[component];
+		}
+
+		const T* lane(size_t component) const
+		{
+			assert(component < C);
+			return streams[component];
+		}
+
+		void reserve(size_t newCapacity)
+		{
+			if (roundUp(newCapacity) > allocated)
+			{
+				allocate(newCapacity);
+			}
+		}
+
+		void resize(size_t newCount)
+		{
+			reserve(newCount);
+
+			if (newCount < count)
+			{
+				for (size_t i = 0; i < C; i++)
+				{
+					std::memset(streams[i] + newCount, 0, sizeof(T) * (count - newCount));
+				}
+			}
+
+			count = newCount;
+		}
+
+		void clear()
+		{
+			resize(0);
+		}
+
+		Vector<T, C> get(size_t index) const
+		{
+			assert(index < count);
+			Vector<T, C> result;
+
+			for (size_t i = 0; i < C; i++)
+			{
+				result[i] = streams[i][index];
+			}
+
+			return result;
+		}
+
+		void set(size_t index, const Vector<T, C>& value)
+		{
+			assert(index < count);
+
+			for (size_t i = 0; i < C; i++)
+			{
+				streams[i][index] = value[i];
+			}
+		}
+
+		void push_back(const Vector<T, C>& value)
+		{
+			if (count == allocated)
+			{
+				reserve(allocated == 0 ? LANE_WIDTH : allocated * 2);
+			}
+
+			count++;
+			set(count - 1, value);
+		}
+
+		// V is Vector<T, C> or one of its sized wrappers (Vector3<T>, Vector4<T>, Quaternion<T>)
+		template<typename V>
+		void load(const V* src, size_t srcCount)
+		{
+			static_assert(std::is_base_of<Vector<T, C>, V>::value && sizeof(V) == sizeof(Vector<T, C>), "Source must be an array of Vector<T, C>!");
+
+			resize(srcCount);
+
+			for (size_t index = 0; index < srcCount; index++)
+			{
+				for (size_t i = 0; i < C; i++)
+				{
+					streams[i][index] = src[index].data[i];
+				}
+			}
+		}
+
+		template<typename V>
+		void store(V* dst) const
+		{
+			static_assert(std::is_base_of<Vector<T, C>, V>::value && sizeof(V) == sizeof(Vector<T, C>), "Destination must be an array of Vector<T, C>!");
+
+			for (size_t index = 0; index < count; index++)
+			{
+				for (size_t i = 0; i < C; i++)
+				{
+					dst[index].data[i] = streams[i][index];
+				}
+			}
+		}
+
+		void operator+=(const VectorArray<T, C>& other);
+		void operator-=(const VectorArray<T, C>& other);
+		void operator*=(const VectorArray<T, C>& other);
+		void operator/=(const VectorArray<T, C>& other);
+
+		void operator+=(T other);
+		void operator-=(T other);
+		void operator*=(T other);
+		void operator/=(T other);
+
+	private:
+		static size_t roundUp(size_t value)
+		{
+			return (value + LANE_WIDTH - 1) / LANE_WIDTH * LANE_WIDTH;
+		}
+
+		void allocate(size_t newCapacity)
+		{
+			size_t padded = roundUp(newCapacity);
+			T* block = static_cast<T*>(alignedAlloc(sizeof(T) * C * padded));
+
+			if (padded > 0)
+			{
+				assert(block != nullptr);
+				std::memset(block, 0, sizeof(T) * C * padded);
+			}
+
+			for (size_t i = 0; i < C; i++)
+			{
+				if (count > 0)
+				{
+					std::memcpy(block + i * padded, streams[i], sizeof(T) * count);
+				}
+			}
+
+			alignedFree(streams[0]);
+
+			for (size_t i = 0; i < C; i++)
+			{
+				streams[i] = padded > 0 ? block + i * padded : nullptr;
+			}
+
+			allocated = padded;
+		}
+
+		T* streams[C] = { nullptr }; //all streams share one allocation owned by streams[0]
+		size_t count = 0;
+		size_t allocated = 0;
+	};
+
+	typedef VectorArray<float, 2> Vector2fArray;
+	typedef VectorArray<float, 3> Vector3fArray;
+	typedef VectorArray<float, 4> Vector4fArray;
+	typedef VectorArray<double, 2> Vector2dArray;
+	typedef VectorArray<double, 3> Vector3dArray;
+	typedef VectorArray<double, 4> Vector4dArray;
+
+	namespace detail {
+
+		// plain stream kernels, written so the compiler vectorizes them for any T, dst may alias a source
+
+		template<typename T, typename Op>
+		inline void streamBinary(const T* a, const T* b, T* dst, size_t n, Op op)
+		{
+			for (size_t i = 0; i < n; i++)
+			{
+				dst[i] = op(a[i], b[i]);
+			}
+		}
+
+		template<typename T, typename Op>
+		inline void streamScalar(const T* a, T scalar, T* dst, size_t n, Op op)
+		{
+			for (size_t i = 0; i < n; i++)
+			{
+				dst[i] = op(a[i], scalar);
+			}
+		}
+
+		template<typename T, size_t C>
+		inline void streamDot(const T* const* a, const T* const* b, T* ABSTRACTMATH_RESTRICT dst, size_t n)
+		{
+			size_t i = 0;
+
+#if defined(ABSTRACTMATH_AVX2)
+			if (std::is_same<T, float>::value)
+			{
+				for (; i + 8 <= n; i += 8)
+				{
+					__m256 sum = _mm256_mul_ps(_mm256_load_ps((const float*)a[0] + i), _mm256_load_ps((const float*)b[0] + i));
+
+					for (size_t c = 1; c < C; c++)
+					{
+#if defined(ABSTRACTMATH_FMA)
+						sum = _mm256_fmadd_ps(_mm256_load_ps((const float*)a[c] + i), _mm256_load_ps((const float*)b[c] + i), sum);
+#else
+						sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_load_ps((const float*)a[c] + i), _mm256_load_ps((const float*)b[c] + i)));
+#endif
+					}
+
+					_mm256_storeu_ps((float*)dst + i, sum);
+				}
+			}
+#elif defined(ABSTRACTMATH_SSE)
+			if (std::is_same<T, float>::value)
+			{
+				for (; i + 4 <= n; i += 4)
+				{
+					__m128 sum = _mm_mul_ps(_mm_load_ps((const float*)a[0] + i), _mm_load_ps((const float*)b[0] + i));
+
+					for (size_t c = 1; c < C; c++)
+					{
+						sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps((const float*)a[c] + i), _mm_load_ps((const float*)b[c] + i)));
+					}
+
+					_mm_storeu_ps((float*)dst + i, sum);
+				}
+			}
+#endif
+
+			for (; i < n; i++)
+			{
+				T sum = a[0][i] * b[0][i];
+
+				for (size_t c = 1; c < C; c++)
+				{
+					sum += a[c][i] * b[c][i];
+				}
+
+				dst[i] = sum;
+			}
+		}
+
+		template<typename T, size_t C>
+		inline void streamLength(const T* const* a, T* ABSTRACTMATH_RESTRICT dst, size_t n)
+		{
+			size_t i = 0;
+
+#if defined(ABSTRACTMATH_AVX2)
+			if (std::is_same<T, float>::value)
+			{
+				for (; i + 8 <= n; i += 8)
+				{
+					__m256 v = _mm256_load_ps((const float*)a[0] + i);
+					__m256 sum = _mm256_mul_ps(v, v);
+
+					for (size_t c = 1; c < C; c++)
+					{
+						v = _mm256_load_ps((const float*)a[c] + i);
+#if defined(ABSTRACTMATH_FMA)
+						sum = _mm256_fmadd_ps(v, v, sum);
+#else
+						sum = _mm256_add_ps(sum, _mm256_mul_ps(v, v));
+#endif
+					}
+
+					_mm256_storeu_ps((float*)dst + i, _mm256_sqrt_ps(sum));
+				}
+			}
+#elif defined(ABSTRACTMATH_SSE)
+			if (std::is_same<T, float>::value)
+			{
+				for (; i + 4 <= n; i += 4)
+				{
+					__m128 v = _mm_load_ps((const float*)a[0] + i);
+					__m128 sum = _mm_mul_ps(v, v);
+
+					for (size_t c = 1; c < C; c++)
+					{
+						v = _mm_load_ps((const float*)a[c] + i);
+						sum = _mm_add_ps(sum, _mm_mul_ps(v, v));
+					}
+
+					_mm_storeu_ps((float*)dst + i, _mm_sqrt_ps(sum));
+				}
+			}
+#endif
+
+			for (; i < n; i++)
+			{
+				T sum = a[0][i] * a[0][i];
+
+				for (size_t c = 1; c < C; c++)
+				{
+					sum += a[c][i] * a[c][i];
+				}
+
+				dst[i] = T(std::sqrt(sum));
+			}
+		}
+
+		// each element is divided by its length like Vector::normalized()
+		template<typename T, size_t C>
+		inline void streamNormalize(const T* const* src, T* const* dst, size_t n)
+		{
+			size_t i = 0;
+
+#if defined(ABSTRACTMATH_AVX2)
+			if (std::is_same<T, float>::value)
+			{
+				for (; i + 8 <= n; i += 8)
+				{
+					__m256 v[C];
+					__m256 sum = _mm256_setzero_ps();
+
+					for (size_t c = 0; c < C; c++)
+					{
+						v[c] = _mm256_load_ps((const float*)src[c] + i);
+#if defined(ABSTRACTMATH_FMA)
+						sum = _mm256_fmadd_ps(v[c], v[c], sum);
+#else
+						sum = _mm256_add_ps(sum, _mm256_mul_ps(v[c], v[c]));
+#endif
+					}
+
+					__m256 len = _mm256_sqrt_ps(sum);
+
+					for (size_t c = 0; c < C; c++)
+					{
+						_mm256_store_ps((float*)dst[c] + i, _mm256_div_ps(v[c], len));
+					}
+				}
+			}
+#elif defined(ABSTRACTMATH_SSE)
+			if (std::is_same<T, float>::value)
+			{
+				for (; i + 4 <= n; i += 4)
+				{
+					__m128 v[C];
+					__m128 sum = _mm_setzero_ps();
+
+					for (size_t c = 0; c < C; c++)
+					{
+						v[c] = _mm_load_ps((const float*)src[c] + i);
+						sum = _mm_add_ps(sum, _mm_mul_ps(v[c], v[c]));
+					}
+
+					__m128 len = _mm_sqrt_ps(sum);
+
+					for (size_t c = 0; c < C; c++)
+					{
+						_mm_store_ps((float*)dst[c] + i, _mm_div_ps(v[c], len));
+					}
+				}
+			}
+#endif
+
+			for (; i < n; i++)
+			{
+				T sum = 0;
+
+				for (size_t c = 0; c < C; c++)
+				{
+					sum += src[c][i] * src[c][i];
+				}
+
+				T len = T(std::sqrt(sum));
+
+				for (size_t c = 0; c < C; c++)
+				{
+					dst[c][i] = src[c][i] / len;
+				}
+			}
+		}
+
+		template<typename T, typename Fy>
+		inline void streamLerp(const T* a, const T* b, Fy amount, T* dst, size_t n)
+		{
+			for (size_t i = 0; i < n; i++)
+			{
+				dst[i] = T((1 - amount) * a[i] + amount * b[i]);
+			}
+		}
+
+		template<typename T, size_t C>
+		inline void prepareOutput(const VectorArray<T, C>& src, VectorArray<T, C>& dst)
+		{
+			if (&src != &dst)
+			{
+				dst.resize(src.size());
+			}
+		}
+	}
+
+	template<typename T, size_t C>
+	void add(const VectorArray<T, C>& a, const VectorArray<T, C>& b, VectorArray<T, C>& dst)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchVector, a.size());
+		assert(a.size() == b.size());
+		detail::prepareOutput(a, dst);
+
+		for (size_t i = 0; i < C; i++)
+		{
+			detail::streamBinary(a.lane(i), b.lane(i), dst.lane(i), a.paddedSize(), [](T l, T r) { return l + r; });
+		}
+	}
+
+	template<typename T, size_t C>
+	void subtract(const VectorArray<T, C>& a, const VectorArray<T, C>& b, VectorArray<T, C>& dst)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchVector, a.size());
+		assert(a.size() == b.size());
+		detail::prepareOutput(a, dst);
+
+		for (size_t i = 0; i < C; i++)
+		{
+			detail::streamBinary(a.lane(i), b.lane(i), dst.lane(i), a.paddedSize(), [](T l, T r) { return l - r; });
+		}
+	}
+
+	template<typename T, size_t C>
+	void multiply(const VectorArray<T, C>& a, const VectorArray<T, C>& b, VectorArray<T, C>& dst)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchVector, a.size());
+		assert(a.size() == b.size());
+		detail::prepareOutput(a, dst);
+
+		for (size_t i = 0; i < C; i++)
+		{
+			detail::streamBinary(a.lane(i), b.lane(i), dst.lane(i), a.paddedSize(), [](T l, T r) { return l * r; });
+		}
+	}
+
+	// only the live elements are divided so the zero padding never produces NaNs
+	template<typename T, size_t C>
+	void divide(const VectorArray<T, C>& a, const VectorArray<T, C>& b, VectorArray<T, C>& dst)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchVector, a.size());
+		assert(a.size() == b.size());
+		detail::prepareOutput(a, dst);
+
+		for (size_t i = 0; i < C; i++)
+		{
+			detail::streamBinary(a.lane(i), b.lane(i), dst.lane(i), a.size(), [](T l, T r) { return l / r; });
+		}
+	}
+
+	template<typename T, size_t C>
+	void add(const VectorArray<T, C>& a, T scalar, VectorArray<T, C>& dst)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchVector, a.size());
+		detail::prepareOutput(a, dst);
+
+		for (size_t i = 0; i < C; i++)
+		{
+			detail::streamScalar(a.lane(i), scalar, dst.lane(i), a.size(), [](T l, T r) { return l + r; });
+		}
+	}
+
+	template<typename T, size_t C>
+	void subtract(const VectorArray<T, C>& a, T scalar, VectorArray<T, C>& dst)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchVector, a.size());
+		detail::prepareOutput(a, dst);
+
+		for (size_t i = 0; i < C; i++)
+		{
+			detail::streamScalar(a.lane(i), scalar, dst.lane(i), a.size(), [](T l, T r) { return l - r; });
+		}
+	}
+
+	template<typename T, size_t C>
+	void multiply(const VectorArray<T, C>& a, T scalar, VectorArray<T, C>& dst)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchVector, a.size());
+		detail::prepareOutput(a, dst);
+
+		for (size_t i = 0; i < C; i++)
+		{
+			detail::streamScalar(a.lane(i), scalar, dst.lane(i), a.size(), [](T l, T r) { return l * r; });
+		}
+	}
+
+	template<typename T, size_t C>
+	void divide(const VectorArray<T, C>& a, T scalar, VectorArray<T, C>& dst)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchVector, a.size());
+		detail::prepareOutput(a, dst);
+
+		for (size_t i = 0; i < C; i++)
+		{
+			detail::streamScalar(a.lane(i), scalar, dst.lane(i), a.size(), [](T l, T r) { return l / r; });
+		}
+	}
+
+	// dst needs room for a.size() values
+	template<typename T, size_t C>
+	void dot(const VectorArray<T, C>& a, const VectorArray<T, C>& b, T* dst)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchVector, a.size());
+		assert(a.size() == b.size());
+		const T* aLanes[C];
+		const T* bLanes[C];
+
+		for (size_t i = 0; i < C; i++)
+		{
+			aLanes[i] = a.lane(i);
+			bLanes[i] = b.lane(i);
+		}
+
+		detail::streamDot<T, C>(aLanes, bLanes, dst, a.size());
+	}
+
+	template<typename T, size_t C>
+	void length(const VectorArray<T, C>& a, T* dst)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchVector, a.size());
+		const T* lanes[C];
+
+		for (size_t i = 0; i < C; i++)
+		{
+			lanes[i] = a.lane(i);
+		}
+
+		detail::streamLength<T, C>(lanes, dst, a.size());
+	}
+
+	template<typename T, size_t C>
+	void normalized(const VectorArray<T, C>& a, VectorArray<T, C>& dst)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchVector, a.size());
+		detail::prepareOutput(a, dst);
+		const T* srcLanes[C];
+		T* dstLanes[C];
+
+		for (size_t i = 0; i < C; i++)
+		{
+			srcLanes[i] = a.lane(i);
+			dstLanes[i] = dst.lane(i);
+		}
+
+		//only the full registers run in SIMD, the zero padding would divide by zero
+		size_t full = a.size() / VectorArray<T, C>::LANE_WIDTH * VectorArray<T, C>::LANE_WIDTH;
+		detail::streamNormalize<T, C>(srcLanes, dstLanes, full);
+
+		for (size_t i = 0; i < C; i++)
+		{
+			srcLanes[i] += full;
+			dstLanes[i] += full;
+		}
+
+		detail::streamNormalize<T, C>(srcLanes, dstLanes, a.size() - full);
+	}
+
+	template<typename T, size_t C>
+	void normalize(VectorArray<T, C>& a)
+	{
+		normalized(a, a);
+	}
+
+	template<typename T, size_t C, typename Fy>
+	void lerp(const VectorArray<T, C>& a, const VectorArray<T, C>& b, Fy amount, VectorArray<T, C>& dst)
+	{
+		ABSTRACTMATH_PROFILE_SCOPE(BatchVector, a.size());
+		static_assert(std::is_floating_point<Fy>::value, "Amount Type must be a floating point number!");
+		assert(a.size() == b.size());
+		detail::prepareOutput(a, dst);
+
+		for (size_t i = 0; i < C; i++)
+		{
+			detail::streamLerp(a.lane(i), b.lane(i), amount, dst.lane(i), a.paddedSize());
+		}
+	}
+
+	// whole streams between element types, e.g. float positions to Vector<half, 3> or snorm16 keyframes back to float,
+	// each component runs through the scalar convert() so F16C/AVX2 kernels apply
+	template<typename S, typename D, size_t C>
+	void convert(const Vector<S, C>* src, Vector<D, C>* dst, size_t count)
+	{
+		static_assert(sizeof(Vector<S, C>) == sizeof(S) * C && sizeof(Vector<D, C>) == sizeof(D) * C, "Vectors must be tightly packed!");
+
+		if (count > 0)
+		{
+			convert(src[0].data, dst[0].data, count * C);
+		}
+	}
+
+	template<typename S, typename D, size_t C>
+	void convert(const VectorArray<S, C>& src, VectorArray<D, C>& dst)
+	{
+		dst.resize(src.size());
+
+		for (size_t i = 0; i < C; i++)
+		{
+			convert(src.lane(i), dst.lane(i), src.size());
+		}
+	}
+
+	template<typename T, size_t C>
+	void VectorArray<T, C>::operator+=(const VectorArray<T, C>& other) { add(*this, other, *this); }
+	template<typename T, size_t C>
+	void VectorArray<T, C>::operator-=(const VectorArray<T, C>& other) { subtract(*this, other, *this); }
+	template<typename T, size_t C>
+	void VectorArray<T, C>::operator*=(const VectorArray<T, C>& other) { multiply(*this, other, *this); }
+	template<typename T, size_t C>
+	void VectorArray<T, C>::operator/=(const VectorArray<T, C>& other) { divide(*this, other, *this); }
+
+	template<typename T, size_t C>
+	void VectorArray<T, C>::operator+=(T other) { add(*this, other, *this); }
+	template<typename T, size_t C>
+	void VectorArray<T, C>::operator-=(T other) { subtract(*this, other, *this); }
+	template<typename T, size_t C>
+	void VectorArray<T, C>::operator*=(T other) { multiply(*this, other, *this); }
+	template<typename T, size_t C>
+	void VectorArray<T, C>::operator/=(T other) { divide(*this, other, *this); }
+}
\ No newline at end of file